@@ -0,0 +1,722 @@
+#include "cam.h"
+
+// capture state, shared with the ISR
+static volatile uint8_t saveImage = 0; // user requests image
+static volatile uint8_t startImage = 0; // got a start of frame
+static volatile uint8_t startCollect = 0; // got a start of row
+static volatile uint32_t rawIndex = 0;
+static volatile uint32_t hsCount = 0;
+static volatile uint32_t vsCount = 0;
+
+// the frame buffers, defined once for the whole program and placed by the
+// linker in RAM the boot code doesn't clear, every frame overwrites them
+static volatile uint8_t __uninitialized_ram(cameraData)[IMAGESIZEX*IMAGESIZEY*2];
+static volatile cameraImage_t __uninitialized_ram(picture);
+
+static int lineDetector = LINE_DETECTOR_CENTROID;
+
+// row projection state, filled by the ISR while a frame arrives
+static uint16_t projMass[IMAGESIZEX]; // r+g+b of each pixel of the current row
+static uint32_t projSum = 0; // sum of projMass so far this row
+static uint8_t projLow = 0; // low byte of the current pixel
+static volatile int16_t projCenter[IMAGESIZEY]; // findLine() of each row
+static volatile int projRows = 0; // rows finished this frame
+
+// flat field gain per pixel, FLAT_ONE is 1.0, NULL for no correction
+static const uint8_t *flatGain = NULL;
+
+static inline uint8_t flatApply(int v, uint8_t gain){
+    int x = (v * gain) >> FLAT_SHIFT;
+    return x > 255 ? 255 : x;
+}
+
+// clocks used by init_camera_pins() and init_camera(), the defaults are
+// the original MCLK = sys / 8 (18.75MHz at 150MHz) and CLKRC prescale 2
+static clockPlan_t camClock = {
+    .sysKhz = 0, // leave the system clock alone
+    .mclkDiv = 2,
+    .mclkWrap = 3,
+    .clkrc = 1,
+    .dblv = 0,
+    .pclkShift = OV7670_SIZE_DIV8,
+};
+
+// row projection, called from the ISR as bytes arrive. Same sums as
+// convertImage() and findLine() but nothing is kept past the current row.
+static inline void projectByte(uint8_t d){
+    if ((vsCount & 1) == 1){
+        projLow = d; // low byte GGGBBBBB comes first
+        return;
+    }
+    int x = (vsCount >> 1) - 1;
+    uint16_t mass;
+    if (flatGain){
+        uint8_t gain = flatGain[projRows*IMAGESIZEX + x];
+        mass = flatApply((d>>3)<<3, gain) + flatApply((((d&0b111)<<3) | projLow>>5)<<2, gain)
+            + flatApply((projLow&0b11111)<<3, gain);
+    } else {
+        mass = ((d>>3)<<3) + ((((d&0b111)<<3) | projLow>>5)<<2) + ((projLow&0b11111)<<3);
+    }
+    projMass[x] = mass;
+    projSum += mass;
+}
+
+// threshold at the row mean and take the centre of the pixels above it,
+// runs in the blanking after each row
+static inline void projectEndRow(){
+    int avg = projSum / IMAGESIZEX;
+    int count = 0, sumI = 0, i;
+    for(i=0;i<IMAGESIZEX;i++){
+        if (projMass[i] >= avg){
+            count++;
+            sumI += i;
+        }
+    }
+    if (projRows < IMAGESIZEY){
+        projCenter[projRows] = count ? sumI / count : -1;
+        projRows++;
+    }
+    projSum = 0;
+}
+
+void gpio_callback(uint gpio, uint32_t events) {
+    if (gpio == VS){
+        //printf("v\n");
+        if (saveImage==1){
+            //printf("v\n");
+            rawIndex = 0;
+            hsCount = 0;
+            vsCount = 0;
+            startImage = 1;
+            startCollect = 0;
+            projRows = 0;
+            projSum = 0;
+        }
+    }
+    if (gpio == HS){
+        //printf("h");
+        if(saveImage){
+            if (startImage){
+                startCollect = 1;
+                hsCount++;
+                if (hsCount == IMAGESIZEY){
+                    //printf("%d",hsCount);
+                    saveImage = 0;
+                    startImage = 0;
+                    startCollect = 0;
+                    hsCount = 0;
+                }
+            }
+        }
+    }
+    if (gpio == PCLK){
+        if(saveImage){
+            if(startImage){
+                if(startCollect){
+                    vsCount++;
+                    // read the raw data
+                    uint32_t d = gpio_get_all();
+                    if (lineDetector == LINE_DETECTOR_PROJECTION){
+                        projectByte(d & 0xFF);
+                    } else {
+                        cameraData[rawIndex] = d & 0xFF;
+                    }
+                    rawIndex++;
+                    if (rawIndex == IMAGESIZEX*IMAGESIZEY*2){
+                        saveImage = 0;
+                        startImage = 0;
+                        startCollect = 0;
+                    }
+                    if (vsCount == IMAGESIZEX*2){
+                        startCollect = 0;
+                        vsCount = 0;
+                        if (lineDetector == LINE_DETECTOR_PROJECTION){
+                            projectEndRow();
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// setup the camera pins
+void init_camera_pins(){
+    // 8 data pins
+    gpio_init(D0);
+    gpio_set_dir(D0, GPIO_IN);
+    gpio_init(D1);
+    gpio_set_dir(D1, GPIO_IN);
+    gpio_init(D2);
+    gpio_set_dir(D2, GPIO_IN);
+    gpio_init(D3);
+    gpio_set_dir(D3, GPIO_IN);
+    gpio_init(D4);
+    gpio_set_dir(D4, GPIO_IN);
+    gpio_init(D5);
+    gpio_set_dir(D5, GPIO_IN);
+    gpio_init(D6);
+    gpio_set_dir(D6, GPIO_IN);
+    gpio_init(D7);
+    gpio_set_dir(D7, GPIO_IN);
+
+    gpio_init(RST); // reset pin
+    gpio_set_dir(RST, GPIO_OUT);
+    gpio_put(RST, 1);
+
+    gpio_init(PWDN); // powerdown pin
+    gpio_set_dir(PWDN, GPIO_OUT);
+    gpio_put(PWDN, 0);
+
+    // system clock and 50% MCLK from the clock plan, see setClockPlan()
+    clockplanApply(&camClock, MCLK);
+    clockplanTiming(&camClock, OV7670_SIZE_DIV8); // frame time for the watchdog
+
+    sleep_ms(1000); // give the camera time to get going
+
+    // powerdown and restart
+    gpio_put(PWDN, 1);
+    sleep_ms(1);
+    gpio_put(PWDN, 0);
+    sleep_ms(1000);
+
+    // I2C Initialisation. Using it at 100Khz.
+    i2c_init(I2C_PORT, 100*1000);
+    gpio_set_function(I2C_SDA, GPIO_FUNC_I2C);
+    gpio_set_function(I2C_SCL, GPIO_FUNC_I2C);
+    gpio_pull_up(I2C_SDA);
+    gpio_pull_up(I2C_SCL);
+    
+    printf("Start init camera\n");
+    init_camera();
+    printf("End init camera\n");
+
+    // interrupts
+    gpio_init(VS); // vertical sync
+    gpio_set_dir(VS, GPIO_IN);
+    // new image starts on falling VS
+    gpio_set_irq_enabled_with_callback(VS, GPIO_IRQ_EDGE_FALL, true, &gpio_callback);
+
+    gpio_init(HS); // horizontal sync
+    gpio_set_dir(HS, GPIO_IN);
+    // new row starts on rising HS
+    gpio_set_irq_enabled_with_callback(HS, GPIO_IRQ_EDGE_RISE, true, &gpio_callback);
+
+    gpio_init(PCLK); // pixel clock
+    gpio_set_dir(PCLK, GPIO_IN);
+    // read byte on rising PCLK
+    gpio_set_irq_enabled_with_callback(PCLK, GPIO_IRQ_EDGE_RISE, true, &gpio_callback);
+}
+
+// use a plan from clockplanMake(), call before init_camera_pins()
+void setClockPlan(const clockPlan_t *plan){
+    camClock = *plan;
+}
+
+const clockPlan_t *getClockPlan(){
+    return &camClock;
+}
+
+// switch MCLK to the PWM at sys clock / (div * 4), for captest
+void setMclkDivider(float div){
+    gpio_set_function(MCLK, GPIO_FUNC_PWM);
+    uint slice_num = pwm_gpio_to_slice_num(MCLK);
+    pwm_set_clkdiv(slice_num, div);
+    pwm_set_wrap(slice_num, 3);
+    pwm_set_gpio_level(MCLK, 2);
+}
+
+// init the camera with RST and I2C commands
+void init_camera(){
+    // hardware reset the camera
+    gpio_put(RST, 0);
+    sleep_ms(1);
+    gpio_put(RST, 1);
+    sleep_ms(1000);
+
+    OV7670_write_register(0x12, 0x80); // software reset
+    sleep_ms(1000);
+
+    // perform all the I2C writes for init
+    // MCLK * PLL / prescale, picked by the clock plan
+    OV7670_write_register(OV7670_REG_CLKRC, camClock.clkrc);
+    OV7670_write_register(OV7670_REG_DBLV, camClock.dblv);
+
+    int i = 0;
+
+    // init regular registers
+    for(i=0; i<92; i++){
+        OV7670_write_register(OV7670_init[i][0],OV7670_init[i][1]);
+    }
+
+    // set colorspace to RGB565
+    for(i=0; i<12; i++){
+        OV7670_write_register(OV7670_rgb[i][0],OV7670_rgb[i][1]);
+    }
+
+    // init image size
+    
+    // Window settings were tediously determined empirically.
+    // I hope there's a formula for this, if a do-over is needed.
+    //{vstart,hstart,edge_offset,pclk_delay}
+            //{9, 162, 2, 2},  // SIZE_DIV1  640x480 VGA
+            //{10, 174, 4, 2}, // SIZE_DIV2  320x240 QVGA
+            //{11, 186, 2, 2}, // SIZE_DIV4  160x120 QQVGA
+            //{12, 210, 0, 2}, // SIZE_DIV8  80x60   ...
+            //{15, 252, 3, 2}, // SIZE_DIV16 40x30
+
+    uint8_t value;
+    uint8_t size = OV7670_SIZE_DIV8; // 80x60
+    uint16_t vstart = 12;
+    uint16_t hstart = 210;
+    uint16_t edge_offset = 0;
+    uint16_t pclk_delay = 2;
+
+    // Enable downsampling if sub-VGA, and zoom if 1:16 scale
+    value = (size > OV7670_SIZE_DIV1) ? OV7670_COM3_DCWEN : 0;
+    if (size == OV7670_SIZE_DIV16)
+    value |= OV7670_COM3_SCALEEN;
+    OV7670_write_register(OV7670_REG_COM3, value);
+
+    // Enable PCLK division if sub-VGA 2,4,8,16 = 0x19,1A,1B,1C
+    // the plan can divide less than the downsample, never more
+    uint8_t pclk_shift = (camClock.pclkShift < size) ? camClock.pclkShift : size;
+    value = (size > OV7670_SIZE_DIV1) ? (0x18 + pclk_shift) : 0;
+    OV7670_write_register(OV7670_REG_COM14, value);
+
+    // Horiz/vert downsample ratio, 1:8 max (H,V are always equal for now)
+    value = (size <= OV7670_SIZE_DIV8) ? size : OV7670_SIZE_DIV8;
+    OV7670_write_register(OV7670_REG_SCALING_DCWCTR, value * 0x11);
+
+    // Pixel clock divider if sub-VGA
+    value = (size > OV7670_SIZE_DIV1) ? (0xF0 + pclk_shift) : 0x08;
+    OV7670_write_register(OV7670_REG_SCALING_PCLK_DIV, value);
+
+    // Apply 0.5 digital zoom at 1:16 size (others are downsample only)
+    value = (size == OV7670_SIZE_DIV16) ? 0x40 : 0x20; // 0.5, 1.0
+    // Read current SCALING_XSC and SCALING_YSC register values because
+    // test pattern settings are also stored in those registers and we
+    // don't want to corrupt anything there.
+
+    uint8_t xsc = OV7670_read_register(OV7670_REG_SCALING_XSC);
+    uint8_t ysc = OV7670_read_register(OV7670_REG_SCALING_YSC);
+
+    xsc = (xsc & 0x80) | value; // Modify only scaling bits (not test pattern)
+    ysc = (ysc & 0x80) | value;
+    // Write modified result back to SCALING_XSC and SCALING_YSC
+    OV7670_write_register(OV7670_REG_SCALING_XSC, xsc);
+    OV7670_write_register(OV7670_REG_SCALING_YSC, ysc);
+
+    // Window size is scattered across multiple registers.
+    // Horiz/vert stops can be automatically calc'd from starts.
+    uint16_t vstop = vstart + 480;
+    uint16_t hstop = (hstart + 640) % 784;
+    OV7670_write_register(OV7670_REG_HSTART, hstart >> 3);
+    OV7670_write_register(OV7670_REG_HSTOP, hstop >> 3);
+    OV7670_write_register(OV7670_REG_HREF,(edge_offset << 6) | ((hstop & 0b111) << 3) | (hstart & 0b111));
+    OV7670_write_register(OV7670_REG_VSTART, vstart >> 2);
+    OV7670_write_register(OV7670_REG_VSTOP, vstop >> 2);
+    OV7670_write_register(OV7670_REG_VREF, ((vstop & 0b11) << 2) | (vstart & 0b11));
+    OV7670_write_register(OV7670_REG_SCALING_PCLK_DELAY, pclk_delay);
+
+    sleep_ms(300); // allow camera to settle with new settings 
+
+    //OV7670_test_pattern(OV7670_TEST_PATTERN_NONE);
+    //OV7670_test_pattern(OV7670_TEST_PATTERN_COLOR_BAR);
+    //sleep_ms(300);
+
+    uint8_t p = OV7670_read_register(OV7670_REG_PID);
+    printf("pid = %d (118)\n",p);
+
+    uint8_t v = OV7670_read_register(OV7670_REG_VER);
+    printf("ver = %d (115)\n",v);
+}
+
+// Selects one of the camera's test patterns (or disable).
+// See Adafruit_OV7670.h for notes about minor visual bug here.
+void OV7670_test_pattern(OV7670_pattern pattern) {
+    // Read current SCALING_XSC and SCALING_YSC register settings,
+    // so image scaling settings aren't corrupted.
+    uint8_t xsc = OV7670_read_register(OV7670_REG_SCALING_XSC);
+    uint8_t ysc = OV7670_read_register(OV7670_REG_SCALING_YSC);
+    if (pattern & 1) {
+      xsc |= 0x80;
+    } else {
+      xsc &= ~0x80;
+    }
+    if (pattern & 2) {
+      ysc |= 0x80;
+    } else {
+      ysc &= ~0x80;
+    }
+    // Write modified results back to SCALING_XSC and SCALING_YSC registers
+    OV7670_write_register(OV7670_REG_SCALING_XSC, xsc);
+    OV7670_write_register(OV7670_REG_SCALING_YSC, ysc);
+  }
+
+// I2C write to the camera
+void OV7670_write_register(uint8_t reg, uint8_t value){
+    uint8_t buf[2];
+    buf[0] = reg;
+    buf[1] = value;
+    i2c_write_blocking(I2C_PORT, OV7670_ADDR, buf, 2, false);
+    sleep_ms(1); // after each
+}
+
+// I2C read from the camera
+uint8_t OV7670_read_register(uint8_t reg){
+    uint8_t buf;
+    i2c_write_blocking(I2C_PORT, OV7670_ADDR, &reg, 1, false);  // true to keep master control of bus
+    i2c_read_blocking(I2C_PORT, OV7670_ADDR, &buf, 1, false);  // false - finished with bus
+    return buf;
+}
+
+// save an image
+void setSaveImage(uint32_t s){
+    if (s){
+        edgeReset(); // new frame, start the edge rows over
+    }
+    saveImage = s;
+}
+
+// see if you are supposed to be saving an image
+uint32_t getSaveImage(){
+    return saveImage;
+}
+
+static captureStats_t captureStats;
+
+// drop whatever the ISR was in the middle of
+void captureReset(){
+    saveImage = 0;
+    startImage = 0;
+    startCollect = 0;
+    rawIndex = 0;
+    hsCount = 0;
+    vsCount = 0;
+}
+
+// how long a frame may take from setSaveImage(1), from the clock plan
+uint32_t captureDeadlineUs(){
+    if (camClock.frameUs){
+        return CAPTURE_DEADLINE_FRAMES * camClock.frameUs;
+    }
+    return CAPTURE_DEADLINE_US;
+}
+
+// capture one frame, calling poll (if not NULL) while waiting.
+// Returns CAPTURE_OK or what the watchdog had to do.
+int captureFrame(void (*poll)(void)){
+    uint64_t deadline = time_us_64() + captureDeadlineUs();
+    setSaveImage(1);
+    while (getSaveImage() == 1){
+        if (poll){
+            poll();
+        }
+        if (time_us_64() > deadline){
+            captureReset();
+            captureStats.timeouts++;
+            captureStats.failStreak++;
+            if (captureStats.failStreak % CAPTURE_SENSOR_RESET_AFTER == 0){
+                // the sensor has stopped, start it over
+                captureStats.sensorResets++;
+                init_camera();
+                return CAPTURE_SENSOR_RESET;
+            }
+            return CAPTURE_TIMEOUT;
+        }
+        tight_loop_contents();
+    }
+    // the ISR ends on the IMAGESIZEY'th HS, an extra HS ends it short
+    if (rawIndex < (IMAGESIZEY-1)*IMAGESIZEX*2){
+        captureStats.shortFrames++;
+        return CAPTURE_SHORT;
+    }
+    captureStats.frames++;
+    captureStats.failStreak = 0;
+    return CAPTURE_OK;
+}
+
+const captureStats_t *getCaptureStats(){
+    return &captureStats;
+}
+
+// the raw RGB565 bytes of the last capture
+const volatile uint8_t *getCameraData(){
+    return cameraData;
+}
+
+// how many rows were counted, should be IMAGESIZEY
+uint32_t getHSCount(){
+    return hsCount;
+}
+
+// how many pixels were counted times 2, should be 2*IMAGESIZEX*IMAGESIZEY
+uint32_t getPixelCount(){
+    return rawIndex;
+}
+
+// copy a recorded raw frame into cameraData, same byte order as the ISR
+// stores it, so it can be replayed through convertImage() and findLine()
+void loadRawImage(const uint8_t *raw){
+    int i = 0;
+    for(i=0;i<IMAGESIZEX*IMAGESIZEY*2;i++){
+        cameraData[i] = raw[i];
+    }
+    rawIndex = IMAGESIZEX*IMAGESIZEY*2; // looks like a finished capture
+    edgeReset();
+}
+
+// convert the raw image to RGB
+// https://blog.usedbytes.com/2022/02/pico-pio-camera/
+void convertImage(){
+    picture.index = 0;
+    int i = 0;
+    if (flatGain){
+        // same as below with the flat field gain folded in
+        for(i=0;i<IMAGESIZEX*IMAGESIZEY*2;i=i+2){
+            uint8_t gain = flatGain[picture.index];
+            picture.r[picture.index] = flatApply((cameraData[i+1]>>3)<<3, gain);
+            picture.g[picture.index] = flatApply((((cameraData[i+1]&0b111)<<3) | cameraData[i]>>5)<<2, gain);
+            picture.b[picture.index] = flatApply((cameraData[i]&0b11111)<<3, gain);
+            picture.index++;
+        }
+        return;
+    }
+    for(i=0;i<IMAGESIZEX*IMAGESIZEY*2;i=i+2){
+        
+        picture.r[picture.index] = (cameraData[i+1]>>3)<<3;
+        picture.g[picture.index] = (((cameraData[i+1]&0b111)<<3) | cameraData[i]>>5)<<2;
+        picture.b[picture.index] = (cameraData[i]&0b11111)<<3;
+        picture.index++;
+    }
+}
+
+// use a flat field gain table (IMAGESIZEX*IMAGESIZEY, FLAT_ONE = 1.0) in
+// convertImage(), getLumaRow() and the projection ISR, NULL turns it off
+void setFlatField(const uint8_t *gain){
+    flatGain = gain;
+}
+
+const uint8_t *getFlatField(){
+    return flatGain;
+}
+
+// threshold and then find the center of mass of a row
+int findLine(int row){
+    int pos = 0;
+    int r = row*IMAGESIZEX; // find the index of the start of the row in the pixel array
+    int sumMass = 0;
+    int sumMassR = 0;
+
+    int i;
+
+    // find the row average brightness
+    int sumBright = 0;
+    for(i=0;i<IMAGESIZEX;i++){
+        sumBright = sumBright + picture.r[r+i] + picture.g[r+i] + picture.b[r+i];
+    }
+    int avgBright = sumBright / IMAGESIZEX;
+
+    // threshold the row
+    for(i=0;i<IMAGESIZEX;i++){
+        int mass = picture.r[r+i] + picture.g[r+i] + picture.b[r+i];
+        if (mass < avgBright){
+            // not bright enough, set pixel to black
+            picture.r[r+i] = 0;
+            picture.g[r+i] = 0;
+            picture.b[r+i] = 0;
+        }
+        else {
+            // set to white
+            picture.r[r+i] = 255;
+            picture.g[r+i] = 255;
+            picture.b[r+i] = 255;
+        }
+    }
+
+    // calculate the center of mass of the thresholded row
+    for(i=0;i<IMAGESIZEX;i++){
+        int mass = picture.r[r+i] + picture.g[r+i] + picture.b[r+i];
+        sumMass = sumMass + mass;
+        sumMassR = sumMassR + mass*i;
+    }
+    float centerOfMass = (float)sumMassR / sumMass;
+    return (int)(centerOfMass);
+}
+
+// change the color of a pixel for visualization purposes
+void setPixel(int row, int col, uint8_t r, uint8_t g, uint8_t b){
+    int index = row*IMAGESIZEX+col;
+    picture.r[index] = r;
+    picture.g[index] = g;
+    picture.b[index] = b;
+}
+
+// print out the image to computer
+void printImage(){
+    int i = 0;
+    for(i=0;i<IMAGESIZEX*IMAGESIZEY;i++){
+        printf("%d %d %d %d\r\n", i, picture.r[i], picture.g[i], picture.b[i]);
+    }
+}
+
+// === Edge based line finder ===
+// Works on luma straight from cameraData, one row at a time, so it can run
+// while the rest of the frame is still being captured. A 3 row ring buffer
+// holds the luma rows the 3x3 Sobel kernel needs.
+
+static uint8_t edgeLuma[3][IMAGESIZEX]; // ring buffer of luma rows
+static int edgeRowsIn = 0; // rows pushed into the ring so far
+static int16_t edgeCenter[IMAGESIZEY]; // line centre per row, -1 if none
+static int16_t edgeWidth[IMAGESIZEY]; // line width per row in pixels
+
+void setLineDetector(int d){
+    lineDetector = d;
+}
+
+int getLineDetector(){
+    return lineDetector;
+}
+
+// forget all rows, call before a new frame arrives
+void edgeReset(){
+    edgeRowsIn = 0;
+}
+
+// one row of cameraData as 8 bit luma, Y = (77R + 150G + 29B) / 256,
+// flat field corrected if there is a gain table
+void getLumaRow(int row, uint8_t *dst){
+    int i;
+    int raw = row*IMAGESIZEX*2;
+    const uint8_t *gain = flatGain ? &flatGain[row*IMAGESIZEX] : NULL;
+    for(i=0;i<IMAGESIZEX;i++){
+        uint8_t lo = cameraData[raw+2*i];
+        uint8_t hi = cameraData[raw+2*i+1];
+        int r = hi & 0xF8;
+        int g = (((hi & 0b111) << 3) | (lo >> 5)) << 2;
+        int b = (lo & 0b11111) << 3;
+        int y = (77*r + 150*g + 29*b) >> 8;
+        dst[i] = gain ? flatApply(y, gain[i]) : (uint8_t)y;
+    }
+}
+
+// horizontal Sobel on the middle row, then pair a rising edge (left side of
+// the bright line) with the falling edge that follows it
+static void edgeScanRow(int row, const uint8_t *up, const uint8_t *mid, const uint8_t *down){
+    int16_t gx[IMAGESIZEX];
+    int i;
+    int maxGrad = 0;
+
+    gx[0] = 0;
+    gx[IMAGESIZEX-1] = 0;
+    for(i=1;i<IMAGESIZEX-1;i++){
+        int g = (up[i+1] - up[i-1]) + 2*(mid[i+1] - mid[i-1]) + (down[i+1] - down[i-1]);
+        gx[i] = (int16_t)g;
+        if (g < 0) g = -g;
+        if (g > maxGrad) maxGrad = g;
+    }
+
+    // only keep edges at least half as strong as the strongest in the row
+    int thresh = maxGrad / 2;
+    if (thresh < EDGE_MIN_GRAD) thresh = EDGE_MIN_GRAD;
+
+    int bestScore = 0;
+    int bestRise = -1;
+    int bestFall = -1;
+    int rise = -1;
+    for(i=1;i<IMAGESIZEX-1;i++){
+        int g = gx[i];
+        if (g >= thresh && g >= gx[i-1] && g > gx[i+1]){
+            rise = i; // newest rising edge wins, older ones had no partner
+        }
+        else if (g <= -thresh && g <= gx[i-1] && g < gx[i+1] && rise >= 0){
+            if (i - rise <= EDGE_MAX_WIDTH){
+                int score = gx[rise] - g;
+                if (score > bestScore){
+                    bestScore = score;
+                    bestRise = rise;
+                    bestFall = i;
+                }
+            }
+            rise = -1;
+        }
+    }
+
+    if (bestRise < 0){
+        edgeCenter[row] = -1;
+        edgeWidth[row] = 0;
+    }
+    else {
+        edgeCenter[row] = (int16_t)((bestRise + bestFall + 1) / 2);
+        edgeWidth[row] = (int16_t)(bestFall - bestRise);
+    }
+}
+
+// convert the next captured row to luma and finish the row above it
+void edgePushRow(){
+    int row = edgeRowsIn;
+    if (row >= IMAGESIZEY){
+        return;
+    }
+    getLumaRow(row, edgeLuma[row%3]);
+    if (row >= 1){
+        int m = row - 1;
+        int u = (m == 0) ? m : m - 1; // repeat the top row at the border
+        edgeScanRow(m, edgeLuma[u%3], edgeLuma[m%3], edgeLuma[row%3]);
+    }
+    if (row == IMAGESIZEY-1){
+        edgeScanRow(row, edgeLuma[(row-1)%3], edgeLuma[row%3], edgeLuma[row%3]);
+    }
+    edgeRowsIn++;
+}
+
+// process every row the capture has finished so far, safe to call while
+// waiting on getSaveImage()
+void edgeProcessAvailableRows(){
+    uint32_t rows;
+    if (saveImage && !startImage){
+        return; // waiting for VS, rawIndex is still from the last frame
+    }
+    rows = rawIndex / (IMAGESIZEX*2);
+    while (edgeRowsIn < (int)rows){
+        edgePushRow();
+    }
+}
+
+// line centre of a row from the edge finder, -1 if no line was found
+// width gets the distance between the two edges, can be NULL
+int findLineEdges(int row, int *width){
+    edgeProcessAvailableRows();
+    if (row >= edgeRowsIn - 1 && edgeRowsIn < IMAGESIZEY){
+        return -1; // row not finished yet
+    }
+    if (width){
+        *width = edgeWidth[row];
+    }
+    return edgeCenter[row];
+}
+
+// line centre the ISR found for a row of the last frame, -1 if the row
+// didn't arrive
+int findLineProjection(int row){
+    if (row < 0 || row >= projRows){
+        return -1;
+    }
+    return projCenter[row];
+}
+
+int getProjectionRows(){
+    return projRows;
+}
+
+// line centre of a row using the selected detector
+int detectLine(int row){
+    if (lineDetector == LINE_DETECTOR_EDGE){
+        return findLineEdges(row, NULL);
+    }
+    if (lineDetector == LINE_DETECTOR_PROJECTION){
+        return findLineProjection(row);
+    }
+    return findLine(row);
+}
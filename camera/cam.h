@@ -0,0 +1,121 @@
+#ifndef CAM_h
+#define CAM_h
+
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/i2c.h"
+#include "hardware/gpio.h"
+#include "hardware/pwm.h"
+#include "ov7670.h"
+#include "clockplan.h"
+
+// I2C defines
+#define I2C_PORT i2c1
+#define I2C_SDA 14
+#define I2C_SCL 15
+
+// pins
+// D0-D7 on GP0-GP7
+#define D0 0
+#define D1 1
+#define D2 2
+#define D3 3
+#define D4 4
+#define D5 5
+#define D6 6
+#define D7 7
+// VS on GP8
+#define VS 8
+// HS on GP9
+#define HS 9
+// MCLK on GP10, set 50% 25MHz PWM
+#define MCLK 10
+// PCLK on GP11
+#define PCLK 11
+// RST to GP12
+#define RST 12
+// PWDN to GP13
+#define PWDN 13
+
+// RGB565 example:
+// https://blog.usedbytes.com/2022/02/pico-pio-camera/
+
+void init_camera_pins();
+void init_camera();
+void setClockPlan(const clockPlan_t *plan);
+const clockPlan_t *getClockPlan();
+void setMclkDivider(float div);
+void setSaveImage(uint32_t);
+uint32_t getSaveImage();
+
+// capture watchdog, a frame that isn't in by its deadline soft resets the
+// capture, CAPTURE_SENSOR_RESET_AFTER in a row re-runs init_camera()
+#define CAPTURE_OK 0
+#define CAPTURE_TIMEOUT 1 // no frame by the deadline, capture was reset
+#define CAPTURE_SENSOR_RESET 2 // too many timeouts, init_camera() was re-run
+#define CAPTURE_SHORT 3 // frame ended early, a glitch on HS
+#define CAPTURE_DEADLINE_FRAMES 3 // wait for the VS, the frame and a spare
+#define CAPTURE_DEADLINE_US 500000 // when the frame time isn't known
+#define CAPTURE_SENSOR_RESET_AFTER 3
+typedef struct captureStats {
+    uint32_t frames; // good frames
+    uint32_t shortFrames;
+    uint32_t timeouts; // soft resets of the capture state
+    uint32_t sensorResets; // init_camera() re-runs
+    uint32_t failStreak; // timeouts since the last good frame
+} captureStats_t;
+void captureReset();
+uint32_t captureDeadlineUs();
+int captureFrame(void (*poll)(void));
+const captureStats_t *getCaptureStats();
+uint32_t getHSCount();
+uint32_t getPixelCount();
+const volatile uint8_t *getCameraData();
+void convertImage();
+#define FLAT_SHIFT 6 // flat field gains are Q6, up to 4x
+#define FLAT_ONE (1 << FLAT_SHIFT)
+void setFlatField(const uint8_t *gain);
+const uint8_t *getFlatField();
+void loadRawImage(const uint8_t *raw);
+void getLumaRow(int row, uint8_t *dst);
+void printImage();
+int findLine(int row);
+
+// line detectors, pick one at runtime with setLineDetector()
+#define LINE_DETECTOR_CENTROID 0 // threshold at the row mean, then centre of mass
+#define LINE_DETECTOR_EDGE 1 // Sobel edges, pairs rising and falling edges
+#define LINE_DETECTOR_PROJECTION 2 // findLine() in the capture ISR, no frame stored
+#define EDGE_MIN_GRAD 48 // smallest Sobel response counted as an edge
+#define EDGE_MAX_WIDTH (IMAGESIZEX/4) // widest line accepted, in pixels
+void setLineDetector(int d);
+int getLineDetector();
+int detectLine(int row);
+void edgeReset();
+void edgePushRow();
+void edgeProcessAvailableRows();
+int findLineEdges(int row, int *width);
+int findLineProjection(int row);
+int getProjectionRows();
+void setPixel(int row, int col, uint8_t r, uint8_t g, uint8_t b);
+
+// can be overridden from the build, e.g. the host benchmark at 160x120
+#ifndef IMAGESIZEX
+#define IMAGESIZEX 80
+#endif
+#ifndef IMAGESIZEY
+#define IMAGESIZEY 60
+#endif
+
+typedef struct cameraImage{
+    uint32_t index;
+    uint8_t r[IMAGESIZEX*IMAGESIZEY];
+    uint8_t g[IMAGESIZEX*IMAGESIZEY];
+    uint8_t b[IMAGESIZEX*IMAGESIZEY];
+} cameraImage_t;
+
+// I2C functions
+void OV7670_write_register(uint8_t reg, uint8_t value);
+uint8_t OV7670_read_register(uint8_t reg);
+void OV7670_test_pattern(OV7670_pattern pattern);
+
+#endif
\ No newline at end of file
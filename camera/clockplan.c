@@ -0,0 +1,182 @@
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "hardware/pwm.h"
+#include "hardware/clocks.h"
+#include "clockplan.h"
+
+static const uint8_t clockplanPll[4] = {1, 4, 6, 8}; // DBLV bits 7:6
+
+// same search as the SDK's check_sys_clock_khz(), 0 if sysKhz can't be made
+int clockplanSysPll(uint32_t sysKhz, clockPlan_t *plan){
+    int fbdiv, pd1, pd2;
+    for(fbdiv=320;fbdiv>=16;fbdiv--){
+        uint32_t vco = fbdiv * CLOCKPLAN_XOSC_KHZ;
+        if (vco < 750000 || vco > 1600000){
+            continue;
+        }
+        for(pd1=7;pd1>=1;pd1--){
+            for(pd2=pd1;pd2>=1;pd2--){
+                if (vco % (pd1*pd2) == 0 && vco / (pd1*pd2) == sysKhz){
+                    plan->fbdiv = fbdiv;
+                    plan->postdiv1 = pd1;
+                    plan->postdiv2 = pd2;
+                    return 1;
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+// OV7670 internal clock = MCLK * PLL / (CLKRC prescale + 1)
+uint32_t clockplanInternalHz(uint32_t mclkHz, uint8_t clkrc, uint8_t dblv){
+    if (clkrc & 0x40){
+        return mclkHz; // external clock used directly
+    }
+    return (uint64_t)mclkHz * clockplanPll[dblv >> 6] / ((clkrc & 0x3F) + 1);
+}
+
+// fill in the clocks and frame timing from the settings in the plan, a
+// plan that leaves the system clock alone is timed at the current one
+void clockplanTiming(clockPlan_t *plan, int size){
+    uint32_t sysHz = plan->sysKhz ? plan->sysKhz * 1000 : clock_get_hz(clk_sys);
+    uint32_t period = plan->mclkDiv * (plan->mclkWrap + 1);
+    plan->mclkHz = sysHz / period;
+    plan->internalHz = clockplanInternalHz(plan->mclkHz, plan->clkrc, plan->dblv);
+    plan->pclkHz = plan->internalHz >> plan->pclkShift;
+    plan->maxPclkHz = sysHz / CLOCKPLAN_CAPTURE_CYCLES;
+    if (plan->internalHz == 0){
+        plan->frameUs = plan->lineUs = plan->rowBurstUs = 0;
+        return;
+    }
+    plan->lineUs = (uint64_t)CLOCKPLAN_LINE_CLOCKS * 1000000 / plan->internalHz;
+    plan->frameUs = (uint64_t)CLOCKPLAN_LINE_CLOCKS * CLOCKPLAN_FRAME_LINES * 1000000 / plan->internalHz;
+    plan->rowBurstUs = (uint64_t)(640 >> size) * 2 * 1000000 / plan->pclkHz;
+}
+
+// how far a candidate is from ideal: frame rate error first, then using
+// the sensor PLL, then MCLK away from the 24MHz the sensor is specified at
+typedef struct clockplanScore {
+    uint32_t fpsErr;
+    uint32_t pll;
+    uint32_t mclkErr;
+} clockplanScore_t;
+
+static int clockplanBetter(const clockplanScore_t *a, const clockplanScore_t *b){
+    if (a->fpsErr != b->fpsErr) return a->fpsErr < b->fpsErr;
+    if (a->pll != b->pll) return a->pll < b->pll;
+    return a->mclkErr < b->mclkErr;
+}
+
+// try every sensor PLL and prescale for one MCLK, keep it in best if it
+// scores better. Ties go to the earlier candidate, so the faster system clock.
+static void clockplanTry(clockPlan_t *cand, clockPlan_t *best, clockplanScore_t *bestScore, uint32_t fpsMilli, int size){
+    uint32_t sysHz = cand->sysKhz * 1000;
+    uint32_t period = cand->mclkDiv * (cand->mclkWrap + 1);
+    uint32_t mclk = sysHz / period;
+    uint32_t maxPclk = sysHz / CLOCKPLAN_CAPTURE_CYCLES;
+    uint64_t maxInternal = (uint64_t)maxPclk << size;
+    uint64_t wantInternal = (uint64_t)fpsMilli * CLOCKPLAN_LINE_CLOCKS * CLOCKPLAN_FRAME_LINES / 1000;
+    int p, c, k;
+    if (mclk < CLOCKPLAN_MCLK_MIN_HZ || mclk > CLOCKPLAN_MCLK_MAX_HZ){
+        return;
+    }
+    if (maxInternal > CLOCKPLAN_INTERNAL_MAX_HZ){
+        maxInternal = CLOCKPLAN_INTERNAL_MAX_HZ;
+    }
+    for(p=0;p<4;p++){
+        uint64_t pllHz = (uint64_t)mclk * clockplanPll[p];
+        // prescale that lands nearest the wanted internal clock and the one
+        // above it, but never fast enough to outrun the sensor or the capture
+        int guess = (int)((pllHz + wantInternal / 2) / wantInternal) - 1;
+        int slowest = (int)((pllHz + maxInternal - 1) / maxInternal) - 1;
+        if (guess < slowest){
+            guess = slowest;
+        }
+        for(k=0;k<2;k++){
+            c = guess + k;
+            if (c < 0 || c > 0x3F){
+                continue;
+            }
+            uint32_t internal = pllHz / (c + 1);
+            uint32_t fps = (uint64_t)internal * 1000 / (CLOCKPLAN_LINE_CLOCKS * CLOCKPLAN_FRAME_LINES);
+            clockplanScore_t score;
+            score.fpsErr = fps > fpsMilli ? fps - fpsMilli : fpsMilli - fps;
+            score.pll = p != 0;
+            score.mclkErr = mclk > 24000000 ? mclk - 24000000 : 24000000 - mclk;
+            if (clockplanBetter(&score, bestScore)){
+                *bestScore = score;
+                *best = *cand;
+                best->clkrc = c;
+                best->dblv = p << 6;
+            }
+        }
+    }
+}
+
+// plan the clocks for fpsMilli (frames per 1000 s) at an OV7670_SIZE_*,
+// system clock up to sysMaxKhz.
+// Returns 0, or -1 if no setting captures reliably.
+int clockplanMake(clockPlan_t *plan, uint32_t fpsMilli, int size, uint32_t sysMaxKhz){
+    clockPlan_t cand = {0}, best = {0};
+    clockplanScore_t bestScore = {UINT32_MAX, 0, 0};
+    uint32_t khz;
+    int n;
+
+    // DCW divides PCLK by up to the downsample factor, always use all of it
+    cand.pclkShift = size;
+    for(khz=sysMaxKhz;khz>=CLOCKPLAN_SYS_MIN_KHZ;khz-=1000){
+        if (!clockplanSysPll(khz, &cand)){
+            continue;
+        }
+        cand.sysKhz = khz;
+        // PWM needs an even period for 50% duty, div 1 reaches 10MHz here
+        cand.mclkDiv = 1;
+        for(n=2;n<=16;n+=2){
+            cand.mclkWrap = n - 1;
+            clockplanTry(&cand, &best, &bestScore, fpsMilli, size);
+        }
+    }
+    if (bestScore.fpsErr == UINT32_MAX){
+        return -1;
+    }
+    *plan = best;
+    clockplanTiming(plan, size);
+    return 0;
+}
+
+void clockplanPrint(const clockPlan_t *plan, int size){
+    int w = 640 >> size, h = 480 >> size;
+    printf("sys %lu kHz (VCO %lu MHz / %d / %d)\n", (unsigned long)plan->sysKhz,
+        (unsigned long)(plan->fbdiv * CLOCKPLAN_XOSC_KHZ / 1000), plan->postdiv1, plan->postdiv2);
+    printf("MCLK %lu Hz from PWM, div %d wrap %d\n", (unsigned long)plan->mclkHz, plan->mclkDiv, plan->mclkWrap);
+    printf("OV7670 CLKRC 0x%02x DBLV 0x%02x (PLL x%d, prescale %d) -> internal %lu Hz\n",
+        plan->clkrc, plan->dblv, clockplanPll[plan->dblv >> 6], (plan->clkrc & 0x3F) + 1,
+        (unsigned long)plan->internalHz);
+    // PCLK keeps toggling through blanking (COM10 isn't set to stop it), so
+    // the ISR runs at this rate for the whole frame
+    printf("%dx%d, PCLK /%d = %lu Hz, capture limit %lu Hz (%d%% used)\n", w, h, 1 << plan->pclkShift,
+        (unsigned long)plan->pclkHz, (unsigned long)plan->maxPclkHz,
+        plan->maxPclkHz ? (int)((uint64_t)plan->pclkHz * 100 / plan->maxPclkHz) : 0);
+    if (plan->frameUs){
+        printf("frame %lu us (%lu.%02lu fps), line %lu us, row burst %lu us\n",
+            (unsigned long)plan->frameUs, (unsigned long)(100000000ull / plan->frameUs / 100),
+            (unsigned long)(100000000ull / plan->frameUs % 100), (unsigned long)plan->lineUs,
+            (unsigned long)plan->rowBurstUs);
+    }
+}
+
+// switch the system clock and start MCLK, the sensor registers are written
+// by init_camera()
+void clockplanApply(const clockPlan_t *plan, int mclkPin){
+    if (plan->sysKhz && clock_get_hz(clk_sys) != plan->sysKhz * 1000){
+        set_sys_clock_khz(plan->sysKhz, true);
+    }
+    gpio_set_function(mclkPin, GPIO_FUNC_PWM);
+    uint slice_num = pwm_gpio_to_slice_num(mclkPin);
+    pwm_set_clkdiv(slice_num, plan->mclkDiv);
+    pwm_set_wrap(slice_num, plan->mclkWrap);
+    pwm_set_enabled(slice_num, true);
+    pwm_set_gpio_level(mclkPin, (plan->mclkWrap + 1) / 2); // 50% duty
+}
@@ -0,0 +1,55 @@
+#ifndef CLOCKPLAN_h
+#define CLOCKPLAN_h
+
+#include <stdint.h>
+
+// Clock tree planner for the camera.
+// Picks the system clock, the PWM that makes MCLK from it and the OV7670
+// CLKRC/DBLV/PCLK divider so a frame size runs at a target rate without
+// PCLK outrunning the capture interrupt. MCLK is wired to GP10, and the
+// header's clock GPOUT pins are taken on the car (GP13 PWDN, GP15 SCL,
+// GP21 the left encoder), so PWM is the only way to make it.
+// Plain C apart from clockplanApply(), the host builds it as a CLI too.
+
+#define CLOCKPLAN_XOSC_KHZ 12000 // crystal feeding the system PLL
+#define CLOCKPLAN_SYS_MIN_KHZ 48000
+#define CLOCKPLAN_SYS_MAX_KHZ 150000 // RP2350 rated clock, overclocking is opt in
+#define CLOCKPLAN_MCLK_MIN_HZ 10000000 // OV7670 XCLK range
+#define CLOCKPLAN_MCLK_MAX_HZ 48000000
+#define CLOCKPLAN_INTERNAL_MAX_HZ 24000000 // VGA at 30fps, the sensor's top speed
+// system clock cycles allowed between PCLKs, the ISR plus time left for the
+// main loop. 128 is init_camera()'s 1.17MHz PCLK at 150MHz, which captures
+// cleanly, captest finds the real limit.
+#define CLOCKPLAN_CAPTURE_CYCLES 128
+
+// every VGA frame is 784 x 510 pixel times, 2 internal clocks per pixel
+// in RGB565, whatever the output size
+#define CLOCKPLAN_LINE_CLOCKS (784*2)
+#define CLOCKPLAN_FRAME_LINES 510
+
+typedef struct clockPlan {
+    uint32_t sysKhz; // system clock, 0 leaves it alone
+    uint16_t fbdiv; // system PLL, VCO = 12MHz * fbdiv
+    uint8_t postdiv1, postdiv2;
+    uint8_t mclkDiv; // PWM clkdiv, integer
+    uint8_t mclkWrap; // PWM period is wrap + 1 (even for 50% duty)
+    uint8_t clkrc; // OV7670 CLKRC, prescale is clkrc + 1
+    uint8_t dblv; // OV7670 DBLV, PLL x1/x4/x6/x8 in bits 7:6
+    uint8_t pclkShift; // DCW PCLK divider, PCLK = internal >> pclkShift
+    uint32_t mclkHz;
+    uint32_t internalHz; // sensor internal clock after PLL and prescale
+    uint32_t pclkHz;
+    uint32_t maxPclkHz; // what the capture ISR keeps up with at sysKhz
+    uint32_t frameUs;
+    uint32_t lineUs; // one sensor line, HS to HS
+    uint32_t rowBurstUs; // the PCLK burst of one output row
+} clockPlan_t;
+
+int clockplanSysPll(uint32_t sysKhz, clockPlan_t *plan);
+uint32_t clockplanInternalHz(uint32_t mclkHz, uint8_t clkrc, uint8_t dblv);
+void clockplanTiming(clockPlan_t *plan, int size);
+int clockplanMake(clockPlan_t *plan, uint32_t fpsMilli, int size, uint32_t sysMaxKhz);
+void clockplanPrint(const clockPlan_t *plan, int size);
+void clockplanApply(const clockPlan_t *plan, int mclkPin);
+
+#endif
@@ -0,0 +1,256 @@
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/clocks.h"
+#include "captest.h"
+
+// clock settings to try, the sweep runs them slowest PCLK first
+static const captestConfig_t captestConfigs[] = {
+    // sys kHz, MCLK div, CLKRC, DBLV, COM14, PCLK_DIV
+    {150000, 2.0f, 3, 0x00, 0x1B, 0xF3},
+    {150000, 2.0f, 2, 0x00, 0x1B, 0xF3},
+    {150000, 2.0f, 1, 0x00, 0x1B, 0xF3}, // what init_camera() sets
+    {150000, 2.0f, 7, 0x40, 0x1B, 0xF3}, // same PCLK through the x4 PLL
+    {200000, 2.0f, 1, 0x00, 0x1B, 0xF3},
+    {150000, 2.0f, 0, 0x00, 0x1B, 0xF3},
+    {150000, 2.0f, 1, 0x00, 0x1A, 0xF2}, // PCLK divided by 4 instead of 8
+    {200000, 2.0f, 0, 0x00, 0x1B, 0xF3},
+    {150000, 1.5f, 0, 0x00, 0x1B, 0xF3},
+    {200000, 2.0f, 1, 0x00, 0x1A, 0xF2},
+    {150000, 2.0f, 0, 0x00, 0x1A, 0xF2},
+};
+#define CAPTEST_NUM_CONFIGS (int)(sizeof(captestConfigs) / sizeof(captestConfigs[0]))
+
+// majority vote of the colour bar row, the bars are vertical so every
+// row should match it
+static uint8_t captestRef[IMAGESIZEX*2];
+// data lines that never toggle across the reference row
+static uint8_t captestStuck = 0;
+
+int captestNumConfigs(){
+    return CAPTEST_NUM_CONFIGS;
+}
+
+const captestConfig_t *captestGetConfig(int i){
+    return &captestConfigs[i];
+}
+
+// what PCLK the sensor should produce with these settings
+uint32_t captestPclkHz(const captestConfig_t *cfg){
+    uint32_t mclk = (uint32_t)(cfg->sysKhz * 1000.0f / (cfg->mclkDiv * 4));
+    uint32_t internal = clockplanInternalHz(mclk, cfg->clkrc, cfg->dblv);
+    if (cfg->com14 & OV7670_COM14_DCWEN){
+        internal >>= (cfg->com14 & 0x7);
+    }
+    return internal;
+}
+
+void captestApply(const captestConfig_t *cfg){
+    if (clock_get_hz(clk_sys) != cfg->sysKhz * 1000){
+        set_sys_clock_khz(cfg->sysKhz, true);
+        i2c_init(I2C_PORT, 100*1000); // the I2C divider follows clk_peri
+    }
+    setMclkDivider(cfg->mclkDiv);
+    OV7670_write_register(OV7670_REG_CLKRC, cfg->clkrc);
+    OV7670_write_register(OV7670_REG_DBLV, cfg->dblv);
+    OV7670_write_register(OV7670_REG_COM14, cfg->com14);
+    OV7670_write_register(OV7670_REG_SCALING_PCLK_DIV, cfg->pclkDiv);
+    sleep_ms(300); // allow camera to settle with new settings
+
+    int i;
+    for(i=0;i<CAPTEST_SETTLE_FRAMES;i++){
+        captestCapture();
+    }
+}
+
+// grab one frame, returns the number of whole rows in it or -1 if it timed
+// out or lost bytes. The ISR ends the frame on the IMAGESIZEY'th HS, so
+// depending on where the sensor puts HREF the last row can be missing.
+int captestCapture(){
+    uint64_t deadline = time_us_64() + CAPTEST_TIMEOUT_US;
+    setSaveImage(1);
+    while (getSaveImage() == 1){
+        if (time_us_64() > deadline){
+            captureReset();
+            return -1;
+        }
+        tight_loop_contents();
+    }
+    int count = getPixelCount();
+    if (count % (IMAGESIZEX*2) != 0 || count < (IMAGESIZEY-1)*IMAGESIZEX*2){
+        return -1;
+    }
+    return count / (IMAGESIZEX*2);
+}
+
+// vote every bit of the reference row over all rows of a few frames,
+// returns how many frames were dropped while doing it
+int captestLearnReference(){
+    static uint16_t ones[IMAGESIZEX*2][8];
+    const volatile uint8_t *data = getCameraData();
+    int f, row, i, b, rows;
+    int votes = 0, dropped = 0;
+
+    memset(ones, 0, sizeof(ones));
+    for(f=0;f<CAPTEST_REF_FRAMES;f++){
+        rows = captestCapture();
+        if (rows < 0){
+            dropped++;
+            continue;
+        }
+        for(row=0;row<rows;row++){
+            for(i=0;i<IMAGESIZEX*2;i++){
+                uint8_t d = data[row*IMAGESIZEX*2+i];
+                for(b=0;b<8;b++){
+                    ones[i][b] += (d >> b) & 1;
+                }
+            }
+            votes++;
+        }
+    }
+    for(i=0;i<IMAGESIZEX*2;i++){
+        uint8_t v = 0;
+        for(b=0;b<8;b++){
+            if (2*ones[i][b] > votes){
+                v |= 1 << b;
+            }
+        }
+        captestRef[i] = v;
+    }
+
+    // white to black covers every bit, so a line that doesn't toggle
+    // would fool the vote above, flag it instead
+    uint8_t all = 0xFF, any = 0;
+    for(i=0;i<IMAGESIZEX*2;i+=2){
+        all &= captestRef[i] & captestRef[i+1];
+        any |= captestRef[i] | captestRef[i+1];
+    }
+    captestStuck = all | (uint8_t)~any;
+    return dropped;
+}
+
+uint8_t captestStuckLines(){
+    return captestStuck;
+}
+
+// capture frames and compare every byte to the reference row
+void captestRun(int frames, captestStats_t *stats){
+    const volatile uint8_t *data = getCameraData();
+    int f, row, i, b, rows;
+    memset(stats, 0, sizeof(*stats));
+    for(f=0;f<frames;f++){
+        rows = captestCapture();
+        if (rows < 0){
+            stats->dropped++;
+            continue;
+        }
+        stats->frames++;
+        stats->bits += (uint64_t)rows*IMAGESIZEX*2*8;
+        for(row=0;row<rows;row++){
+            stats->rowBits[row] += IMAGESIZEX*2*8;
+            for(i=0;i<IMAGESIZEX*2;i++){
+                uint8_t d = data[row*IMAGESIZEX*2+i] ^ captestRef[i];
+                if (d){
+                    stats->badBytes++;
+                    stats->rowErrors[row] += __builtin_popcount(d);
+                    for(b=0;b<8;b++){
+                        stats->bitErrors[b] += (d >> b) & 1;
+                    }
+                }
+            }
+        }
+    }
+}
+
+static uint32_t captestTotalErrors(const captestStats_t *stats){
+    uint32_t total = 0;
+    int b;
+    for(b=0;b<8;b++){
+        total += stats->bitErrors[b];
+    }
+    return total;
+}
+
+void captestPrint(const captestStats_t *stats){
+    int b, row;
+    uint64_t perLine = stats->bits / 8;
+    printf("frames %lu dropped %lu bad bytes %lu bit errors %lu\n",
+        (unsigned long)stats->frames, (unsigned long)stats->dropped,
+        (unsigned long)stats->badBytes, (unsigned long)captestTotalErrors(stats));
+    for(b=0;b<8;b++){
+        printf("  D%d BER %.2e (%lu)\n", b, perLine ? (double)stats->bitErrors[b] / perLine : 0.0,
+            (unsigned long)stats->bitErrors[b]);
+    }
+    for(row=0;row<IMAGESIZEY;row++){
+        if (stats->rowErrors[row]){
+            printf("  row %d BER %.2e (%lu)\n", row, (double)stats->rowErrors[row] / stats->rowBits[row],
+                (unsigned long)stats->rowErrors[row]);
+        }
+    }
+}
+
+// try every config from the slowest PCLK up, leave the fastest one that
+// captured all frames without a single bit error applied.
+// Returns its index, or -1 if none passed (the slowest is applied then).
+int captestSweep(int frames){
+    int order[CAPTEST_NUM_CONFIGS];
+    int i, j;
+    for(i=0;i<CAPTEST_NUM_CONFIGS;i++){
+        order[i] = i;
+    }
+    // insertion sort by PCLK, lower system clock first on a tie
+    for(i=1;i<CAPTEST_NUM_CONFIGS;i++){
+        int v = order[i];
+        uint32_t p = captestPclkHz(&captestConfigs[v]);
+        for(j=i;j>0;j--){
+            const captestConfig_t *o = &captestConfigs[order[j-1]];
+            uint32_t op = captestPclkHz(o);
+            if (op < p || (op == p && o->sysKhz <= captestConfigs[v].sysKhz)){
+                break;
+            }
+            order[j] = order[j-1];
+        }
+        order[j] = v;
+    }
+
+    OV7670_test_pattern(OV7670_TEST_PATTERN_COLOR_BAR);
+    captestApply(&captestConfigs[order[0]]);
+    int dropped = captestLearnReference();
+    if (dropped){
+        printf("warning: %d frames dropped while learning the reference\n", dropped);
+    }
+    for(i=0;i<8;i++){
+        if (captestStuck & (1 << i)){
+            printf("warning: D%d never changes, stuck or open\n", i);
+        }
+    }
+
+    int best = -1;
+    static captestStats_t stats;
+    for(i=0;i<CAPTEST_NUM_CONFIGS;i++){
+        const captestConfig_t *cfg = &captestConfigs[order[i]];
+        captestApply(cfg);
+        captestRun(frames, &stats);
+        uint32_t errors = captestTotalErrors(&stats);
+        int pass = stats.dropped == 0 && errors == 0 && stats.frames > 0;
+        printf("cfg %d: sys %lu MHz MCLK div %.2f CLKRC %d DBLV 0x%02x COM14 0x%02x -> PCLK %lu kHz | BER %.2e dropped %lu %s\n",
+            order[i], (unsigned long)(cfg->sysKhz / 1000), cfg->mclkDiv, cfg->clkrc, cfg->dblv, cfg->com14,
+            (unsigned long)(captestPclkHz(cfg) / 1000), stats.bits ? (double)errors / stats.bits : 1.0,
+            (unsigned long)stats.dropped, pass ? "PASS" : "FAIL");
+        if (pass){
+            best = order[i]; // later entries are faster
+        }
+        else {
+            captestPrint(&stats);
+        }
+    }
+
+    OV7670_test_pattern(OV7670_TEST_PATTERN_NONE);
+    captestApply(&captestConfigs[best >= 0 ? best : order[0]]);
+    if (best >= 0){
+        printf("fastest stable: cfg %d, PCLK %lu kHz\n", best, (unsigned long)(captestPclkHz(&captestConfigs[best]) / 1000));
+    }
+    else {
+        printf("no config passed\n");
+    }
+    return best;
+}
@@ -0,0 +1,48 @@
+#ifndef CAPTEST_h
+#define CAPTEST_h
+
+#include <stdint.h>
+#include "cam.h"
+
+// Capture bit error rate tester.
+// Puts the OV7670 in colour bar test pattern mode, learns the pattern at
+// the slowest clocks, then captures frames and counts every bit that
+// differs, per data line and per row. Sweeping the sensor and capture
+// clocks finds the fastest setting that still captures cleanly.
+
+#define CAPTEST_REF_FRAMES 8 // frames voted into the reference row
+#define CAPTEST_TIMEOUT_US 2000000 // give up on a frame after this long
+#define CAPTEST_SETTLE_FRAMES 2 // thrown away after changing clocks
+#define CAPTEST_FRAMES 500 // frames per config in a sweep
+
+typedef struct captestConfig {
+    uint32_t sysKhz; // system clock, the GPIO ISR runs on it
+    float mclkDiv; // MCLK PWM divider, MCLK = sys / (div * 4)
+    uint8_t clkrc; // OV7670 CLKRC, internal clock prescaler
+    uint8_t dblv; // OV7670 DBLV, PLL multiplier in bits 7:6
+    uint8_t com14; // OV7670 COM14, DCW PCLK divider
+    uint8_t pclkDiv; // OV7670 SCALING_PCLK_DIV, kept equal to COM14's
+} captestConfig_t;
+
+typedef struct captestStats {
+    uint32_t frames; // frames compared
+    uint32_t dropped; // timed out or came back short
+    uint64_t bits; // bits compared
+    uint32_t badBytes;
+    uint32_t bitErrors[8]; // per data line D0-D7
+    uint32_t rowErrors[IMAGESIZEY]; // bit errors per row
+    uint32_t rowBits[IMAGESIZEY]; // bits compared per row
+} captestStats_t;
+
+int captestNumConfigs();
+const captestConfig_t *captestGetConfig(int i);
+uint32_t captestPclkHz(const captestConfig_t *cfg);
+void captestApply(const captestConfig_t *cfg);
+int captestCapture();
+int captestLearnReference();
+uint8_t captestStuckLines();
+void captestRun(int frames, captestStats_t *stats);
+void captestPrint(const captestStats_t *stats);
+int captestSweep(int frames);
+
+#endif
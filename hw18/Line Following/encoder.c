@@ -0,0 +1,44 @@
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "encoder.h"
+#include "encoder.pio.h"
+
+#define ENCODER_PIO pio0 // the camera doesn't use PIO
+
+static const uint encoderPins[ENCODER_WHEELS] = {ENCODER_LEFT_PIN, ENCODER_RIGHT_PIN};
+// the right motor is mounted the other way round, its encoder counts back
+static const int encoderSign[ENCODER_WHEELS] = {1, -1};
+static int encoderSm[ENCODER_WHEELS] = {-1, -1};
+
+// load the decoder and start a state machine per wheel, -1 if the PIO
+// is taken
+int encoderInit(){
+    if (!pio_can_add_program_at_offset(ENCODER_PIO, &encoder_program, 0)){
+        return -1;
+    }
+    pio_add_program_at_offset(ENCODER_PIO, &encoder_program, 0);
+    int i;
+    for(i=0;i<ENCODER_WHEELS;i++){
+        encoderSm[i] = pio_claim_unused_sm(ENCODER_PIO, false);
+        if (encoderSm[i] < 0){
+            return -1;
+        }
+        encoder_program_init(ENCODER_PIO, encoderSm[i], encoderPins[i]);
+    }
+    return 0;
+}
+
+// the FIFO holds up to 8 old counts, drain it and wait for a new one, a
+// few PIO cycles
+int32_t encoderCount(int wheel){
+    int sm = encoderSm[wheel];
+    if (sm < 0){
+        return 0;
+    }
+    uint32_t count = 0;
+    int n = pio_sm_get_rx_fifo_level(ENCODER_PIO, sm) + 1;
+    while (n-- > 0){
+        count = pio_sm_get_blocking(ENCODER_PIO, sm);
+    }
+    return encoderSign[wheel] * (int32_t)count;
+}
@@ -0,0 +1,20 @@
+#ifndef ENCODER_h
+#define ENCODER_h
+
+#include <stdint.h>
+
+// Wheel encoders, decoded by PIO (encoder.pio) so no edge costs the CPU
+// anything. Counts are x4: every edge of either phase, positive forward.
+// The host build has a simulated encoder behind the same calls, see
+// host/tools/sim_encoder.c.
+
+#define ENCODER_WHEELS 2
+#define ENCODER_LEFT 0
+#define ENCODER_RIGHT 1
+#define ENCODER_LEFT_PIN 20 // phase A, B on the next pin
+#define ENCODER_RIGHT_PIN 26
+
+int encoderInit();
+int32_t encoderCount(int wheel);
+
+#endif
@@ -0,0 +1,150 @@
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/flash.h"
+#include "hardware/flash.h"
+#include "flatfield.h"
+
+static uint8_t flatTable[FLAT_TABLE_SIZE];
+
+static uint32_t flatChecksum(const uint8_t *data, int len){
+    uint32_t h = 2166136261u;
+    int i;
+    for(i=0;i<len;i++){
+        h = (h ^ data[i]) * 16777619u;
+    }
+    return h;
+}
+
+// vignetting and the shadow's edge change slowly across a row, a line is
+// a narrow band brighter or darker than the floor on both sides of it.
+// Counts pixels half as bright again as both pixels FLAT_LINE_PX either
+// side, or under two thirds of both.
+static int flatLinePixels(const uint16_t *sum){
+    int x, y, n = 0;
+    for(y=0;y<IMAGESIZEY;y++){
+        const uint16_t *row = sum + y * IMAGESIZEX;
+        for(x=FLAT_LINE_PX;x<IMAGESIZEX-FLAT_LINE_PX;x++){
+            uint32_t s = row[x], l = row[x - FLAT_LINE_PX], r = row[x + FLAT_LINE_PX];
+            if ((2 * s > 3 * l && 2 * s > 3 * r) || (3 * s < 2 * l && 3 * s < 2 * r)){
+                n++;
+            }
+        }
+    }
+    return n;
+}
+
+// average blank floor frames and work out the gains, the camera has to be
+// looking at floor without a line. Returns FLAT_OK, or FLAT_NO_FRAMES or
+// FLAT_LINE_IN_VIEW and then the gains in use are kept.
+int flatfieldCalibrate(int frames){
+    static uint16_t sum[FLAT_TABLE_SIZE];
+    const volatile uint8_t *data = getCameraData();
+    int f, i, got = 0;
+
+    // the projection detector doesn't store frames
+    int detector = getLineDetector();
+    if (detector == LINE_DETECTOR_PROJECTION){
+        setLineDetector(LINE_DETECTOR_CENTROID);
+    }
+    if (frames > FLAT_MAX_FRAMES){
+        frames = FLAT_MAX_FRAMES;
+    }
+    memset(sum, 0, sizeof(sum));
+    for(f=0;f<frames;f++){
+        if (captureFrame(NULL) != CAPTURE_OK){
+            continue;
+        }
+        got++;
+        for(i=0;i<FLAT_TABLE_SIZE;i++){
+            uint8_t lo = data[2*i], hi = data[2*i+1];
+            // r+g+b as convertImage() makes it, what findLine() thresholds
+            sum[i] += ((hi>>3)<<3) + ((((hi&0b111)<<3) | lo>>5)<<2) + ((lo&0b11111)<<3);
+        }
+    }
+    setLineDetector(detector);
+    if (got == 0){
+        return FLAT_NO_FRAMES;
+    }
+    if (flatLinePixels(sum) > FLAT_LINE_MAX){
+        return FLAT_LINE_IN_VIEW;
+    }
+
+    // lift every pixel to the mean of the frame
+    uint32_t total = 0;
+    for(i=0;i<FLAT_TABLE_SIZE;i++){
+        total += sum[i];
+    }
+    uint32_t mean = total / FLAT_TABLE_SIZE;
+    for(i=0;i<FLAT_TABLE_SIZE;i++){
+        uint32_t g = sum[i] ? (mean * FLAT_ONE + sum[i] / 2) / sum[i] : 255;
+        flatTable[i] = g < 1 ? 1 : (g > 255 ? 255 : g);
+    }
+    setFlatField(flatTable);
+    return FLAT_OK;
+}
+
+static void flatWrite(void *param){
+    (void)param;
+    static uint8_t page[FLASH_PAGE_SIZE];
+    flatHeader_t header = {FLAT_MAGIC, IMAGESIZEX, IMAGESIZEY, flatChecksum(flatTable, FLAT_TABLE_SIZE), 0};
+    int done = 0, off = 0;
+
+    flash_range_erase(FLAT_FLASH_OFFSET, FLAT_FLASH_BYTES);
+    // header then table, a page at a time
+    while (done < FLAT_TABLE_SIZE || off == 0){
+        int n = 0;
+        memset(page, 0xFF, sizeof(page));
+        if (off == 0){
+            memcpy(page, &header, sizeof(header));
+            n = FLAT_HEADER_SIZE;
+        }
+        int chunk = FLASH_PAGE_SIZE - n;
+        if (chunk > FLAT_TABLE_SIZE - done){
+            chunk = FLAT_TABLE_SIZE - done;
+        }
+        memcpy(page + n, flatTable + done, chunk);
+        done += chunk;
+        flash_range_program(FLAT_FLASH_OFFSET + off, page, FLASH_PAGE_SIZE);
+        off += FLASH_PAGE_SIZE;
+    }
+}
+
+// keep the current gains in flash, 0 on success
+int flatfieldSave(){
+    if (getFlatField() != flatTable){
+        return -1; // nothing calibrated or loaded
+    }
+    // flash can't be read while it's written, this holds off the other
+    // core and interrupts while it runs
+    if (flash_safe_execute(flatWrite, NULL, 1000) != PICO_OK){
+        return -1;
+    }
+    return flatfieldLoad();
+}
+
+// use the gains in flash, 0 on success, -1 if there are none for this frame size
+int flatfieldLoad(){
+    const uint8_t *flash = (const uint8_t *)(XIP_BASE + FLAT_FLASH_OFFSET);
+    flatHeader_t header;
+    memcpy(&header, flash, sizeof(header));
+    if (header.magic != FLAT_MAGIC || header.sizeX != IMAGESIZEX || header.sizeY != IMAGESIZEY){
+        return -1;
+    }
+    if (flatChecksum(flash + FLAT_HEADER_SIZE, FLAT_TABLE_SIZE) != header.checksum){
+        return -1;
+    }
+    // the ISR reads the gains, keep them out of XIP cache misses
+    memcpy(flatTable, flash + FLAT_HEADER_SIZE, FLAT_TABLE_SIZE);
+    setFlatField(flatTable);
+    return 0;
+}
+
+void flatfieldStats(uint8_t *minGain, uint8_t *maxGain){
+    int i;
+    *minGain = 255;
+    *maxGain = 0;
+    for(i=0;i<FLAT_TABLE_SIZE;i++){
+        if (flatTable[i] < *minGain) *minGain = flatTable[i];
+        if (flatTable[i] > *maxGain) *maxGain = flatTable[i];
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef FLATFIELD_h
+#define FLATFIELD_h
+
+#include <stdint.h>
+#include "hardware/flash.h"
+#include "cam.h"
+
+// Flat field illumination correction.
+// A few frames of blank floor are averaged into a per pixel gain that
+// lifts every pixel to the frame mean, which takes out vignetting and the
+// robot's own shadow. The gains are applied by cam.c while it works out
+// brightness anyway, and kept in the last sectors of flash so later boots
+// don't have to calibrate.
+
+#define FLAT_FRAMES 8 // blank floor frames averaged
+#define FLAT_MAX_FRAMES 85 // 16 bit sums of r+g+b
+#define FLAT_LINE_PX 8 // a line is narrower than this either side
+#define FLAT_LINE_MAX IMAGESIZEY // pixels that look like a line before the floor isn't blank
+
+// flatfieldCalibrate() results
+#define FLAT_OK 0
+#define FLAT_NO_FRAMES -1 // no frame came in
+#define FLAT_LINE_IN_VIEW -2 // the floor wasn't blank
+#define FLAT_MAGIC 0x54414C46 // "FLAT"
+#define FLAT_TABLE_SIZE (IMAGESIZEX*IMAGESIZEY)
+#define FLAT_HEADER_SIZE 16
+#define FLAT_FLASH_BYTES (((FLAT_HEADER_SIZE + FLAT_TABLE_SIZE) + FLASH_SECTOR_SIZE - 1) / FLASH_SECTOR_SIZE * FLASH_SECTOR_SIZE)
+#define FLAT_FLASH_OFFSET (PICO_FLASH_SIZE_BYTES - FLAT_FLASH_BYTES) // from the start of flash
+
+typedef struct flatHeader {
+    uint32_t magic;
+    uint16_t sizeX, sizeY; // tables for another frame size are ignored
+    uint32_t checksum; // FNV-1a of the table
+    uint32_t reserved;
+} flatHeader_t;
+
+int flatfieldCalibrate(int frames);
+int flatfieldSave();
+int flatfieldLoad();
+void flatfieldStats(uint8_t *minGain, uint8_t *maxGain);
+
+#endif
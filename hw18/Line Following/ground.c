@@ -0,0 +1,51 @@
+#include <math.h>
+#include "ground.h"
+
+static int32_t groundAhead[IMAGESIZEY]; // mm << GROUND_SHIFT, -1 above the horizon
+static int32_t groundSide[IMAGESIZEY]; // mm to the left per pixel right of centre, << 16
+
+// hw18's OV7670 on its bracket
+void groundDefaultCamera(groundCamera_t *cam){
+    cam->heightMm = 90;
+    cam->aheadMm = 100;
+    cam->pitchDeg = 45;
+    cam->hfovDeg = 56;
+}
+
+// square pixels, the vertical focal length is the horizontal one
+void groundInit(const groundCamera_t *cam){
+    float pitch = cam->pitchDeg * (float)M_PI / 180;
+    float focal = (IMAGESIZEX / 2) / tanf(cam->hfovDeg * (float)M_PI / 360);
+    int row;
+    for(row=0;row<IMAGESIZEY;row++){
+        float v = (row + 0.5f - IMAGESIZEY / 2.0f) / focal;
+        // the ray through the middle of the row, ahead and up from the lens
+        float ahead = cosf(pitch) - v * sinf(pitch);
+        float up = -sinf(pitch) - v * cosf(pitch);
+        if (up > -1e-3f){
+            groundAhead[row] = -1;
+            groundSide[row] = 0;
+            continue;
+        }
+        float dist = cam->heightMm / -up;
+        groundAhead[row] = (int32_t)lroundf((cam->aheadMm + dist * ahead) * GROUND_ONE);
+        groundSide[row] = (int32_t)lroundf(dist / focal * GROUND_ONE * 65536);
+    }
+}
+
+// where the middle of a pixel is on the floor, -1 if the row sees no floor
+int groundPoint(int row, int col, int32_t *ahead, int32_t *left){
+    if (row < 0 || row >= IMAGESIZEY || groundAhead[row] < 0){
+        return -1;
+    }
+    *ahead = groundAhead[row];
+    // half pixels from the centre, so the middle of a pixel lands on it
+    int32_t across = 2 * col + 1 - IMAGESIZEX;
+    *left = (int32_t)(-((int64_t)across * groundSide[row]) >> 17);
+    return 0;
+}
+
+// how far ahead of the axle a row looks, mm << GROUND_SHIFT, -1 if it doesn't see the floor
+int32_t groundRowAhead(int row){
+    return row < 0 || row >= IMAGESIZEY ? -1 : groundAhead[row];
+}
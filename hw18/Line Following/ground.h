@@ -0,0 +1,32 @@
+#ifndef GROUND_h
+#define GROUND_h
+
+#include <stdint.h>
+#include "cam.h"
+
+// Image to floor. The camera looks down at the floor ahead of the car, so
+// every pixel sees a point on it: a row is a distance ahead, and across a
+// row the distance to the side grows with the column, further per pixel
+// the further ahead the row is. groundInit() works a table of both out
+// per row from the camera's mounting, once; after that a point is two
+// multiplies.
+//
+// Floor coordinates are from the middle of the axle, mm << GROUND_SHIFT:
+// ahead along the car and left across it.
+
+#define GROUND_SHIFT 8
+#define GROUND_ONE (1 << GROUND_SHIFT)
+
+typedef struct groundCamera {
+    float heightMm; // lens above the floor
+    float aheadMm; // lens ahead of the axle
+    float pitchDeg; // down from level
+    float hfovDeg; // across the image
+} groundCamera_t;
+
+void groundDefaultCamera(groundCamera_t *cam);
+void groundInit(const groundCamera_t *cam);
+int groundPoint(int row, int col, int32_t *ahead, int32_t *left);
+int32_t groundRowAhead(int row);
+
+#endif
@@ -0,0 +1,104 @@
+#include <string.h>
+#include "hough.h"
+
+// cos and sin of theta = -90 + k*180/HOUGH_ANGLES degrees, Q15
+static const int16_t houghCos[HOUGH_ANGLES] = {
+    0, 3212, 6393, 9512, 12539, 15446, 18204, 20787,
+    23170, 25329, 27245, 28898, 30273, 31356, 32137, 32609,
+    32767, 32609, 32137, 31356, 30273, 28898, 27245, 25329,
+    23170, 20787, 18204, 15446, 12539, 9512, 6393, 3212,
+};
+
+static const int16_t houghSin[HOUGH_ANGLES] = {
+    -32767, -32609, -32137, -31356, -30273, -28898, -27245, -25329,
+    -23170, -20787, -18204, -15446, -12539, -9512, -6393, -3212,
+    0, 3212, 6393, 9512, 12539, 15446, 18204, 20787,
+    23170, 25329, 27245, 28898, 30273, 31356, 32137, 32609,
+};
+
+// theta of each bin in tenths of a degree
+static const int16_t houghAngle[HOUGH_ANGLES] = {
+    -900, -844, -788, -731, -675, -619, -562, -506,
+    -450, -394, -338, -281, -225, -169, -112, -56,
+    0, 56, 112, 169, 225, 281, 338, 394,
+    450, 506, 562, 619, 675, 731, 788, 844,
+};
+
+// 32 x 101 bytes at 80x60, a third of cameraData
+static uint8_t houghAcc[HOUGH_ANGLES][HOUGH_RHO_BINS];
+
+void houghReset(){
+    memset(houghAcc, 0, sizeof(houghAcc));
+}
+
+// vote for every angle through pixel (x, y), fixed HOUGH_ANGLES steps
+void houghAddPoint(int x, int y){
+    int k;
+    int xc = x - IMAGESIZEX/2;
+    int yc = y - IMAGESIZEY/2;
+    for(k=0;k<HOUGH_ANGLES;k++){
+        int32_t rho = (xc*houghCos[k] + yc*houghSin[k] + (1 << 14)) >> 15;
+        uint8_t *cell = &houghAcc[k][rho + HOUGH_RHO_MAX];
+        if (*cell < 255){
+            (*cell)++;
+        }
+    }
+}
+
+// find the strongest cell, rho is refined with its two neighbours
+// returns 0 if a line was found, -1 if nothing had enough votes
+int houghPeak(houghLine_t *line){
+    int k, r;
+    int best = 0, bestK = 0, bestR = 0;
+    for(k=0;k<HOUGH_ANGLES;k++){
+        for(r=0;r<HOUGH_RHO_BINS;r++){
+            if (houghAcc[k][r] > best){
+                best = houghAcc[k][r];
+                bestK = k;
+                bestR = r;
+            }
+        }
+    }
+    if (best < HOUGH_MIN_VOTES){
+        return -1;
+    }
+
+    int left = (bestR > 0) ? houghAcc[bestK][bestR-1] : 0;
+    int right = (bestR < HOUGH_RHO_BINS-1) ? houghAcc[bestK][bestR+1] : 0;
+    int sum = left + best + right;
+    int rho16 = (bestR - HOUGH_RHO_MAX)*16 + ((right - left)*16) / sum;
+
+    line->angle = houghAngle[bestK];
+    line->rho = (int16_t)rho16;
+    line->angleIndex = (uint8_t)bestK;
+    line->votes = (uint8_t)best;
+    line->offset = (int16_t)(houghLineX(line, IMAGESIZEY/2) - IMAGESIZEX/2);
+    return 0;
+}
+
+// x of the line at an image row, -1 if the line is horizontal
+int houghLineX(const houghLine_t *line, int row){
+    int32_t c = houghCos[line->angleIndex];
+    if (c == 0){
+        return -1;
+    }
+    int32_t yc = row - IMAGESIZEY/2;
+    // x = (rho - y*sin) / cos, with rho in 1/16 pixel
+    int32_t num = ((int32_t)line->rho << 11) - yc*houghSin[line->angleIndex];
+    int32_t x = (num + (num >= 0 ? c/2 : -c/2)) / c;
+    return IMAGESIZEX/2 + x;
+}
+
+// dominant line of the current frame, voting with the centre of the
+// edge pair found on every row, so the work is at most IMAGESIZEY points
+int houghFindLine(houghLine_t *line){
+    int row;
+    houghReset();
+    for(row=0;row<IMAGESIZEY;row++){
+        int x = findLineEdges(row, NULL);
+        if (x >= 0){
+            houghAddPoint(x, row);
+        }
+    }
+    return houghPeak(line);
+}
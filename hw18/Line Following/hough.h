@@ -0,0 +1,31 @@
+#ifndef HOUGH_h
+#define HOUGH_h
+
+#include <stdint.h>
+#include "cam.h"
+
+// Coarse Hough transform for the dominant line direction in a frame.
+// Lines are x*cos(theta) + y*sin(theta) = rho with x, y measured from the
+// centre of the image. theta is the normal angle, so 0 is a line straight
+// ahead and positive angles lean right further up the image.
+
+#define HOUGH_ANGLES 32 // 5.6 degree steps over -90..90
+#define HOUGH_RHO_MAX (IMAGESIZEX*5/8) // half diagonal of a 4:3 frame
+#define HOUGH_RHO_BINS (2*HOUGH_RHO_MAX+1) // 1 pixel rho bins
+#define HOUGH_MIN_VOTES 8 // fewer votes than this is not a line
+
+typedef struct houghLine {
+    int16_t angle; // tenths of a degree from straight ahead
+    int16_t offset; // x of the line at the middle row, from the centre, pixels
+    int16_t rho; // distance from the image centre, 1/16 pixel
+    uint8_t angleIndex; // which HOUGH_ANGLES bin won
+    uint8_t votes;
+} houghLine_t;
+
+void houghReset();
+void houghAddPoint(int x, int y);
+int houghPeak(houghLine_t *line);
+int houghFindLine(houghLine_t *line);
+int houghLineX(const houghLine_t *line, int row);
+
+#endif
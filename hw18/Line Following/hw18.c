@@ -1,9 +1,29 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
 #include "pico/stdlib.h"
-#include "hardware/pwm.h"
+#include "hardware/irq.h"
 #include "cam.h"
+#include "hough.h"
+#include "odometry.h"
+#include "nn.h"
+#include "captest.h"
+#include "clockplan.h"
+#include "flatfield.h"
+#include "topology.h"
+#include "marker.h"
+#include "steer.h"
+#include "encoder.h"
+#include "wheel.h"
+#include "motion.h"
+#include "pose.h"
+#include "motor.h"
+#include "params.h"
+#include "ground.h"
+#include "speedplan.h"
+#include "pursuit.h"
+#include "nn_model.h"
 
 // === Motor Pin Setup ===
 #define A_PHASE 16
@@ -11,49 +31,161 @@
 #define B_PHASE 18
 #define B_ENABLE 19
 
+#define CAMERA_FPS_MILLI 10000 // frame rate the clock planner aims for, 1/1000 fps
+
+// what to do at junctions, 'p' changes the policy
+#define TOPO_LAP_SCRIPT "LSRS" // one turn per junction, from the start each lap
+#define TOPO_STOP_LAPS 3 // stop at this stop bar
+
 #define WRAP 255
-#define CLK_DIV 1.0f
-
-void init_pwm(uint gpio) {
-    gpio_set_function(gpio, GPIO_FUNC_PWM);
-    uint slice = pwm_gpio_to_slice_num(gpio);
-    pwm_set_wrap(slice, WRAP);
-    pwm_set_clkdiv(slice, CLK_DIV);
-    pwm_set_enabled(slice, true);
+#define PWM_FREQ 20000 // Hz, out of hearing
+
+// gains and speeds, from flash if the tuner has left some there
+params_t params;
+// base speed in percent of WRAP, set per track segment by the markers
+int base_percent = 30;
+// slower for the bends in view, the base speed is the top speed
+plan_t speed_plan;
+float plan_lat_accel; // what 'v' turns the planner back on with
+// steering on the line ahead's geometry instead of the PID, 'g'
+pursuit_t pursuit;
+bool pursuit_on = false;
+
+// where the car is, from the encoders or without them the PWM
+pose_t pose;
+poseConfig_t pose_cfg;
+bool encoders_ok = false;
+volatile bool pose_reset = false;
+volatile int motor_left = 0, motor_right = 0;
+
+// both motors, the steering loop's output
+void drive_motors(int left, int right) {
+    motorSet(left, right);
+    motor_left = left;
+    motor_right = right;
 }
 
-void set_motor(uint phase_pin, uint pwm_pin, int speed) {
-    if (speed >= 0) {
-        gpio_put(phase_pin, 0); // Forward
+// the steering loop's output, a motion script takes over while it runs
+void steer_output(int left, int right) {
+    uint64_t now = time_us_64();
+    motionTick(now, &left, &right);
+    wheelDrive(left, right);
+    if (pose_reset) {
+        poseReset(&pose, &pose_cfg);
+        pose_reset = false;
+    }
+    if (encoders_ok) {
+        poseUpdateCounts(&pose, encoderCount(ENCODER_LEFT), encoderCount(ENCODER_RIGHT), now);
     } else {
-        gpio_put(phase_pin, 1); // Reverse
-        speed = -speed;
+        poseUpdatePwm(&pose, motor_left, motor_right, now);
     }
-    if (speed > WRAP) speed = WRAP;
-    pwm_set_gpio_level(pwm_pin, speed);
 }
 
-void set_motor_speeds(int com) {
-    int line_pos = ((com - 40) * 100) / 40;
-    if (line_pos > 100) line_pos = 100;
-    if (line_pos < -100) line_pos = -100;
+// stop now and keep the steering loop stopped until the next estimate
+void stop_motors() {
+    motionAbort();
+    steerHold();
+    drive_motors(0, 0);
+}
 
-    int base_speed = WRAP * 0.55;
-    int adjust = (WRAP * abs(line_pos)) / 100;
+// the line's column in the planner's rows, far to near, -1 where there's none
+void line_rows(int *cols) {
+    for (int i = 0; i < PLAN_ROWS; i++) {
+        // the edge finder says when a row has no line, the projection has no frame
+        cols[i] = getLineDetector() == LINE_DETECTOR_PROJECTION ? findLineProjection(planRow(i))
+                                                                : findLineEdges(planRow(i), NULL);
+    }
+}
 
-    int left_speed = base_speed;
-    int right_speed = base_speed;
+// the frame's base speed: the segment's, or slower for a bend in view
+int frame_speed(const int *cols, uint64_t frame_us) {
+    int top = WRAP * base_percent / 100;
+    if (speed_plan.cfg.latAccel <= 0) {
+        return top;
+    }
+    float full = (float)pose_cfg.umPerCount * pose_cfg.maxCps / 1000; // mm/s at WRAP
+    float v = planSpeed(&speed_plan, cols, top * full / WRAP, frame_us);
+    return (int)(v * WRAP / full + 0.5f);
+}
 
-    if (line_pos > 0) {
-        right_speed -= adjust;
-    } else if (line_pos < 0) {
-        left_speed -= adjust;
+// hand the frame's line to the steering loop, the timer does the driving.
+// heading is the line's angle in radians, 0 if it wasn't measured. Off
+// follow_rows com is steered on even with pursuit, it's a junction's way.
+void post_line(int com, float heading, bool follow_rows, uint64_t frame_us) {
+    int cols[PLAN_ROWS];
+    if (speed_plan.cfg.latAccel > 0 || pursuit_on) {
+        line_rows(cols);
+    }
+    steerEstimate_t est;
+    est.position = (float)(com - IMAGESIZEX / 2) / (IMAGESIZEX / 2);
+    if (est.position > 1) est.position = 1;
+    if (est.position < -1) est.position = -1;
+    est.heading = heading;
+    est.baseSpeed = frame_speed(cols, frame_us);
+    est.timeUs = frame_us;
+    est.direct = pursuit_on && follow_rows;
+    est.turn = 0;
+    if (est.direct) {
+        // no line in any row keeps the last turn
+        poseState_t ps;
+        poseRead(&pose, &ps);
+        pursuitSteer(&pursuit, cols, ps.speed);
+        est.turn = (float)pursuit.turn / PURSUIT_TURN_ONE * est.baseSpeed / WRAP;
     }
+    steerPost(&est);
+}
 
-    set_motor(A_PHASE, A_ENABLE, left_speed);
-    set_motor(B_PHASE, B_ENABLE, right_speed);
+// the rest of a command line, up to Enter or a second without a key
+int read_line(char *line, int size) {
+    int n = 0;
+    while (n < size - 1) {
+        int c = getchar_timeout_us(1000000);
+        if (c == PICO_ERROR_TIMEOUT || c == '\r' || c == '\n') {
+            break;
+        }
+        line[n++] = (char)c;
+    }
+    line[n] = 0;
+    return n;
+}
 
+// what the steering loop is driving, after the frame like before
+void print_motor_speeds(int com) {
+    int left_speed, right_speed;
+    steerLastOutput(&left_speed, &right_speed);
     printf("COM: %d | Left PWM: %d | Right PWM: %d\n", com, left_speed, right_speed);
+    poseState_t ps;
+    poseRead(&pose, &ps);
+    printf("Pose: x %ld y %ld mm | heading %ld mdeg | %ld mm/s | turning %ld mdeg/s\n", (long)(ps.x / 1000),
+        (long)(ps.y / 1000), (long)ps.headingMdeg, (long)ps.speed, (long)ps.turnRate);
+    if (pursuit_on) {
+        printf("Pursuit: lookahead %ld mm | target %ld ahead %ld left mm | radius %ld mm\n",
+            (long)(pursuit.lookahead >> GROUND_SHIFT), (long)(pursuit.targetAhead >> GROUND_SHIFT),
+            (long)(pursuit.targetLeft >> GROUND_SHIFT),
+            pursuit.curvature != 0 ? (long)((1 << PURSUIT_SHIFT) / pursuit.curvature) : 0L);
+    }
+    if (speed_plan.cfg.latAccel > 0) {
+        printf("Plan: radius %ld mm | %d mm/s\n", speed_plan.curvature != 0 ? (long)(1 / speed_plan.curvature) : 0L,
+            (int)speed_plan.speed);
+    }
+}
+
+// calibrate the flat field on the floor in view and keep it in flash,
+// saying why not if it didn't
+void flat_calibrate() {
+    int result = flatfieldCalibrate(FLAT_FRAMES);
+    const char *kept = getFlatField() ? "keeping the gains in use" : "running uncorrected";
+    if (result == FLAT_LINE_IN_VIEW) {
+        printf("Flat field: a line is in view, %s, press f over blank floor\n", kept);
+    } else if (result != FLAT_OK) {
+        printf("Flat field: no frames came in, %s\n", kept);
+    } else if (flatfieldSave() != 0) {
+        printf("Flat field: calibrated, saving to flash failed\n");
+    } else {
+        uint8_t lo, hi;
+        flatfieldStats(&lo, &hi);
+        printf("Flat field: calibrated and saved, gains %d..%d /%d\n", lo, hi, FLAT_ONE);
+    }
 }
 
 int main() {
@@ -63,15 +195,102 @@ int main() {
     }
     printf("Hello, camera!\n");
 
+    // system clock, MCLK and sensor clocks for the frame rate
+    clockPlan_t plan;
+    if (clockplanMake(&plan, CAMERA_FPS_MILLI, OV7670_SIZE_DIV8, CLOCKPLAN_SYS_MAX_KHZ) == 0) {
+        clockplanPrint(&plan, OV7670_SIZE_DIV8);
+        setClockPlan(&plan);
+    } else {
+        printf("Clock plan failed, using the default clocks\n");
+    }
+
     init_camera_pins();
 
-    gpio_init(A_PHASE);
-    gpio_set_dir(A_PHASE, GPIO_OUT);
-    gpio_init(B_PHASE);
-    gpio_set_dir(B_PHASE, GPIO_OUT);
+    // flat field gains from flash, or calibrate on the floor in view now.
+    // A line in view is refused and the car runs uncorrected until 'f'.
+    if (flatfieldLoad() == 0) {
+        printf("Flat field: loaded from flash\n");
+    } else {
+        flat_calibrate();
+    }
+
+    // tuned gains and speeds, or the hand picked ones
+    if (paramsLoad(&params) == 0) {
+        printf("Params: loaded from flash\n");
+    } else {
+        paramsDefault(&params);
+        printf("Params: defaults\n");
+    }
+    base_percent = params.basePercent;
+    groundCamera_t ground_cam;
+    groundDefaultCamera(&ground_cam);
+    groundInit(&ground_cam);
+    planConfig_t plan_cfg;
+    planDefaultConfig(&plan_cfg);
+    plan_lat_accel = params.latAccel ? params.latAccel : plan_cfg.latAccel;
+    plan_cfg.latAccel = params.latAccel;
+    planInit(&speed_plan, &plan_cfg);
+
+    // PWM set up once, both slices in step
+    motorConfig_t motors;
+    motorDefaultConfig(&motors);
+    motors.pins[MOTOR_LEFT].phase = A_PHASE;
+    motors.pins[MOTOR_LEFT].enable = A_ENABLE;
+    motors.pins[MOTOR_RIGHT].phase = B_PHASE;
+    motors.pins[MOTOR_RIGHT].enable = B_ENABLE;
+    motors.pins[MOTOR_LEFT].freqHz = motors.pins[MOTOR_RIGHT].freqHz = PWM_FREQ;
+    motors.wrap = WRAP;
+    motors.slewPerS = 40; // the wheel loops are the lag that matters, just take the edge off
+    if (motorInit(&motors) != 0) {
+        printf("Motors: no PWM for %d Hz\n", PWM_FREQ);
+    }
+
+    // the pixel ISR can't wait behind a steering tick, a tick can wait
+    irq_set_priority(IO_IRQ_BANK0, PICO_HIGHEST_IRQ_PRIORITY);
+    // wheel speed loops under the steering, open loop if there are no encoders
+    wheelGains_t wheel_gains;
+    wheelDefaultGains(&wheel_gains);
+    wheelInit(&wheel_gains, WRAP, drive_motors);
+    encoders_ok = encoderInit() == 0;
+    if (!encoders_ok) {
+        printf("Encoders: no PIO state machines, running open loop\n");
+        wheelSetClosedLoop(false);
+    }
+    poseDefaultConfig(&pose_cfg);
+    pose_cfg.wrap = WRAP;
+    poseReset(&pose, &pose_cfg);
+    pursuitConfig_t pursuit_cfg;
+    pursuitDefaultConfig(&pursuit_cfg);
+    pursuit_cfg.trackMm = pose_cfg.trackUm / 1000;
+    pursuitInit(&pursuit, &pursuit_cfg);
+    // scripted moves, run from the steering tick
+    motionConfig_t motion_cfg;
+    motionDefaultConfig(&motion_cfg);
+    motion_cfg.outputScale = WRAP;
+    motionInit(&motion_cfg);
+    steerGains_t gains;
+    steerDefaultGains(&gains);
+    gains.kp = params.kp;
+    gains.ki = params.ki;
+    gains.kd = params.kd;
+    gains.kff = params.kff;
+    if (!steerStart(&gains, WRAP, steer_output)) {
+        printf("Steering timer failed to start\n");
+    }
+
+    int nn_ok = nnLoad(nn_model, NN_MODEL_SIZE) == NN_OK;
+    bool nn_report = false;
+    printf("CNN model: %s\n", nn_ok ? "loaded" : "failed to load");
+#ifdef NN_MODEL_PLACEHOLDER
+    printf("CNN model has placeholder weights, timing only\n");
+#endif
 
-    init_pwm(A_ENABLE);
-    init_pwm(B_ENABLE);
+    topoPolicy_t policy;
+    topoPolicyInit(&policy, TOPO_POLICY_STRAIGHT, TOPO_LAP_SCRIPT, TOPO_STOP_LAPS);
+
+    int last_com = IMAGESIZEX / 2;
+    uint64_t last_frame_us = time_us_64();
+    uint64_t steer_log_us = last_frame_us;
 
     while (true) {
         int c = getchar_timeout_us(0);
@@ -80,25 +299,193 @@ int main() {
             if (ch == 'q' || ch == 'Q') {
                 printf("Quitting.\n");
                 break;
+            } else if (ch == 'o' || ch == 'O') {
+                // the pose starts again from here
+                pose_reset = true;
+                printf("Pose: reset\n");
+            } else if (ch == ':') {
+                // a motion script line, e.g. ":T 180;S 300", see motionParse()
+                char line[MOTION_LINE_MAX];
+                read_line(line, sizeof(line));
+                int n = motionParse(line);
+                if (n < 0) {
+                    printf("Motion: bad or too many moves: %s\n", line);
+                } else {
+                    printf("Motion: %d moves queued\n", n);
+                }
+            } else if (ch == 'e' || ch == 'E') {
+                // cycle centroid -> edge -> projection in the ISR
+                if (getLineDetector() == LINE_DETECTOR_CENTROID) {
+                    setLineDetector(LINE_DETECTOR_EDGE);
+                    printf("Line detector: edge\n");
+                } else if (getLineDetector() == LINE_DETECTOR_EDGE) {
+                    setLineDetector(LINE_DETECTOR_PROJECTION);
+                    printf("Line detector: projection (no frame stored)\n");
+                } else {
+                    setLineDetector(LINE_DETECTOR_CENTROID);
+                    printf("Line detector: centroid\n");
+                }
+            } else if (ch == 'p' || ch == 'P') {
+                // next junction policy, starts the laps over
+                topoPolicyInit(&policy, (policy.mode + 1) % TOPO_POLICIES, TOPO_LAP_SCRIPT, TOPO_STOP_LAPS);
+                printf("Junction policy: %s\n", topoPolicyName(policy.mode));
+            } else if (ch == 'w' || ch == 'W') {
+                // wheel speed loops on and off, off for a car without encoders
+                wheelSetClosedLoop(!wheelClosedLoop());
+                printf("Wheel speed loops: %s\n", wheelClosedLoop() ? "on" : "off");
+            } else if (ch == 'v' || ch == 'V') {
+                // curvature speed planning on and off, off drives at the base speed
+                speed_plan.cfg.latAccel = speed_plan.cfg.latAccel > 0 ? 0 : plan_lat_accel;
+                printf("Speed planner: %s\n", speed_plan.cfg.latAccel > 0 ? "on" : "off");
+            } else if (ch == 'g' || ch == 'G') {
+                // pure pursuit on the rows' floor points, or the PID on the line position
+                pursuit_on = !pursuit_on;
+                printf("Steering: %s\n", pursuit_on ? "pure pursuit" : "PID");
+            } else if ((ch == 'n' || ch == 'N') && nn_ok) {
+                // run the CNN every frame and print its output and timing
+                nn_report = !nn_report;
+            } else if (ch == 'f' || ch == 'F') {
+                // recalibrate the flat field, the camera must see blank floor
+                stop_motors();
+                flat_calibrate();
+            } else if (ch == 'b' || ch == 'B') {
+                // capture bit error test, put the car on its stand first
+                stop_motors();
+                captestSweep(CAPTEST_FRAMES);
+                odometryReset();
+                topoReset();
+                last_frame_us = time_us_64();
+            }
+        }
+
+        // the edge finder works on rows as they arrive
+        int cap = captureFrame(getLineDetector() == LINE_DETECTOR_EDGE ? edgeProcessAvailableRows : NULL);
+        if (cap != CAPTURE_OK) {
+            // no usable frame, stop until the camera is back
+            stop_motors();
+            const captureStats_t *cs = getCaptureStats();
+            printf("Capture %s | timeouts %lu short %lu sensor resets %lu\n",
+                cap == CAPTURE_SHORT ? "short frame" : (cap == CAPTURE_TIMEOUT ? "timeout" : "timeout, sensor reset"),
+                (unsigned long)cs->timeouts, (unsigned long)cs->shortFrames, (unsigned long)cs->sensorResets);
+            odometryReset(); // the next frame doesn't follow the last good one
+            topoReset();
+            last_frame_us = time_us_64();
+            continue;
+        }
+
+        // steering loop timing, once a second
+        uint64_t frame_us = time_us_64();
+        if (frame_us - steer_log_us >= 1000000) {
+            steerTiming_t st;
+            steerGetTiming(&st);
+            printf("Steer: %lu ticks | period %lu..%lu us | run max %lu us | late %lu | %lu frames, oldest %lu ms\n",
+                (unsigned long)st.ticks, (unsigned long)st.periodMinUs, (unsigned long)st.periodMaxUs,
+                (unsigned long)st.runMaxUs, (unsigned long)st.late, (unsigned long)st.estimates,
+                (unsigned long)(st.ageMaxUs / 1000));
+            float left_cps, right_cps;
+            wheelSpeeds(&left_cps, &right_cps);
+            printf("Wheels: left %d right %d counts/s\n", (int)left_cps, (int)right_cps);
+            steer_log_us = frame_us;
+        }
+
+        if (getLineDetector() == LINE_DETECTOR_PROJECTION) {
+            // the ISR already has every row, there is no frame to look at
+            // and nothing to wait out, the capture paces the loop
+            int com = findLineProjection(IMAGESIZEY / 2);
+            if (com < 0) {
+                com = last_com;
+            }
+            last_com = com;
+            post_line(com, 0, true, frame_us);
+            printf("%d\r\n", com);
+            print_motor_speeds(com);
+            continue;
+        }
+
+        // ground speed from how far the floor texture moved
+        odomMotion_t motion;
+        odometryUpdate((uint32_t)(frame_us - last_frame_us), &motion);
+        last_frame_us = frame_us;
+        if (motion.valid) {
+            printf("Speed: fwd %ld lat %ld px/s\n", (long)(motion.forwardRate / 256), (long)(motion.lateralRate / 256));
+        }
+
+        if (nn_report) {
+            int32_t nn_offset, nn_heading;
+            nnLoadCameraFrame();
+            nnRun();
+            nnGetOutput(&nn_offset, &nn_heading);
+            printf("CNN: offset %ld heading %ld | us:", (long)nn_offset, (long)nn_heading);
+            for (int i = 0; i < nnNumLayers(); i++) {
+                printf(" %lu", (unsigned long)nnGetLayerUs(i));
             }
+            printf("\n");
         }
 
-        setSaveImage(1);
-        while (getSaveImage() == 1) {}
+        // checkpoints beside the track, log the pass and set the segment speed
+        marker_t markers[MARKER_MAX_FOUND];
+        int num_markers = markerDetect(markers, MARKER_MAX_FOUND);
+        int passed = markerLogUpdate(markers, num_markers, (uint32_t)(frame_us / 1000));
+        if (passed >= 0) {
+            const markerPass_t *pass = markerLogEntry(markerLogCount() - 1);
+            printf("Checkpoint %d at %lu ms | segment %lu ms", passed, (unsigned long)pass->timeMs,
+                (unsigned long)pass->segmentMs);
+            if (passed == MARKER_START_ID && markerLaps() > 0) {
+                printf(" | lap %d %lu ms", markerLaps(), (unsigned long)markerLastLapMs());
+            }
+            printf("\n");
+            if (params.segmentPercent[passed]) {
+                base_percent = params.segmentPercent[passed];
+            }
+        }
+
+        // crossings and forks, the row centroid would steer between the lines
+        topoFrame_t topo;
+        int topo_com;
+        topoClassify(&topo);
+        int action = topoPolicySteer(&policy, &topo, &topo_com);
+        if (action == TOPO_ACTION_STOP) {
+            stop_motors();
+            printf("Stopped at %s after %d laps, 'p' to go again\n", topoLabelName(topo.label), policy.laps);
+            sleep_ms(100);
+            continue;
+        }
+        if (topo.label != TOPO_STRAIGHT) {
+            printf("Track: %s\n", topoLabelName(topo.label));
+        }
 
         convertImage();
-        int com = findLine(IMAGESIZEY / 2);
+        int com = detectLine(IMAGESIZEY / 2);
+        if (action == TOPO_ACTION_TURN) {
+            com = topo_com; // the way the policy picked
+        }
+        if (com < 0) {
+            com = last_com; // no line this frame, keep steering the same way
+        }
+        last_com = com;
+
+        float heading = 0;
+        if (getLineDetector() == LINE_DETECTOR_EDGE) {
+            // direction of the whole line, the single row can't see turns
+            houghLine_t line;
+            if (houghFindLine(&line) == 0) {
+                printf("Angle: %d.%d deg | Offset: %d\n", line.angle / 10, abs(line.angle % 10), line.offset);
+                heading = line.angle * (float)M_PI / 1800;
+            }
+        }
+        // steer before the image goes out, printing it takes a while
+        post_line(com, heading, action != TOPO_ACTION_TURN, frame_us);
         setPixel(IMAGESIZEY / 2, com, 0, 255, 0);
         printImage();
         printf("%d\r\n", com);
-        set_motor_speeds(com);
+        print_motor_speeds(com);
 
         sleep_ms(100);
     }
 
     // Stop motors
-    set_motor(A_PHASE, A_ENABLE, 0);
-    set_motor(B_PHASE, B_ENABLE, 0);
+    steerStop();
+    motorSet(0, 0);
 
     return 0;
 }
@@ -0,0 +1,314 @@
+#include <string.h>
+#include "marker.h"
+
+// the capture ends on the last HS, so the bottom row isn't from this frame
+#define MARKER_ROWS (IMAGESIZEY-1)
+
+// 16 bit codes, bit 4*row+col of the data cells, 1 is white. Every code is
+// at least 5 bits from every other one and from its own turns, in any turn.
+static const uint16_t markerDict[MARKER_IDS] = {
+    0x9c92, 0x2494, 0x0383, 0xdf86, 0xda9f, 0xc565, 0x931d, 0x5621,
+    0x6443, 0x3bf6, 0xaa1e, 0xefa8, 0x2628, 0x8bfc, 0xacec, 0xe25d,
+};
+
+static uint32_t markerBits[MARKER_ROWS][MARKER_WORDS]; // 1 is bright
+
+static inline int markerBright(int x, int y){
+    return (markerBits[y][x >> 5] >> (x & 31)) & 1;
+}
+
+// dark with white above, or two above where the top edge blurs over a row
+static inline int markerTopEdge(int x, int y){
+    return !markerBright(x, y) && (markerBright(x, y - 1) || (y >= 2 && markerBright(x, y - 2)));
+}
+
+uint16_t markerCode(int id){
+    return markerDict[id];
+}
+
+// the code seen after turning a marker a quarter turn clockwise
+uint16_t markerRotate(uint16_t code){
+    uint16_t out = 0;
+    int i, j;
+    for(i=0;i<4;i++){
+        for(j=0;j<4;j++){
+            if (code & (1 << ((3-j)*4 + i))){
+                out |= 1 << (i*4 + j);
+            }
+        }
+    }
+    return out;
+}
+
+// threshold the frame at its mean luma, a quarter of the rows are enough
+// to find the mean
+static void markerThreshold(){
+    uint8_t luma[IMAGESIZEX];
+    uint32_t sum = 0;
+    int x, y, n = 0;
+    for(y=0;y<MARKER_ROWS;y+=4){
+        getLumaRow(y, luma);
+        for(x=0;x<IMAGESIZEX;x++){
+            sum += luma[x];
+        }
+        n++;
+    }
+    int thresh = sum / (n * IMAGESIZEX);
+    for(y=0;y<MARKER_ROWS;y++){
+        getLumaRow(y, luma);
+        memset(markerBits[y], 0, sizeof(markerBits[y]));
+        for(x=0;x<IMAGESIZEX;x++){
+            if (luma[x] > thresh){
+                markerBits[y][x >> 5] |= 1u << (x & 31);
+            }
+        }
+    }
+}
+
+// nearest code in any turn, -1 if none is within MARKER_MAX_FIX bits
+static int markerDecode(uint16_t code, marker_t *m){
+    int r, id;
+    int best = MARKER_MAX_FIX + 1;
+    for(r=0;r<4;r++){
+        for(id=0;id<MARKER_IDS;id++){
+            int d = __builtin_popcount(code ^ markerDict[id]);
+            if (d < best){
+                best = d;
+                m->id = (uint8_t)id;
+                m->rotation = (uint8_t)r;
+            }
+        }
+        code = markerRotate(code);
+    }
+    if (best > MARKER_MAX_FIX){
+        return -1;
+    }
+    m->fixed = (uint8_t)best;
+    // the code was turned back r times, the marker is turned the other way
+    m->rotation = (uint8_t)((4 - m->rotation) & 3);
+    return m->id;
+}
+
+// last dark row going down a border from (x, y), stepping sideways by a
+// pixel where the border leans out, dir is the way out
+static int markerDown(int x, int y, int dir){
+    while (y + 1 < MARKER_ROWS){
+        if (!markerBright(x, y + 1)){
+            y++;
+        }
+        else if (x + dir >= 0 && x + dir < IMAGESIZEX && !markerBright(x + dir, y + 1)){
+            x += dir;
+            y++;
+        }
+        else {
+            break;
+        }
+    }
+    return y;
+}
+
+// dark run through (x, y), returns its start and sets its end
+static int markerRun(int x, int y, int *end){
+    int a = x, b = x;
+    while (a > 0 && !markerBright(a - 1, y)) a--;
+    while (b < IMAGESIZEX - 1 && !markerBright(b + 1, y)) b++;
+    *end = b;
+    return a;
+}
+
+// sample a marker whose top edge is the dark run x0..x1 on row y0, with
+// white above it. Returns 0 and fills m if it decodes.
+static int markerSample(int x0, int x1, int y0, marker_t *m){
+    int w = x1 - x0 + 1;
+    int half = w / (2*MARKER_CELLS); // half a cell
+    int i, j;
+
+    // white either side of the top edge
+    if (x0 < 1 || x1 >= IMAGESIZEX-1 || !markerBright(x0 - 1, y0) || !markerBright(x1 + 1, y0)){
+        return -1;
+    }
+    // down the left and right border cells to the bottom edge
+    int yl = markerDown(x0 + half, y0, -1);
+    int yr = markerDown(x1 - half, y0, 1);
+    int y1 = yl > yr ? yl : yr;
+    int h = y1 - y0 + 1;
+    if ((yl > yr ? yl - yr : yr - yl) > half + 1 || 5*h < 2*w || 3*h > 4*w){
+        return -1;
+    }
+    if (y1 + 1 >= MARKER_ROWS){
+        return -1; // no room for the white below
+    }
+    // the bottom edge is wider if the camera looks down at the marker,
+    // measured a little up from the last row, which is blurred
+    int bx1;
+    int bx0 = markerRun(x0 + half, y1 - half/2, &bx1);
+    int bw = bx1 - bx0 + 1;
+    if (3*bw < 2*w || 2*bw > 3*w){
+        return -1;
+    }
+
+    // 6x6 cells plus the quiet zone around them, corners in 1/256 pixel
+    // between the top and bottom edges
+    int errors = 0;
+    uint16_t code = 0;
+    for(i=-1;i<=MARKER_CELLS;i++){
+        int v = ((2*i + 1) << 8) / (2*MARKER_CELLS); // down the marker, 1/256
+        int y = y0 + ((v * h) >> 8);
+        int left = (x0 << 8) + v * (bx0 - x0);
+        int right = ((x1 + 1) << 8) + v * (bx1 - x1);
+        if (y < 0 || y >= MARKER_ROWS){
+            return -1;
+        }
+        for(j=-1;j<=MARKER_CELLS;j++){
+            int x = (left + (right - left) * (2*j + 1) / (2*MARKER_CELLS)) >> 8;
+            if (x < 0 || x >= IMAGESIZEX){
+                return -1;
+            }
+            int b = markerBright(x, y);
+            if (i < 0 || j < 0 || i == MARKER_CELLS || j == MARKER_CELLS){
+                errors += !b; // quiet zone, white
+            }
+            else if (i == 0 || j == 0 || i == MARKER_CELLS-1 || j == MARKER_CELLS-1){
+                errors += b; // border, black
+            }
+            else {
+                code |= b << ((i-1)*4 + (j-1));
+            }
+        }
+    }
+    // 48 cells outside the data, a corner of the quiet zone can clip
+    if (errors > 2){
+        return -1;
+    }
+    if (markerDecode(code, m) < 0){
+        return -1;
+    }
+    m->x = (int16_t)((x0 + x1 + bx0 + bx1) / 4);
+    m->y = (int16_t)((y0 + y1) / 2);
+    m->size = (int16_t)w;
+    return 0;
+}
+
+// find up to max markers in the frame in cameraData, returns how many
+int markerDetect(marker_t *found, int max){
+    int n = 0;
+    int y, w, k;
+    markerThreshold();
+    // top edges, 32 pixels at a time
+    for(y=1;y<MARKER_ROWS && n<max;y++){
+        for(w=0;w<MARKER_WORDS && n<max;w++){
+            uint32_t above = markerBits[y-1][w] | (y >= 2 ? markerBits[y-2][w] : 0);
+            uint32_t edge = above & ~markerBits[y][w];
+            if (w == MARKER_WORDS-1 && (IMAGESIZEX & 31)){
+                edge &= (1u << (IMAGESIZEX & 31)) - 1;
+            }
+            while (edge && n < max){
+                int x0 = w*32 + __builtin_ctz(edge);
+                // runs that carry on into the next word are followed there
+                int x1 = x0;
+                while (x1 + 1 < IMAGESIZEX && markerTopEdge(x1 + 1, y)){
+                    x1++;
+                }
+                if (x1 >= w*32 + 31){
+                    edge = 0;
+                }
+                else {
+                    edge &= ~((2u << (x1 & 31)) - 1);
+                }
+                if (x0 > 0 && markerTopEdge(x0 - 1, y)){
+                    continue; // the tail of a run from the word before
+                }
+                int len = x1 - x0 + 1;
+                if (len < MARKER_MIN_PX || len > MARKER_MAX_PX){
+                    continue;
+                }
+                // skip the inside of markers already found
+                int inside = 0;
+                for(k=0;k<n;k++){
+                    int s = found[k].size;
+                    if (x0 < found[k].x + s && x1 > found[k].x - s && y > found[k].y - s && y < found[k].y + s){
+                        inside = 1;
+                    }
+                }
+                if (!inside && markerSample(x0, x1, y, &found[n]) == 0){
+                    n++;
+                }
+            }
+        }
+    }
+    return n;
+}
+
+// === Checkpoints ===
+
+static markerPass_t markerLog[MARKER_LOG_SIZE];
+static int markerLogN = 0; // passes logged, the ring keeps the last MARKER_LOG_SIZE
+static int markerLastId = -1;
+static uint32_t markerSeenMs = 0; // last frame markerLastId was in view
+static uint32_t markerPassMs = 0; // when it was passed
+static uint32_t markerLapStartMs = 0;
+static uint32_t markerLapMs = 0;
+static int markerLapCount = 0;
+static int markerLapStarted = 0;
+
+void markerLogReset(){
+    markerLogN = 0;
+    markerLastId = -1;
+    markerLapMs = 0;
+    markerLapCount = 0;
+    markerLapStarted = 0;
+}
+
+// log the biggest marker in view, which is the nearest, if it is a new
+// pass. Returns its id or -1 if nothing new was passed.
+int markerLogUpdate(const marker_t *found, int n, uint32_t nowMs){
+    int i, best = -1;
+    for(i=0;i<n;i++){
+        if (best < 0 || found[i].size > found[best].size){
+            best = i;
+        }
+    }
+    if (best < 0){
+        return -1;
+    }
+    int id = found[best].id;
+    if (id == markerLastId && nowMs - markerSeenMs < MARKER_HOLDOFF_MS){
+        markerSeenMs = nowMs; // still in view
+        return -1;
+    }
+    if (id == MARKER_START_ID){
+        if (markerLapStarted){
+            markerLapMs = nowMs - markerLapStartMs;
+            markerLapCount++;
+        }
+        markerLapStarted = 1;
+        markerLapStartMs = nowMs;
+    }
+    markerPass_t *p = &markerLog[markerLogN % MARKER_LOG_SIZE];
+    p->id = (uint8_t)id;
+    p->lap = (uint8_t)markerLapCount;
+    p->timeMs = nowMs;
+    p->segmentMs = markerLastId >= 0 ? nowMs - markerPassMs : 0;
+    markerLogN++;
+    markerLastId = id;
+    markerSeenMs = markerPassMs = nowMs;
+    return id;
+}
+
+int markerLogCount(){
+    return markerLogN < MARKER_LOG_SIZE ? markerLogN : MARKER_LOG_SIZE;
+}
+
+// i = 0 is the oldest pass still in the log
+const markerPass_t *markerLogEntry(int i){
+    int first = markerLogN < MARKER_LOG_SIZE ? 0 : markerLogN - MARKER_LOG_SIZE;
+    return &markerLog[(first + i) % MARKER_LOG_SIZE];
+}
+
+uint32_t markerLastLapMs(){
+    return markerLapMs;
+}
+
+int markerLaps(){
+    return markerLapCount;
+}
@@ -0,0 +1,55 @@
+#ifndef MARKER_h
+#define MARKER_h
+
+#include <stdint.h>
+#include "cam.h"
+
+// Square fiducial markers beside the track for lap timing and checkpoints.
+// A marker is 6x6 cells: a black border around 4x4 data bits, on white
+// paper with a one cell quiet zone, like a 4x4 ArUco code. The frame is
+// thresholded into one bit per pixel and the cells are sampled from that.
+// The camera sees the floor at an angle, so markers are allowed to look
+// shorter than wide and wider at the bottom, but must be square to the
+// image within a few degrees. They can be turned by any multiple of 90.
+
+#define MARKER_IDS 16
+#define MARKER_CELLS 6 // across, border included
+#define MARKER_MIN_CELL 2 // smallest cell in pixels that still decodes
+#define MARKER_MIN_PX (MARKER_CELLS*MARKER_MIN_CELL)
+#define MARKER_MAX_PX (IMAGESIZEX/2)
+#define MARKER_MAX_FIX 1 // data bits corrected, codes are 5 apart
+#define MARKER_MAX_FOUND 4
+#define MARKER_WORDS ((IMAGESIZEX+31)/32) // 32 pixels to a word
+
+typedef struct marker {
+    uint8_t id;
+    uint8_t rotation; // quarter turns clockwise
+    uint8_t fixed; // data bits that were corrected
+    int16_t x, y; // centre in pixels
+    int16_t size; // width of the top edge in pixels
+} marker_t;
+
+int markerDetect(marker_t *found, int max);
+uint16_t markerCode(int id);
+uint16_t markerRotate(uint16_t code);
+
+// checkpoint log: each marker passed, MARKER_START_ID is the start line
+#define MARKER_START_ID 0
+#define MARKER_HOLDOFF_MS 1000 // the same marker seen again this soon is the same pass
+#define MARKER_LOG_SIZE 32
+
+typedef struct markerPass {
+    uint8_t id;
+    uint8_t lap; // laps finished when it was passed
+    uint32_t timeMs;
+    uint32_t segmentMs; // since the checkpoint before, 0 for the first
+} markerPass_t;
+
+void markerLogReset();
+int markerLogUpdate(const marker_t *found, int n, uint32_t nowMs);
+int markerLogCount();
+const markerPass_t *markerLogEntry(int i);
+uint32_t markerLastLapMs();
+int markerLaps();
+
+#endif
@@ -0,0 +1,358 @@
+#include <string.h>
+#include "pico/stdlib.h"
+#include "nn.h"
+
+#if defined(__ARM_FEATURE_SIMD32)
+#include <arm_acle.h>
+#define NN_SIMD 1
+#define NN_SXTB16(x) __sxtb16(x)
+#define NN_SMLAD(a, b, acc) __smlad(a, b, acc)
+#define NN_ROR8(x) __ror(x, 8)
+#elif defined(NN_EMULATE_SIMD32)
+// host stand-ins for the M33 DSP instructions, so that path can be
+// checked against the reference on a PC
+#define NN_SIMD 1
+static inline uint32_t NN_SXTB16(uint32_t x){
+    return ((uint32_t)(uint16_t)(int8_t)(x & 0xFF)) | ((uint32_t)(uint16_t)(int8_t)((x >> 16) & 0xFF) << 16);
+}
+static inline int32_t NN_SMLAD(uint32_t a, uint32_t b, int32_t acc){
+    uint32_t r = (uint32_t)acc;
+    r += (uint32_t)((int16_t)a * (int16_t)b);
+    r += (uint32_t)((int16_t)(a >> 16) * (int16_t)(b >> 16));
+    return (int32_t)r;
+}
+#define NN_ROR8(x) (((x) >> 8) | ((x) << 24))
+#else
+#define NN_SIMD 0
+#endif
+
+static nnLayer_t nnLayers[NN_MAX_LAYERS];
+static int nnLayerCount = 0;
+static int32_t nnOutScale[NN_OUTPUTS];
+static uint32_t nnLayerUs[NN_MAX_LAYERS];
+
+// two activation buffers, layer i reads half i%2 and writes the other
+static int8_t nnArena[NN_ARENA_SIZE] __attribute__((aligned(4)));
+#define NN_HALF (NN_ARENA_SIZE/2)
+
+static int8_t *nnBuffer(int i){
+    return nnArena + (i & 1)*NN_HALF;
+}
+
+// parse a model blob, the layers keep pointers into it so it must stay put
+int nnLoad(const uint8_t *blob, uint32_t len){
+    nnModelHeader_t h;
+    nnLayerCount = 0;
+    if (((uintptr_t)blob & 3) || len < sizeof(h)){
+        return NN_ERR_SIZE;
+    }
+    memcpy(&h, blob, sizeof(h));
+    if (h.magic != NN_MAGIC){
+        return NN_ERR_MAGIC;
+    }
+    if (h.inX != NN_INPUT_X || h.inY != NN_INPUT_Y || h.inC != 1){
+        return NN_ERR_INPUT;
+    }
+    if (h.numLayers == 0 || h.numLayers > NN_MAX_LAYERS){
+        return NN_ERR_LAYER;
+    }
+
+    uint32_t pos = sizeof(h);
+    uint16_t x = h.inX, y = h.inY, c = h.inC;
+    int i;
+    for(i=0;i<h.numLayers;i++){
+        nnLayerHeader_t lh;
+        nnLayer_t *l = &nnLayers[i];
+        if (pos + sizeof(lh) > len){
+            return NN_ERR_SIZE;
+        }
+        memcpy(&lh, blob + pos, sizeof(lh));
+        pos += sizeof(lh);
+
+        l->type = lh.type;
+        l->k = lh.k;
+        l->stride = lh.stride ? lh.stride : 1;
+        l->relu = lh.relu;
+        l->mult = lh.mult;
+        l->shift = lh.shift;
+        l->inX = x;
+        l->inY = y;
+        l->inC = c;
+        l->bias = NULL;
+        l->weights = NULL;
+
+        uint32_t numWeights = 0;
+        switch (l->type){
+            case NN_LAYER_CONV:
+                l->outX = (x + l->stride - 1) / l->stride;
+                l->outY = (y + l->stride - 1) / l->stride;
+                l->outC = lh.outC;
+                numWeights = (uint32_t)l->outC * l->k * l->k * c;
+                break;
+            case NN_LAYER_DEPTHWISE:
+                if (c > NN_MAX_CHANNELS){
+                    return NN_ERR_LAYER;
+                }
+                l->outX = (x + l->stride - 1) / l->stride;
+                l->outY = (y + l->stride - 1) / l->stride;
+                l->outC = c;
+                numWeights = (uint32_t)l->k * l->k * c;
+                break;
+            case NN_LAYER_MAXPOOL:
+                if (l->k == 0){
+                    return NN_ERR_LAYER;
+                }
+                l->outX = x / l->k;
+                l->outY = y / l->k;
+                l->outC = c;
+                break;
+            case NN_LAYER_DENSE:
+                l->outX = 1;
+                l->outY = 1;
+                l->outC = lh.outC;
+                numWeights = (uint32_t)l->outC * x * y * c;
+                break;
+            default:
+                return NN_ERR_LAYER;
+        }
+        if (l->type != NN_LAYER_MAXPOOL){
+            // keep the rounding shift in range, see nnRequant()
+            if (l->shift < -30 || l->shift > 31){
+                return NN_ERR_LAYER;
+            }
+            uint32_t biasBytes = 4u * l->outC;
+            uint32_t weightBytes = (numWeights + 3) & ~3u;
+            if (pos + biasBytes + weightBytes > len){
+                return NN_ERR_SIZE;
+            }
+            l->bias = (const int32_t *)(blob + pos);
+            l->weights = (const int8_t *)(blob + pos + biasBytes);
+            pos += biasBytes + weightBytes;
+        }
+        if ((uint32_t)l->outX * l->outY * l->outC > NN_HALF || (uint32_t)x * y * c > NN_HALF){
+            return NN_ERR_ARENA;
+        }
+        x = l->outX;
+        y = l->outY;
+        c = l->outC;
+    }
+    if (x * y * c != NN_OUTPUTS){
+        return NN_ERR_OUTPUT;
+    }
+    memcpy(nnOutScale, h.outScale, sizeof(nnOutScale));
+    nnLayerCount = h.numLayers;
+    return NN_OK;
+}
+
+int nnNumLayers(){
+    return nnLayerCount;
+}
+
+const nnLayer_t *nnGetLayer(int i){
+    return &nnLayers[i];
+}
+
+// shrink cameraData 2x2 into the input buffer, luma - 128
+void nnLoadCameraFrame(){
+    uint8_t rowA[IMAGESIZEX];
+    uint8_t rowB[IMAGESIZEX];
+    int8_t *in = nnBuffer(0);
+    int x, y;
+    for(y=0;y<NN_INPUT_Y;y++){
+        getLumaRow(2*y, rowA);
+        getLumaRow(2*y+1, rowB);
+        for(x=0;x<NN_INPUT_X;x++){
+            int sum = rowA[2*x] + rowA[2*x+1] + rowB[2*x] + rowB[2*x+1];
+            in[y*NN_INPUT_X+x] = (int8_t)((sum >> 2) - 128);
+        }
+    }
+}
+
+// copy an already prepared NN_INPUT_X x NN_INPUT_Y input in
+void nnSetInput(const int8_t *input){
+    memcpy(nnBuffer(0), input, NN_INPUT_X*NN_INPUT_Y);
+}
+
+// int32 sum scaled back to int8, acc * mult / 2^(31 + shift), rounded
+static inline int8_t nnRequant(int32_t acc, const nnLayer_t *l){
+    int total = 31 + l->shift;
+    int64_t p = (int64_t)acc * l->mult;
+    p = (p + ((int64_t)1 << (total - 1))) >> total;
+    int32_t lo = l->relu ? 0 : -128;
+    if (p < lo) p = lo;
+    if (p > 127) p = 127;
+    return (int8_t)p;
+}
+
+// acc + sum of a[i]*b[i], 4 at a time
+static inline int32_t nnDot(const int8_t *a, const int8_t *b, int n, int32_t acc){
+#if NN_SIMD
+    for(;n>=4;n-=4){
+        uint32_t wa, wb;
+        memcpy(&wa, a, 4);
+        memcpy(&wb, b, 4);
+        acc = NN_SMLAD(NN_SXTB16(wa), NN_SXTB16(wb), acc); // bytes 0 and 2
+        acc = NN_SMLAD(NN_SXTB16(NN_ROR8(wa)), NN_SXTB16(NN_ROR8(wb)), acc); // bytes 1 and 3
+        a += 4;
+        b += 4;
+    }
+#else
+    // M0+ has a single cycle multiplier, unrolling saves the loop overhead
+    for(;n>=4;n-=4){
+        acc += a[0]*b[0] + a[1]*b[1] + a[2]*b[2] + a[3]*b[3];
+        a += 4;
+        b += 4;
+    }
+#endif
+    for(;n>0;n--){
+        acc += *a++ * *b++;
+    }
+    return acc;
+}
+
+// HWC layout, weights [outC][k][k][inC]. Inside the image a kernel row is
+// k*inC contiguous bytes in both input and weights, so it is one dot product.
+static void nnConv(const nnLayer_t *l, const int8_t *in, int8_t *out){
+    int k = l->k, pad = l->k/2;
+    int rowLen = k*l->inC;
+    int ox, oy, oc, ky, kx;
+    for(oy=0;oy<l->outY;oy++){
+        for(ox=0;ox<l->outX;ox++){
+            int x0 = ox*l->stride - pad;
+            int y0 = oy*l->stride - pad;
+            int inside = x0 >= 0 && x0 + k <= l->inX;
+            for(oc=0;oc<l->outC;oc++){
+                const int8_t *w = l->weights + oc*k*rowLen;
+                int32_t acc = l->bias[oc];
+                for(ky=0;ky<k;ky++){
+                    int iy = y0 + ky;
+                    if (iy < 0 || iy >= l->inY){
+                        continue;
+                    }
+                    const int8_t *row = in + iy*l->inX*l->inC;
+                    const int8_t *wrow = w + ky*rowLen;
+                    if (inside){
+                        acc = nnDot(wrow, row + x0*l->inC, rowLen, acc);
+                    }
+                    else {
+                        for(kx=0;kx<k;kx++){
+                            int ix = x0 + kx;
+                            if (ix >= 0 && ix < l->inX){
+                                acc = nnDot(wrow + kx*l->inC, row + ix*l->inC, l->inC, acc);
+                            }
+                        }
+                    }
+                }
+                out[(oy*l->outX + ox)*l->outC + oc] = nnRequant(acc, l);
+            }
+        }
+    }
+}
+
+// weights [k][k][C], every channel on its own
+static void nnDepthwise(const nnLayer_t *l, const int8_t *in, int8_t *out){
+    int32_t acc[NN_MAX_CHANNELS];
+    int k = l->k, pad = l->k/2, C = l->inC;
+    int ox, oy, c, ky, kx;
+    for(oy=0;oy<l->outY;oy++){
+        for(ox=0;ox<l->outX;ox++){
+            for(c=0;c<C;c++){
+                acc[c] = l->bias[c];
+            }
+            for(ky=0;ky<k;ky++){
+                int iy = oy*l->stride - pad + ky;
+                if (iy < 0 || iy >= l->inY){
+                    continue;
+                }
+                for(kx=0;kx<k;kx++){
+                    int ix = ox*l->stride - pad + kx;
+                    if (ix < 0 || ix >= l->inX){
+                        continue;
+                    }
+                    const int8_t *p = in + (iy*l->inX + ix)*C;
+                    const int8_t *w = l->weights + (ky*k + kx)*C;
+                    for(c=0;c<C;c++){
+                        acc[c] += p[c]*w[c];
+                    }
+                }
+            }
+            int8_t *o = out + (oy*l->outX + ox)*C;
+            for(c=0;c<C;c++){
+                o[c] = nnRequant(acc[c], l);
+            }
+        }
+    }
+}
+
+static void nnMaxPool(const nnLayer_t *l, const int8_t *in, int8_t *out){
+    int k = l->k, C = l->inC;
+    int ox, oy, c, ky, kx;
+    for(oy=0;oy<l->outY;oy++){
+        for(ox=0;ox<l->outX;ox++){
+            int8_t *o = out + (oy*l->outX + ox)*C;
+            for(c=0;c<C;c++){
+                o[c] = -128;
+            }
+            for(ky=0;ky<k;ky++){
+                for(kx=0;kx<k;kx++){
+                    const int8_t *p = in + ((oy*k + ky)*l->inX + ox*k + kx)*C;
+                    for(c=0;c<C;c++){
+                        if (p[c] > o[c]){
+                            o[c] = p[c];
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+static void nnDense(const nnLayer_t *l, const int8_t *in, int8_t *out){
+    int n = l->inX*l->inY*l->inC;
+    int o;
+    for(o=0;o<l->outC;o++){
+        out[o] = nnRequant(nnDot(l->weights + o*n, in, n, l->bias[o]), l);
+    }
+}
+
+void nnRunLayer(int i){
+    const nnLayer_t *l = &nnLayers[i];
+    const int8_t *in = nnBuffer(i);
+    int8_t *out = nnBuffer(i+1);
+    switch (l->type){
+        case NN_LAYER_CONV: nnConv(l, in, out); break;
+        case NN_LAYER_DEPTHWISE: nnDepthwise(l, in, out); break;
+        case NN_LAYER_MAXPOOL: nnMaxPool(l, in, out); break;
+        case NN_LAYER_DENSE: nnDense(l, in, out); break;
+    }
+}
+
+// run every layer on the current input, timing each one
+void nnRun(){
+    int i;
+    for(i=0;i<nnLayerCount;i++){
+        uint32_t t0 = time_us_32();
+        nnRunLayer(i);
+        nnLayerUs[i] = time_us_32() - t0;
+    }
+}
+
+// output of layer i, only valid until the next layer runs
+const int8_t *nnGetLayerOutput(int i){
+    return nnBuffer(i+1);
+}
+
+const int8_t *nnGetOutputRaw(){
+    return nnBuffer(nnLayerCount);
+}
+
+// offset in pixels from the image centre, heading in tenths of a degree
+void nnGetOutput(int32_t *offset, int32_t *heading){
+    const int8_t *out = nnGetOutputRaw();
+    *offset = (out[0] * nnOutScale[0]) >> 16;
+    *heading = (out[1] * nnOutScale[1]) >> 16;
+}
+
+uint32_t nnGetLayerUs(int i){
+    return nnLayerUs[i];
+}
@@ -0,0 +1,78 @@
+#ifndef NN_h
+#define NN_h
+
+#include <stdint.h>
+#include "cam.h"
+
+// Small int8 CNN runtime for steering straight from the camera.
+// The model is a blob (see host/tools/nn_pack.py) that stays in flash,
+// layers point into it. Activations live in a static arena, two halves
+// used ping-pong, so nothing is allocated at run time.
+//
+// Quantization is symmetric: int8 activations and weights with no zero
+// point, int32 bias, and every layer rescales its int32 sums with
+// acc * mult / 2^(31 + shift).
+
+#define NN_MAGIC 0x31424E4E // "NNB1"
+#define NN_MAX_LAYERS 16
+#define NN_ARENA_SIZE 12288 // bytes, both activation buffers
+#define NN_INPUT_X (IMAGESIZEX/2) // the camera frame is shrunk 2x2
+#define NN_INPUT_Y (IMAGESIZEY/2)
+#define NN_OUTPUTS 2 // line offset and heading
+#define NN_MAX_CHANNELS 64 // widest depthwise layer
+
+#define NN_LAYER_CONV 1 // k x k convolution, same padding
+#define NN_LAYER_DEPTHWISE 2 // k x k per channel convolution, same padding
+#define NN_LAYER_MAXPOOL 3 // k x k max, stride k
+#define NN_LAYER_DENSE 4 // fully connected on the flattened input
+
+#define NN_OK 0
+#define NN_ERR_MAGIC -1 // not a model blob
+#define NN_ERR_SIZE -2 // blob shorter than its layers say
+#define NN_ERR_LAYER -3 // unknown layer type or too many layers
+#define NN_ERR_ARENA -4 // an activation doesn't fit in half the arena
+#define NN_ERR_INPUT -5 // model input isn't NN_INPUT_X x NN_INPUT_Y x 1
+#define NN_ERR_OUTPUT -6 // model doesn't end in NN_OUTPUTS values
+// NN_ERR_SIZE is also returned for a blob that isn't 4 byte aligned
+
+typedef struct nnLayer {
+    uint8_t type;
+    uint8_t k; // kernel size
+    uint8_t stride;
+    uint8_t relu; // clamp the output at 0
+    uint16_t inX, inY, inC;
+    uint16_t outX, outY, outC;
+    int32_t mult; // Q31 requantization multiplier
+    int32_t shift; // extra right shift after mult
+    const int32_t *bias; // outC values, NULL for pooling
+    const int8_t *weights; // NULL for pooling
+} nnLayer_t;
+
+typedef struct nnModelHeader {
+    uint32_t magic;
+    uint16_t inX, inY, inC;
+    uint16_t numLayers;
+    int32_t outScale[NN_OUTPUTS]; // Q16, output int8 to pixels / tenths of a degree
+} nnModelHeader_t;
+
+// on disk layer record, followed by bias[outC] then weights padded to 4 bytes
+typedef struct nnLayerHeader {
+    uint8_t type, k, stride, relu;
+    uint16_t outC, reserved;
+    int32_t mult;
+    int32_t shift;
+} nnLayerHeader_t;
+
+int nnLoad(const uint8_t *blob, uint32_t len);
+int nnNumLayers();
+const nnLayer_t *nnGetLayer(int i);
+void nnLoadCameraFrame();
+void nnSetInput(const int8_t *input);
+void nnRunLayer(int i);
+void nnRun();
+const int8_t *nnGetLayerOutput(int i);
+const int8_t *nnGetOutputRaw();
+void nnGetOutput(int32_t *offset, int32_t *heading);
+uint32_t nnGetLayerUs(int i);
+
+#endif
@@ -0,0 +1,187 @@
+#ifndef NN_MODEL_h
+#define NN_MODEL_h
+
+// generated by host/tools/nn_pack.py from steer_tiny.json, do not edit
+// random placeholder weights, only good for timing until a trained model exists
+#define NN_MODEL_PLACEHOLDER 1
+
+#include <stdint.h>
+
+#define NN_MODEL_SIZE 2748
+
+static const uint8_t nn_model[NN_MODEL_SIZE] __attribute__((aligned(4))) = {
+    0x4e, 0x4e, 0x42, 0x31, 0x28, 0x00, 0x1e, 0x00, 0x01, 0x00, 0x05, 0x00, 0xa4, 0x50, 0x00, 0x00,
+    0x0a, 0x17, 0x07, 0x00, 0x01, 0x03, 0x02, 0x01, 0x08, 0x00, 0x00, 0x00, 0x55, 0x55, 0x55, 0x55,
+    0x07, 0x00, 0x00, 0x00, 0xac, 0xff, 0xff, 0xff, 0xe8, 0xff, 0xff, 0xff, 0x0c, 0xff, 0xff, 0xff,
+    0xcc, 0xff, 0xff, 0xff, 0xed, 0xff, 0xff, 0xff, 0x9e, 0x00, 0x00, 0x00, 0x60, 0x00, 0x00, 0x00,
+    0x69, 0x00, 0x00, 0x00, 0xe2, 0xd0, 0x01, 0xde, 0x3e, 0x33, 0x38, 0x21, 0xf5, 0xd8, 0x3c, 0xc7,
+    0x23, 0x2e, 0xc0, 0x32, 0x04, 0xfa, 0xda, 0x11, 0xc7, 0xc5, 0xc6, 0xc2, 0x21, 0xf7, 0x2c, 0xc7,
+    0xf8, 0x30, 0x3e, 0xfb, 0x18, 0xfb, 0xf8, 0x35, 0x0a, 0xc5, 0x2a, 0xd9, 0xef, 0x0b, 0xde, 0x15,
+    0x40, 0x2c, 0xf0, 0x0d, 0x08, 0x3f, 0x24, 0xc8, 0x3a, 0xfe, 0x27, 0x2a, 0xec, 0x1d, 0x1f, 0xd6,
+    0x30, 0xdb, 0xe9, 0x24, 0x1e, 0x3d, 0xc7, 0x38, 0xcb, 0x0e, 0x24, 0xeb, 0x02, 0x03, 0x01, 0x01,
+    0x00, 0x00, 0x00, 0x00, 0x55, 0x55, 0x55, 0x55, 0x07, 0x00, 0x00, 0x00, 0xe4, 0xff, 0xff, 0xff,
+    0x1f, 0xff, 0xff, 0xff, 0x94, 0x00, 0x00, 0x00, 0x48, 0x00, 0x00, 0x00, 0xb4, 0x00, 0x00, 0x00,
+    0x3c, 0xff, 0xff, 0xff, 0x31, 0x00, 0x00, 0x00, 0x80, 0xff, 0xff, 0xff, 0x35, 0x04, 0xc1, 0x22,
+    0xe1, 0xf4, 0x2d, 0xce, 0x3b, 0x1d, 0xf3, 0x29, 0x3c, 0x1b, 0x2a, 0x18, 0xc0, 0x14, 0x35, 0xc7,
+    0xfa, 0xed, 0xee, 0xd7, 0x01, 0xc8, 0xd2, 0xd5, 0xc4, 0x33, 0xc3, 0x07, 0xff, 0x04, 0xdc, 0xef,
+    0x18, 0x0a, 0xd1, 0xea, 0xe8, 0x01, 0xeb, 0x05, 0x0b, 0x34, 0x12, 0x3f, 0x39, 0xdd, 0xc6, 0x0f,
+    0x22, 0x17, 0x2b, 0xf0, 0x02, 0xdb, 0x00, 0xf5, 0x2e, 0xc5, 0xf9, 0xc4, 0x25, 0xe5, 0xc9, 0xe9,
+    0x32, 0x2d, 0xf8, 0x33, 0x01, 0x01, 0x01, 0x01, 0x10, 0x00, 0x00, 0x00, 0x9a, 0x79, 0x82, 0x5a,
+    0x07, 0x00, 0x00, 0x00, 0xdc, 0xff, 0xff, 0xff, 0xe0, 0x00, 0x00, 0x00, 0x6c, 0x00, 0x00, 0x00,
+    0x09, 0x00, 0x00, 0x00, 0xbb, 0xff, 0xff, 0xff, 0xd4, 0xff, 0xff, 0xff, 0x3a, 0x00, 0x00, 0x00,
+    0xcb, 0xff, 0xff, 0xff, 0xfc, 0xff, 0xff, 0xff, 0x71, 0x00, 0x00, 0x00, 0x53, 0xff, 0xff, 0xff,
+    0x1f, 0x00, 0x00, 0x00, 0x5b, 0xff, 0xff, 0xff, 0xca, 0x00, 0x00, 0x00, 0x5c, 0xff, 0xff, 0xff,
+    0x5b, 0x00, 0x00, 0x00, 0xf6, 0xcc, 0x0e, 0xd2, 0xd3, 0x0f, 0x0c, 0xe8, 0x2a, 0x00, 0xe1, 0xc2,
+    0xc9, 0xf7, 0x35, 0xeb, 0xc9, 0x20, 0xf3, 0x18, 0xd9, 0xf4, 0x2e, 0xf1, 0x3e, 0xda, 0x23, 0x0b,
+    0x3f, 0xc4, 0x13, 0x26, 0x08, 0xc4, 0xe8, 0xf3, 0x13, 0xe2, 0x16, 0x2d, 0xf6, 0x04, 0xd8, 0x21,
+    0x18, 0x3c, 0xfc, 0xd0, 0xca, 0xd5, 0xe2, 0xeb, 0xea, 0xf6, 0x04, 0x15, 0x01, 0x1e, 0x16, 0x17,
+    0xdd, 0x0a, 0xfc, 0x3d, 0xe2, 0xda, 0x12, 0xca, 0x28, 0xd2, 0x21, 0xe5, 0xe0, 0x17, 0xdd, 0x20,
+    0xd3, 0xf9, 0xd4, 0x04, 0x1d, 0x0b, 0xdd, 0x35, 0x06, 0xdb, 0xcb, 0x0b, 0xc3, 0xc3, 0xd7, 0x29,
+    0xdd, 0xca, 0xf0, 0xfd, 0x2b, 0xe9, 0xdd, 0x33, 0xea, 0xfd, 0xe8, 0xda, 0x2f, 0x20, 0x0b, 0x00,
+    0x3a, 0x10, 0xd9, 0xf5, 0x11, 0xca, 0xc6, 0xc2, 0x0b, 0x11, 0x33, 0x24, 0x10, 0x26, 0xd0, 0xd0,
+    0x11, 0x34, 0xdc, 0x00, 0x03, 0x02, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x04, 0x00, 0x01, 0x00, 0x02, 0x00, 0x00, 0x00, 0x6b, 0x33, 0x64, 0x7a,
+    0x0b, 0x00, 0x00, 0x00, 0x56, 0xff, 0xff, 0xff, 0x0b, 0x00, 0x00, 0x00, 0xfa, 0x23, 0x0e, 0xca,
+    0x13, 0xef, 0x11, 0x0d, 0xfe, 0x15, 0xd9, 0xd7, 0xfe, 0xf8, 0xc5, 0xfe, 0x26, 0xd2, 0x04, 0xd2,
+    0xd3, 0xc5, 0xc2, 0x0a, 0x1b, 0x3e, 0x38, 0xe7, 0xd9, 0x40, 0x13, 0xd3, 0xec, 0xed, 0xe6, 0xe4,
+    0x11, 0x0e, 0xdb, 0x0b, 0xe0, 0xf4, 0xe4, 0xc8, 0x10, 0xf4, 0xed, 0x0c, 0x2e, 0xe8, 0xcc, 0xff,
+    0x00, 0xd0, 0x32, 0x2e, 0x00, 0x30, 0x34, 0xc2, 0x25, 0x16, 0xeb, 0x02, 0x3c, 0xc6, 0x2a, 0xc4,
+    0xcf, 0x1a, 0xe3, 0xe0, 0xe3, 0x02, 0x06, 0x25, 0x26, 0xec, 0xd6, 0xfb, 0x3c, 0xc1, 0xed, 0x11,
+    0x40, 0x30, 0xf9, 0xfd, 0x10, 0x3e, 0x3a, 0xf9, 0x29, 0x16, 0x06, 0xf8, 0xcc, 0xd2, 0x1e, 0xe8,
+    0xf4, 0x0f, 0x0c, 0x0c, 0x1f, 0xea, 0x36, 0xd5, 0xdf, 0x20, 0xed, 0xe7, 0x00, 0x2d, 0xf7, 0xcd,
+    0x3e, 0x24, 0x19, 0x22, 0xea, 0xca, 0xd7, 0x01, 0xd9, 0x04, 0xd5, 0xe3, 0xd4, 0x31, 0xfd, 0x21,
+    0x2e, 0x25, 0xea, 0x13, 0x30, 0xe0, 0x3c, 0xf6, 0xde, 0x2e, 0x28, 0xde, 0x0b, 0x07, 0xff, 0x20,
+    0xc1, 0xf0, 0x30, 0xc5, 0xc7, 0xfe, 0x02, 0xf4, 0xec, 0x08, 0xe5, 0xf3, 0x05, 0x0f, 0x00, 0x32,
+    0xeb, 0x1b, 0x3d, 0x2b, 0xdf, 0xf5, 0x22, 0xf4, 0x08, 0xdb, 0xc6, 0xde, 0xc3, 0x0b, 0xe2, 0xd3,
+    0x40, 0x1f, 0x0f, 0x2f, 0x40, 0x1b, 0x12, 0xc0, 0xdf, 0x31, 0x33, 0x19, 0x0e, 0x26, 0x16, 0x3e,
+    0xdc, 0x20, 0x21, 0xf4, 0xc0, 0x07, 0xf2, 0x36, 0x28, 0x0e, 0xeb, 0x33, 0xf2, 0x1c, 0xc0, 0x23,
+    0x2d, 0x27, 0x16, 0xd1, 0x3e, 0xff, 0x0a, 0xc5, 0x28, 0xe7, 0x25, 0x05, 0xed, 0xd2, 0xc2, 0x19,
+    0x03, 0x29, 0x0d, 0xe6, 0x36, 0x02, 0x3c, 0xeb, 0x37, 0xcb, 0x05, 0xd9, 0x2c, 0xd1, 0x1a, 0xd1,
+    0x31, 0xc5, 0xea, 0xe9, 0xd7, 0x26, 0x06, 0x0d, 0xf5, 0xf5, 0xfc, 0x15, 0x04, 0xd1, 0xd3, 0x1e,
+    0x37, 0xcc, 0xeb, 0x0c, 0x05, 0x1b, 0xfb, 0x24, 0x26, 0xec, 0x3b, 0x02, 0x14, 0xf8, 0x02, 0xfe,
+    0xc7, 0x27, 0x11, 0x2e, 0xff, 0x04, 0xf0, 0xd2, 0xea, 0x31, 0xe5, 0x03, 0x35, 0xe9, 0xe3, 0xe3,
+    0x30, 0x1c, 0x0f, 0x26, 0xfd, 0xdd, 0xf4, 0x0e, 0xd1, 0xdb, 0xfa, 0x25, 0x12, 0x3e, 0xd9, 0xef,
+    0xcb, 0xce, 0xc5, 0xf7, 0xc8, 0x3e, 0x31, 0x17, 0x06, 0xde, 0xec, 0xd8, 0xf8, 0x26, 0xfb, 0x3e,
+    0x33, 0x20, 0xeb, 0xfb, 0xfc, 0x08, 0x36, 0x23, 0xf6, 0x33, 0x02, 0x14, 0x3f, 0xdc, 0xf6, 0xd4,
+    0xcb, 0xc3, 0xc1, 0x3a, 0x11, 0x22, 0x09, 0xf2, 0x26, 0xe8, 0xe6, 0xc7, 0xc3, 0x23, 0xe5, 0xce,
+    0x21, 0x01, 0xe1, 0xd4, 0x36, 0x0d, 0xc3, 0xc9, 0xcf, 0xe1, 0xca, 0x06, 0xde, 0x2e, 0xd7, 0xf0,
+    0xc7, 0x3f, 0xe1, 0x07, 0xf1, 0x32, 0x23, 0x14, 0x04, 0x02, 0xfe, 0xfe, 0xcf, 0xec, 0x19, 0x2d,
+    0xcf, 0x1a, 0x29, 0xf3, 0x2c, 0xd1, 0x04, 0xd2, 0x00, 0xed, 0xd8, 0xe6, 0xcf, 0xf4, 0x2d, 0xcb,
+    0xcd, 0xd7, 0x38, 0x40, 0x1e, 0xd9, 0x10, 0xca, 0xe0, 0xc8, 0x31, 0xe0, 0x25, 0x32, 0xc6, 0x05,
+    0xd7, 0x00, 0x13, 0xd5, 0x0d, 0xc8, 0x22, 0xce, 0x02, 0x10, 0xe1, 0x02, 0x21, 0xdd, 0x0d, 0xd8,
+    0x2c, 0xfe, 0x40, 0xf4, 0x14, 0x16, 0x24, 0x3b, 0xda, 0xe1, 0x32, 0xc7, 0x0a, 0xe8, 0xf3, 0x1e,
+    0x23, 0x13, 0xd8, 0x28, 0x18, 0xe0, 0xd0, 0xcb, 0x0c, 0x10, 0x2a, 0x0c, 0x11, 0x1a, 0x05, 0x13,
+    0x40, 0xc2, 0xdf, 0xe6, 0x11, 0x13, 0x13, 0xd1, 0x33, 0x07, 0x3a, 0x34, 0x1d, 0x21, 0xd4, 0xce,
+    0xe2, 0xcc, 0x3d, 0x00, 0xfe, 0x16, 0x1c, 0x1e, 0x27, 0x0e, 0x36, 0x17, 0xea, 0xc7, 0xe5, 0x00,
+    0xf8, 0xe2, 0xdc, 0xef, 0x29, 0xcc, 0xd9, 0x04, 0xdb, 0xf4, 0x02, 0xd1, 0xd4, 0xd2, 0xf7, 0xec,
+    0x2e, 0xc5, 0x1e, 0x3c, 0x08, 0xf8, 0xf3, 0x3e, 0xfc, 0x2c, 0x33, 0x1d, 0xf0, 0x3b, 0xd2, 0x01,
+    0x28, 0xf3, 0xc2, 0x21, 0x3c, 0xd3, 0x27, 0x2c, 0xca, 0x1a, 0x35, 0xc1, 0xf0, 0x0c, 0xc1, 0xde,
+    0x0d, 0x10, 0x08, 0x29, 0x28, 0x0e, 0x33, 0x0d, 0xe1, 0x31, 0xe3, 0xe9, 0x00, 0xc2, 0x2c, 0xc9,
+    0x1e, 0x2b, 0x26, 0x08, 0xc4, 0xd7, 0xd7, 0xc1, 0x22, 0x04, 0x36, 0x05, 0x1f, 0x3b, 0x16, 0x23,
+    0x34, 0xdd, 0x3b, 0x1a, 0xe5, 0x2a, 0xe5, 0xc4, 0xec, 0x02, 0x1e, 0xe0, 0x09, 0x29, 0x02, 0x09,
+    0x2b, 0x06, 0x2e, 0x15, 0x3c, 0xf7, 0x3d, 0x26, 0x2c, 0xd7, 0xd0, 0xe1, 0xf4, 0xe6, 0xfa, 0xc6,
+    0xda, 0x00, 0xe7, 0x3a, 0xd9, 0x26, 0xef, 0xc0, 0xd6, 0x2d, 0xcd, 0xf7, 0x2c, 0x18, 0xcc, 0xda,
+    0x2b, 0xde, 0x03, 0x07, 0xed, 0x3a, 0xcc, 0xf6, 0xd6, 0x23, 0xdf, 0x32, 0x0b, 0x3f, 0x24, 0xdd,
+    0x3a, 0xdb, 0xe6, 0x22, 0xf3, 0xea, 0x01, 0x2a, 0x09, 0x3e, 0xf6, 0x16, 0x3c, 0xda, 0xc2, 0x18,
+    0x04, 0xce, 0x30, 0x0c, 0xd9, 0xfa, 0x06, 0x05, 0xff, 0x29, 0xe5, 0xe1, 0x01, 0xf1, 0x28, 0xce,
+    0xe6, 0x29, 0x05, 0x07, 0x3a, 0x0e, 0x04, 0x3d, 0xf6, 0x3f, 0x1e, 0x38, 0xfd, 0x16, 0xed, 0xee,
+    0x33, 0xe6, 0xce, 0x13, 0xe2, 0xf6, 0x10, 0x3e, 0x3a, 0x14, 0xde, 0xe0, 0xe3, 0x01, 0xf9, 0xd6,
+    0xcc, 0xec, 0xdd, 0xf9, 0xf3, 0x40, 0x0e, 0x2c, 0x13, 0xc1, 0xc5, 0x0e, 0xf8, 0xd5, 0xf9, 0x07,
+    0x17, 0x04, 0x21, 0xc5, 0xdf, 0x14, 0x18, 0xe3, 0xdd, 0x00, 0xe4, 0xca, 0x18, 0xd3, 0xd7, 0xda,
+    0x0c, 0x11, 0xff, 0x04, 0xcc, 0x1c, 0xc7, 0xd4, 0xe3, 0x26, 0x1f, 0xfd, 0xd8, 0x14, 0x06, 0xc2,
+    0x12, 0xdc, 0x1a, 0xe0, 0x05, 0x27, 0xd7, 0x39, 0x2b, 0x24, 0x0d, 0xf8, 0x0d, 0xe2, 0xcd, 0xdc,
+    0xec, 0xfd, 0xf7, 0x2f, 0x06, 0xc5, 0x00, 0x05, 0x03, 0x39, 0xe0, 0x27, 0xda, 0x1f, 0xd1, 0x1c,
+    0xc7, 0x0e, 0x32, 0xe1, 0xe7, 0xd3, 0xe4, 0xf7, 0x3b, 0x15, 0x1d, 0x0a, 0xe8, 0xe7, 0x21, 0x30,
+    0x27, 0xde, 0xe5, 0x05, 0x0b, 0xc2, 0xc2, 0xe1, 0x21, 0xd9, 0x35, 0xc7, 0x2e, 0x2c, 0x06, 0x1e,
+    0x28, 0x27, 0x36, 0xcd, 0xd9, 0x38, 0xc9, 0xc0, 0xca, 0xdc, 0xe3, 0x1b, 0x05, 0x1b, 0x39, 0xfe,
+    0xfd, 0xdb, 0x1b, 0xe8, 0xdd, 0xca, 0x10, 0x2c, 0x18, 0x00, 0xce, 0x2f, 0x2a, 0x20, 0x1b, 0x0b,
+    0x17, 0x30, 0xfc, 0xe4, 0xce, 0x17, 0xdd, 0xec, 0x3c, 0x17, 0xdf, 0xc5, 0x3a, 0xf5, 0x22, 0xec,
+    0x25, 0xfa, 0xd9, 0xff, 0x15, 0x14, 0xfe, 0x36, 0x38, 0x1e, 0x3e, 0xf1, 0x2e, 0x30, 0x26, 0xde,
+    0x3c, 0x04, 0xe0, 0xe6, 0xc3, 0x20, 0x2a, 0xdb, 0xc6, 0xd3, 0xee, 0x35, 0x20, 0x40, 0x09, 0xe7,
+    0xe7, 0xdb, 0x01, 0xc4, 0x36, 0x25, 0xfa, 0x24, 0xc1, 0xff, 0x2c, 0xe8, 0xed, 0x17, 0xfd, 0xd3,
+    0xe9, 0xec, 0x20, 0xc5, 0xf7, 0x2d, 0xfc, 0xca, 0xf0, 0xd3, 0xff, 0x25, 0x37, 0xde, 0xcc, 0x23,
+    0xd6, 0xd8, 0x3a, 0xcb, 0xfd, 0xc3, 0xc5, 0x0f, 0x37, 0x07, 0x2a, 0xea, 0xe2, 0x11, 0x32, 0x40,
+    0x2a, 0xea, 0x25, 0x23, 0xf3, 0x3e, 0x07, 0x1c, 0xe6, 0x02, 0x07, 0xec, 0xd5, 0x1c, 0x16, 0xe4,
+    0x02, 0x01, 0x00, 0x19, 0x22, 0x07, 0x37, 0xc3, 0xe6, 0xe1, 0x00, 0xf9, 0xf2, 0xd2, 0xf2, 0x2d,
+    0xfd, 0xe3, 0x35, 0x24, 0xf2, 0xd5, 0xd3, 0xe7, 0xce, 0xc7, 0x27, 0x21, 0x2a, 0xe3, 0xe1, 0xd2,
+    0xfd, 0x21, 0xe3, 0x09, 0xf3, 0x25, 0x1b, 0xed, 0xf9, 0x0c, 0xe4, 0x19, 0x3d, 0x0a, 0xd6, 0x0c,
+    0xf5, 0x36, 0xc5, 0x0a, 0xda, 0x1f, 0x31, 0x01, 0xce, 0xcd, 0x10, 0xe8, 0xe1, 0xda, 0xdc, 0x2f,
+    0xfe, 0xf5, 0x25, 0xdf, 0xf6, 0x22, 0xe2, 0x01, 0xc0, 0xde, 0xf3, 0x20, 0x3b, 0xfb, 0x04, 0xc9,
+    0xea, 0x40, 0xfb, 0x29, 0x06, 0x2b, 0x26, 0x05, 0x3e, 0xd9, 0xe1, 0xef, 0xc4, 0x34, 0xcb, 0x3d,
+    0xf6, 0x24, 0x16, 0xfe, 0xd8, 0xd3, 0xca, 0x2c, 0x31, 0xf0, 0xec, 0x40, 0xf0, 0x22, 0x1c, 0xf2,
+    0xfb, 0x1c, 0xd0, 0x17, 0xcd, 0x35, 0xcb, 0xed, 0xe5, 0x09, 0x38, 0xcb, 0x40, 0xd0, 0x25, 0xd7,
+    0x26, 0x0d, 0x24, 0x04, 0x1a, 0x38, 0xcc, 0x3a, 0xc4, 0x2d, 0x0d, 0x11, 0xe6, 0x07, 0xd0, 0x1c,
+    0x2a, 0x24, 0xc6, 0xdd, 0xc9, 0xc3, 0xd9, 0x15, 0x16, 0x1e, 0xc8, 0x1e, 0xd2, 0x3c, 0xd5, 0x32,
+    0x15, 0x40, 0xc0, 0xe9, 0x13, 0x1c, 0xf6, 0xe5, 0xe5, 0xdb, 0x27, 0x11, 0x2b, 0x1c, 0x17, 0x02,
+    0x1e, 0xc9, 0xd0, 0xff, 0x03, 0x25, 0x08, 0xd5, 0xd3, 0xeb, 0x04, 0x29, 0xd5, 0xe0, 0x08, 0x03,
+    0xfc, 0xf5, 0xd9, 0x06, 0x3a, 0xcc, 0x0d, 0xf4, 0xd3, 0x10, 0x16, 0x0b, 0xe2, 0xc9, 0x31, 0x1d,
+    0xc9, 0xc7, 0x10, 0x2a, 0xe9, 0xca, 0x2c, 0xef, 0xf2, 0xfb, 0xdd, 0xe1, 0xdf, 0x04, 0x35, 0xf2,
+    0xce, 0x1c, 0x34, 0x15, 0x1a, 0xf8, 0xc2, 0xc3, 0x3d, 0xc8, 0xea, 0x00, 0xca, 0xc2, 0xfa, 0xd5,
+    0xec, 0xc8, 0xf3, 0xf5, 0x31, 0x09, 0xfe, 0x3d, 0x1f, 0x13, 0x24, 0xd2, 0xf1, 0xee, 0xf0, 0x0c,
+    0x2d, 0x39, 0x1d, 0xc5, 0x3c, 0xc5, 0xda, 0x2e, 0x17, 0x16, 0xd2, 0x2b, 0xf1, 0x3e, 0x40, 0x3a,
+    0x33, 0x38, 0xea, 0x04, 0x0d, 0x25, 0x02, 0x01, 0x0f, 0xc3, 0xcb, 0x35, 0x35, 0x1b, 0xfb, 0x31,
+    0xf5, 0x39, 0x15, 0xe5, 0x22, 0x2f, 0xcd, 0xdc, 0x1b, 0xc2, 0x01, 0xcd, 0x0e, 0x20, 0xc3, 0x13,
+    0x16, 0x0f, 0xcc, 0xf5, 0xd4, 0x14, 0xde, 0xd0, 0xe0, 0x0b, 0x28, 0x17, 0xfb, 0xc6, 0xee, 0x1d,
+    0x0d, 0x0b, 0x20, 0x2b, 0x36, 0xd2, 0xf2, 0x28, 0xfb, 0xca, 0xfd, 0xf9, 0xfe, 0x25, 0x21, 0xf5,
+    0xe6, 0x0c, 0x1c, 0xc0, 0x0e, 0x31, 0x3f, 0xeb, 0xe5, 0xc7, 0x1e, 0x2f, 0x17, 0x3d, 0x11, 0xdc,
+    0x0a, 0x06, 0x2d, 0xc2, 0x0f, 0xd6, 0x3d, 0xdd, 0x40, 0xf8, 0x03, 0x2f, 0x1f, 0xfb, 0xcd, 0xda,
+    0xe9, 0xe1, 0x0a, 0xcc, 0xd1, 0xf7, 0xc0, 0xcf, 0x2c, 0xc5, 0xd0, 0xce, 0xc2, 0xc8, 0x16, 0x15,
+    0xc4, 0xc2, 0xf6, 0x38, 0xf3, 0x04, 0x0b, 0x00, 0xfb, 0xee, 0xf5, 0x24, 0xcf, 0xfd, 0x33, 0xc9,
+    0x14, 0x13, 0x28, 0xde, 0xc4, 0xef, 0xd7, 0xef, 0xf7, 0xf9, 0xed, 0x0d, 0xd9, 0xcf, 0x10, 0xe5,
+    0xd0, 0x31, 0xe6, 0xfb, 0xcb, 0x09, 0x18, 0xce, 0xd6, 0x31, 0xf3, 0xfa, 0xef, 0xde, 0xce, 0xf3,
+    0xcd, 0xdd, 0xd6, 0xf8, 0x09, 0x00, 0x2c, 0xff, 0xc8, 0x00, 0xf1, 0x13, 0x19, 0x1b, 0x34, 0x21,
+    0x22, 0xd6, 0x2d, 0xfe, 0x3d, 0x17, 0xed, 0xdd, 0xfd, 0xd2, 0x2f, 0x06, 0x0d, 0x15, 0x1e, 0x28,
+    0x34, 0x1d, 0x1a, 0x10, 0x25, 0x38, 0xc4, 0x1e, 0xe0, 0x0d, 0xeb, 0x0d, 0xe0, 0xe6, 0xea, 0x35,
+    0xe6, 0xe2, 0xe9, 0xd4, 0x00, 0xfc, 0x1b, 0x10, 0xeb, 0x06, 0x39, 0x0f, 0xd3, 0x2d, 0xe7, 0x1a,
+    0x33, 0xdb, 0xe7, 0x10, 0xd1, 0xef, 0x3a, 0xc8, 0xcb, 0xf1, 0x1b, 0x1d, 0x1a, 0x40, 0x1f, 0x17,
+    0xde, 0xef, 0x20, 0xc8, 0x05, 0xf5, 0xcf, 0xff, 0x0d, 0x13, 0x27, 0xfe, 0x1c, 0xcc, 0xfb, 0x0a,
+    0xc1, 0xf2, 0xd8, 0xe2, 0xf9, 0x1e, 0x04, 0xe4, 0xe9, 0xfa, 0xd3, 0x0f, 0x2e, 0x30, 0x39, 0xee,
+    0x1b, 0xf2, 0x2e, 0xd2, 0x06, 0xf4, 0xfa, 0xe4, 0xe2, 0xf5, 0xc5, 0xe9, 0x3c, 0x1c, 0xef, 0xcc,
+    0x1c, 0xd5, 0xfc, 0xf6, 0xd6, 0x30, 0xf2, 0x17, 0xea, 0xc4, 0xf7, 0x10, 0x3a, 0xc9, 0xcd, 0x1d,
+    0x3f, 0x19, 0xe2, 0x3c, 0xd1, 0x11, 0x0f, 0x11, 0xd6, 0x3b, 0x16, 0x2a, 0xd2, 0x03, 0xd0, 0x12,
+    0xc4, 0xee, 0x13, 0xf9, 0x10, 0x03, 0x00, 0x0e, 0x3c, 0x2a, 0xc3, 0x0b, 0xe9, 0x0a, 0xcc, 0xdd,
+    0x2e, 0x2e, 0xf7, 0x07, 0x1b, 0x3e, 0x08, 0x01, 0xec, 0x12, 0xe4, 0x1a, 0xd8, 0x25, 0x1b, 0xf1,
+    0x25, 0x33, 0xe6, 0x3b, 0xfe, 0xc9, 0xff, 0xd4, 0xd2, 0xc9, 0x38, 0x3b, 0x13, 0xeb, 0x3f, 0x25,
+    0xc3, 0x22, 0x33, 0xea, 0x1f, 0xcd, 0x1e, 0x1a, 0x30, 0xfc, 0x0d, 0xd6, 0x31, 0x1b, 0xf1, 0xe9,
+    0xe2, 0x31, 0xcb, 0x1d, 0x16, 0xec, 0x3d, 0x3a, 0xc2, 0xfb, 0xcf, 0x31, 0xe9, 0xf5, 0x26, 0x37,
+    0xdf, 0x10, 0x03, 0xe3, 0xeb, 0x14, 0xe1, 0xee, 0x0e, 0xfb, 0x2d, 0x37, 0x35, 0x0f, 0xeb, 0x0f,
+    0xf4, 0x08, 0xe7, 0xc1, 0x17, 0xde, 0x2c, 0x21, 0xed, 0x30, 0x33, 0x31, 0x1d, 0xf4, 0xcd, 0xd5,
+    0xdb, 0xd8, 0x23, 0xe3, 0x31, 0x25, 0xee, 0x39, 0x32, 0xc9, 0xf1, 0x33, 0x3d, 0x23, 0x0a, 0x19,
+    0xec, 0x05, 0xee, 0xc7, 0xcf, 0xd0, 0xfa, 0x32, 0x11, 0x31, 0x15, 0xda, 0x23, 0xcd, 0x37, 0x07,
+    0x28, 0x37, 0x14, 0xd8, 0xea, 0x26, 0x2d, 0x3a, 0xe6, 0x11, 0xe5, 0x19, 0xe3, 0xf1, 0xf9, 0xf7,
+    0x34, 0xe7, 0xda, 0xda, 0x2c, 0xcd, 0x34, 0xe6, 0x1f, 0x12, 0x07, 0x25, 0xc3, 0x23, 0x3c, 0x32,
+    0x0d, 0x0d, 0x23, 0x10, 0x0a, 0xec, 0xd9, 0x3d, 0xee, 0x32, 0xe7, 0x35, 0xdb, 0xdf, 0x11, 0x10,
+    0x3e, 0x17, 0x11, 0x36, 0x12, 0x3c, 0x24, 0xf7, 0xea, 0xfd, 0xf3, 0xfe, 0xcd, 0x12, 0xcf, 0x14,
+    0x2b, 0xc7, 0x18, 0x1c, 0x1c, 0x28, 0xf5, 0x09, 0xf9, 0x10, 0x25, 0x22, 0xec, 0xc2, 0x23, 0x19,
+    0xf8, 0xfb, 0xd0, 0x11, 0x22, 0xf4, 0x0b, 0xd8, 0x2f, 0xc1, 0x19, 0xd7, 0x28, 0xe7, 0xdc, 0xed,
+    0x17, 0xe4, 0x20, 0x2f, 0x13, 0x06, 0xf5, 0xf1, 0xe8, 0xea, 0xe9, 0xe5, 0xde, 0x31, 0xe1, 0x2e,
+    0xe2, 0x15, 0x11, 0xe3, 0xc5, 0x1b, 0xec, 0xf9, 0xfc, 0x3f, 0x3d, 0xc8, 0xd6, 0xe2, 0x38, 0xe4,
+    0xf5, 0x1c, 0xe3, 0x07, 0x19, 0xd0, 0x22, 0x39, 0xc7, 0x36, 0xf2, 0xfd, 0xf4, 0xc1, 0x0d, 0xca,
+    0x04, 0xf0, 0xd2, 0xdb, 0xdc, 0x26, 0x14, 0xda, 0x32, 0x3b, 0x07, 0xe4, 0x2e, 0x1f, 0x19, 0x22,
+    0x29, 0x2f, 0x1e, 0xf4, 0xf2, 0xd0, 0xe5, 0xfc, 0xfd, 0xc5, 0xfd, 0x24, 0x34, 0x30, 0xd8, 0xcd,
+    0xec, 0xc1, 0xcb, 0x2e, 0x07, 0x2a, 0xe1, 0xfc, 0x1f, 0x2a, 0x17, 0xcc, 0x34, 0xe1, 0x1d, 0xcf,
+    0x19, 0xde, 0xfe, 0xdf, 0x2f, 0xe6, 0xc4, 0x1d, 0xe1, 0xe6, 0x09, 0xc6, 0x38, 0xc6, 0x3b, 0xd1,
+    0x2e, 0xd7, 0x38, 0x40, 0xd8, 0xe0, 0x24, 0x28, 0xfd, 0x21, 0x3a, 0x11, 0x30, 0xdd, 0xd1, 0xf5,
+    0x1e, 0xda, 0xd8, 0x1a, 0xdb, 0xf2, 0xdc, 0xd6, 0xc0, 0x2e, 0xfc, 0xd7, 0x0e, 0x3c, 0xcf, 0x2d,
+    0x0c, 0x24, 0xca, 0xc7, 0x06, 0x3a, 0x30, 0xf8, 0x04, 0x12, 0x3a, 0x31, 0xce, 0x04, 0xec, 0x30,
+    0x34, 0x0b, 0xee, 0x12, 0x25, 0x29, 0x25, 0x3a, 0xf8, 0x0e, 0xc4, 0xd0, 0xe5, 0x3e, 0xdd, 0x1c,
+    0x02, 0x0f, 0x0d, 0xe3, 0xdb, 0x40, 0xe3, 0x34, 0xc9, 0x32, 0x38, 0x13, 0x1f, 0xe0, 0xc3, 0xf3,
+    0x04, 0xd0, 0x36, 0x08, 0xc3, 0x04, 0x40, 0xc5, 0x26, 0xdc, 0xd9, 0x12, 0x32, 0xd7, 0x3f, 0x17,
+    0xcb, 0xf0, 0xeb, 0xce, 0xdd, 0xca, 0xde, 0x0e, 0xf3, 0xe9, 0xe6, 0xfa, 0xf7, 0xd6, 0x40, 0x1a,
+    0x2f, 0x04, 0xe2, 0x09, 0xff, 0xd1, 0x03, 0xce, 0xc5, 0x2e, 0x08, 0x39, 0x2c, 0x2f, 0xd1, 0xef,
+    0xf6, 0xc8, 0x2d, 0x2a, 0x1a, 0x1a, 0xe5, 0xed, 0xf9, 0xfa, 0xcf, 0x1d, 0xd1, 0x32, 0x12, 0xf7,
+    0xf8, 0x01, 0xe7, 0x21, 0xdb, 0x3a, 0xc0, 0x38, 0x0f, 0x03, 0x0a, 0xf5, 0xe1, 0x21, 0xc8, 0x21,
+    0x35, 0xc6, 0xe1, 0xfb, 0x3e, 0xd9, 0x0b, 0x2f, 0xf3, 0x15, 0xd9, 0xff, 0xfe, 0x3d, 0xdd, 0xed,
+    0x3f, 0x1b, 0x2e, 0x26, 0x2b, 0xc6, 0x26, 0xe4, 0x2c, 0xe0, 0xcf, 0x0a, 0x23, 0x2e, 0xd8, 0xf3,
+    0x05, 0x3a, 0x2c, 0x03, 0xdb, 0x13, 0xe7, 0x02, 0xc6, 0xd8, 0x1e, 0x34, 0x03, 0xd8, 0x08, 0xe3,
+    0xd5, 0x28, 0x21, 0xc7, 0x3a, 0xe1, 0x24, 0x3d, 0xfb, 0xc7, 0x20, 0xcf, 0x29, 0xd5, 0xff, 0xca,
+    0x34, 0xd5, 0x0b, 0xca, 0x18, 0xca, 0xd1, 0xd2, 0xcb, 0x0e, 0x1a, 0x0e, 0xd7, 0x38, 0x1b, 0x13,
+    0xeb, 0x1a, 0xff, 0x13, 0xfb, 0xff, 0xf7, 0x0f, 0x0e, 0x12, 0x0d, 0xc1, 0x3b, 0x00, 0xfa, 0xe5,
+    0xfd, 0xe9, 0xd5, 0x02, 0x26, 0xf3, 0xe3, 0xea, 0xd2, 0x10, 0x22, 0xf6, 0xe8, 0xc9, 0x32, 0xf7,
+    0x26, 0xdc, 0x0f, 0xf8, 0x0a, 0x32, 0x16, 0xd5, 0xd1, 0xd2, 0xfb, 0xde, 0x36, 0x35, 0xc2, 0xea,
+    0x35, 0x2e, 0xdc, 0xf1, 0xc3, 0xfe, 0x0e, 0xf6, 0x0b, 0x0e, 0x03, 0x19, 0x04, 0x09, 0xcc, 0xc7,
+    0xc2, 0x30, 0xca, 0xf4, 0xd3, 0x10, 0x33, 0x0d, 0xdd, 0xff, 0xdc, 0xf1, 0xc7, 0xf1, 0xe2, 0xc6,
+    0x30, 0xc7, 0xfa, 0x39, 0xec, 0xc2, 0xf9, 0xe3, 0xd0, 0xc4, 0xe3, 0x12,
+};
+
+#endif
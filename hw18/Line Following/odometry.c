@@ -0,0 +1,144 @@
+#include <string.h>
+#include "odometry.h"
+
+#if defined(__ARM_FEATURE_SIMD32)
+#include <arm_acle.h>
+#endif
+
+// current and previous downsampled frames, 7 bit luma so the SWAR
+// difference below can't borrow between bytes. Stored as words so the
+// unshifted block is read 4 pixels per load.
+static uint32_t odomFrames[2][ODOM_SIZEY][ODOM_SIZEX/4];
+static int odomCur = 0;
+static int odomCount = 0;
+
+void odometryReset(){
+    odomCount = 0;
+}
+
+// shrink cameraData 2x2 into the next frame buffer
+void odometryLoadFrame(){
+    uint8_t rowA[IMAGESIZEX];
+    uint8_t rowB[IMAGESIZEX];
+    int x, y;
+    odomCur ^= 1;
+    for(y=0;y<ODOM_SIZEY;y++){
+        uint8_t *out = (uint8_t *)odomFrames[odomCur][y];
+        getLumaRow(2*y, rowA);
+        getLumaRow(2*y+1, rowB);
+        for(x=0;x<ODOM_SIZEX;x++){
+            int sum = rowA[2*x] + rowA[2*x+1] + rowB[2*x] + rowB[2*x+1];
+            out[x] = (uint8_t)(sum >> 3); // average, then 7 bit
+        }
+    }
+    if (odomCount < 2){
+        odomCount++;
+    }
+}
+
+// sum of |a - b| over the 4 bytes of a word
+static inline uint32_t sad4(uint32_t a, uint32_t b){
+#if defined(__ARM_FEATURE_SIMD32)
+    return __usada8(a, b, 0); // M33 DSP extension does it in one go
+#else
+    uint32_t d = (a | 0x80808080u) - b; // 128 + a - b in every byte, never borrows
+    uint32_t neg = ((~d & 0x80808080u) >> 7) * 0xFF; // 0xFF in bytes where a < b
+    uint32_t v = d ^ 0x80808080u; // a - b per byte, two's complement
+    v = (v ^ neg) + (neg & 0x01010101u); // negate the negative bytes
+    v = (v & 0x00FF00FFu) + ((v >> 8) & 0x00FF00FFu);
+    return (v & 0xFFFF) + (v >> 16);
+#endif
+}
+
+// the shifted block can start on any byte, M0+ can't do unaligned loads
+static inline uint32_t load32(const uint8_t *p){
+    uint32_t w;
+    memcpy(&w, p, 4);
+    return w;
+}
+
+// SAD between the centre of the previous frame and the current frame
+// shifted by (dx, dy)
+static uint32_t odomSad(int dx, int dy){
+    int prev = odomCur ^ 1;
+    uint32_t sad = 0;
+    int y, w;
+    for(y=ODOM_RANGE;y<ODOM_SIZEY-ODOM_RANGE;y++){
+        const uint32_t *p = &odomFrames[prev][y][ODOM_RANGE/4];
+        const uint8_t *c = (const uint8_t *)odomFrames[odomCur][y+dy] + ODOM_RANGE + dx;
+        for(w=0;w<ODOM_WORDS;w++){
+            sad += sad4(p[w], load32(c + 4*w));
+        }
+    }
+    return sad;
+}
+
+// parabola through three SADs, returns the minimum's offset in 1/256 pixel
+static int odomSubPixel(uint32_t left, uint32_t mid, uint32_t right){
+    int32_t den = (int32_t)left - 2*(int32_t)mid + (int32_t)right;
+    if (den <= 0){
+        return 0;
+    }
+    int32_t frac = (((int32_t)left - (int32_t)right) * 128) / den;
+    if (frac > 128) frac = 128;
+    if (frac < -128) frac = -128;
+    return frac;
+}
+
+// find how far the floor moved between the last two loaded frames
+void odometryMatch(odomMotion_t *motion){
+    uint32_t sads[2*ODOM_RANGE+1][2*ODOM_RANGE+1];
+    uint32_t best = UINT32_MAX;
+    uint64_t total = 0;
+    int bestX = 0, bestY = 0;
+    int dx, dy;
+
+    memset(motion, 0, sizeof(*motion));
+    if (odomCount < 2){
+        return;
+    }
+
+    for(dy=-ODOM_RANGE;dy<=ODOM_RANGE;dy++){
+        for(dx=-ODOM_RANGE;dx<=ODOM_RANGE;dx++){
+            // full SAD for every shift, the average is the texture check
+            uint32_t s = odomSad(dx, dy);
+            sads[dy+ODOM_RANGE][dx+ODOM_RANGE] = s;
+            total += s;
+            if (s < best){
+                best = s;
+                bestX = dx;
+                bestY = dy;
+            }
+        }
+    }
+
+    uint32_t mean = (uint32_t)(total / ((2*ODOM_RANGE+1)*(2*ODOM_RANGE+1)));
+    int ix = bestX + ODOM_RANGE;
+    int iy = bestY + ODOM_RANGE;
+    int fx = 0, fy = 0;
+    if (ix > 0 && ix < 2*ODOM_RANGE){
+        fx = odomSubPixel(sads[iy][ix-1], best, sads[iy][ix+1]);
+    }
+    if (iy > 0 && iy < 2*ODOM_RANGE){
+        fy = odomSubPixel(sads[iy-1][ix], best, sads[iy+1][ix]);
+    }
+
+    motion->lateral = (int16_t)(bestX*256 + fx);
+    motion->forward = (int16_t)(bestY*256 + fy);
+    motion->sad = best;
+    // a plain floor matches everywhere, and a best shift on the edge of the
+    // search may really be further away
+    motion->valid = (mean - best) > mean / 8
+        && bestX > -ODOM_RANGE && bestX < ODOM_RANGE
+        && bestY > -ODOM_RANGE && bestY < ODOM_RANGE;
+}
+
+// load the frame in cameraData and measure the motion since the last one
+void odometryUpdate(uint32_t frameTimeUs, odomMotion_t *motion){
+    odometryLoadFrame();
+    odometryMatch(motion);
+    if (motion->valid && frameTimeUs > 0){
+        motion->lateralRate = (int32_t)(((int64_t)motion->lateral * 1000000) / frameTimeUs);
+        motion->forwardRate = (int32_t)(((int64_t)motion->forward * 1000000) / frameTimeUs);
+    }
+}
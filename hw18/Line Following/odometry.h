@@ -0,0 +1,31 @@
+#ifndef ODOMETRY_h
+#define ODOMETRY_h
+
+#include <stdint.h>
+#include "cam.h"
+
+// Visual odometry from the floor texture.
+// Each frame is shrunk to half size luma and block matched against the
+// previous one, the best shift is how far the floor moved in the image.
+// Driving forward moves the floor down the image (+y).
+
+#define ODOM_SIZEX (IMAGESIZEX/2) // 40x30 at the default frame size
+#define ODOM_SIZEY (IMAGESIZEY/2)
+#define ODOM_RANGE 4 // search +-4 pixels in x and y, keep a multiple of 4
+#define ODOM_WORDS ((ODOM_SIZEX - 2*ODOM_RANGE) / 4) // compared 4 pixels at a time
+
+typedef struct odomMotion {
+    int16_t lateral; // floor shift to the right, 1/256 pixel per frame
+    int16_t forward; // floor shift down the image, 1/256 pixel per frame
+    int32_t lateralRate; // same as above per second, 1/256 pixel
+    int32_t forwardRate;
+    uint32_t sad; // sum of absolute differences at the best shift
+    uint8_t valid; // 0 on the first frame or when the floor has no texture
+} odomMotion_t;
+
+void odometryReset();
+void odometryLoadFrame();
+void odometryMatch(odomMotion_t *motion);
+void odometryUpdate(uint32_t frameTimeUs, odomMotion_t *motion);
+
+#endif
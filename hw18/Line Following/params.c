@@ -0,0 +1,61 @@
+#include <string.h>
+#include <stddef.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "steer.h"
+#include "speedplan.h"
+#include "params.h"
+
+// what hw18 boots with and no record, slow enough for line_sim's bends
+// (line_sim -e checks it). The markers keep the speed until a track's own
+// are saved.
+void paramsDefault(params_t *p){
+    steerGains_t gains;
+    planConfig_t plan;
+    steerDefaultGains(&gains);
+    planDefaultConfig(&plan);
+    memset(p, 0, sizeof(*p));
+    p->kp = gains.kp;
+    p->ki = gains.ki;
+    p->kd = gains.kd;
+    p->kff = gains.kff;
+    p->basePercent = 30;
+    p->latAccel = (uint16_t)plan.latAccel;
+    paramsSeal(p);
+}
+
+uint32_t paramsChecksum(const params_t *p){
+    const uint8_t *data = (const uint8_t *)p;
+    uint32_t h = 2166136261u;
+    int i;
+    for(i=0;i<(int)offsetof(params_t, checksum);i++){
+        h = (h ^ data[i]) * 16777619u;
+    }
+    return h;
+}
+
+// header and checksum, after the values are set
+void paramsSeal(params_t *p){
+    p->magic = PARAMS_MAGIC;
+    p->version = PARAMS_VERSION;
+    p->size = sizeof(*p);
+    p->checksum = paramsChecksum(p);
+}
+
+// the record in flash, 0 on success. -1 if there is none or it doesn't
+// check out, p is left alone then.
+int paramsLoad(params_t *p){
+    params_t rec;
+    memcpy(&rec, (const void *)(XIP_BASE + PARAMS_FLASH_OFFSET), sizeof(rec));
+    if (rec.magic != PARAMS_MAGIC || rec.version != PARAMS_VERSION || rec.size != sizeof(rec)){
+        return -1;
+    }
+    if (paramsChecksum(&rec) != rec.checksum){
+        return -1;
+    }
+    if (rec.basePercent > 100){
+        return -1;
+    }
+    *p = rec;
+    return 0;
+}
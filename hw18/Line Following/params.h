@@ -0,0 +1,39 @@
+#ifndef PARAMS_h
+#define PARAMS_h
+
+#include <stdint.h>
+#include "hardware/flash.h"
+#include "flatfield.h"
+#include "marker.h"
+
+// Line following parameters, the steering gains and the speeds, the base
+// speed being the top speed when the planner (speedplan.h) is on.
+// The defaults are the hand picked ones; a record in flash, written by
+// the host's gain tuner (host/tools/tune.c), replaces them at boot. The
+// record sits in the sector below the flat field gains and is loaded
+// onto the car with
+//   picotool load -o <XIP_BASE + PARAMS_FLASH_OFFSET> params.bin
+// which tune prints. A record from another version is ignored.
+
+#define PARAMS_MAGIC 0x534D5250 // "PRMS"
+#define PARAMS_VERSION 2
+#define PARAMS_FLASH_BYTES FLASH_SECTOR_SIZE
+#define PARAMS_FLASH_OFFSET (FLAT_FLASH_OFFSET - PARAMS_FLASH_BYTES) // from the start of flash
+
+typedef struct params {
+    uint32_t magic;
+    uint16_t version, size; // size of the whole record
+    float kp, ki, kd, kff; // steering gains, see steerGains_t
+    uint8_t basePercent; // base speed in percent of full
+    uint8_t segmentPercent[MARKER_IDS]; // speed after each marker, 0 keeps it
+    uint8_t reserved;
+    uint16_t latAccel; // mm/s^2 in bends for the speed planner, 0 drives at the base speed
+    uint32_t checksum; // FNV-1a of everything before it
+} params_t;
+
+void paramsDefault(params_t *p);
+uint32_t paramsChecksum(const params_t *p);
+void paramsSeal(params_t *p);
+int paramsLoad(params_t *p);
+
+#endif
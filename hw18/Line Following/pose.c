@@ -0,0 +1,167 @@
+#include <string.h>
+#include <math.h>
+#include "pose.h"
+
+#define POSE_RAD 683565276LL // binary angle per radian, 2^32 / 2pi
+
+// sin over a quarter turn, 1 << 15 is 1, one more for interpolating
+static int32_t poseTable[POSE_TABLE + 1];
+static bool poseTableDone = false;
+
+static void poseMakeTable(){
+    int i;
+    for(i=0;i<=POSE_TABLE;i++){
+        poseTable[i] = (int32_t)lround(sin(i * M_PI / 2 / POSE_TABLE) * 32768);
+    }
+    poseTableDone = true;
+}
+
+// a is 0 to a quarter turn, 2^30
+static int32_t poseQuarter(uint32_t a){
+    if (!poseTableDone){
+        poseMakeTable();
+    }
+    uint32_t i = a >> 22;
+    uint32_t f = (a >> 6) & 0xFFFF;
+    if (i >= POSE_TABLE){
+        return poseTable[POSE_TABLE];
+    }
+    return poseTable[i] + (int32_t)(((int64_t)(poseTable[i + 1] - poseTable[i]) * f) >> 16);
+}
+
+int32_t poseSin(uint32_t theta){
+    uint32_t a = theta & 0x3FFFFFFF;
+    switch (theta >> 30){
+    case 0: return poseQuarter(a);
+    case 1: return poseQuarter(0x40000000 - a);
+    case 2: return -poseQuarter(a);
+    default: return -poseQuarter(0x40000000 - a);
+    }
+}
+
+int32_t poseCos(uint32_t theta){
+    return poseSin(theta + 0x40000000);
+}
+
+// the hw18 car: 10 counts per mm, the same top speed the wheel loops
+// and the motion scripts assume
+void poseDefaultConfig(poseConfig_t *cfg){
+    cfg->umPerCount = 100;
+    cfg->trackUm = 120000;
+    cfg->maxCps = 6000;
+    cfg->friction = 15;
+    cfg->tauUs = 60000;
+    cfg->wrap = 255;
+}
+
+// back to 0, 0 facing along x. Not while the tick is updating it.
+void poseReset(pose_t *p, const poseConfig_t *cfg){
+    uint32_t seq = p->seq;
+    memset(p, 0, sizeof(*p));
+    p->cfg = *cfg;
+    p->seq = seq + 2; // a reader that was part way through tries again
+}
+
+static void poseBegin(pose_t *p){
+    p->seq++;
+    __sync_synchronize();
+}
+
+static void poseEnd(pose_t *p){
+    __sync_synchronize();
+    p->seq++;
+}
+
+// move on by each wheel's travel, um << 8
+static void poseStep(pose_t *p, int64_t left, int64_t right, uint32_t dtUs){
+    int64_t ds = (left + right) / 2;
+    int32_t turn = (int32_t)((right - left) * POSE_RAD / ((int64_t)p->cfg.trackUm << 8));
+    uint32_t mid = p->theta + (uint32_t)(turn / 2);
+    p->x += (ds * poseCos(mid)) >> 8;
+    p->y += (ds * poseSin(mid)) >> 8;
+    p->theta += (uint32_t)turn;
+    if (dtUs > 0){
+        p->speed = (int32_t)(ds * 1000 / ((int64_t)dtUs << 8));
+        int64_t mdeg = ((int64_t)turn * 360000) >> 16; // per step, << 16
+        p->turnRate = (int32_t)((mdeg * 1000000 / dtUs) >> 16);
+    }
+}
+
+// from the encoder counts, + forwards
+void poseUpdateCounts(pose_t *p, int32_t left, int32_t right, uint64_t nowUs){
+    poseBegin(p);
+    if (p->started){
+        int64_t l = ((int64_t)(left - p->lastCount[0]) * p->cfg.umPerCount) << 8;
+        int64_t r = ((int64_t)(right - p->lastCount[1]) * p->cfg.umPerCount) << 8;
+        poseStep(p, l, r, (uint32_t)(nowUs - p->timeUs));
+    }
+    p->lastCount[0] = left;
+    p->lastCount[1] = right;
+    p->timeUs = nowUs;
+    p->started = true;
+    poseEnd(p);
+}
+
+// the speed a wheel settles at on this PWM, counts per second << 8
+static int32_t poseModelTarget(const poseConfig_t *cfg, int pwm){
+    int mag = pwm < 0 ? -pwm : pwm;
+    if (mag > cfg->wrap) mag = cfg->wrap;
+    if (mag <= cfg->friction){
+        return 0;
+    }
+    int32_t cps = (int32_t)((int64_t)(mag - cfg->friction) * cfg->maxCps * 256 / cfg->wrap);
+    return pwm < 0 ? -cps : cps;
+}
+
+// from the PWM through the motor model: left and right are what's set
+// now, the time since the last update ran on the last ones
+void poseUpdatePwm(pose_t *p, int left, int right, uint64_t nowUs){
+    poseBegin(p);
+    if (p->started){
+        uint32_t dt = (uint32_t)(nowUs - p->timeUs);
+        int64_t travel[2];
+        int i;
+        for(i=0;i<2;i++){
+            int32_t target = poseModelTarget(&p->cfg, p->lastPwm[i]);
+            int32_t before = p->modelCps[i];
+            // the lag, implicit so no step is too long for it
+            p->modelCps[i] += (int32_t)((int64_t)(target - before) * dt / (p->cfg.tauUs + dt));
+            int64_t counts = ((int64_t)before + p->modelCps[i]) * dt / 2000000; // << 8
+            travel[i] = counts * p->cfg.umPerCount;
+        }
+        poseStep(p, travel[0], travel[1], dt);
+    }
+    p->lastPwm[0] = left;
+    p->lastPwm[1] = right;
+    p->timeUs = nowUs;
+    p->started = true;
+    poseEnd(p);
+}
+
+// pull the heading gainQ8/256 of the way towards one known another way
+void poseFuseHeading(pose_t *p, uint32_t theta, int gainQ8){
+    poseBegin(p);
+    int32_t err = (int32_t)(theta - p->theta);
+    p->theta += (uint32_t)(int32_t)(((int64_t)err * gainQ8) >> 8);
+    poseEnd(p);
+}
+
+// a consistent copy, safe against the tick
+void poseRead(const pose_t *p, poseState_t *out){
+    uint32_t seq;
+    int64_t x, y;
+    do {
+        seq = p->seq;
+        __sync_synchronize();
+        x = p->x;
+        y = p->y;
+        out->theta = p->theta;
+        out->speed = p->speed;
+        out->turnRate = p->turnRate;
+        out->timeUs = p->timeUs;
+        __sync_synchronize();
+    } while ((seq & 1) || seq != p->seq);
+    out->x = (int32_t)(x >> 15);
+    out->y = (int32_t)(y >> 15);
+    out->headingMdeg = (int32_t)(((int64_t)(int32_t)out->theta * 360000) >> 32);
+}
@@ -0,0 +1,67 @@
+#ifndef POSE_h
+#define POSE_h
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Where the car is: x, y and heading from its wheels, integrated every
+// steering tick. The wheel travel comes from the encoder counts, or with
+// no encoders from the PWM through a motor model (a deadband and a first
+// order lag, calibrate it against the encoders). An absolute heading, if
+// something knows one, can be blended in with poseFuseHeading().
+//
+// All integer: position in micrometres with 15 more bits underneath so
+// nothing is lost to rounding tick by tick, heading as a binary angle
+// that wraps by itself, 2^32 a whole turn. Sin and cos come from a
+// quarter wave table. Each step turns about the midpoint heading.
+//
+// The tick writes, the main loop reads with poseRead(), which copies it
+// whole between the tick's sequence counts.
+
+#define POSE_TABLE 256 // sine table entries per quarter turn
+#define POSE_TURN 4294967296.0 // binary angle of a whole turn
+
+typedef struct poseConfig {
+    int32_t umPerCount; // wheel travel per encoder count
+    int32_t trackUm; // between the wheels' contact points
+    // the motor model, for poseUpdatePwm()
+    int32_t maxCps; // counts per second at full PWM
+    int32_t friction; // PWM lost to friction, nothing moves below it
+    uint32_t tauUs; // motor time constant
+    int wrap; // full PWM
+} poseConfig_t;
+
+typedef struct poseState {
+    int32_t x, y; // um from where it was reset
+    uint32_t theta; // 0 along x, + anticlockwise, 2^32 a turn
+    int32_t headingMdeg; // the same in millidegrees, -180000..180000
+    int32_t speed; // mm/s forwards
+    int32_t turnRate; // millidegrees per second, + anticlockwise
+    uint64_t timeUs; // of the last update
+} poseState_t;
+
+typedef struct pose {
+    poseConfig_t cfg;
+    int64_t x, y; // um << 15
+    uint32_t theta;
+    int32_t speed, turnRate;
+    uint64_t timeUs;
+    int32_t lastCount[2]; // poseUpdateCounts()
+    int lastPwm[2]; // poseUpdatePwm()
+    int32_t modelCps[2]; // counts per second << 8
+    bool started;
+    volatile uint32_t seq; // odd while the tick is writing
+} pose_t;
+
+void poseDefaultConfig(poseConfig_t *cfg);
+void poseReset(pose_t *p, const poseConfig_t *cfg);
+void poseUpdateCounts(pose_t *p, int32_t left, int32_t right, uint64_t nowUs);
+void poseUpdatePwm(pose_t *p, int left, int right, uint64_t nowUs);
+void poseFuseHeading(pose_t *p, uint32_t theta, int gainQ8);
+void poseRead(const pose_t *p, poseState_t *out);
+
+// fixed point trig on the binary angle, 1 << 15 is 1
+int32_t poseSin(uint32_t theta);
+int32_t poseCos(uint32_t theta);
+
+#endif
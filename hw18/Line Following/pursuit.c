@@ -0,0 +1,143 @@
+#include <string.h>
+#include "ground.h"
+#include "speedplan.h"
+#include "pursuit.h"
+
+// the camera's nearest row is 140 mm ahead and its furthest 310 mm
+void pursuitDefaultConfig(pursuitConfig_t *cfg){
+    cfg->lookMinMm = 150;
+    cfg->lookMaxMm = 290;
+    cfg->lookMs = 150;
+    cfg->trackMm = 120;
+}
+
+void pursuitInit(pursuit_t *p, const pursuitConfig_t *cfg){
+    memset(p, 0, sizeof(*p));
+    p->cfg = *cfg;
+}
+
+// mm << GROUND_SHIFT
+int32_t pursuitLookahead(const pursuitConfig_t *cfg, int32_t speedMmS){
+    int32_t look = cfg->lookMinMm;
+    if (speedMmS > 0){
+        look += (int32_t)((int64_t)speedMmS * cfg->lookMs / 1000);
+    }
+    if (look > cfg->lookMaxMm){
+        look = cfg->lookMaxMm;
+    }
+    return look << GROUND_SHIFT;
+}
+
+// where the line, points from near to far, crosses the lookahead circle.
+// Between two points it's taken as straight and the crossing is
+// interpolated on the squared distance, which is close enough over the
+// few mm between rows and needs no square root. With every point beyond
+// the circle the nearest is aimed at, with every point inside it the
+// furthest. -1 without points.
+int pursuitTarget(const int32_t *ahead, const int32_t *left, int n, int32_t lookahead, int32_t *tAhead, int32_t *tLeft){
+    int64_t look2 = (int64_t)lookahead * lookahead;
+    int64_t last2 = 0;
+    int i;
+    if (n < 1){
+        return -1;
+    }
+    for(i=0;i<n;i++){
+        int64_t d2 = (int64_t)ahead[i] * ahead[i] + (int64_t)left[i] * left[i];
+        if (d2 >= look2){
+            if (i == 0){
+                *tAhead = ahead[0];
+                *tLeft = left[0];
+                return 0;
+            }
+            // how far from the last point to this one, << 16
+            int64_t t = (look2 - last2) * 65536 / (d2 - last2);
+            *tAhead = ahead[i - 1] + (int32_t)(((int64_t)(ahead[i] - ahead[i - 1]) * t) >> 16);
+            *tLeft = left[i - 1] + (int32_t)(((int64_t)(left[i] - left[i - 1]) * t) >> 16);
+            return 0;
+        }
+        last2 = d2;
+    }
+    *tAhead = ahead[n - 1];
+    *tLeft = left[n - 1];
+    return 0;
+}
+
+// the arc from the axle, along the car, through the point: 2 * left / d^2.
+// In mm << GROUND_SHIFT that's left << 29 / d^2 for 1/mm << PURSUIT_SHIFT.
+int32_t pursuitCurvature(int32_t ahead, int32_t left){
+    int64_t d2 = (int64_t)ahead * ahead + (int64_t)left * left;
+    if (d2 == 0){
+        return 0;
+    }
+    int64_t k = (int64_t)left * ((int64_t)1 << (PURSUIT_SHIFT + GROUND_SHIFT + 1)) / d2;
+    if (k > INT32_MAX) k = INT32_MAX;
+    if (k < -INT32_MAX) k = -INT32_MAX;
+    return (int32_t)k;
+}
+
+// on an arc of radius r the inner wheel runs at (r - w/2) / (r + w/2) of
+// the outer one's speed, so it loses k w / (1 + k w / 2) of it, short of
+// 2 turning on the spot
+int32_t pursuitTurn(int32_t curvature, int32_t trackMm){
+    int64_t k = curvature < 0 ? -(int64_t)curvature : curvature;
+    int64_t kw = (k * trackMm) >> (PURSUIT_SHIFT - 16);
+    int64_t turn = kw * PURSUIT_TURN_ONE / (PURSUIT_TURN_ONE + kw / 2);
+    // turning left slows the left wheel, a negative steering output
+    return (int32_t)(curvature > 0 ? -turn : turn);
+}
+
+// one frame's columns in the planner's rows, far to near, -1 where a row
+// has no line. The line is taken from the nearest row it's in outwards,
+// up to a row it's missing from or jumps sideways in. Where it ran out of
+// the side of the view it's at least as far over as the image's edge in
+// that row, and that point is aimed at as well: in a bend tight enough to
+// leave the view the car turns harder rather than straight on. Until the
+// line is back in the nearest rows the car aims at the edge it went out
+// of, anything further up isn't trusted to be the line. Returns -1 and
+// keeps the last turn with no line at all.
+int pursuitSteer(pursuit_t *p, const int *cols, int32_t speedMmS){
+    int32_t ahead[PLAN_ROWS], left[PLAN_ROWS];
+    int i, n = 0, seen = 0, first = -1, last = -1, side = 0;
+    for(i=PLAN_ROWS-1;i>=0;i--){
+        if (cols[i] < 0){
+            if (n == 0){
+                continue;
+            }
+            if (last < PURSUIT_EDGE_PX || last >= IMAGESIZEX - PURSUIT_EDGE_PX){
+                side = last < IMAGESIZEX / 2 ? 1 : -1;
+                if (groundPoint(planRow(i), side > 0 ? 0 : IMAGESIZEX - 1, &ahead[n], &left[n]) == 0){
+                    n++;
+                }
+            }
+            break;
+        }
+        if (groundPoint(planRow(i), cols[i], &ahead[n], &left[n]) != 0){
+            continue;
+        }
+        // something else beside the line, it and the rows past it aren't the line
+        int32_t jump = n > 0 ? left[n] - left[n - 1] : 0;
+        if (jump > PURSUIT_JUMP_MM << GROUND_SHIFT || jump < -(PURSUIT_JUMP_MM << GROUND_SHIFT)){
+            break;
+        }
+        if (first < 0){
+            first = i;
+        }
+        last = cols[i];
+        n++;
+        seen++;
+    }
+    p->points = seen;
+    if (p->side != 0 && first < PLAN_ROWS - PURSUIT_NEAR_ROWS){
+        // still out of the side
+        n = groundPoint(planRow(PLAN_ROWS - 1), p->side > 0 ? 0 : IMAGESIZEX - 1, &ahead[0], &left[0]) == 0;
+    } else {
+        p->side = side;
+    }
+    p->lookahead = pursuitLookahead(&p->cfg, speedMmS);
+    if (pursuitTarget(ahead, left, n, p->lookahead, &p->targetAhead, &p->targetLeft) != 0){
+        return -1;
+    }
+    p->curvature = pursuitCurvature(p->targetAhead, p->targetLeft);
+    p->turn = pursuitTurn(p->curvature, p->cfg.trackMm);
+    return 0;
+}
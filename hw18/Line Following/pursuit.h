@@ -0,0 +1,53 @@
+#ifndef PURSUIT_h
+#define PURSUIT_h
+
+#include <stdint.h>
+#include "cam.h"
+
+// Pure pursuit: steer along the arc that takes the axle's middle through
+// a point on the line a lookahead distance away. The line's centre in the
+// planner's rows (speedplan.h) is put on the floor (ground.h) and the
+// point is where the line crosses a circle of the lookahead round the
+// axle, between the two rows either side of it. The arc through it from
+// the car's heading has curvature 2 * left / distance^2. The lookahead
+// grows with speed, from lookMinMm by the distance covered in lookMs, so
+// a fast car aims further along the line and turns more gently.
+//
+// The curvature is turned into how much of the outer wheel's speed the
+// inner one loses, the steering loop's output (steer.h) with a base speed.
+//
+// All of it is integer arithmetic, the same code on the car and on the
+// host, see host/tools/pursuit_check.c.
+
+#define PURSUIT_SHIFT 20 // curvature is 1/mm << PURSUIT_SHIFT
+#define PURSUIT_TURN_ONE (1 << 16) // a whole wheel's speed
+#define PURSUIT_JUMP_MM 25 // the line moved this far sideways from one row to the next, it isn't the line
+#define PURSUIT_EDGE_PX (IMAGESIZEX / 5) // the line this near the side, it may have run out of the view
+#define PURSUIT_NEAR_ROWS 2 // out of the side, the line is back once it's in these
+
+typedef struct pursuitConfig {
+    int32_t lookMinMm; // lookahead standing still
+    int32_t lookMaxMm; // and at most
+    int32_t lookMs; // grows by the distance covered in this long
+    int32_t trackMm; // between the wheels
+} pursuitConfig_t;
+
+typedef struct pursuit {
+    pursuitConfig_t cfg;
+    int32_t lookahead; // mm << GROUND_SHIFT, the last frame's
+    int32_t targetAhead, targetLeft; // the point aimed at, the same
+    int32_t curvature; // + turning left
+    int32_t turn; // PURSUIT_TURN_ONE fractions, + turning right like steerMix()
+    int points; // rows the line was in
+    int side; // the line went out of the view, + to the left, - right, 0 it didn't
+} pursuit_t;
+
+void pursuitDefaultConfig(pursuitConfig_t *cfg);
+void pursuitInit(pursuit_t *p, const pursuitConfig_t *cfg);
+int32_t pursuitLookahead(const pursuitConfig_t *cfg, int32_t speedMmS);
+int pursuitTarget(const int32_t *ahead, const int32_t *left, int n, int32_t lookahead, int32_t *tAhead, int32_t *tLeft);
+int32_t pursuitCurvature(int32_t ahead, int32_t left);
+int32_t pursuitTurn(int32_t curvature, int32_t trackMm);
+int pursuitSteer(pursuit_t *p, const int *cols, int32_t speedMmS);
+
+#endif
@@ -0,0 +1,141 @@
+#include <string.h>
+#include <math.h>
+#include "ground.h"
+#include "speedplan.h"
+
+// far to near, spread over the frame
+int planRow(int i){
+    return (2 * i + 1) * IMAGESIZEY / (2 * PLAN_ROWS);
+}
+
+void planDefaultConfig(planConfig_t *cfg){
+    cfg->latAccel = 100; // what line_sim's bends hold at 5 frames a second
+    cfg->accel = 600;
+    cfg->minMmS = 90;
+    cfg->maxFitMm = 6;
+}
+
+void planInit(plan_t *p, const planConfig_t *cfg){
+    memset(p, 0, sizeof(*p));
+    p->cfg = *cfg;
+}
+
+// least squares y = a + b x + c x^2 through n points, x about its mean
+// to keep the sums small. The rms about it, or -1 if it can't be fitted.
+static float planFit(const float *x, const float *y, int n, float *b, float *c, int *worst){
+    float mean = 0, s1 = 0, s2 = 0, s3 = 0, s4 = 0, t0 = 0, t1 = 0, t2 = 0;
+    int i;
+    for(i=0;i<n;i++){
+        mean += x[i] / n;
+    }
+    for(i=0;i<n;i++){
+        float u = x[i] - mean, u2 = u * u;
+        s1 += u;
+        s2 += u2;
+        s3 += u2 * u;
+        s4 += u2 * u2;
+        t0 += y[i];
+        t1 += y[i] * u;
+        t2 += y[i] * u2;
+    }
+    float s0 = (float)n;
+    float det = s0 * (s2 * s4 - s3 * s3) - s1 * (s1 * s4 - s3 * s2) + s2 * (s1 * s3 - s2 * s2);
+    if (fabsf(det) < 1e-6f){
+        return -1;
+    }
+    float a = (t0 * (s2 * s4 - s3 * s3) - s1 * (t1 * s4 - s3 * t2) + s2 * (t1 * s3 - s2 * t2)) / det;
+    *b = (s0 * (t1 * s4 - t2 * s3) - t0 * (s1 * s4 - s3 * s2) + s2 * (s1 * t2 - t1 * s2)) / det;
+    *c = (s0 * (s2 * t2 - s3 * t1) - s1 * (s1 * t2 - s2 * t1) + t0 * (s1 * s3 - s2 * s2)) / det;
+    float sq = 0, worstErr = -1;
+    for(i=0;i<n;i++){
+        float u = x[i] - mean;
+        float e = y[i] - (a + *b * u + *c * u * u);
+        sq += e * e;
+        if (e * e > worstErr){
+            worstErr = e * e;
+            *worst = i;
+        }
+    }
+    return sqrtf(sq / n);
+}
+
+// how sharply the car has to turn for the line in view, 1/mm, + to the
+// left. cols[i] is the line's centre in planRow(i), -1 where there was no
+// line. Two ways, the sharper wins:
+// - the curvature of a parabola through the points, the line's own bend.
+//   A row well off the others (a crossing, a stray edge) is dropped while
+//   that leaves enough rows. Over less than PLAN_MIN_SPAN_MM a pixel's
+//   rounding is too much of the bend, it isn't used;
+// - the arc from the axle, along the car, through the furthest point: how
+//   much the car turns to get there. It counts the car being off the line
+//   or turned on it, and in a bend too sharp for the far rows to see the
+//   line the furthest point is at the edge of the view, so it's the least
+//   the bend can be.
+// 0, or -1 if the line is in fewer than two rows.
+int planCurvature(const int *cols, float *curvature, float *fitMm){
+    float x[PLAN_ROWS], y[PLAN_ROWS], b = 0, c = 0, fit = -1;
+    int i, n = 0, worst = 0;
+    for(i=0;i<PLAN_ROWS;i++){
+        int32_t ahead, left;
+        if (cols[i] < 0 || groundPoint(planRow(i), cols[i], &ahead, &left) != 0){
+            continue;
+        }
+        x[n] = (float)ahead / GROUND_ONE;
+        y[n] = (float)left / GROUND_ONE;
+        n++;
+    }
+    if (n < 2){
+        return -1;
+    }
+    float bend = 0;
+    while (n >= PLAN_MIN_POINTS){
+        fit = planFit(x, y, n, &b, &c, &worst);
+        if (fit < 0 || fit <= PLAN_OUTLIER_MM || n == PLAN_MIN_POINTS){
+            break;
+        }
+        x[worst] = x[n - 1];
+        y[worst] = y[n - 1];
+        n--;
+    }
+    int far = 0, near = 0;
+    for(i=1;i<n;i++){
+        if (x[i] > x[far]) far = i;
+        if (x[i] < x[near]) near = i;
+    }
+    if (fit >= 0 && x[far] - x[near] >= PLAN_MIN_SPAN_MM){
+        // in the middle of the rows, the slope there is b
+        float k = 1 + b * b;
+        bend = 2 * c / (k * sqrtf(k));
+    }
+    float arc = 2 * y[far] / (x[far] * x[far] + y[far] * y[far]);
+    *curvature = fabsf(arc) > fabsf(bend) ? arc : bend;
+    *fitMm = fit < 0 ? 0 : fit;
+    return 0;
+}
+
+// the frame's speed in mm/s, at most topMmS
+float planSpeed(plan_t *p, const int *cols, float topMmS, uint64_t nowUs){
+    float curvature, fit;
+    if (planCurvature(cols, &curvature, &fit) == 0 && fit <= p->cfg.maxFitMm){
+        p->curvature = curvature;
+        p->fitMm = fit;
+    }
+    float target = topMmS;
+    float bend = fabsf(p->curvature);
+    if (p->cfg.latAccel > 0 && bend > 0){
+        float v = sqrtf(p->cfg.latAccel / bend);
+        if (v < target) target = v;
+    }
+    if (target < p->cfg.minMmS){
+        target = p->cfg.minMmS < topMmS ? p->cfg.minMmS : topMmS;
+    }
+    if (!p->started || target <= p->speed){
+        p->speed = target;
+    } else {
+        float up = p->cfg.accel * (float)(nowUs - p->timeUs) / 1e6f;
+        p->speed = p->speed + up < target ? p->speed + up : target;
+    }
+    p->timeUs = nowUs;
+    p->started = true;
+    return p->speed;
+}
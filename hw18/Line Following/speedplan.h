@@ -0,0 +1,49 @@
+#ifndef SPEEDPLAN_h
+#define SPEEDPLAN_h
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Speed planner: slower for bends, by how sharp they are.
+// The line's centre in rows from the top of the image to the bottom is
+// put on the floor (ground.h), 140 to 310 mm ahead of the axle. How
+// sharply the car has to turn comes from those points two ways, a
+// parabola through them for the line's own bend and the arc from the car
+// to the furthest of them, see planCurvature(). The speed that keeps the
+// sideways acceleration on that curvature within latAccel is
+// v = sqrt(latAccel / curvature); the planned speed drops to it at once
+// and climbs back at accel, so the car slows as a bend comes into view
+// and speeds up again once the view is straight. A frame with too little
+// of the line, or a poor fit, keeps the last curvature.
+//
+// Per frame it's a few dozen multiplies and two square roots, plain
+// arithmetic tested on the host, see host/tools/plan_check.c.
+
+#define PLAN_ROWS 10 // rows looked at, far to near
+#define PLAN_MIN_POINTS 4 // fewer rows with the line, no fit
+#define PLAN_OUTLIER_MM 2.0f // rms about the fit over this, the worst row goes
+#define PLAN_MIN_SPAN_MM 80 // nearest to furthest point, less and the fit isn't used
+
+typedef struct planConfig {
+    float latAccel; // mm/s^2 sideways in a bend, 0 doesn't plan
+    float accel; // mm/s^2 speeding up again
+    float minMmS; // never planned slower
+    float maxFitMm; // rms of the points about the fit, worse isn't trusted
+} planConfig_t;
+
+typedef struct plan {
+    planConfig_t cfg;
+    float curvature; // 1/mm, + bending left, the last trusted fit
+    float fitMm; // its rms
+    float speed; // mm/s planned
+    uint64_t timeUs; // of the last frame
+    bool started;
+} plan_t;
+
+int planRow(int i);
+void planDefaultConfig(planConfig_t *cfg);
+void planInit(plan_t *p, const planConfig_t *cfg);
+int planCurvature(const int *cols, float *curvature, float *fitMm);
+float planSpeed(plan_t *p, const int *cols, float topMmS, uint64_t nowUs);
+
+#endif
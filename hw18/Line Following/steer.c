@@ -0,0 +1,228 @@
+#include <string.h>
+#include "pico/stdlib.h"
+#include "steer.h"
+
+// the mailbox: two slots, the writer fills the one not being read and
+// then bumps the count. The count's low bit says which slot is newest.
+static steerEstimate_t steerSlots[2];
+static volatile uint32_t steerSeq = 0;
+
+// the timer loop's state, only touched from the timer callback once started
+static steerPid_t steerCtl;
+static repeating_timer_t steerTimer;
+static bool steerRunning = false;
+static volatile bool steerHeld = true;
+static int steerWrap = 255;
+static steerOutput_t steerOut = NULL;
+static uint32_t steerSeen = 0; // mailbox count of the estimate steered on
+static uint64_t steerLastTickUs = 0;
+static steerTiming_t steerStats;
+static int steerLeft = 0, steerRight = 0;
+static volatile bool steerStatsReset = true; // set by the reader, cleared by the tick
+
+// proportional only, what line_sim's oval and bends are driven with at
+// params.c's default speed; a tuned record (tools/tune.c) goes faster
+void steerDefaultGains(steerGains_t *gains){
+    gains->kp = 0.2f;
+    gains->ki = 0;
+    gains->kd = 0;
+    gains->kff = 0.5f;
+    gains->dTauS = 0.05f;
+    gains->iLimit = 0.25f;
+    gains->outLimit = 1.0f;
+}
+
+void steerPidInit(steerPid_t *pid, const steerGains_t *gains){
+    memset(pid, 0, sizeof(*pid));
+    pid->gains = *gains;
+}
+
+void steerPidReset(steerPid_t *pid){
+    steerGains_t gains = pid->gains;
+    steerPidInit(pid, &gains);
+}
+
+static float steerClamp(float v, float limit){
+    if (v > limit) return limit;
+    if (v < -limit) return -limit;
+    return v;
+}
+
+// one step of the controller, dtUs since the last step. fresh says the
+// estimate is new since the last step, the derivative only moves then.
+float steerPidUpdate(steerPid_t *pid, const steerEstimate_t *est, bool fresh, uint32_t dtUs){
+    const steerGains_t *g = &pid->gains;
+    if (fresh){
+        if (pid->haveSample && est->timeUs > pid->sampleUs){
+            // rate between the two frames, low passed so one noisy
+            // position doesn't kick the motors
+            float dt = (float)(est->timeUs - pid->sampleUs) * 1e-6f;
+            float rate = (est->position - pid->error) / dt;
+            pid->deriv += (rate - pid->deriv) * dt / (g->dTauS + dt);
+        }
+        pid->error = est->position;
+        pid->sampleUs = est->timeUs;
+        pid->haveSample = true;
+    }
+    if (!pid->haveSample){
+        pid->out = 0;
+        return 0;
+    }
+
+    float rest = g->kp * pid->error + g->kd * pid->deriv + g->kff * est->heading;
+    float integral = steerClamp(pid->integral + g->ki * pid->error * (float)dtUs * 1e-6f, g->iLimit);
+    float out = rest + integral;
+    // anti-windup: while the output is saturated, don't integrate further
+    // in the direction that saturated it
+    if ((out > g->outLimit && pid->error > 0) || (out < -g->outLimit && pid->error < 0)){
+        integral = pid->integral;
+        out = rest + integral;
+    }
+    pid->integral = integral;
+    pid->out = steerClamp(out, g->outLimit);
+    return pid->out;
+}
+
+// controller output to motor PWM: positive slows the right motor to turn
+// right, full output takes a whole WRAP off one side like the old map
+void steerMix(float out, int baseSpeed, int wrap, int *left, int *right){
+    int adjust = (int)(out * wrap);
+    *left = baseSpeed;
+    *right = baseSpeed;
+    if (adjust > 0){
+        *right -= adjust;
+    } else {
+        *left += adjust;
+    }
+}
+
+// single writer, the main loop
+void steerPost(const steerEstimate_t *est){
+    uint32_t next = steerSeq + 1;
+    steerSlots[next & 1] = *est;
+    __sync_synchronize(); // the slot is written before the count says so
+    steerSeq = next;
+    steerHeld = false;
+}
+
+// copy out the newest estimate, returns its count or 0 if none was posted.
+// From the timer on the same core the writer can't run in between, the
+// retry is for a reader on the other core.
+int steerLatest(steerEstimate_t *est){
+    int tries;
+    for(tries=0;tries<4;tries++){
+        uint32_t seq = steerSeq;
+        if (seq == 0){
+            return 0;
+        }
+        __sync_synchronize();
+        *est = steerSlots[seq & 1];
+        __sync_synchronize();
+        if (steerSeq == seq){
+            return (int)seq;
+        }
+    }
+    return 0;
+}
+
+void steerTick(uint64_t nowUs){
+    if (steerStatsReset){
+        memset(&steerStats, 0, sizeof(steerStats));
+        steerStats.periodMinUs = UINT32_MAX;
+        steerStatsReset = false;
+    }
+    uint32_t period = STEER_PERIOD_US;
+    if (steerLastTickUs){
+        period = (uint32_t)(nowUs - steerLastTickUs);
+        if (period < steerStats.periodMinUs) steerStats.periodMinUs = period;
+        if (period > steerStats.periodMaxUs) steerStats.periodMaxUs = period;
+        if (period > STEER_LATE_US){
+            steerStats.late++;
+            period = STEER_LATE_US; // don't integrate over the gap
+        }
+    }
+    steerLastTickUs = nowUs;
+    steerStats.ticks++;
+
+    steerEstimate_t est;
+    int seq = steerLatest(&est);
+    int left = 0, right = 0;
+    if (!steerHeld && seq > 0 && nowUs - est.timeUs < STEER_STALE_US){
+        bool fresh = (uint32_t)seq != steerSeen;
+        steerSeen = (uint32_t)seq;
+        if (fresh){
+            steerStats.estimates++;
+        }
+        uint32_t age = (uint32_t)(nowUs - est.timeUs);
+        if (age > steerStats.ageMaxUs) steerStats.ageMaxUs = age;
+        float out;
+        if (est.direct){
+            // the PID starts over if the estimates go back to positions
+            steerPidReset(&steerCtl);
+            out = steerCtl.out = est.turn;
+        } else {
+            out = steerPidUpdate(&steerCtl, &est, fresh, period);
+        }
+        steerMix(out, est.baseSpeed, steerWrap, &left, &right);
+    } else {
+        // held or the camera went quiet, stop and start over on the next estimate
+        steerPidReset(&steerCtl);
+    }
+    if (steerOut){
+        steerOut(left, right);
+    }
+    steerLeft = steerStats.left = left;
+    steerRight = steerStats.right = right;
+    steerStats.out = steerCtl.out;
+    uint32_t run = time_us_32() - (uint32_t)nowUs;
+    if (run > steerStats.runMaxUs) steerStats.runMaxUs = run;
+}
+
+static bool steerCallback(repeating_timer_t *rt){
+    (void)rt;
+    steerTick(time_us_64());
+    return steerRunning;
+}
+
+// start the loop, it stays stopped until the first steerPost()
+bool steerStart(const steerGains_t *gains, int wrap, steerOutput_t output){
+    steerPidInit(&steerCtl, gains);
+    steerWrap = wrap;
+    steerOut = output;
+    steerHeld = true;
+    steerLastTickUs = 0;
+    steerStatsReset = true;
+    // negative: every period from the start of the last call, not its end
+    steerRunning = add_repeating_timer_us(-STEER_PERIOD_US, steerCallback, NULL, &steerTimer);
+    return steerRunning;
+}
+
+void steerStop(){
+    if (steerRunning){
+        cancel_repeating_timer(&steerTimer);
+        steerRunning = false;
+    }
+    if (steerOut){
+        steerOut(0, 0);
+    }
+}
+
+// stop the motors from the next tick on, until an estimate is posted
+void steerHold(){
+    steerHeld = true;
+}
+
+// PWM the last tick wrote
+void steerLastOutput(int *left, int *right){
+    *left = steerLeft;
+    *right = steerRight;
+}
+
+// copy the timing since the last call and start a new window
+void steerGetTiming(steerTiming_t *timing){
+    *timing = steerStats;
+    if (timing->ticks == 0){
+        timing->periodMinUs = 0;
+    }
+    steerStatsReset = true;
+}
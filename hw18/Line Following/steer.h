@@ -0,0 +1,89 @@
+#ifndef STEER_h
+#define STEER_h
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Steering controller.
+// A PID on the line position runs from a repeating timer at a fixed rate
+// and drives the motors itself, so the steering doesn't wait on the
+// camera or the USB prints. The main loop posts each frame's line
+// estimate to a mailbox and the timer picks up the newest one. The
+// derivative is taken between estimates, with the time they were
+// captured, so the 500 Hz loop doesn't see every new frame as a step.
+//
+// An estimate can instead carry the output itself, worked out from the
+// line's geometry (pursuit.h), and the timer just drives it.
+//
+// The controller itself (steerPid*) is plain arithmetic and is tested on
+// the host, see host/tools/steer_check.c.
+
+#define STEER_RATE_HZ 500
+#define STEER_PERIOD_US (1000000 / STEER_RATE_HZ)
+#define STEER_STALE_US 500000 // no estimate for this long, stop the motors
+#define STEER_LATE_US (STEER_PERIOD_US * 3 / 2) // a tick this late counts as late
+
+typedef struct steerGains {
+    float kp; // output per unit of line position, 1 is the old proportional map
+    float ki; // per unit of position and second
+    float kd; // per unit of position per second
+    float kff; // per radian of line heading
+    float dTauS; // derivative low-pass time constant, seconds
+    float iLimit; // the integral term stays within +-iLimit
+    float outLimit; // output is clamped to +-outLimit
+} steerGains_t;
+
+typedef struct steerPid {
+    steerGains_t gains;
+    float error; // newest line position
+    float integral; // the I term itself, not the sum of errors
+    float deriv; // filtered rate of change of the position, per second
+    float out;
+    uint64_t sampleUs; // capture time of the newest position
+    bool haveSample;
+} steerPid_t;
+
+// one line estimate, what the main loop posts each frame
+typedef struct steerEstimate {
+    float position; // -1 line at the left edge, 0 centred, +1 at the right edge
+    float heading; // radians, + the line leans right further ahead, 0 if unknown
+    int baseSpeed; // PWM both motors run at when centred
+    uint64_t timeUs; // when the frame was captured
+    bool direct; // steer on turn, the PID doesn't run
+    float turn; // a steering output worked out already, e.g. by pursuit.h
+} steerEstimate_t;
+
+// what the timer did, the window restarts each time it's read
+typedef struct steerTiming {
+    uint32_t ticks;
+    uint32_t periodMinUs, periodMaxUs; // between tick starts
+    uint32_t runMaxUs; // longest tick
+    uint32_t late; // ticks more than STEER_LATE_US after the one before
+    uint32_t estimates; // new estimates picked up
+    uint32_t ageMaxUs; // oldest estimate steered on
+    int left, right; // last PWM written
+    float out; // last controller output
+} steerTiming_t;
+
+typedef void (*steerOutput_t)(int left, int right);
+
+// the controller
+void steerPidInit(steerPid_t *pid, const steerGains_t *gains);
+void steerPidReset(steerPid_t *pid);
+float steerPidUpdate(steerPid_t *pid, const steerEstimate_t *est, bool fresh, uint32_t dtUs);
+void steerMix(float out, int baseSpeed, int wrap, int *left, int *right);
+
+// the mailbox, the main loop posts and the timer reads
+void steerPost(const steerEstimate_t *est);
+int steerLatest(steerEstimate_t *est);
+
+// the timer loop
+void steerDefaultGains(steerGains_t *gains);
+bool steerStart(const steerGains_t *gains, int wrap, steerOutput_t output);
+void steerStop();
+void steerHold();
+void steerTick(uint64_t nowUs);
+void steerLastOutput(int *left, int *right);
+void steerGetTiming(steerTiming_t *timing);
+
+#endif
@@ -0,0 +1,451 @@
+#include <stdlib.h>
+#include <string.h>
+#include "topology.h"
+
+// the capture ends on the last HS, so the bottom row isn't from this frame
+#define TOPO_LUMA_ROWS (IMAGESIZEY-1)
+
+typedef struct topoSeg {
+    uint8_t start; // rising edge
+    uint8_t end; // falling edge
+} topoSeg_t;
+
+typedef struct topoBar {
+    int cols; // column scanlines it was followed through
+    int outer; // last of them, furthest from the line
+    int y; // mean row
+} topoBar_t;
+
+static uint8_t topoLuma[TOPO_LUMA_ROWS][IMAGESIZEX];
+static topoSeg_t topoRowSeg[TOPO_ROWS][TOPO_MAX_SEGS];
+static uint8_t topoRowCount[TOPO_ROWS];
+static topoSeg_t topoColSeg[TOPO_COLS][TOPO_MAX_SEGS];
+static uint8_t topoColCount[TOPO_COLS];
+static int topoHint = -1; // where the line started last frame
+
+static const char *topoLabels[TOPO_LABELS] = {"lost", "straight", "left", "right", "cross", "end", "stop"};
+static const char *topoPolicies[TOPO_POLICIES] = {"straight", "left", "right", "script"};
+
+static inline int topoRowY(int k){
+    return (2*k + 1) * TOPO_LUMA_ROWS / (2*TOPO_ROWS);
+}
+
+static inline int topoColX(int k){
+    return (2*k + 1) * IMAGESIZEX / (2*TOPO_COLS);
+}
+
+static inline int topoCenter(const topoSeg_t *s){
+    return (s->start + s->end + 1) / 2;
+}
+
+// strongest step along a scanline of n pixels, stride apart
+static int topoMaxGrad(const uint8_t *p, int stride, int n){
+    int i, best = 0;
+    for(i=1;i<n-1;i++){
+        int g = p[(i+1)*stride] - p[(i-1)*stride];
+        if (g < 0) g = -g;
+        if (g > best) best = g;
+    }
+    return best;
+}
+
+// mean of n pixels from i, clipped to the scanline
+static int topoMean(const uint8_t *p, int stride, int len, int i, int n){
+    int sum = 0, count = 0;
+    for(;n>0;n--,i++){
+        if (i >= 0 && i < len){
+            sum += p[i*stride];
+            count++;
+        }
+    }
+    return count ? sum / count : 0;
+}
+
+// pair each rising edge with the falling edge after it, same rules as
+// edgeScanRow() but every pair is kept, returns how many. The inside has to
+// stand above both sides, a pair of noise spikes on a glare slope doesn't.
+static int topoScan(const uint8_t *p, int stride, int n, int thresh, int maxWidth, topoSeg_t *seg){
+    int i, count = 0;
+    int rise = -1;
+    int prev = 0;
+    int g = p[2*stride] - p[0];
+    for(i=1;i<n-1;i++){
+        int next = (i < n-2) ? p[(i+2)*stride] - p[i*stride] : 0;
+        if (g >= thresh && g >= prev && g > next){
+            rise = i;
+        }
+        else if (g <= -thresh && g <= prev && g < next && rise >= 0){
+            // either edge can be a pixel out, skip the pixel next to each
+            int inside = topoMean(p, stride, n, rise + 1, i - rise - 1);
+            int before = topoMean(p, stride, n, rise - 2, 2);
+            int after = topoMean(p, stride, n, i + 1, 2);
+            int side = before > after ? before : after;
+            if (i - rise <= maxWidth && inside - side >= thresh*3/4 && count < TOPO_MAX_SEGS){
+                seg[count].start = (uint8_t)rise;
+                seg[count].end = (uint8_t)i;
+                count++;
+            }
+            rise = -1;
+        }
+        prev = g;
+        g = next;
+    }
+    return count;
+}
+
+// follow a bar out from column scanline first in direction dir, allowing
+// one column without it. Every bar in the first two columns is tried and
+// the longest is kept.
+static void topoFollowBar(int first, int dir, topoBar_t *best){
+    int c0, i, j;
+    best->cols = 0;
+    best->outer = -1;
+    best->y = -1;
+    for(c0=first;c0!=first+2*dir;c0+=dir){
+        if (c0 < 0 || c0 >= TOPO_COLS){
+            break;
+        }
+        for(i=0;i<topoColCount[c0];i++){
+            int y = topoCenter(&topoColSeg[c0][i]);
+            int cols = 1, sumY = y, outer = c0, miss = 0;
+            int c = c0 + dir;
+            while (c >= 0 && c < TOPO_COLS && miss <= 1){
+                int found = -1;
+                for(j=0;j<topoColCount[c];j++){
+                    int yj = topoCenter(&topoColSeg[c][j]);
+                    if (abs(yj - y) <= TOPO_BAR_DY){
+                        found = yj;
+                        break;
+                    }
+                }
+                if (found < 0){
+                    miss++;
+                }
+                else {
+                    y = found;
+                    cols++;
+                    sumY += found;
+                    outer = c;
+                    miss = 0;
+                }
+                c += dir;
+            }
+            if (cols > best->cols){
+                best->cols = cols;
+                best->outer = outer;
+                best->y = sumY / cols;
+            }
+        }
+    }
+}
+
+// forget the line position, call after the robot was moved
+void topoReset(){
+    topoHint = -1;
+}
+
+// label the frame in cameraData
+void topoClassify(topoFrame_t *f){
+    int k, i;
+
+    f->label = TOPO_LOST;
+    f->exits = 0;
+    f->mainX = f->leftX = f->rightX = -1;
+    f->junctionY = -1;
+    f->topY = -1;
+
+    for(i=0;i<TOPO_LUMA_ROWS;i++){
+        getLumaRow(i, topoLuma[i]);
+    }
+
+    // edges have to be half as strong as the strongest in the frame, a
+    // glare spot's slope stays under that next to a real line
+    int maxGrad = 0;
+    for(k=0;k<TOPO_ROWS;k++){
+        int g = topoMaxGrad(topoLuma[topoRowY(k)], 1, IMAGESIZEX);
+        if (g > maxGrad) maxGrad = g;
+    }
+    for(k=0;k<TOPO_COLS;k++){
+        int g = topoMaxGrad(&topoLuma[0][topoColX(k)], IMAGESIZEX, TOPO_LUMA_ROWS);
+        if (g > maxGrad) maxGrad = g;
+    }
+    int thresh = maxGrad / 2;
+    if (thresh < TOPO_MIN_EDGE){
+        return; // flat frame, nothing in view
+    }
+    for(k=0;k<TOPO_ROWS;k++){
+        topoRowCount[k] = (uint8_t)topoScan(topoLuma[topoRowY(k)], 1, IMAGESIZEX, thresh, TOPO_MAX_WIDTH, topoRowSeg[k]);
+    }
+    for(k=0;k<TOPO_COLS;k++){
+        topoColCount[k] = (uint8_t)topoScan(&topoLuma[0][topoColX(k)], IMAGESIZEX, TOPO_LUMA_ROWS, thresh, TOPO_MAX_HEIGHT, topoColSeg[k]);
+    }
+
+    // the line starts in the bottom half, nearest where it was last frame
+    int hint = topoHint >= 0 ? topoHint : IMAGESIZEX/2;
+    int start = -1, x = -1;
+    for(k=TOPO_ROWS-1;k>=0 && topoRowY(k)>=IMAGESIZEY/2;k--){
+        int bestD = IMAGESIZEX;
+        for(i=0;i<topoRowCount[k];i++){
+            int d = abs(topoCenter(&topoRowSeg[k][i]) - hint);
+            if (d < bestD){
+                bestD = d;
+                x = topoCenter(&topoRowSeg[k][i]);
+            }
+        }
+        if (x >= 0){
+            start = k;
+            break;
+        }
+    }
+    if (start < 0){
+        topoHint = -1;
+        return;
+    }
+    topoHint = x;
+
+    // follow it up the image, any other line on the way is a branch. The
+    // line is expected where it was heading since it started, so at a fork
+    // it keeps going the way it came and the other line is the branch.
+    int width = 0, tracked = 0, skipped = 0;
+    int leftRows = 0, rightRows = 0, leftSplit = -1, rightSplit = -1;
+    int steerD = IMAGESIZEY;
+    int startX = x, startY = topoRowY(start);
+    int topX = x, xY = startY;
+    for(k=start;k>=0;k--){
+        int y = topoRowY(k);
+        int pred = x;
+        if (xY < startY){
+            pred = x + (x - startX) * (xY - y) / (startY - xY);
+        }
+        int m = -1, bestD = TOPO_MAX_STEP + skipped * TOPO_MAX_STEP / 2 + 1;
+        for(i=0;i<topoRowCount[k];i++){
+            int d = abs(topoCenter(&topoRowSeg[k][i]) - pred);
+            if (d < bestD){
+                bestD = d;
+                m = i;
+            }
+        }
+        if (m < 0){
+            if (++skipped > TOPO_MAX_GAP){
+                break;
+            }
+        }
+        else {
+            int w = topoRowSeg[k][m].end - topoRowSeg[k][m].start;
+            skipped = 0;
+            // where a branch joins the two lines are one wide one, its
+            // centre is off the line so it doesn't move the line
+            if (tracked < 2 || 2*w*tracked <= 3*width){
+                x = topoCenter(&topoRowSeg[k][m]);
+                xY = y;
+                width += w;
+                tracked++;
+            }
+            f->topY = (int16_t)y;
+            topX = x;
+            if (abs(y - TOPO_STEER_ROW) < steerD){
+                steerD = abs(y - TOPO_STEER_ROW);
+                f->mainX = (int16_t)x;
+            }
+        }
+        int leftSeen = 0, rightSeen = 0;
+        for(i=0;i<topoRowCount[k];i++){
+            int c = topoCenter(&topoRowSeg[k][i]);
+            if (i == m){
+                continue;
+            }
+            // the furthest row out gives the strongest turn
+            if (c < x){
+                leftSeen = 1;
+                f->leftX = (int16_t)c;
+            }
+            else {
+                rightSeen = 1;
+                f->rightX = (int16_t)c;
+            }
+        }
+        if (leftSeen){
+            leftRows++;
+            if (leftSplit < 0) leftSplit = y;
+        }
+        if (rightSeen){
+            rightRows++;
+            if (rightSplit < 0) rightSplit = y;
+        }
+    }
+    if (leftRows < TOPO_BRANCH_ROWS){
+        f->leftX = -1;
+        leftSplit = -1;
+    }
+    if (rightRows < TOPO_BRANCH_ROWS){
+        f->rightX = -1;
+        rightSplit = -1;
+    }
+    if (tracked < TOPO_MIN_ROWS){
+        // a few specks, not a line
+        f->mainX = f->leftX = f->rightX = -1;
+        f->topY = -1;
+        return;
+    }
+    width /= tracked;
+
+    // bars across the line, from the first column clear of it outwards
+    int clear = width / 2 + 2;
+    int firstLeft = -1, firstRight = TOPO_COLS;
+    for(k=0;k<TOPO_COLS;k++){
+        if (topoColX(k) < f->mainX - clear) firstLeft = k;
+        if (topoColX(k) > f->mainX + clear && firstRight == TOPO_COLS) firstRight = k;
+    }
+    topoBar_t left, right;
+    topoFollowBar(firstLeft, -1, &left);
+    topoFollowBar(firstRight, 1, &right);
+    int leftBar = left.cols >= TOPO_BAR_MIN_COLS;
+    int rightBar = right.cols >= TOPO_BAR_MIN_COLS;
+    // a bar all the way to the side of the image is a turn off
+    if (leftBar && left.outer <= 1){
+        f->leftX = (int16_t)topoColX(left.outer);
+        leftSplit = left.y;
+    }
+    if (rightBar && right.outer >= TOPO_COLS-2){
+        f->rightX = (int16_t)topoColX(right.outer);
+        rightSplit = right.y;
+    }
+
+    // the line goes on if it reaches the top or leaves by the side
+    if (f->topY <= TOPO_FAR_ROW || topX < IMAGESIZEX/8 || topX >= IMAGESIZEX - IMAGESIZEX/8){
+        f->exits |= TOPO_EXIT_STRAIGHT;
+    }
+    if (f->leftX >= 0) f->exits |= TOPO_EXIT_LEFT;
+    if (f->rightX >= 0) f->exits |= TOPO_EXIT_RIGHT;
+    f->junctionY = (int16_t)(leftSplit > rightSplit ? leftSplit : rightSplit);
+
+    if ((f->exits & TOPO_EXIT_LEFT) && (f->exits & TOPO_EXIT_RIGHT)){
+        f->label = TOPO_CROSS;
+    }
+    else if (f->exits & TOPO_EXIT_LEFT){
+        f->label = TOPO_LEFT;
+    }
+    else if (f->exits & TOPO_EXIT_RIGHT){
+        f->label = TOPO_RIGHT;
+    }
+    else if (leftBar && rightBar && abs(left.y - right.y) <= 2*TOPO_BAR_DY){
+        f->label = TOPO_STOP;
+        f->junctionY = (int16_t)((left.y + right.y) / 2);
+    }
+    else if (!(f->exits & TOPO_EXIT_STRAIGHT)){
+        f->label = TOPO_END;
+    }
+    else {
+        f->label = TOPO_STRAIGHT;
+    }
+}
+
+const char *topoLabelName(int label){
+    if (label < 0 || label >= TOPO_LABELS){
+        return "?";
+    }
+    return topoLabels[label];
+}
+
+// === Path selection ===
+
+// script entries past the end start the lap over
+void topoPolicyInit(topoPolicy_t *p, int mode, const char *script, int stopLaps){
+    memset(p, 0, sizeof(*p));
+    p->mode = (uint8_t)mode;
+    p->script = script;
+    p->stopLaps = (uint8_t)stopLaps;
+}
+
+const char *topoPolicyName(int mode){
+    if (mode < 0 || mode >= TOPO_POLICIES){
+        return "?";
+    }
+    return topoPolicies[mode];
+}
+
+// which way the policy wants to go at the next junction
+static uint8_t topoPolicyChoice(topoPolicy_t *p){
+    char c = 'S';
+    if (p->mode == TOPO_POLICY_LEFT){
+        c = 'L';
+    }
+    else if (p->mode == TOPO_POLICY_RIGHT){
+        c = 'R';
+    }
+    else if (p->mode == TOPO_POLICY_SCRIPT && p->script && p->script[0]){
+        if (p->script[p->step] == '\0'){
+            p->step = 0;
+        }
+        c = p->script[p->step++];
+    }
+    if (c == 'L' || c == 'l') return TOPO_EXIT_LEFT;
+    if (c == 'R' || c == 'r') return TOPO_EXIT_RIGHT;
+    return TOPO_EXIT_STRAIGHT;
+}
+
+// column to steer for an exit, another way out if this frame doesn't have
+// it: straight on first, then whichever branch there is
+static int topoTarget(const topoFrame_t *f, uint8_t choice){
+    if (choice == TOPO_EXIT_LEFT && f->leftX >= 0) return f->leftX;
+    if (choice == TOPO_EXIT_RIGHT && f->rightX >= 0) return f->rightX;
+    if (f->mainX >= 0 && (f->exits & TOPO_EXIT_STRAIGHT)) return f->mainX;
+    if (f->leftX >= 0) return f->leftX;
+    if (f->rightX >= 0) return f->rightX;
+    return f->mainX;
+}
+
+// one frame through the policy, returns a TOPO_ACTION_* and for
+// TOPO_ACTION_TURN the column to steer for in com
+int topoPolicySteer(topoPolicy_t *p, const topoFrame_t *f, int *com){
+    *com = -1;
+    if (p->halted){
+        return TOPO_ACTION_STOP;
+    }
+    if (f->label == TOPO_END){
+        if (++p->ends >= TOPO_CONFIRM_FRAMES){
+            p->halted = 1;
+            return TOPO_ACTION_STOP;
+        }
+    }
+    else {
+        p->ends = 0;
+    }
+
+    int junction = f->label == TOPO_LEFT || f->label == TOPO_RIGHT || f->label == TOPO_CROSS || f->label == TOPO_STOP;
+    if (junction){
+        p->clear = 0;
+        if (!p->active && ++p->seen >= TOPO_CONFIRM_FRAMES){
+            p->active = 1;
+            p->seen = 0;
+            if (f->label == TOPO_STOP){
+                // a lap is done, the script starts over
+                p->laps++;
+                p->step = 0;
+                p->choice = TOPO_EXIT_STRAIGHT;
+                if (p->stopLaps && p->laps >= p->stopLaps){
+                    p->halted = 1;
+                    return TOPO_ACTION_STOP;
+                }
+            }
+            else {
+                p->choice = topoPolicyChoice(p);
+            }
+        }
+    }
+    else if (p->active){
+        if (++p->clear >= TOPO_CLEAR_FRAMES){
+            p->active = 0;
+            p->clear = 0;
+        }
+    }
+    else {
+        p->seen = 0;
+    }
+
+    if (!p->active || f->label == TOPO_LOST){
+        return TOPO_ACTION_FOLLOW;
+    }
+    *com = topoTarget(f, p->choice);
+    return *com >= 0 ? TOPO_ACTION_TURN : TOPO_ACTION_FOLLOW;
+}
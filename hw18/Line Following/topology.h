@@ -0,0 +1,92 @@
+#ifndef TOPOLOGY_h
+#define TOPOLOGY_h
+
+#include <stdint.h>
+#include "cam.h"
+
+// Track topology from a stored frame: is the line straight, does a branch
+// leave it, is there a crossing, a stop bar or the end of the line.
+// Row scanlines find the lines running up the image, column scanlines find
+// the bars running across it. Both pair a rising and a falling luma edge
+// like the edge finder, so a glare spot or a dim floor doesn't make blobs.
+// A policy then picks which way to go at each junction, instead of the
+// centroid averaging two lines into one that isn't there.
+
+#define TOPO_ROWS 20 // row scanlines, every 3rd row at 80x60
+#define TOPO_COLS 20 // column scanlines, every 4th column at 80x60
+#define TOPO_MAX_SEGS 4 // lines kept per scanline
+#define TOPO_MIN_EDGE 16 // weakest luma step that can be an edge
+#define TOPO_MAX_WIDTH (IMAGESIZEX*3/16) // widest line across a row, a glare spot is wider
+#define TOPO_MAX_HEIGHT (IMAGESIZEY/4) // thickest bar down a column
+#define TOPO_MAX_STEP (IMAGESIZEX/16) // line drift between two row scanlines
+#define TOPO_MIN_ROWS 3 // row scanlines the line has to be followed through
+#define TOPO_MAX_GAP 4 // row scanlines the line can vanish for, a crossing bar
+#define TOPO_BAR_DY (IMAGESIZEY/20) // bar drift between two column scanlines
+#define TOPO_BAR_MIN_COLS 2 // shortest bar, in column scanlines
+#define TOPO_BRANCH_ROWS 2 // row scanlines a second line needs to be a branch
+#define TOPO_FAR_ROW (IMAGESIZEY/4) // the line reaching above this goes on
+#define TOPO_STEER_ROW (IMAGESIZEY/2) // same row the line detector steers on
+
+// frame labels
+#define TOPO_LOST 0 // no line
+#define TOPO_STRAIGHT 1 // one line, straight or curved
+#define TOPO_LEFT 2 // a branch leaves to the left
+#define TOPO_RIGHT 3 // a branch leaves to the right
+#define TOPO_CROSS 4 // branches both ways, a crossing or a T
+#define TOPO_END 5 // the line stops in view
+#define TOPO_STOP 6 // a short bar across the line
+#define TOPO_LABELS 7
+
+// ways out of the frame
+#define TOPO_EXIT_LEFT 1
+#define TOPO_EXIT_STRAIGHT 2
+#define TOPO_EXIT_RIGHT 4
+
+typedef struct topoFrame {
+    uint8_t label;
+    uint8_t exits; // TOPO_EXIT_* bits
+    int16_t mainX; // the line at TOPO_STEER_ROW, -1 if lost
+    int16_t leftX; // where to steer for each branch, -1 if there isn't one
+    int16_t rightX;
+    int16_t junctionY; // row of the bar or where the lines split, -1 if none
+    int16_t topY; // highest row the line was followed to
+} topoFrame_t;
+
+void topoReset();
+void topoClassify(topoFrame_t *f);
+const char *topoLabelName(int label);
+
+// path selection, one decision per junction. A junction has to be seen
+// TOPO_CONFIRM_FRAMES in a row, the decision holds until the frame has been
+// plain for TOPO_CLEAR_FRAMES.
+#define TOPO_POLICY_STRAIGHT 0 // straight on where possible
+#define TOPO_POLICY_LEFT 1 // always left
+#define TOPO_POLICY_RIGHT 2 // always right
+#define TOPO_POLICY_SCRIPT 3 // 'L', 'S' or 'R' per junction, from the start each lap
+#define TOPO_POLICIES 4
+#define TOPO_CONFIRM_FRAMES 2
+#define TOPO_CLEAR_FRAMES 3
+
+#define TOPO_ACTION_FOLLOW 0 // no junction, steer on the line detector
+#define TOPO_ACTION_TURN 1 // steer on the com the policy gave
+#define TOPO_ACTION_STOP 2 // end of the line or the last lap, stop
+
+typedef struct topoPolicy {
+    uint8_t mode; // TOPO_POLICY_*
+    const char *script; // lap script for TOPO_POLICY_SCRIPT
+    uint8_t stopLaps; // stop at this stop bar, 0 never
+    uint8_t step; // next script entry
+    uint8_t laps; // stop bars passed
+    uint8_t seen; // frames in a row with a junction
+    uint8_t clear; // plain frames in a row since
+    uint8_t ends; // frames in a row with the end of the line
+    uint8_t active; // going through a junction
+    uint8_t choice; // TOPO_EXIT_* taken there
+    uint8_t halted;
+} topoPolicy_t;
+
+void topoPolicyInit(topoPolicy_t *p, int mode, const char *script, int stopLaps);
+int topoPolicySteer(topoPolicy_t *p, const topoFrame_t *f, int *com);
+const char *topoPolicyName(int mode);
+
+#endif
@@ -0,0 +1,157 @@
+#include <string.h>
+#include "pico/stdlib.h"
+#include "encoder.h"
+#include "wheel.h"
+
+// the loops, only touched from the steering tick
+static wheelSpeed_t wheelSpd[ENCODER_WHEELS];
+static wheelPi_t wheelCtl[ENCODER_WHEELS];
+static wheelOutput_t wheelOut = NULL;
+static int wheelWrap = 255;
+static volatile bool wheelLoop = false;
+static uint64_t wheelLastUs = 0;
+
+void wheelSpeedReset(wheelSpeed_t *ws){
+    memset(ws, 0, sizeof(*ws));
+}
+
+static void wheelSpeedPush(wheelSpeed_t *ws, int32_t count, uint64_t nowUs){
+    ws->head = (ws->head + 1) % WHEEL_EDGES;
+    ws->count[ws->head] = count;
+    ws->timeUs[ws->head] = nowUs;
+    if (ws->filled < WHEEL_EDGES){
+        ws->filled++;
+    }
+}
+
+// new count sample, returns counts per second
+float wheelSpeedUpdate(wheelSpeed_t *ws, int32_t count, uint64_t nowUs){
+    if (!ws->started){
+        ws->lastCount = count;
+        ws->cps = 0;
+        ws->started = true;
+        wheelSpeedPush(ws, count, nowUs);
+        return 0;
+    }
+    if (count != ws->lastCount){
+        ws->lastCount = count;
+        wheelSpeedPush(ws, count, nowUs);
+        // back to the oldest edge in the span, at least the one before
+        int back = 1, i;
+        for(i=2;i<ws->filled;i++){
+            int k = (ws->head - i + WHEEL_EDGES) % WHEEL_EDGES;
+            if (nowUs - ws->timeUs[k] > WHEEL_SPAN_US){
+                break;
+            }
+            back = i;
+        }
+        int k = (ws->head - back + WHEEL_EDGES) % WHEEL_EDGES;
+        ws->cps = (float)(count - ws->count[k]) * 1e6f / (float)(nowUs - ws->timeUs[k]);
+        return ws->cps;
+    }
+    // no edge: slowing down, or stopped
+    uint64_t since = nowUs - ws->timeUs[ws->head];
+    if (since >= WHEEL_STOP_US){
+        ws->cps = 0;
+    } else if (since > 0){
+        // two edges late, it can't be faster than one edge in that time
+        float bound = 1e6f / (float)since;
+        if (ws->cps > 2 * bound){
+            ws->cps = bound;
+        } else if (ws->cps < -2 * bound){
+            ws->cps = -bound;
+        }
+    }
+    return ws->cps;
+}
+
+void wheelDefaultGains(wheelGains_t *gains){
+    gains->kff = 1.0f / WHEEL_MAX_CPS;
+    gains->kp = 0.5f / WHEEL_MAX_CPS;
+    gains->ki = 5.0f / WHEEL_MAX_CPS;
+    gains->iLimit = 0.5f;
+}
+
+void wheelPiInit(wheelPi_t *pi, const wheelGains_t *gains){
+    wheelGains_t g = *gains; // may be pi's own, to start it over
+    memset(pi, 0, sizeof(*pi));
+    pi->gains = g;
+}
+
+static float wheelClamp(float v, float limit){
+    if (v > limit) return limit;
+    if (v < -limit) return -limit;
+    return v;
+}
+
+// duty for the target speed, the feed-forward does most of it and the PI
+// makes up what the battery and the load take
+float wheelPiUpdate(wheelPi_t *pi, float targetCps, float measuredCps, uint32_t dtUs){
+    const wheelGains_t *g = &pi->gains;
+    float err = targetCps - measuredCps;
+    float rest = g->kff * targetCps + g->kp * err;
+    float integral = wheelClamp(pi->integral + g->ki * err * (float)dtUs * 1e-6f, g->iLimit);
+    float duty = rest + integral;
+    // the same anti-windup as the steering PID
+    if ((duty > 1 && err > 0) || (duty < -1 && err < 0)){
+        integral = pi->integral;
+        duty = rest + integral;
+    }
+    pi->integral = integral;
+    pi->duty = wheelClamp(duty, 1);
+    return pi->duty;
+}
+
+// output writes the PWM, wrap is full PWM. Closed loop from the start.
+void wheelInit(const wheelGains_t *gains, int wrap, wheelOutput_t output){
+    int i;
+    for(i=0;i<ENCODER_WHEELS;i++){
+        wheelSpeedReset(&wheelSpd[i]);
+        wheelPiInit(&wheelCtl[i], gains);
+    }
+    wheelWrap = wrap;
+    wheelOut = output;
+    wheelLastUs = 0;
+    wheelLoop = true;
+}
+
+// off passes the steering loop's PWM straight through, for running
+// without encoders
+void wheelSetClosedLoop(bool on){
+    wheelLoop = on;
+}
+
+bool wheelClosedLoop(){
+    return wheelLoop;
+}
+
+// the steering loop's output: PWM per side as it would be open loop
+void wheelDrive(int left, int right){
+    int cmd[ENCODER_WHEELS] = {left, right};
+    int pwm[ENCODER_WHEELS];
+    uint64_t now = time_us_64();
+    uint32_t dt = wheelLastUs ? (uint32_t)(now - wheelLastUs) : 0;
+    wheelLastUs = now;
+    bool loop = wheelLoop;
+    int i;
+    for(i=0;i<ENCODER_WHEELS;i++){
+        float cps = wheelSpeedUpdate(&wheelSpd[i], encoderCount(i), now);
+        if (!loop || cmd[i] == 0){
+            // stopping doesn't need the loop, and starts it over
+            wheelPiInit(&wheelCtl[i], &wheelCtl[i].gains);
+            pwm[i] = cmd[i];
+            continue;
+        }
+        float target = wheelClamp((float)cmd[i] / wheelWrap, 1) * WHEEL_MAX_CPS;
+        pwm[i] = (int)(wheelPiUpdate(&wheelCtl[i], target, cps, dt) * wheelWrap);
+    }
+    if (wheelOut){
+        wheelOut(pwm[ENCODER_LEFT], pwm[ENCODER_RIGHT]);
+    }
+}
+
+// measured speeds, counts per second
+void wheelSpeeds(float *left, float *right){
+    *left = wheelSpd[ENCODER_LEFT].cps;
+    *right = wheelSpd[ENCODER_RIGHT].cps;
+}
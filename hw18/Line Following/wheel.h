@@ -0,0 +1,65 @@
+#ifndef WHEEL_h
+#define WHEEL_h
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Wheel speed loops under the steering controller.
+// The steering loop asks for a PWM per side as if the motors were open
+// loop. That becomes a speed, full PWM being WHEEL_MAX_CPS, and a PI per
+// wheel on the encoder speed finds the PWM that really gives it, so the
+// car keeps its speed as the battery runs down.
+//
+// Speed is measured from the encoder count sampled every steering tick.
+// The ticks that saw the count change are kept as the times of the
+// latest edges, and the speed is the counts over the span back to the
+// oldest of them within WHEEL_SPAN_US: many edges at speed, which also
+// evens out the encoder's unequal phases, down to the time between two
+// edges at a crawl, where counting per tick would see 0 or 1. With no
+// edge the speed can't be more than one count over the time since the
+// last one, so it decays to zero instead of holding the last value.
+
+#define WHEEL_MAX_CPS 6000.0f // counts per second at full PWM on a full battery
+#define WHEEL_EDGES 8 // edge samples kept
+#define WHEEL_SPAN_US 100000 // longest span measured over, unless it's one edge
+#define WHEEL_STOP_US 200000 // no edge for this long is stopped
+
+typedef struct wheelSpeed {
+    int32_t count[WHEEL_EDGES]; // at the ticks the count changed, a ring
+    uint64_t timeUs[WHEEL_EDGES];
+    int head, filled;
+    int32_t lastCount; // at the last sample
+    float cps; // counts per second, + forward
+    bool started;
+} wheelSpeed_t;
+
+typedef struct wheelGains {
+    float kff; // duty per count per second, 1 / WHEEL_MAX_CPS does the open loop part
+    float kp; // duty per count per second of error
+    float ki; // duty per count of error
+    float iLimit; // integral term within +-iLimit of duty
+} wheelGains_t;
+
+typedef struct wheelPi {
+    wheelGains_t gains;
+    float integral;
+    float duty; // -1 to 1
+} wheelPi_t;
+
+// speed estimate and PI, plain arithmetic
+void wheelSpeedReset(wheelSpeed_t *ws);
+float wheelSpeedUpdate(wheelSpeed_t *ws, int32_t count, uint64_t nowUs);
+void wheelDefaultGains(wheelGains_t *gains);
+void wheelPiInit(wheelPi_t *pi, const wheelGains_t *gains);
+float wheelPiUpdate(wheelPi_t *pi, float targetCps, float measuredCps, uint32_t dtUs);
+
+// the loops on the encoders, run from the steering tick
+typedef void (*wheelOutput_t)(int left, int right);
+
+void wheelInit(const wheelGains_t *gains, int wrap, wheelOutput_t output);
+void wheelSetClosedLoop(bool on);
+bool wheelClosedLoop();
+void wheelDrive(int left, int right);
+void wheelSpeeds(float *left, float *right);
+
+#endif
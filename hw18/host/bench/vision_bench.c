@@ -0,0 +1,375 @@
+// Host benchmark for the line-extraction kernels in cam.c.
+// Replays the raw frames in the corpus through each kernel and reports
+// ns/frame, error against the labelled line centre and heap allocations,
+// as JSON so results can be compared across commits.
+//
+// usage: vision_bench_WxH [-c corpus dir] [-l run.log] [-n reps] [-r rev] [-o out.json]
+// The frame size is fixed at build time by IMAGESIZEX/IMAGESIZEY, so only
+// corpus frames of that size are used. -l replays a recorded frame log
+// (framelog.h) instead, scored against the com the car steered on; raw
+// RGB565 frames are used straight from the mapped log.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "cam.h"
+#include "hough.h"
+#include "framelog.h"
+
+#ifndef BENCH_CORPUS_DIR
+#define BENCH_CORPUS_DIR "corpus"
+#endif
+#ifndef BENCH_GIT_REV
+#define BENCH_GIT_REV "unknown"
+#endif
+
+#define MAX_ROWS 8
+#define FRAME_BYTES (IMAGESIZEX*IMAGESIZEY*2)
+
+typedef struct frame {
+    char name[64];
+    char scene[64];
+    const uint8_t *raw; // in the mapped log, or owned
+    uint8_t *owned;
+    int numRows;
+    int rows[MAX_ROWS];
+    float truth[MAX_ROWS];
+} frame_t;
+
+static frame_t *frames = NULL;
+static int numFrames = 0;
+static int capFrames = 0;
+static framelogReader_t runLog;
+
+// a kernel takes one raw frame and returns the line centre for each row,
+// or -1 when it finds no line there
+typedef void (*line_kernel_fn)(const uint8_t *raw, const int *rows, int numRows, int *centers);
+
+typedef struct kernel {
+    const char *name;
+    line_kernel_fn fn;
+} kernel_t;
+
+// what the firmware does today: convert to RGB, threshold and centroid a row
+static void kernel_findLine(const uint8_t *raw, const int *rows, int numRows, int *centers){
+    loadRawImage(raw);
+    convertImage();
+    int i;
+    for (i = 0; i < numRows; i++){
+        centers[i] = findLine(rows[i]);
+    }
+}
+
+// Sobel edge pairs, fed row by row the way it runs during capture
+static void kernel_findLineEdges(const uint8_t *raw, const int *rows, int numRows, int *centers){
+    loadRawImage(raw);
+    edgeProcessAvailableRows();
+    int i;
+    for (i = 0; i < numRows; i++){
+        centers[i] = findLineEdges(rows[i], NULL);
+    }
+}
+
+// whole frame Hough line through the edge centres, read back at each row
+static void kernel_houghLine(const uint8_t *raw, const int *rows, int numRows, int *centers){
+    loadRawImage(raw);
+    houghLine_t line;
+    int found = houghFindLine(&line) == 0;
+    int i;
+    for (i = 0; i < numRows; i++){
+        centers[i] = found ? houghLineX(&line, rows[i]) : -1;
+    }
+}
+
+static const kernel_t kernels[] = {
+    {"findLine", kernel_findLine},
+    {"findLineEdges", kernel_findLineEdges},
+    {"houghLine", kernel_houghLine},
+};
+#define NUM_KERNELS (sizeof(kernels) / sizeof(kernels[0]))
+
+// heap use is counted by wrapping malloc and friends at link time
+static size_t allocCount = 0;
+static size_t allocBytes = 0;
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t n, size_t size);
+void *__real_realloc(void *p, size_t size);
+
+void *__wrap_malloc(size_t size){
+    allocCount++;
+    allocBytes += size;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t n, size_t size){
+    allocCount++;
+    allocBytes += n * size;
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *p, size_t size){
+    allocCount++;
+    allocBytes += size;
+    return __real_realloc(p, size);
+}
+
+static uint64_t now_ns(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static frame_t *new_frame(){
+    if (numFrames == capFrames){
+        int cap = capFrames ? capFrames * 2 : 64;
+        frame_t *more = realloc(frames, (size_t)cap * sizeof(frame_t));
+        if (!more){
+            return NULL;
+        }
+        frames = more;
+        capFrames = cap;
+    }
+    frame_t *fr = &frames[numFrames];
+    memset(fr, 0, sizeof(*fr));
+    return fr;
+}
+
+static frame_t *find_frame_scene(const char *scene){
+    int i;
+    for (i = 0; i < numFrames; i++){
+        if (strcmp(frames[i].scene, scene) == 0){
+            return &frames[i];
+        }
+    }
+    return NULL;
+}
+
+static frame_t *find_frame(const char *name){
+    int i;
+    for (i = 0; i < numFrames; i++){
+        if (strcmp(frames[i].name, name) == 0){
+            return &frames[i];
+        }
+    }
+    return NULL;
+}
+
+// labels.txt lines are: file width height row center
+static int load_corpus(const char *dir){
+    char path[512];
+    snprintf(path, sizeof(path), "%s/labels.txt", dir);
+    FILE *f = fopen(path, "r");
+    if (!f){
+        perror(path);
+        return -1;
+    }
+    char line[256];
+    while (fgets(line, sizeof(line), f)){
+        char name[64];
+        int w, h, row;
+        float center;
+        if (line[0] == '#' || sscanf(line, "%63s %d %d %d %f", name, &w, &h, &row, &center) != 5){
+            continue;
+        }
+        if (w != IMAGESIZEX || h != IMAGESIZEY){
+            continue;
+        }
+        frame_t *fr = find_frame(name);
+        if (!fr){
+            fr = new_frame();
+            if (!fr){
+                break;
+            }
+            snprintf(fr->name, sizeof(fr->name), "%s", name);
+            snprintf(fr->scene, sizeof(fr->scene), "%s", name);
+            char *us = strchr(fr->scene, '_');
+            if (us){
+                *us = 0;
+            }
+            snprintf(path, sizeof(path), "%s/%s", dir, name);
+            FILE *rf = fopen(path, "rb");
+            fr->owned = malloc(FRAME_BYTES);
+            if (!rf || !fr->owned || fread(fr->owned, 1, FRAME_BYTES, rf) != FRAME_BYTES){
+                fprintf(stderr, "could not read %s\n", path);
+                if (rf){
+                    fclose(rf);
+                }
+                free(fr->owned);
+                continue;
+            }
+            fclose(rf);
+            fr->raw = fr->owned;
+            numFrames++;
+        }
+        if (fr->numRows < MAX_ROWS){
+            fr->rows[fr->numRows] = row;
+            fr->truth[fr->numRows] = center;
+            fr->numRows++;
+        }
+    }
+    fclose(f);
+    return numFrames;
+}
+
+// every frame of a recorded run that has a com, labelled with it at the
+// steering row
+static int load_log(const char *path){
+    if (framelogOpen(&runLog, path) != 0){
+        return -1;
+    }
+    if (runLog.header->width != IMAGESIZEX || runLog.header->height != IMAGESIZEY){
+        fprintf(stderr, "%s is %dx%d\n", path, runLog.header->width, runLog.header->height);
+        return -1;
+    }
+    uint32_t i;
+    for (i = 0; i < runLog.frames; i++){
+        const framelogEntry_t *e = framelogEntry(&runLog, i);
+        if (e->com == FRAMELOG_NO_VALUE){
+            continue;
+        }
+        frame_t *fr = new_frame();
+        if (!fr){
+            break;
+        }
+        snprintf(fr->name, sizeof(fr->name), "frame_%u", i);
+        snprintf(fr->scene, sizeof(fr->scene), "log");
+        if (runLog.header->format == FRAMELOG_RGB565 && e->encoding == FRAMELOG_RAW){
+            fr->raw = framelogPayload(&runLog, i);
+        } else {
+            fr->owned = malloc(FRAME_BYTES);
+            if (!fr->owned || framelogReadCamera(&runLog, i, fr->owned) != 0){
+                free(fr->owned);
+                continue;
+            }
+            fr->raw = fr->owned;
+        }
+        fr->rows[0] = IMAGESIZEY / 2;
+        fr->truth[0] = e->com;
+        fr->numRows = 1;
+        numFrames++;
+    }
+    return numFrames;
+}
+
+static void run_kernel(FILE *out, const kernel_t *k, int reps){
+    int centers[MAX_ROWS];
+    int i, j, rep;
+
+    // accuracy and allocations from one pass over the corpus
+    float *sceneErr = calloc((size_t)numFrames, sizeof(float));
+    int *sceneHits = calloc((size_t)numFrames, sizeof(int));
+    float sumErr = 0, maxErr = 0;
+    int numErr = 0, numMiss = 0;
+    allocCount = 0;
+    allocBytes = 0;
+    for (i = 0; i < numFrames; i++){
+        k->fn(frames[i].raw, frames[i].rows, frames[i].numRows, centers);
+        for (j = 0; j < frames[i].numRows; j++){
+            if (centers[j] < 0){
+                numMiss++; // misses are counted apart, not as an error
+                continue;
+            }
+            float e = fabsf(centers[j] - frames[i].truth[j]);
+            // by the first frame of the scene
+            frame_t *first = find_frame_scene(frames[i].scene);
+            sceneErr[first - frames] += e;
+            sceneHits[first - frames]++;
+            sumErr += e;
+            if (e > maxErr){
+                maxErr = e;
+            }
+            numErr++;
+        }
+    }
+    size_t allocs = allocCount;
+    size_t bytes = allocBytes;
+
+    // timing over many passes so the clock resolution doesn't matter
+    uint64_t t0 = now_ns();
+    for (rep = 0; rep < reps; rep++){
+        for (i = 0; i < numFrames; i++){
+            k->fn(frames[i].raw, frames[i].rows, frames[i].numRows, centers);
+        }
+    }
+    uint64_t t1 = now_ns();
+    double nsPerFrame = (double)(t1 - t0) / ((double)reps * numFrames);
+
+    fprintf(out, "    {\"name\": \"%s\", \"ns_per_frame\": %.1f, \"mean_abs_err_px\": %.3f, \"max_abs_err_px\": %.3f, \"miss_rate\": %.3f, "
+        "\"allocs_per_frame\": %.2f, \"alloc_bytes_per_frame\": %.1f, \"scenes\": {",
+        k->name, nsPerFrame, numErr ? sumErr / numErr : 0.0f, maxErr,
+        (double)numMiss / (numErr + numMiss), (double)allocs / numFrames, (double)bytes / numFrames);
+    int scenes = 0;
+    for (i = 0; i < numFrames; i++){
+        if (find_frame_scene(frames[i].scene) == &frames[i]){
+            fprintf(out, "%s\"%s\": %.3f", scenes++ ? ", " : "", frames[i].scene,
+                sceneHits[i] ? sceneErr[i] / sceneHits[i] : 0.0f);
+        }
+    }
+    fprintf(out, "}}");
+    free(sceneErr);
+    free(sceneHits);
+
+    fprintf(stderr, "%-16s %10.1f ns/frame  err mean %.2f max %.2f px  misses %d  allocs %zu\n",
+        k->name, nsPerFrame, numErr ? sumErr / numErr : 0.0f, maxErr, numMiss, allocs);
+}
+
+int main(int argc, char **argv){
+    const char *corpus = BENCH_CORPUS_DIR;
+    const char *rev = BENCH_GIT_REV;
+    const char *outPath = NULL;
+    const char *logPath = NULL;
+    int reps = 200;
+    int i;
+    for (i = 1; i < argc - 1; i++){
+        if (strcmp(argv[i], "-c") == 0){
+            corpus = argv[++i];
+        } else if (strcmp(argv[i], "-l") == 0){
+            logPath = argv[++i];
+        } else if (strcmp(argv[i], "-n") == 0){
+            reps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-r") == 0){
+            rev = argv[++i];
+        } else if (strcmp(argv[i], "-o") == 0){
+            outPath = argv[++i];
+        }
+    }
+    if (reps < 1){
+        reps = 1;
+    }
+
+    if (logPath){
+        if (load_log(logPath) <= 0){
+            fprintf(stderr, "no %dx%d frames with a com in %s\n", IMAGESIZEX, IMAGESIZEY, logPath);
+            return 1;
+        }
+    } else if (load_corpus(corpus) <= 0){
+        fprintf(stderr, "no %dx%d frames in %s\n", IMAGESIZEX, IMAGESIZEY, corpus);
+        return 1;
+    }
+
+    FILE *out = stdout;
+    if (outPath){
+        out = fopen(outPath, "w");
+        if (!out){
+            perror(outPath);
+            return 1;
+        }
+    }
+
+    fprintf(out, "{\n  \"rev\": \"%s\",\n  \"frame\": \"%dx%d\",\n  \"frames\": %d,\n  \"reps\": %d,\n  \"kernels\": [\n",
+        rev, IMAGESIZEX, IMAGESIZEY, numFrames, reps);
+    unsigned int k;
+    for (k = 0; k < NUM_KERNELS; k++){
+        run_kernel(out, &kernels[k], reps);
+        fprintf(out, "%s\n", k + 1 < NUM_KERNELS ? "," : "");
+    }
+    fprintf(out, "  ]\n}\n");
+
+    if (outPath){
+        fclose(out);
+    }
+    return 0;
+}
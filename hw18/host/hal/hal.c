@@ -0,0 +1,456 @@
+// Host implementation of the small slice of the Pico SDK used by hw18.
+// Nothing here touches real hardware: pins, PWM and the camera's I2C
+// registers are plain arrays so host tools can drive and inspect them.
+
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/gpio.h"
+#include "hardware/pwm.h"
+#include "hardware/i2c.h"
+#include "hardware/clocks.h"
+#include "hardware/irq.h"
+#include "hardware/flash.h"
+#include "pico/flash.h"
+
+static uint64_t now_us = 0;
+static uint32_t sys_khz = 150000;
+static void (*idle_hook)(void) = 0;
+static int (*input_hook)(void) = 0;
+
+#define HAL_TIMERS 4
+static repeating_timer_t *timers[HAL_TIMERS];
+static int in_timer = 0;
+static uint8_t irq_priority[64];
+static irq_handler_t irq_handlers[64];
+static uint64_t irq_enabled = 0;
+
+static uint32_t gpio_state = 0;
+static gpio_irq_callback_t gpio_callback_fn = 0;
+
+static uint16_t pwm_level[NUM_PWM_SLICES][2];
+static uint16_t pwm_wrap[NUM_PWM_SLICES];
+static float pwm_div[NUM_PWM_SLICES];
+static uint16_t pwm_counter[NUM_PWM_SLICES];
+static pwm_hw_t pwm_regs;
+static uint32_t pwm_inte = 0, pwm_intr = 0;
+pwm_hw_t *pwm_hw = &pwm_regs;
+static uint32_t io_writes = 0; // every call below that would write a GPIO or PWM register
+
+struct i2c_inst {
+    uint baudrate;
+};
+static struct i2c_inst i2c_insts[2];
+i2c_inst_t *i2c0 = &i2c_insts[0];
+i2c_inst_t *i2c1 = &i2c_insts[1];
+
+// fake OV7670 register file, PID/VER read back like a real sensor
+static uint8_t sensor_regs[256] = {
+    [0x0A] = 0x76,
+    [0x0B] = 0x73,
+};
+static uint8_t sensor_addr = 0;
+
+// starts out blank (no valid data), erase sets 0xFF like the real part
+uint8_t hal_flash[PICO_FLASH_SIZE_BYTES];
+static uint32_t flash_erase_count = 0;
+static uint32_t flash_program_count = 0;
+
+// move the clock to t, running every timer that falls due on the way at
+// its own time. A timer calling something that moves the clock doesn't
+// run the timers again.
+static void advance_to(uint64_t t){
+    if (in_timer){
+        now_us = t;
+        return;
+    }
+    for (;;){
+        int i, due = -1;
+        for (i = 0; i < HAL_TIMERS; i++){
+            if (timers[i] && timers[i]->next_us <= t && (due < 0 || timers[i]->next_us < timers[due]->next_us)){
+                due = i;
+            }
+        }
+        if (due < 0){
+            break;
+        }
+        repeating_timer_t *rt = timers[due];
+        if (rt->next_us > now_us){
+            now_us = rt->next_us;
+        }
+        in_timer = 1;
+        bool again = rt->callback(rt);
+        in_timer = 0;
+        if (timers[due] != rt){
+            continue; // cancelled itself
+        }
+        if (!again){
+            timers[due] = 0;
+            continue;
+        }
+        if (rt->delay_us < 0){
+            rt->next_us += (uint64_t)(-rt->delay_us);
+        } else {
+            rt->next_us = now_us + (uint64_t)rt->delay_us;
+        }
+    }
+    if (t > now_us){
+        now_us = t;
+    }
+}
+
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void *user_data, repeating_timer_t *out){
+    int i;
+    if (delay_us == 0){
+        return false;
+    }
+    for (i = 0; i < HAL_TIMERS; i++){
+        if (!timers[i]){
+            out->delay_us = delay_us;
+            out->next_us = now_us + (uint64_t)(delay_us < 0 ? -delay_us : delay_us);
+            out->callback = callback;
+            out->user_data = user_data;
+            timers[i] = out;
+            return true;
+        }
+    }
+    return false; // the SDK's default pool runs out too
+}
+
+bool cancel_repeating_timer(repeating_timer_t *timer){
+    int i;
+    for (i = 0; i < HAL_TIMERS; i++){
+        if (timers[i] == timer){
+            timers[i] = 0;
+            return true;
+        }
+    }
+    return false;
+}
+
+void irq_set_priority(uint num, uint8_t hardware_priority){
+    irq_priority[num] = hardware_priority;
+}
+
+uint8_t hal_irq_get_priority(uint num){
+    return irq_priority[num];
+}
+
+void irq_set_exclusive_handler(uint num, irq_handler_t handler){
+    irq_handlers[num] = handler;
+}
+
+void irq_set_enabled(uint num, bool enabled){
+    if (enabled){
+        irq_enabled |= 1ull << num;
+    } else {
+        irq_enabled &= ~(1ull << num);
+    }
+}
+
+void stdio_init_all(){
+}
+
+bool stdio_usb_connected(){
+    return true;
+}
+
+int getchar_timeout_us(uint32_t timeout_us){
+    if (input_hook){
+        int c = input_hook();
+        if (c != PICO_ERROR_TIMEOUT){
+            return c;
+        }
+    }
+    advance_to(now_us + timeout_us);
+    return PICO_ERROR_TIMEOUT;
+}
+
+void sleep_ms(uint32_t ms){
+    advance_to(now_us + (uint64_t)ms * 1000);
+}
+
+void sleep_us(uint64_t us){
+    advance_to(now_us + us);
+}
+
+uint64_t time_us_64(){
+    return now_us;
+}
+
+uint32_t time_us_32(){
+    return (uint32_t)now_us;
+}
+
+absolute_time_t get_absolute_time(){
+    return now_us;
+}
+
+void hal_advance_us(uint64_t us){
+    advance_to(now_us + us);
+}
+
+void tight_loop_contents(){
+    if (idle_hook){
+        idle_hook();
+    } else {
+        advance_to(now_us + 1); // keep timeouts moving
+    }
+}
+
+void hal_set_idle_hook(void (*hook)(void)){
+    idle_hook = hook;
+}
+
+void hal_set_input(int (*next)(void)){
+    input_hook = next;
+}
+
+bool set_sys_clock_khz(uint32_t freq_khz, bool required){
+    (void)required;
+    sys_khz = freq_khz;
+    return true;
+}
+
+uint32_t clock_get_hz(enum clock_index clk_index){
+    (void)clk_index;
+    return sys_khz * 1000;
+}
+
+void gpio_init(uint gpio){
+    io_writes++;
+    gpio_state &= ~(1u << gpio);
+}
+
+void gpio_set_dir(uint gpio, bool out){
+    io_writes++;
+    (void)gpio;
+    (void)out;
+}
+
+void gpio_put(uint gpio, bool value){
+    io_writes++;
+    if (value){
+        gpio_state |= (1u << gpio);
+    } else {
+        gpio_state &= ~(1u << gpio);
+    }
+}
+
+void gpio_put_masked(uint32_t mask, uint32_t value){
+    io_writes++;
+    gpio_state = (gpio_state & ~mask) | (value & mask);
+}
+
+bool gpio_get(uint gpio){
+    return (gpio_state >> gpio) & 1;
+}
+
+uint32_t gpio_get_all(){
+    return gpio_state;
+}
+
+void gpio_set_function(uint gpio, enum gpio_function fn){
+    io_writes++;
+    (void)gpio;
+    (void)fn;
+}
+
+void gpio_pull_up(uint gpio){
+    (void)gpio;
+}
+
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t events, bool enabled, gpio_irq_callback_t callback){
+    (void)gpio;
+    (void)events;
+    (void)enabled;
+    // the SDK has one shared callback for all pins, same here
+    gpio_callback_fn = callback;
+}
+
+void hal_gpio_set_all(uint32_t value){
+    gpio_state = value;
+}
+
+void hal_gpio_irq(uint gpio, uint32_t events){
+    if (gpio_callback_fn){
+        gpio_callback_fn(gpio, events);
+    }
+}
+
+void pwm_set_clkdiv(uint slice_num, float divider){
+    io_writes++;
+    pwm_div[slice_num] = divider;
+}
+
+void pwm_set_wrap(uint slice_num, uint16_t wrap){
+    io_writes++;
+    pwm_wrap[slice_num] = wrap;
+}
+
+void pwm_set_enabled(uint slice_num, bool enabled){
+    io_writes++;
+    if (enabled){
+        pwm_regs.en |= 1u << slice_num;
+    } else {
+        pwm_regs.en &= ~(1u << slice_num);
+    }
+}
+
+void pwm_set_chan_level(uint slice_num, uint chan, uint16_t level){
+    io_writes++;
+    pwm_level[slice_num][chan] = level;
+}
+
+void pwm_set_gpio_level(uint gpio, uint16_t level){
+    io_writes++;
+    pwm_level[pwm_gpio_to_slice_num(gpio)][pwm_gpio_to_channel(gpio)] = level;
+}
+
+void pwm_set_both_levels(uint slice_num, uint16_t level_a, uint16_t level_b){
+    io_writes++;
+    pwm_level[slice_num][0] = level_a;
+    pwm_level[slice_num][1] = level_b;
+}
+
+void pwm_set_counter(uint slice_num, uint16_t c){
+    io_writes++;
+    pwm_counter[slice_num] = c;
+}
+
+// the counters don't run on the host
+uint16_t pwm_get_counter(uint slice_num){
+    return pwm_counter[slice_num];
+}
+
+void pwm_set_irq_enabled(uint slice_num, bool enabled){
+    pwm_set_irq_mask_enabled(1u << slice_num, enabled);
+}
+
+void pwm_set_irq_mask_enabled(uint32_t slice_mask, bool enabled){
+    io_writes++;
+    if (enabled){
+        pwm_inte |= slice_mask;
+    } else {
+        pwm_inte &= ~slice_mask;
+    }
+}
+
+void pwm_clear_irq(uint slice_num){
+    io_writes++;
+    pwm_intr &= ~(1u << slice_num);
+}
+
+uint32_t pwm_get_irq_status_mask(){
+    return pwm_intr & pwm_inte;
+}
+
+void hal_pwm_wrap(uint32_t slice_mask){
+    pwm_intr |= slice_mask & pwm_regs.en;
+    if ((irq_enabled >> PWM_IRQ_WRAP) & 1 && irq_handlers[PWM_IRQ_WRAP] && (pwm_intr & pwm_inte)){
+        irq_handlers[PWM_IRQ_WRAP]();
+    }
+}
+
+uint32_t hal_pwm_irq_enabled_mask(){
+    return pwm_inte;
+}
+
+void hw_set_bits(io_rw_32 *addr, uint32_t mask){
+    io_writes++;
+    *addr |= mask;
+}
+
+void hw_clear_bits(io_rw_32 *addr, uint32_t mask){
+    io_writes++;
+    *addr &= ~mask;
+}
+
+uint32_t hal_io_writes(){
+    return io_writes;
+}
+
+uint16_t hal_pwm_get_level(uint gpio){
+    return pwm_level[pwm_gpio_to_slice_num(gpio)][pwm_gpio_to_channel(gpio)];
+}
+
+uint16_t hal_pwm_get_wrap(uint slice_num){
+    return pwm_wrap[slice_num];
+}
+
+float hal_pwm_get_clkdiv(uint slice_num){
+    return pwm_div[slice_num];
+}
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate){
+    i2c->baudrate = baudrate;
+    return baudrate;
+}
+
+// first byte is the register address, any following bytes are written to it
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop){
+    (void)i2c;
+    (void)addr;
+    (void)nostop;
+    if (len == 0){
+        return 0;
+    }
+    sensor_addr = src[0];
+    size_t i;
+    for (i = 1; i < len; i++){
+        sensor_regs[sensor_addr] = src[i];
+    }
+    return (int)len;
+}
+
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop){
+    (void)i2c;
+    (void)addr;
+    (void)nostop;
+    size_t i;
+    for (i = 0; i < len; i++){
+        dst[i] = sensor_regs[sensor_addr];
+    }
+    return (int)len;
+}
+
+uint8_t hal_i2c_get_register(uint8_t reg){
+    return sensor_regs[reg];
+}
+
+void hal_i2c_set_register(uint8_t reg, uint8_t value){
+    sensor_regs[reg] = value;
+}
+
+void flash_range_erase(uint32_t flash_offs, size_t count){
+    if (flash_offs % FLASH_SECTOR_SIZE || count % FLASH_SECTOR_SIZE || flash_offs + count > PICO_FLASH_SIZE_BYTES){
+        abort(); // the real erase would hit the wrong sectors
+    }
+    memset(hal_flash + flash_offs, 0xFF, count);
+    flash_erase_count++;
+}
+
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count){
+    if (flash_offs % FLASH_PAGE_SIZE || count % FLASH_PAGE_SIZE || flash_offs + count > PICO_FLASH_SIZE_BYTES){
+        abort();
+    }
+    size_t i;
+    for (i = 0; i < count; i++){
+        hal_flash[flash_offs + i] &= data[i]; // programming only clears bits
+    }
+    flash_program_count++;
+}
+
+uint32_t hal_flash_erases(){
+    return flash_erase_count;
+}
+
+uint32_t hal_flash_programs(){
+    return flash_program_count;
+}
+
+int flash_safe_execute(void (*func)(void *), void *param, uint32_t enter_exit_timeout_ms){
+    (void)enter_exit_timeout_ms;
+    func(param);
+    return PICO_OK;
+}
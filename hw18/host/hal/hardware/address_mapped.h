@@ -0,0 +1,12 @@
+#ifndef HOST_HARDWARE_ADDRESS_MAPPED_h
+#define HOST_HARDWARE_ADDRESS_MAPPED_h
+
+#include <stdint.h>
+
+typedef volatile uint32_t io_rw_32;
+
+// the atomic set and clear aliases, one register write each
+void hw_set_bits(io_rw_32 *addr, uint32_t mask);
+void hw_clear_bits(io_rw_32 *addr, uint32_t mask);
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef HOST_HARDWARE_CLOCKS_h
+#define HOST_HARDWARE_CLOCKS_h
+
+#include <stdint.h>
+#include "hardware/gpio.h"
+
+enum clock_index {
+    clk_gpout0 = 0,
+    clk_gpout1,
+    clk_gpout2,
+    clk_gpout3,
+    clk_ref,
+    clk_sys,
+    clk_peri,
+    clk_hstx,
+    clk_usb,
+    clk_adc,
+    CLK_COUNT
+};
+
+// follows set_sys_clock_khz(), starts at the RP2350's 150MHz
+uint32_t clock_get_hz(enum clock_index clk_index);
+
+#endif
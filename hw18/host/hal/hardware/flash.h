@@ -0,0 +1,24 @@
+#ifndef HOST_HARDWARE_FLASH_h
+#define HOST_HARDWARE_FLASH_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+// flash is a plain array here, XIP_BASE points at it so firmware reads of
+// XIP_BASE + offset see what was programmed
+#define FLASH_PAGE_SIZE 256
+#define FLASH_SECTOR_SIZE 4096
+#define PICO_FLASH_SIZE_BYTES (4 * 1024 * 1024) // Pico 2
+
+extern uint8_t hal_flash[PICO_FLASH_SIZE_BYTES];
+#define XIP_BASE ((uintptr_t)hal_flash)
+
+// offsets must be sector (erase) or page (program) aligned like the real thing
+void flash_range_erase(uint32_t flash_offs, size_t count);
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count);
+
+// times each has been called, to check for needless writes
+uint32_t hal_flash_erases();
+uint32_t hal_flash_programs();
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef HOST_HARDWARE_GPIO_h
+#define HOST_HARDWARE_GPIO_h
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef unsigned int uint;
+
+#define NUM_BANK0_GPIOS 30
+
+enum gpio_function {
+    GPIO_FUNC_SIO = 5,
+    GPIO_FUNC_PWM = 4,
+    GPIO_FUNC_I2C = 3,
+    GPIO_FUNC_NULL = 0x1f,
+};
+
+#define GPIO_IN false
+#define GPIO_OUT true
+
+enum gpio_irq_level {
+    GPIO_IRQ_LEVEL_LOW = 0x1u,
+    GPIO_IRQ_LEVEL_HIGH = 0x2u,
+    GPIO_IRQ_EDGE_FALL = 0x4u,
+    GPIO_IRQ_EDGE_RISE = 0x8u,
+};
+
+typedef void (*gpio_irq_callback_t)(uint gpio, uint32_t event_mask);
+
+void gpio_init(uint gpio);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_put(uint gpio, bool value);
+void gpio_put_masked(uint32_t mask, uint32_t value);
+bool gpio_get(uint gpio);
+uint32_t gpio_get_all();
+void gpio_set_function(uint gpio, enum gpio_function fn);
+void gpio_pull_up(uint gpio);
+void gpio_set_irq_enabled_with_callback(uint gpio, uint32_t events, bool enabled, gpio_irq_callback_t callback);
+
+// host only: drive the input pins and fire the registered callback
+void hal_gpio_set_all(uint32_t value);
+void hal_gpio_irq(uint gpio, uint32_t events);
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef HOST_HARDWARE_I2C_h
+#define HOST_HARDWARE_I2C_h
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "hardware/gpio.h"
+
+typedef struct i2c_inst i2c_inst_t;
+extern i2c_inst_t *i2c0;
+extern i2c_inst_t *i2c1;
+
+uint i2c_init(i2c_inst_t *i2c, uint baudrate);
+int i2c_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop);
+int i2c_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop);
+
+// host only: the fake sensor's register file, one byte per address
+uint8_t hal_i2c_get_register(uint8_t reg);
+void hal_i2c_set_register(uint8_t reg, uint8_t value);
+
+#endif
@@ -0,0 +1,24 @@
+#ifndef HOST_HARDWARE_IRQ_h
+#define HOST_HARDWARE_IRQ_h
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hardware/gpio.h"
+
+#define PICO_HIGHEST_IRQ_PRIORITY 0x00
+#define PICO_DEFAULT_IRQ_PRIORITY 0x80
+#define PICO_LOWEST_IRQ_PRIORITY 0xff
+
+#define PWM_IRQ_WRAP_0 8
+#define PWM_IRQ_WRAP PWM_IRQ_WRAP_0
+#define IO_IRQ_BANK0 21
+
+typedef void (*irq_handler_t)(void);
+
+// host only keeps the value, nothing preempts anything
+void irq_set_priority(uint num, uint8_t hardware_priority);
+uint8_t hal_irq_get_priority(uint num);
+void irq_set_exclusive_handler(uint num, irq_handler_t handler);
+void irq_set_enabled(uint num, bool enabled);
+
+#endif
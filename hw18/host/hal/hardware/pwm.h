@@ -0,0 +1,43 @@
+#ifndef HOST_HARDWARE_PWM_h
+#define HOST_HARDWARE_PWM_h
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hardware/gpio.h"
+#include "hardware/address_mapped.h"
+
+#define NUM_PWM_SLICES 12
+
+// just the enable register, so the slices can be started with one write
+typedef struct {
+    io_rw_32 en;
+} pwm_hw_t;
+
+extern pwm_hw_t *pwm_hw;
+
+static inline uint pwm_gpio_to_slice_num(uint gpio) { return (gpio >> 1) & 0xF; }
+static inline uint pwm_gpio_to_channel(uint gpio) { return gpio & 1; }
+
+void pwm_set_clkdiv(uint slice_num, float divider);
+void pwm_set_wrap(uint slice_num, uint16_t wrap);
+void pwm_set_enabled(uint slice_num, bool enabled);
+void pwm_set_chan_level(uint slice_num, uint chan, uint16_t level);
+void pwm_set_gpio_level(uint gpio, uint16_t level);
+void pwm_set_both_levels(uint slice_num, uint16_t level_a, uint16_t level_b);
+void pwm_set_counter(uint slice_num, uint16_t c);
+uint16_t pwm_get_counter(uint slice_num);
+void pwm_set_irq_enabled(uint slice_num, bool enabled);
+void pwm_set_irq_mask_enabled(uint32_t slice_mask, bool enabled);
+void pwm_clear_irq(uint slice_num);
+uint32_t pwm_get_irq_status_mask();
+
+// host only: read back what the firmware programmed
+uint16_t hal_pwm_get_level(uint gpio);
+uint16_t hal_pwm_get_wrap(uint slice_num);
+float hal_pwm_get_clkdiv(uint slice_num);
+uint32_t hal_io_writes(); // GPIO and PWM register writes so far
+// the enabled slices in the mask wrap, the wrap IRQ runs if it's on for any
+void hal_pwm_wrap(uint32_t slice_mask);
+uint32_t hal_pwm_irq_enabled_mask();
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef HOST_PICO_FLASH_h
+#define HOST_PICO_FLASH_h
+
+#include <stdint.h>
+
+// nothing else runs on the host, so the function is just called
+int flash_safe_execute(void (*func)(void *), void *param, uint32_t enter_exit_timeout_ms);
+
+#endif
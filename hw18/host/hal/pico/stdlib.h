@@ -0,0 +1,58 @@
+#ifndef HOST_PICO_STDLIB_h
+#define HOST_PICO_STDLIB_h
+
+// Host stand-in for the Pico SDK's pico/stdlib.h.
+// Only the calls used by the hw18 sources are provided, see hal.c.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "hardware/gpio.h"
+
+#define PICO_OK 0
+#define PICO_ERROR_TIMEOUT -1
+
+typedef uint64_t absolute_time_t;
+
+// the SDK places these in a section the boot code doesn't zero, the host
+// has no such section
+#define __uninitialized_ram(name) name
+
+void stdio_init_all();
+bool stdio_usb_connected();
+int getchar_timeout_us(uint32_t timeout_us);
+
+// time is simulated, sleeping just moves the clock forward
+void sleep_ms(uint32_t ms);
+void sleep_us(uint64_t us);
+uint64_t time_us_64();
+uint32_t time_us_32();
+absolute_time_t get_absolute_time();
+static inline uint64_t to_us_since_boot(absolute_time_t t) { return t; }
+bool set_sys_clock_khz(uint32_t freq_khz, bool required);
+
+// repeating timers fire as the simulated clock passes their time, in
+// whatever call moved it
+typedef struct repeating_timer repeating_timer_t;
+typedef bool (*repeating_timer_callback_t)(repeating_timer_t *rt);
+struct repeating_timer {
+    int64_t delay_us; // negative: from the start of the last call
+    uint64_t next_us;
+    repeating_timer_callback_t callback;
+    void *user_data;
+};
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void *user_data, repeating_timer_t *out);
+bool cancel_repeating_timer(repeating_timer_t *timer);
+
+// busy-wait loops call this, on the host it runs the idle hook so a
+// simulated peripheral can make progress while the firmware spins
+void tight_loop_contents();
+
+// host only: advance the simulated clock without a sleep call
+void hal_advance_us(uint64_t us);
+void hal_set_idle_hook(void (*hook)(void));
+// host only: where getchar_timeout_us() gets its keys, the hook returns
+// a key or PICO_ERROR_TIMEOUT
+void hal_set_input(int (*next)(void));
+
+#endif
@@ -0,0 +1,66 @@
+// Runs the capture bit error rate tester (captest.c) against the simulated
+// OV7670 in sim_sensor.c so the tester itself can be checked.
+// The sensor flips bits at a chosen rate and, above a PCLK limit, at a rate
+// that climbs with the clock and finally drops bytes the way a GPIO
+// interrupt that can't keep up would.
+//
+// usage: captest_sim [-e base BER] [-l PCLK limit kHz] [-s stuck data line] [-n frames]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "cam.h"
+#include "captest.h"
+#include "sim_sensor.h"
+
+int main(int argc, char **argv){
+    int frames = 200;
+    int i;
+    for (i = 1; i < argc - 1; i++){
+        if (strcmp(argv[i], "-e") == 0){
+            simSensor.ber = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-l") == 0){
+            simSensor.limitHz = (uint32_t)atoi(argv[++i]) * 1000;
+        } else if (strcmp(argv[i], "-s") == 0){
+            simSensor.stuckLine = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-n") == 0){
+            frames = atoi(argv[++i]);
+        }
+    }
+
+    init_camera_pins();
+    sim_sensor_install();
+
+    // 1. the tester must see exactly the bits that were flipped
+    OV7670_test_pattern(OV7670_TEST_PATTERN_COLOR_BAR);
+    captestApply(captestGetConfig(0));
+    captestLearnReference();
+    static captestStats_t stats;
+    uint64_t before = simSensor.injected;
+    captestRun(frames, &stats);
+    uint64_t detected = 0;
+    int b;
+    for (b = 0; b < 8; b++){
+        detected += stats.bitErrors[b];
+    }
+    printf("check: injected %llu bit errors, tester counted %llu\n",
+        (unsigned long long)(simSensor.injected - before), (unsigned long long)detected);
+    captestPrint(&stats);
+    int ok = detected == simSensor.injected - before;
+
+    // a stuck line gets voted into the reference, it has to be flagged instead
+    uint8_t expectStuck = simSensor.stuckLine >= 0 ? 1 << simSensor.stuckLine : 0;
+    printf("stuck lines: expected 0x%02x, flagged 0x%02x\n", expectStuck, captestStuckLines());
+    ok = ok && captestStuckLines() == expectStuck;
+
+    // 2. the sweep should stop at the limit given to the simulated sensor
+    int best = captestSweep(frames);
+    if (best >= 0){
+        uint32_t pclk = captestPclkHz(captestGetConfig(best));
+        printf("sweep picked %lu kHz, simulated limit %lu kHz\n",
+            (unsigned long)(pclk / 1000), (unsigned long)(simSensor.limitHz / 1000));
+    }
+    printf("%s\n", ok ? "tester agrees with the injected errors" : "tester DISAGREES with the injected errors");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,46 @@
+// Plans the system clock, MCLK and OV7670 clock registers for a frame
+// rate and size with clockplan.c, then prints the frame timing.
+//
+// usage: clock_plan [-f fps] [-s WxH] [-m max sys MHz]
+//   -f  target frame rate, may be fractional (default 15)
+//   -s  640x480, 320x240, 160x120, 80x60 (default) or 40x30
+//   -m  highest system clock to consider (default the rated 150MHz)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "clockplan.h"
+
+int main(int argc, char **argv){
+    double fps = 15;
+    int size = 3;
+    uint32_t sysMaxKhz = CLOCKPLAN_SYS_MAX_KHZ;
+    int i;
+    for (i = 1; i < argc - 1; i++){
+        if (strcmp(argv[i], "-f") == 0){
+            fps = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0){
+            int w = atoi(argv[++i]);
+            for (size = 0; size < 4 && (640 >> size) != w; size++){
+            }
+            if ((640 >> size) != w){
+                fprintf(stderr, "unsupported size %s\n", argv[i]);
+                return 2;
+            }
+        } else if (strcmp(argv[i], "-m") == 0){
+            sysMaxKhz = (uint32_t)atoi(argv[++i]) * 1000;
+        }
+    }
+
+    clockPlan_t plan;
+    if (clockplanMake(&plan, (uint32_t)(fps * 1000 + 0.5), size, sysMaxKhz) != 0){
+        fprintf(stderr, "no clock setting captures %dx%d reliably\n", 640 >> size, 480 >> size);
+        return 1;
+    }
+    printf("target %.2f fps\n", fps);
+    clockplanPrint(&plan, size);
+    if (plan.frameUs && 1e6 / plan.frameUs < fps * 0.99){
+        printf("target not reached, PCLK is held to what the capture ISR keeps up with\n");
+    }
+    return 0;
+}
@@ -0,0 +1,138 @@
+// Checks the flat field correction on a floor with vignetting and the
+// robot's shadow. Calibrates on blank floor frames through the simulated
+// sensor, then compares findLine() on line frames with and without the
+// gains, checks a frame with a line isn't taken for blank floor, and
+// checks the table survives a save and reload from flash.
+//
+// usage: flatfield_check [-v vignette 0-1] [-s shadow 0-1]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "cam.h"
+#include "flatfield.h"
+#include "sim_sensor.h"
+
+static double vignette = 0.45; // brightness lost at the corners
+static double shadow = 0.45; // brightness lost under the robot's shadow
+static uint32_t seed = 7;
+static uint8_t frame[IMAGESIZEX*IMAGESIZEY*2];
+static double lineX = -1; // line centre at the middle row, -1 for blank floor
+
+static double noise(){
+    seed = seed * 1664525u + 1013904223u;
+    return ((seed >> 8) / 16777216.0 - 0.5) * 8;
+}
+
+// light falling on the floor at a pixel
+static double illumination(int x, int y){
+    double dx = (x - IMAGESIZEX / 2.0) / (IMAGESIZEX / 2.0);
+    double dy = (y - IMAGESIZEY / 2.0) / (IMAGESIZEY / 2.0);
+    double light = 1 - vignette * (dx * dx + dy * dy) / 2;
+    // shadow over the bottom left, with a soft edge
+    double sx = 1 / (1 + exp((x - IMAGESIZEX * 0.6) / 2.0));
+    double sy = 1 / (1 + exp((IMAGESIZEY * 0.7 - y) / 2.0));
+    return light * (1 - shadow * sx * sy);
+}
+
+static void render(){
+    int x, y;
+    for (y = 0; y < IMAGESIZEY; y++){
+        // 6 pixel wide line, leaning a little
+        double cx = lineX + 0.2 * (y - IMAGESIZEY / 2);
+        for (x = 0; x < IMAGESIZEX; x++){
+            double albedo = (lineX >= 0 && fabs(x - cx) < 3) ? 0.95 : 0.45;
+            double v = 255 * albedo * illumination(x, y);
+            int c[3], k;
+            for (k = 0; k < 3; k++){
+                c[k] = (int)(v + noise());
+                c[k] = c[k] < 0 ? 0 : (c[k] > 255 ? 255 : c[k]);
+            }
+            uint16_t px = ((c[0] >> 3) << 11) | ((c[1] >> 2) << 5) | (c[2] >> 3);
+            frame[(y * IMAGESIZEX + x) * 2] = px & 0xFF;
+            frame[(y * IMAGESIZEX + x) * 2 + 1] = px >> 8;
+        }
+    }
+}
+
+// mean error of findLine() over a sweep of line positions
+static double line_error(){
+    static const int rows[3] = {IMAGESIZEY / 6, IMAGESIZEY / 2, IMAGESIZEY * 5 / 6};
+    double err = 0;
+    int n = 0, r;
+    for (lineX = 10; lineX <= IMAGESIZEX - 10; lineX += 5){
+        render();
+        loadRawImage(frame);
+        convertImage();
+        for (r = 0; r < 3; r++){
+            double want = lineX + 0.2 * (rows[r] - IMAGESIZEY / 2);
+            err += fabs(findLine(rows[r]) - want);
+            n++;
+        }
+    }
+    return err / n;
+}
+
+int main(int argc, char **argv){
+    int i;
+    for (i = 1; i < argc - 1; i++){
+        if (strcmp(argv[i], "-v") == 0){
+            vignette = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0){
+            shadow = atof(argv[++i]);
+        }
+    }
+
+    init_camera_pins();
+    sim_sensor_install();
+    simSensor.frame = frame;
+    simSensor.onFrame = render; // fresh noise every frame
+
+    int ok = flatfieldLoad() != 0; // blank flash has no table
+    double before = line_error();
+
+    // a line in view isn't vignetting, the gains must stay as they were
+    lineX = IMAGESIZEX / 2;
+    int refused = flatfieldCalibrate(FLAT_FRAMES) != 0 && getFlatField() == NULL;
+    printf("line in view: %s\n", refused ? "refused" : "CALIBRATED");
+    ok = ok && refused;
+
+    lineX = -1;
+    if (flatfieldCalibrate(FLAT_FRAMES) != 0){
+        printf("calibration failed on blank floor\n");
+        return 1;
+    }
+    uint8_t lo, hi;
+    flatfieldStats(&lo, &hi);
+    double after = line_error();
+    printf("vignette %.2f shadow %.2f, gains %.2f..%.2f\n", vignette, shadow, lo / (double)FLAT_ONE, hi / (double)FLAT_ONE);
+    printf("findLine mean error: %.2f px uncorrected, %.2f px flat field corrected\n", before, after);
+    ok = ok && after <= before;
+
+    // a later boot should find the same table in flash
+    static uint8_t saved[FLAT_TABLE_SIZE];
+    memcpy(saved, getFlatField(), FLAT_TABLE_SIZE);
+    if (flatfieldSave() != 0){
+        printf("save failed\n");
+        return 1;
+    }
+    printf("saved %d bytes at flash offset 0x%x (%lu erases, %lu page programs)\n", FLAT_FLASH_BYTES, FLAT_FLASH_OFFSET,
+        (unsigned long)hal_flash_erases(), (unsigned long)hal_flash_programs());
+    setFlatField(NULL);
+    int loaded = flatfieldLoad() == 0 && memcmp(saved, getFlatField(), FLAT_TABLE_SIZE) == 0;
+    printf("reload: %s\n", loaded ? "same table" : "FAILED");
+    ok = ok && loaded;
+
+    // a damaged table must not be used
+    hal_flash[FLAT_FLASH_OFFSET + FLAT_HEADER_SIZE + 100] ^= 0x10;
+    setFlatField(NULL);
+    int rejected = flatfieldLoad() != 0 && getFlatField() == NULL;
+    printf("corrupted table: %s\n", rejected ? "rejected" : "USED");
+    ok = ok && rejected;
+
+    printf("%s\n", ok ? "flat field ok" : "flat field FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,316 @@
+// Records the camera stream from the car over USB serial. hw18 prints
+// every frame with printImage(), one "index r g b" line per pixel, then
+// the line position on a line of its own and a "COM: | Left PWM: | Right
+// PWM:" line; anything else is a status line. The stream is read in large
+// non-blocking chunks and parsed byte by byte with no line copies, the
+// pixels going straight into their place in the memory mapped frame log
+// (framelog.h). Status lines are echoed. A PPM preview of the latest frame
+// is rewritten every few frames.
+//
+// usage: frame_recv -d /dev/ttyACM0 [-o run.log] [-p preview.ppm]
+//        [-e every] [-n frames] [-x width] [-y height] [-z] [-q]
+// -d also takes a file or fifo, which is read to the end. -z stores frames
+// RLE encoded where that is smaller. Ends on Ctrl-C, when the device goes
+// away, or after -n frames, then prints the rates.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <termios.h>
+#include "framelog.h"
+
+#define READ_CHUNK (1 << 20)
+#define MAX_FIELDS 4
+#define TEXT_MAX 255
+
+typedef struct parser {
+    uint32_t fields[MAX_FIELDS + 1];
+    int numFields;
+    uint32_t value;
+    int inNumber;
+    int text; // the line has something other than digits and spaces
+    char line[TEXT_MAX + 1]; // kept for echoing status lines
+    int lineLen;
+    uint8_t *frame; // the open frame's pixels in the log, NULL if none
+    uint32_t next; // next pixel index expected
+    int complete; // every pixel arrived, waiting for the line position
+    int pending; // has its line position, waiting for the PWM line
+    framelogEntry_t meta;
+} parser_t;
+
+static uint8_t chunk[READ_CHUNK];
+static volatile sig_atomic_t stop = 0;
+static int quiet = 0;
+static int encoding = FRAMELOG_RAW;
+static const char *previewPath = NULL;
+static uint32_t previewEvery = 10;
+static uint32_t maxFrames = 0;
+static uint32_t pixels;
+static uint64_t startUs;
+static uint64_t textLines = 0;
+
+static uint64_t now_us(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ull + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static void on_signal(int sig){
+    (void)sig;
+    stop = 1;
+}
+
+static void write_preview(const framelogWriter_t *w, const uint8_t *rgb){
+    char tmp[1024];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", previewPath);
+    FILE *f = fopen(tmp, "wb");
+    if (!f){
+        perror(tmp);
+        return;
+    }
+    fprintf(f, "P6\n%d %d\n255\n", w->header->width, w->header->height);
+    fwrite(rgb, 3, pixels, f);
+    fclose(f);
+    // a viewer watching the file never sees half of one
+    rename(tmp, previewPath);
+}
+
+// the frame is done, its pixels are already in place
+static void parser_commit(parser_t *p, framelogWriter_t *w){
+    if (previewPath && (w->header->frames + 1) % previewEvery == 0){
+        write_preview(w, p->frame); // before RLE can rewrite it
+    }
+    p->meta.timeUs = now_us() - startUs;
+    if (framelogCommit(w, &p->meta, encoding) != 0){
+        stop = 1;
+    }
+    if (maxFrames && w->header->frames >= maxFrames){
+        stop = 1;
+    }
+    p->frame = NULL;
+    p->complete = 0;
+    p->pending = 0;
+}
+
+// drop the open frame, the next one reuses its place
+static void parser_drop(parser_t *p, framelogWriter_t *w){
+    if (p->next){
+        w->header->dropped++;
+    }
+    p->frame = NULL;
+    p->next = 0;
+    p->complete = 0;
+}
+
+static void parser_line(parser_t *p, framelogWriter_t *w){
+    if (p->text){
+        p->line[p->lineLen] = 0;
+        int com, left, right;
+        int n = sscanf(p->line, "COM: %d | Left PWM: %d | Right PWM: %d", &com, &left, &right);
+        if (n >= 1 && (p->complete || p->pending)){
+            // hw18 prints this after the line position, hw12 and hw17 only
+            // print this one
+            p->meta.com = (int16_t)com;
+            if (n == 3){
+                p->meta.leftPwm = (int16_t)left;
+                p->meta.rightPwm = (int16_t)right;
+            }
+            parser_commit(p, w);
+        }
+        else if (!quiet){
+            printf("%s\n", p->line);
+        }
+        textLines++;
+        return;
+    }
+    if (p->numFields == MAX_FIELDS){
+        uint32_t i = p->fields[0];
+        if (p->pending){
+            parser_commit(p, w); // no PWM line this time
+        }
+        if (i == 0){
+            if (p->frame){
+                parser_drop(p, w); // the last frame never finished
+            }
+            p->frame = framelogBegin(w);
+            if (!p->frame){
+                stop = 1;
+                return;
+            }
+            p->next = 0;
+            p->complete = 0;
+            p->meta.com = p->meta.leftPwm = p->meta.rightPwm = FRAMELOG_NO_VALUE;
+        }
+        if (!p->frame || i != p->next || p->complete){
+            if (p->frame){
+                parser_drop(p, w); // lost a line, wait for the next frame
+            }
+            return;
+        }
+        uint8_t *px = p->frame + i * 3;
+        px[0] = (uint8_t)(p->fields[1] > 255 ? 255 : p->fields[1]);
+        px[1] = (uint8_t)(p->fields[2] > 255 ? 255 : p->fields[2]);
+        px[2] = (uint8_t)(p->fields[3] > 255 ? 255 : p->fields[3]);
+        p->next = i + 1;
+        if (p->next == pixels){
+            p->complete = 1;
+        }
+    }
+    else if (p->numFields == 1 && p->complete){
+        p->meta.com = (int16_t)p->fields[0];
+        p->complete = 0;
+        p->pending = 1;
+    }
+}
+
+static void parser_feed(parser_t *p, framelogWriter_t *w, const uint8_t *buf, size_t n){
+    size_t k;
+    for(k=0;k<n && !stop;k++){
+        uint8_t c = buf[k];
+        if (c >= '0' && c <= '9'){
+            p->value = p->value * 10 + (c - '0');
+            p->inNumber = 1;
+        }
+        else if (c == ' ' || c == '\t' || c == '\r' || c == '\n'){
+            if (p->inNumber){
+                if (p->numFields <= MAX_FIELDS){
+                    p->fields[p->numFields++] = p->value;
+                }
+                p->value = 0;
+                p->inNumber = 0;
+            }
+            if (c == '\n'){
+                if (p->numFields || p->text){
+                    parser_line(p, w);
+                }
+                p->numFields = 0;
+                p->text = 0;
+                p->lineLen = 0;
+                continue;
+            }
+        }
+        else {
+            p->text = 1;
+        }
+        if (c != '\r' && p->lineLen < TEXT_MAX){
+            p->line[p->lineLen++] = (char)c;
+        }
+    }
+}
+
+static int open_input(const char *path){
+    int fd = open(path, O_RDONLY | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0){
+        perror(path);
+        return -1;
+    }
+    if (isatty(fd)){
+        // raw bytes, USB CDC ignores the baud rate
+        struct termios tio;
+        if (tcgetattr(fd, &tio) == 0){
+            cfmakeraw(&tio);
+            cfsetspeed(&tio, B115200);
+            tio.c_cc[VMIN] = 0;
+            tio.c_cc[VTIME] = 0;
+            tcsetattr(fd, TCSANOW, &tio);
+        }
+        tcflush(fd, TCIFLUSH);
+    }
+    return fd;
+}
+
+int main(int argc, char **argv){
+    const char *device = NULL;
+    const char *out = "run.log";
+    int width = 80, height = 60;
+    int i;
+    for (i = 1; i < argc; i++){
+        if (strcmp(argv[i], "-q") == 0){
+            quiet = 1;
+        } else if (strcmp(argv[i], "-z") == 0){
+            encoding = FRAMELOG_RLE;
+        } else if (i + 1 >= argc){
+            break;
+        } else if (strcmp(argv[i], "-d") == 0){
+            device = argv[++i];
+        } else if (strcmp(argv[i], "-o") == 0){
+            out = argv[++i];
+        } else if (strcmp(argv[i], "-p") == 0){
+            previewPath = argv[++i];
+        } else if (strcmp(argv[i], "-e") == 0){
+            previewEvery = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-n") == 0){
+            maxFrames = (uint32_t)atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-x") == 0){
+            width = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-y") == 0){
+            height = atoi(argv[++i]);
+        }
+    }
+    if (!device || width <= 0 || height <= 0 || previewEvery == 0){
+        fprintf(stderr, "usage: frame_recv -d device [-o run.log] [-p preview.ppm] [-e every] "
+            "[-n frames] [-x width] [-y height] [-z] [-q]\n");
+        return 2;
+    }
+
+    int fd = open_input(device);
+    if (fd < 0){
+        return 1;
+    }
+    framelogWriter_t log;
+    if (framelogCreate(&log, out, width, height, FRAMELOG_RGB888) != 0){
+        return 1;
+    }
+    pixels = (uint32_t)(width * height);
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    parser_t parser;
+    memset(&parser, 0, sizeof(parser));
+    uint64_t bytes = 0;
+    startUs = now_us();
+    struct pollfd pfd = {fd, POLLIN, 0};
+    while (!stop){
+        ssize_t n = read(fd, chunk, sizeof(chunk));
+        if (n > 0){
+            bytes += (uint64_t)n;
+            parser_feed(&parser, &log, chunk, (size_t)n);
+            continue;
+        }
+        if (n == 0 && !isatty(fd)){
+            break; // end of a file or fifo
+        }
+        if (n < 0 && errno != EAGAIN && errno != EINTR){
+            if (errno != EIO){
+                perror("read");
+            }
+            break; // EIO is the device unplugged or the pty closed
+        }
+        poll(&pfd, 1, 200);
+        if (pfd.revents & (POLLHUP | POLLERR) && !(pfd.revents & POLLIN)){
+            break;
+        }
+    }
+    double secs = (now_us() - startUs) / 1e6;
+
+    if (parser.pending){
+        parser_commit(&parser, &log);
+    }
+    uint32_t frames = log.header->frames, dropped = log.header->dropped;
+    if (framelogFinish(&log) != 0){
+        fprintf(stderr, "%s: could not write the index\n", out);
+    }
+    close(fd);
+    fprintf(stderr, "%u frames recorded to %s, %u dropped, %llu status lines\n", frames, out, dropped,
+        (unsigned long long)textLines);
+    fprintf(stderr, "%llu bytes in %.2f s: %.2f MB/s, %.1f frames/s\n", (unsigned long long)bytes, secs,
+        secs > 0 ? bytes / secs / 1e6 : 0.0, secs > 0 ? frames / secs : 0.0);
+    return 0;
+}
@@ -0,0 +1,249 @@
+// Drives frame_recv through a pseudo terminal, the way the car's USB
+// serial port looks to it. Writes frames in the exact printImage() format
+// with status lines between them and one frame with a lost line, as fast
+// as the pty takes them, then checks every pixel, line position and PWM
+// in the recorded frame log and the last preview. Reports the throughput
+// against what a 12 Mbit/s USB full speed link could ever deliver.
+// Exits non-zero on a wrong frame or if the receiver can't keep up with
+// the link.
+//
+// usage: frame_recv_test [-n frames] [-x width] [-y height]
+
+#define _GNU_SOURCE // posix_openpt and friends
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include "framelog.h"
+
+#define USB_FS_BYTES_PER_S (12e6 / 8)
+#define PREVIEW_EVERY 50
+#define BAD_FRAME 7 // loses a pixel line
+
+static int width = 80, height = 60;
+
+static uint64_t now_us(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ull + (uint64_t)ts.tv_nsec / 1000;
+}
+
+static void pixel(int f, int i, int *r, int *g, int *b){
+    *r = (i * 7 + f) & 255;
+    *g = (i * 13 + f * 3) & 255;
+    *b = (i / width * 4 + f * 5) & 255;
+}
+
+static int com_of(int f){
+    return (f * 11) % width;
+}
+
+static int pwm_of(int f, int side){
+    return side ? 100 + f % 50 : 150 - f % 40;
+}
+
+// the stream hw18 prints for frames frames, into a malloc'd buffer
+static char *render_stream(int frames, size_t *len){
+    size_t cap = (size_t)frames * (width * height * 20 + 200) + 4096;
+    char *buf = malloc(cap);
+    size_t n = 0;
+    int f, i, r, g, b;
+    n += sprintf(buf + n, "Hello, camera!\n");
+    // a frame cut off at the start, as if the receiver joined late
+    for(i=width*height/2;i<width*height;i++){
+        n += sprintf(buf + n, "%d 1 2 3\r\n", i);
+    }
+    n += sprintf(buf + n, "40\r\n");
+    for(f=0;f<frames;f++){
+        if (f % 3 == 0){
+            n += sprintf(buf + n, "Track: cross\n");
+        }
+        for(i=0;i<width*height;i++){
+            if (f == BAD_FRAME && i == 100){
+                continue;
+            }
+            pixel(f, i, &r, &g, &b);
+            n += sprintf(buf + n, "%d %d %d %d\r\n", i, r, g, b);
+        }
+        n += sprintf(buf + n, "%d\r\n", com_of(f));
+        if (f % 10 != 5){
+            n += sprintf(buf + n, "COM: %d | Left PWM: %d | Right PWM: %d\n", com_of(f), pwm_of(f, 0), pwm_of(f, 1));
+        }
+    }
+    *len = n;
+    return buf;
+}
+
+// checks the stored frame against the frame the stream had, some frames
+// have no PWM line
+static int check_frame(const framelogReader_t *log, int k, int f){
+    const framelogEntry_t *e = framelogEntry(log, (uint32_t)k);
+    const uint8_t *px = framelogPayload(log, (uint32_t)k);
+    int i, r, g, b;
+    int pwmOk = f % 10 == 5 ? e->leftPwm == FRAMELOG_NO_VALUE && e->rightPwm == FRAMELOG_NO_VALUE
+        : e->leftPwm == pwm_of(f, 0) && e->rightPwm == pwm_of(f, 1);
+    if (e->com != com_of(f) || !pwmOk || e->encoding != FRAMELOG_RAW){
+        return -1;
+    }
+    for(i=0;i<width*height;i++){
+        pixel(f, i, &r, &g, &b);
+        if (px[i*3] != r || px[i*3+1] != g || px[i*3+2] != b){
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv){
+    int frames = 300;
+    int i;
+    for (i = 1; i < argc - 1; i++){
+        if (strcmp(argv[i], "-n") == 0){
+            frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-x") == 0){
+            width = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-y") == 0){
+            height = atoi(argv[++i]);
+        }
+    }
+    alarm(60); // the write blocks forever if the receiver dies
+    size_t len;
+    char *stream = render_stream(frames, &len);
+
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0){
+        perror("pty");
+        return 1;
+    }
+    const char *slaveName = ptsname(master);
+    // raw before anything is written, the line discipline would eat it
+    int slave = open(slaveName, O_RDWR | O_NOCTTY);
+    struct termios tio;
+    tcgetattr(slave, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+
+    char dir[] = "/tmp/frame_recv_XXXXXX";
+    if (!mkdtemp(dir)){
+        perror("mkdtemp");
+        return 1;
+    }
+    char out[256], preview[256], xs[16], ys[16];
+    snprintf(out, sizeof(out), "%s/run.log", dir);
+    snprintf(preview, sizeof(preview), "%s/preview.ppm", dir);
+    snprintf(xs, sizeof(xs), "%d", width);
+    snprintf(ys, sizeof(ys), "%d", height);
+    char every[16];
+    snprintf(every, sizeof(every), "%d", PREVIEW_EVERY);
+
+    pid_t pid = fork();
+    if (pid == 0){
+        close(master);
+        execl(FRAME_RECV, FRAME_RECV, "-d", slaveName, "-o", out, "-p", preview, "-e", every,
+            "-x", xs, "-y", ys, "-q", (char *)NULL);
+        perror(FRAME_RECV);
+        _exit(127);
+    }
+    close(slave); // the receiver's is the only one left, closing master hangs it up
+
+    uint64_t t0 = now_us();
+    size_t sent = 0;
+    while (sent < len){
+        ssize_t n = write(master, stream + sent, len - sent);
+        if (n <= 0){
+            perror("write");
+            break;
+        }
+        sent += (size_t)n;
+    }
+    // wait for the receiver to drain the pty before hanging up
+    uint64_t waitUntil = now_us() + 5000000;
+    int queued = 1;
+    while (now_us() < waitUntil){
+        struct stat st;
+        if (stat(out, &st) == 0){
+            int fd = open(out, O_RDONLY);
+            framelogHeader_t h;
+            if (fd >= 0 && read(fd, &h, sizeof(h)) == sizeof(h) && (int)h.frames == frames - 1){
+                queued = 0;
+            }
+            if (fd >= 0){
+                close(fd);
+            }
+        }
+        if (!queued){
+            break;
+        }
+        usleep(1000);
+    }
+    double secs = (now_us() - t0) / 1e6;
+    close(master);
+    int status;
+    waitpid(pid, &status, 0);
+
+    int ok = WIFEXITED(status) && WEXITSTATUS(status) == 0 && !queued;
+    framelogReader_t log;
+    if (framelogOpen(&log, out) != 0 || log.header->format != FRAMELOG_RGB888 || log.header->width != width
+        || log.header->height != height || !log.header->indexOffset){
+        fprintf(stderr, "bad frame log\n");
+        return 1;
+    }
+    const framelogHeader_t *h = log.header;
+    // every frame but the bad one, in order
+    int f, k = 0, wrong = 0;
+    uint64_t lastTime = 0;
+    for(f=0;f<frames && k<(int)log.frames;f++){
+        if (f == BAD_FRAME){
+            continue;
+        }
+        if (check_frame(&log, k, f) != 0 || framelogEntry(&log, (uint32_t)k)->timeUs < lastTime){
+            wrong++;
+        }
+        lastTime = framelogEntry(&log, (uint32_t)k)->timeUs;
+        k++;
+    }
+    ok = ok && wrong == 0 && (int)log.frames == frames - 1 && h->dropped == 1;
+
+    // the preview is the last frame that was a multiple of PREVIEW_EVERY
+    int previewOk = 0;
+    int last = (int)h->frames / PREVIEW_EVERY * PREVIEW_EVERY - 1;
+    FILE *pf = fopen(preview, "rb");
+    if (pf && last >= 0){
+        char magic[3] = {0};
+        int pw, ph, pmax;
+        if (fscanf(pf, "%2s %d %d %d", magic, &pw, &ph, &pmax) == 4 && fgetc(pf) == '\n'
+            && strcmp(magic, "P6") == 0 && pw == width && ph == height && pmax == 255){
+            uint8_t *px = malloc((size_t)width * height * 3);
+            const uint8_t *want = framelogPayload(&log, (uint32_t)last);
+            previewOk = fread(px, 3, (size_t)width * height, pf) == (size_t)width * height
+                && memcmp(px, want, (size_t)width * height * 3) == 0;
+            free(px);
+        }
+        fclose(pf);
+    }
+    ok = ok && previewOk;
+
+    double frameBytes = (double)len / frames;
+    double linkFps = USB_FS_BYTES_PER_S / frameBytes;
+    double fps = h->frames / secs;
+    printf("%dx%d: %u of %d frames recorded, %u dropped, %d wrong, preview %s\n", width, height, h->frames,
+        frames, h->dropped, wrong, previewOk ? "ok" : "WRONG");
+    printf("  %.0f bytes of text per frame, %.2f MB through the pty in %.3f s\n", frameBytes, len / 1e6, secs);
+    printf("  %.2f MB/s, %.1f frames/s; USB full speed tops out at %.2f MB/s, %.1f frames/s\n",
+        len / secs / 1e6, fps, USB_FS_BYTES_PER_S / 1e6, linkFps);
+    ok = ok && fps > linkFps;
+
+    framelogClose(&log);
+    unlink(out);
+    unlink(preview);
+    rmdir(dir);
+    free(stream);
+    printf("%s\n", ok ? "frame receiver test passed" : "frame receiver test FAILED");
+    return ok ? 0 : 1;
+}
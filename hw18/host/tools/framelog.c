@@ -0,0 +1,369 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "framelog.h"
+
+#define FRAMELOG_GROW_FRAMES 256 // first mapping, doubled when full
+#define FRAMELOG_RUN_MIN 3 // shorter runs go in a literal
+#define FRAMELOG_RUN_MAX 130
+#define FRAMELOG_LITERAL_MAX 128
+
+static size_t pad8(size_t n){
+    return (n + 7) & ~(size_t)7;
+}
+
+// === RLE ===
+// A control byte c < 128 is followed by c+1 literal pixels, c >= 128 by
+// one pixel repeated c-125 times. Pixels are bytesPerPixel wide.
+
+static int same(const uint8_t *a, const uint8_t *b, int bpp){
+    return memcmp(a, b, (size_t)bpp) == 0;
+}
+
+// returns the encoded size, or 0 if it would not fit in cap
+size_t framelogRleEncode(const uint8_t *src, size_t bytes, int bytesPerPixel, uint8_t *dst, size_t cap){
+    size_t n = bytes / (size_t)bytesPerPixel;
+    size_t i = 0, out = 0;
+    int bpp = bytesPerPixel;
+    while (i < n){
+        size_t run = 1;
+        while (i + run < n && run < FRAMELOG_RUN_MAX && same(src + (i + run) * bpp, src + i * bpp, bpp)){
+            run++;
+        }
+        if (run >= FRAMELOG_RUN_MIN){
+            if (out + 1 + bpp > cap){
+                return 0;
+            }
+            dst[out++] = (uint8_t)(run + 125);
+            memcpy(dst + out, src + i * bpp, (size_t)bpp);
+            out += bpp;
+            i += run;
+            continue;
+        }
+        // literal up to the next run worth encoding
+        size_t start = i, count = 0;
+        while (i < n && count < FRAMELOG_LITERAL_MAX){
+            if (i + 2 < n && same(src + i * bpp, src + (i + 1) * bpp, bpp) && same(src + i * bpp, src + (i + 2) * bpp, bpp)){
+                break;
+            }
+            i++;
+            count++;
+        }
+        if (out + 1 + count * bpp > cap){
+            return 0;
+        }
+        dst[out++] = (uint8_t)(count - 1);
+        memcpy(dst + out, src + start * bpp, count * bpp);
+        out += count * bpp;
+    }
+    return out;
+}
+
+// returns the decoded size, -1 if the payload is damaged
+int framelogRleDecode(const uint8_t *src, size_t bytes, int bytesPerPixel, uint8_t *dst, size_t cap){
+    size_t in = 0, out = 0;
+    int bpp = bytesPerPixel;
+    while (in < bytes){
+        uint8_t c = src[in++];
+        if (c < 128){
+            size_t len = (size_t)(c + 1) * bpp;
+            if (in + len > bytes || out + len > cap){
+                return -1;
+            }
+            memcpy(dst + out, src + in, len);
+            in += len;
+            out += len;
+        }
+        else {
+            size_t run = (size_t)c - 125;
+            if (in + bpp > bytes || out + run * bpp > cap){
+                return -1;
+            }
+            size_t k;
+            for(k=0;k<run;k++){
+                memcpy(dst + out, src + in, (size_t)bpp);
+                out += bpp;
+            }
+            in += bpp;
+        }
+    }
+    return (int)out;
+}
+
+// === Writing ===
+
+static int writer_map(framelogWriter_t *w, size_t bytes){
+    if (ftruncate(w->fd, (off_t)bytes) != 0){
+        perror("framelog: ftruncate");
+        return -1;
+    }
+    if (w->map){
+        munmap(w->map, w->mapBytes);
+    }
+    w->map = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, w->fd, 0);
+    if (w->map == MAP_FAILED){
+        perror("framelog: mmap");
+        w->map = NULL;
+        return -1;
+    }
+    w->mapBytes = bytes;
+    w->header = (framelogHeader_t *)w->map;
+    return 0;
+}
+
+// room for need more bytes after the end
+static int writer_reserve(framelogWriter_t *w, size_t need){
+    if (w->end + need <= w->mapBytes){
+        return 0;
+    }
+    size_t bytes = w->mapBytes * 2;
+    while (bytes < w->end + need){
+        bytes *= 2;
+    }
+    return writer_map(w, bytes);
+}
+
+int framelogCreate(framelogWriter_t *w, const char *path, int width, int height, int format){
+    memset(w, 0, sizeof(*w));
+    int bpp = format == FRAMELOG_RGB888 ? 3 : 2;
+    w->frameBytes = (uint32_t)(width * height * bpp);
+    w->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (w->fd < 0){
+        perror(path);
+        return -1;
+    }
+    w->scratch = malloc(w->frameBytes);
+    if (!w->scratch || writer_map(w, FRAMELOG_HEADER + FRAMELOG_GROW_FRAMES * pad8(FRAMELOG_ENTRY + w->frameBytes)) != 0){
+        free(w->scratch);
+        close(w->fd);
+        return -1;
+    }
+    framelogHeader_t *h = w->header;
+    memcpy(h->magic, FRAMELOG_MAGIC, sizeof(h->magic));
+    h->version = FRAMELOG_VERSION;
+    h->width = (uint16_t)width;
+    h->height = (uint16_t)height;
+    h->format = (uint8_t)format;
+    h->bytesPerPixel = (uint8_t)bpp;
+    w->end = FRAMELOG_HEADER;
+    return 0;
+}
+
+// where the next frame goes in the file, good until the commit
+uint8_t *framelogBegin(framelogWriter_t *w){
+    if (writer_reserve(w, pad8(FRAMELOG_ENTRY + w->frameBytes)) != 0){
+        return NULL;
+    }
+    return w->map + w->end + FRAMELOG_ENTRY;
+}
+
+int framelogCommit(framelogWriter_t *w, const framelogEntry_t *meta, int encoding){
+    if (w->indexCap == w->header->frames){
+        uint32_t cap = w->indexCap ? w->indexCap * 2 : FRAMELOG_GROW_FRAMES;
+        framelogEntry_t *index = realloc(w->index, cap * sizeof(framelogEntry_t));
+        if (!index){
+            return -1;
+        }
+        w->index = index;
+        w->indexCap = cap;
+    }
+    uint8_t *payload = w->map + w->end + FRAMELOG_ENTRY;
+    framelogEntry_t e = *meta;
+    e.offset = w->end + FRAMELOG_ENTRY;
+    e.bytes = w->frameBytes;
+    e.encoding = FRAMELOG_RAW;
+    e.reserved0 = 0;
+    e.tag = FRAMELOG_TAG;
+    e.reserved1 = 0;
+    if (encoding == FRAMELOG_RLE){
+        // the encoder gives up once it is no smaller than raw
+        size_t n = framelogRleEncode(payload, w->frameBytes, w->header->bytesPerPixel, w->scratch, w->frameBytes - 1);
+        if (n){
+            memcpy(payload, w->scratch, n);
+            e.bytes = (uint32_t)n;
+            e.encoding = FRAMELOG_RLE;
+        }
+    }
+    memcpy(w->map + w->end, &e, sizeof(e));
+    w->index[w->header->frames] = e;
+    w->end += pad8(FRAMELOG_ENTRY + e.bytes);
+    w->header->frames++; // last, a rebuild only trusts counted records
+    return 0;
+}
+
+int framelogAppend(framelogWriter_t *w, const uint8_t *pixels, const framelogEntry_t *meta, int encoding){
+    uint8_t *dst = framelogBegin(w);
+    if (!dst){
+        return -1;
+    }
+    memcpy(dst, pixels, w->frameBytes);
+    return framelogCommit(w, meta, encoding);
+}
+
+// writes the index, trims the file and closes it
+int framelogFinish(framelogWriter_t *w){
+    int ret = -1;
+    size_t indexBytes = (size_t)w->header->frames * FRAMELOG_ENTRY;
+    if (writer_reserve(w, indexBytes) == 0){
+        memcpy(w->map + w->end, w->index, indexBytes);
+        w->header->indexOffset = w->end;
+        w->end += indexBytes;
+        ret = 0;
+    }
+    munmap(w->map, w->mapBytes);
+    if (ftruncate(w->fd, (off_t)w->end) != 0){
+        ret = -1;
+    }
+    close(w->fd);
+    free(w->index);
+    free(w->scratch);
+    memset(w, 0, sizeof(*w));
+    return ret;
+}
+
+// === Reading ===
+
+// walk the records of a log that has no index
+static int reader_rebuild(framelogReader_t *r){
+    uint32_t want = r->header->frames;
+    r->rebuilt = malloc((want ? want : 1) * sizeof(framelogEntry_t));
+    if (!r->rebuilt){
+        return -1;
+    }
+    uint64_t pos = FRAMELOG_HEADER;
+    uint32_t n = 0;
+    while (n < want && pos + FRAMELOG_ENTRY <= r->bytes){
+        framelogEntry_t e;
+        memcpy(&e, r->map + pos, sizeof(e));
+        if (e.tag != FRAMELOG_TAG || e.offset != pos + FRAMELOG_ENTRY || e.offset + e.bytes > r->bytes){
+            break;
+        }
+        r->rebuilt[n++] = e;
+        pos += pad8(FRAMELOG_ENTRY + e.bytes);
+    }
+    r->index = r->rebuilt;
+    r->frames = n;
+    return 0;
+}
+
+int framelogOpen(framelogReader_t *r, const char *path){
+    memset(r, 0, sizeof(*r));
+    r->fd = open(path, O_RDONLY);
+    struct stat st;
+    if (r->fd < 0 || fstat(r->fd, &st) != 0){
+        perror(path);
+        return -1;
+    }
+    r->bytes = (size_t)st.st_size;
+    if (r->bytes < FRAMELOG_HEADER){
+        fprintf(stderr, "%s: not a frame log\n", path);
+        close(r->fd);
+        return -1;
+    }
+    r->map = mmap(NULL, r->bytes, PROT_READ, MAP_SHARED, r->fd, 0);
+    if (r->map == MAP_FAILED){
+        perror(path);
+        close(r->fd);
+        return -1;
+    }
+    r->header = (const framelogHeader_t *)r->map;
+    const framelogHeader_t *h = r->header;
+    if (memcmp(h->magic, FRAMELOG_MAGIC, sizeof(h->magic)) != 0 || h->version != FRAMELOG_VERSION){
+        fprintf(stderr, "%s: not a frame log\n", path);
+        framelogClose(r);
+        return -1;
+    }
+    r->frameBytes = (uint32_t)h->width * h->height * h->bytesPerPixel;
+    if (h->indexOffset && h->indexOffset + (uint64_t)h->frames * FRAMELOG_ENTRY <= r->bytes){
+        r->index = (const framelogEntry_t *)(r->map + h->indexOffset);
+        r->frames = h->frames;
+        return 0;
+    }
+    if (reader_rebuild(r) != 0){
+        framelogClose(r);
+        return -1;
+    }
+    return 0;
+}
+
+void framelogClose(framelogReader_t *r){
+    if (r->map && r->map != MAP_FAILED){
+        munmap((void *)r->map, r->bytes);
+    }
+    if (r->fd >= 0){
+        close(r->fd);
+    }
+    free(r->rebuilt);
+    memset(r, 0, sizeof(*r));
+    r->fd = -1;
+}
+
+const framelogEntry_t *framelogEntry(const framelogReader_t *r, uint32_t i){
+    return i < r->frames ? &r->index[i] : NULL;
+}
+
+// the payload as stored, raw pixels or RLE
+const uint8_t *framelogPayload(const framelogReader_t *r, uint32_t i){
+    return i < r->frames ? r->map + r->index[i].offset : NULL;
+}
+
+// frame i in the log's pixel format, 0 or -1
+int framelogRead(const framelogReader_t *r, uint32_t i, uint8_t *pixels){
+    const framelogEntry_t *e = framelogEntry(r, i);
+    if (!e){
+        return -1;
+    }
+    const uint8_t *src = r->map + e->offset;
+    if (e->encoding == FRAMELOG_RAW){
+        if (e->bytes != r->frameBytes){
+            return -1;
+        }
+        memcpy(pixels, src, r->frameBytes);
+        return 0;
+    }
+    if (framelogRleDecode(src, e->bytes, r->header->bytesPerPixel, pixels, r->frameBytes) != (int)r->frameBytes){
+        return -1;
+    }
+    return 0;
+}
+
+// frame i as the camera's RGB565 bytes, low byte first, for loadRawImage()
+int framelogReadCamera(const framelogReader_t *r, uint32_t i, uint8_t *raw){
+    if (r->header->format == FRAMELOG_RGB565){
+        return framelogRead(r, i, raw);
+    }
+    uint32_t pixels = (uint32_t)r->header->width * r->header->height;
+    uint8_t *rgb = malloc(r->frameBytes);
+    if (!rgb || framelogRead(r, i, rgb) != 0){
+        free(rgb);
+        return -1;
+    }
+    uint32_t k;
+    for(k=0;k<pixels;k++){
+        uint16_t px = ((rgb[k*3] >> 3) << 11) | ((rgb[k*3+1] >> 2) << 5) | (rgb[k*3+2] >> 3);
+        raw[k*2] = px & 0xFF;
+        raw[k*2+1] = px >> 8;
+    }
+    free(rgb);
+    return 0;
+}
+
+// the last frame at or before timeUs, -1 if there is none
+int framelogFind(const framelogReader_t *r, uint64_t timeUs){
+    int lo = 0, hi = (int)r->frames - 1, found = -1;
+    while (lo <= hi){
+        int mid = (lo + hi) / 2;
+        if (r->index[mid].timeUs <= timeUs){
+            found = mid;
+            lo = mid + 1;
+        }
+        else {
+            hi = mid - 1;
+        }
+    }
+    return found;
+}
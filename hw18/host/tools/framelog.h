@@ -0,0 +1,105 @@
+#ifndef FRAMELOG_h
+#define FRAMELOG_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Frame log: recorded camera runs with random access, for replay,
+// scrubbing and benchmarks. Frames are appended as they arrive, each
+// record an index entry followed by its payload, and finishing the log
+// writes all the entries again as one index at the end. A reader maps
+// the file and finds frame n in the index, so nothing is loaded into RAM.
+// A log that was never finished (the recorder crashed or was killed) is
+// still readable, the index is rebuilt from the records on open.
+//
+//   header (64) | entry (32) payload [pad to 8] | ... | index (32 per frame)
+
+#define FRAMELOG_MAGIC "HW18LOG1"
+#define FRAMELOG_VERSION 1
+#define FRAMELOG_HEADER 64
+#define FRAMELOG_ENTRY 32
+#define FRAMELOG_TAG 0xF17E // every record starts with this, for the rebuild
+
+// pixel formats
+#define FRAMELOG_RGB565 0 // the camera's bytes as in cameraData, loadRawImage() takes them
+#define FRAMELOG_RGB888 1 // r, g, b bytes as printImage() sends them
+
+// payload encodings
+#define FRAMELOG_RAW 0
+#define FRAMELOG_RLE 1 // runs of equal pixels, kept only if smaller than raw
+
+#define FRAMELOG_NO_VALUE -32768 // com or PWM that wasn't known
+
+typedef struct framelogHeader {
+    char magic[8];
+    uint16_t version;
+    uint16_t width, height;
+    uint8_t format; // FRAMELOG_RGB565 or FRAMELOG_RGB888
+    uint8_t bytesPerPixel;
+    uint32_t frames; // kept current while appending
+    uint32_t dropped; // frames the recorder saw but couldn't keep
+    uint64_t indexOffset; // 0 until the log is finished
+    uint8_t reserved[32];
+} framelogHeader_t;
+
+typedef struct framelogEntry {
+    uint64_t offset; // payload, from the start of the file
+    uint32_t bytes; // payload size
+    uint8_t encoding; // FRAMELOG_RAW or FRAMELOG_RLE
+    uint8_t reserved0;
+    uint16_t tag; // FRAMELOG_TAG
+    uint64_t timeUs; // since the recording started
+    int16_t com; // line position the car steered on
+    int16_t leftPwm, rightPwm;
+    uint16_t reserved1;
+} framelogEntry_t;
+
+_Static_assert(sizeof(framelogHeader_t) == FRAMELOG_HEADER, "frame log header size");
+_Static_assert(sizeof(framelogEntry_t) == FRAMELOG_ENTRY, "frame log entry size");
+
+typedef struct framelogWriter {
+    int fd;
+    uint8_t *map;
+    size_t mapBytes;
+    uint64_t end; // bytes written
+    framelogHeader_t *header;
+    framelogEntry_t *index; // every entry so far, written out at the end
+    uint32_t indexCap;
+    uint32_t frameBytes; // one raw frame
+    uint8_t *scratch; // RLE output
+} framelogWriter_t;
+
+typedef struct framelogReader {
+    int fd;
+    const uint8_t *map;
+    size_t bytes;
+    const framelogHeader_t *header;
+    const framelogEntry_t *index; // in the map, or rebuilt
+    framelogEntry_t *rebuilt; // the log wasn't finished
+    uint32_t frames;
+    uint32_t frameBytes;
+} framelogReader_t;
+
+// writing. Either framelogAppend() a frame from memory, or framelogBegin()
+// to get the frame's place in the file, fill it and framelogCommit(). The
+// entry gives the time, com and PWM, the rest of it is filled in here.
+int framelogCreate(framelogWriter_t *w, const char *path, int width, int height, int format);
+uint8_t *framelogBegin(framelogWriter_t *w);
+int framelogCommit(framelogWriter_t *w, const framelogEntry_t *meta, int encoding);
+int framelogAppend(framelogWriter_t *w, const uint8_t *pixels, const framelogEntry_t *meta, int encoding);
+int framelogFinish(framelogWriter_t *w);
+
+// reading
+int framelogOpen(framelogReader_t *r, const char *path);
+void framelogClose(framelogReader_t *r);
+const framelogEntry_t *framelogEntry(const framelogReader_t *r, uint32_t i);
+const uint8_t *framelogPayload(const framelogReader_t *r, uint32_t i);
+int framelogRead(const framelogReader_t *r, uint32_t i, uint8_t *pixels);
+int framelogReadCamera(const framelogReader_t *r, uint32_t i, uint8_t *raw);
+int framelogFind(const framelogReader_t *r, uint64_t timeUs);
+
+// the encoder and decoder on their own
+size_t framelogRleEncode(const uint8_t *src, size_t bytes, int bytesPerPixel, uint8_t *dst, size_t cap);
+int framelogRleDecode(const uint8_t *src, size_t bytes, int bytesPerPixel, uint8_t *dst, size_t cap);
+
+#endif
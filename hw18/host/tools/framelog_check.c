@@ -0,0 +1,244 @@
+// Checks the frame log library (framelog.c). Round trips the RLE coder,
+// writes logs in both pixel formats with raw and RLE frames through both
+// ways of appending, reads every frame and entry back through the index,
+// reads a log whose writer died before finishing it, and times random
+// seeks in a short and a long log to show they cost the same.
+//
+// usage: framelog_check [-n frames] [-d dir]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "framelog.h"
+
+#define WIDTH 80
+#define HEIGHT 60
+#define SEEKS 20000
+
+static uint32_t seed = 5;
+
+static uint32_t rnd(){
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 8;
+}
+
+static uint64_t now_ns(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// frame f: mostly flat floor with a line, which RLE shrinks, or every
+// fourth one noise, which it can't
+static void make_frame(uint8_t *px, int f, int bpp){
+    int x, y, k;
+    for(y=0;y<HEIGHT;y++){
+        for(x=0;x<WIDTH;x++){
+            uint8_t *p = px + (y * WIDTH + x) * bpp;
+            if (f % 4 == 3){
+                for(k=0;k<bpp;k++){
+                    uint32_t h = (uint32_t)(((f * HEIGHT + y) * WIDTH + x) * 3 + k) * 2654435761u;
+                    p[k] = (uint8_t)(h >> 24);
+                }
+                continue;
+            }
+            int line = abs(x - (20 + f % 40)) < 4;
+            for(k=0;k<bpp;k++){
+                p[k] = (uint8_t)(line ? 200 + k : 40 + k + f % 3);
+            }
+        }
+    }
+}
+
+static void make_meta(framelogEntry_t *e, int f){
+    memset(e, 0, sizeof(*e));
+    e->timeUs = (uint64_t)f * 33333 + (uint64_t)(f % 7);
+    e->com = (int16_t)(f % 5 == 0 ? FRAMELOG_NO_VALUE : 20 + f % 40);
+    e->leftPwm = (int16_t)(100 + f % 100);
+    e->rightPwm = (int16_t)(200 - f % 90);
+}
+
+static int check_rle(){
+    static uint8_t src[WIDTH * HEIGHT * 3], enc[WIDTH * HEIGHT * 4], dec[WIDTH * HEIGHT * 3];
+    int bpp, t, bad = 0;
+    for(bpp=2;bpp<=3;bpp++){
+        for(t=0;t<200;t++){
+            size_t n = (rnd() % (WIDTH * HEIGHT)) * bpp;
+            size_t i = 0;
+            // runs of every length next to literals
+            while (i < n){
+                size_t run = 1 + rnd() % (t % 2 ? 300 : 4);
+                uint8_t v = (uint8_t)rnd();
+                size_t k;
+                for(k=0;k<run*bpp && i<n;k++){
+                    src[i++] = (uint8_t)(v + k % bpp);
+                }
+            }
+            size_t e = framelogRleEncode(src, n, bpp, enc, sizeof(enc));
+            if ((n && !e) || framelogRleDecode(enc, e, bpp, dec, sizeof(dec)) != (int)n || memcmp(src, dec, n) != 0){
+                bad++;
+            }
+            // a damaged payload must not run over the buffer
+            if (e > 1 && framelogRleDecode(enc, e - 1, bpp, dec, n) == (int)n && memcmp(src, dec, n) == 0){
+                bad++;
+            }
+        }
+    }
+    printf("rle: %s\n", bad ? "WRONG" : "ok");
+    return bad;
+}
+
+static int write_log(const char *path, int frames, int format, int finish){
+    framelogWriter_t w;
+    int bpp = format == FRAMELOG_RGB888 ? 3 : 2;
+    uint8_t px[WIDTH * HEIGHT * 3];
+    if (framelogCreate(&w, path, WIDTH, HEIGHT, format) != 0){
+        return -1;
+    }
+    int f;
+    for(f=0;f<frames;f++){
+        framelogEntry_t e;
+        make_meta(&e, f);
+        int enc = f % 2 ? FRAMELOG_RLE : FRAMELOG_RAW;
+        if (f % 3 == 0){
+            make_frame(px, f, bpp);
+            if (framelogAppend(&w, px, &e, enc) != 0){
+                return -1;
+            }
+        }
+        else {
+            uint8_t *dst = framelogBegin(&w);
+            if (!dst){
+                return -1;
+            }
+            make_frame(dst, f, bpp);
+            if (framelogCommit(&w, &e, enc) != 0){
+                return -1;
+            }
+        }
+    }
+    if (finish){
+        return framelogFinish(&w);
+    }
+    _exit(0); // the process dies with the log mapped
+}
+
+// every frame and entry of a log written by write_log
+static int check_log(const char *path, int frames, int format, int finished, size_t *bytes){
+    framelogReader_t r;
+    int bpp = format == FRAMELOG_RGB888 ? 3 : 2;
+    uint8_t want[WIDTH * HEIGHT * 3], got[WIDTH * HEIGHT * 3];
+    if (framelogOpen(&r, path) != 0){
+        return 1;
+    }
+    int bad = (int)r.frames != frames || r.header->format != format || !r.header->indexOffset != !finished;
+    int f, rle = 0;
+    for(f=0;f<(int)r.frames && !bad;f++){
+        framelogEntry_t m;
+        make_meta(&m, f);
+        const framelogEntry_t *e = framelogEntry(&r, (uint32_t)f);
+        make_frame(want, f, bpp);
+        if (e->timeUs != m.timeUs || e->com != m.com || e->leftPwm != m.leftPwm || e->rightPwm != m.rightPwm
+            || framelogRead(&r, (uint32_t)f, got) != 0 || memcmp(want, got, r.frameBytes) != 0){
+            bad++;
+        }
+        // noise is stored raw even when RLE was asked for
+        if (e->encoding == FRAMELOG_RLE){
+            rle++;
+            if (f % 2 == 0 || f % 4 == 3){
+                bad++;
+            }
+        }
+        else if (f % 2 && f % 4 != 3){
+            bad++;
+        }
+    }
+    // scrubbing by time
+    for(f=0;f<(int)r.frames && !bad;f+=7){
+        if (framelogFind(&r, framelogEntry(&r, (uint32_t)f)->timeUs + 5) != f){
+            bad++;
+        }
+    }
+    if (r.frames && framelogFind(&r, 0) != 0){
+        bad++;
+    }
+    if (bytes){
+        *bytes = r.bytes;
+    }
+    printf("%s %s log: %u frames, %d RLE, %zu bytes (raw would be %zu), %s\n", format == FRAMELOG_RGB888 ? "rgb888" : "rgb565",
+        finished ? "finished" : "unfinished", r.frames, rle, r.bytes, (size_t)r.frames * r.frameBytes, bad ? "WRONG" : "ok");
+    framelogClose(&r);
+    return bad;
+}
+
+// mean ns for a random framelogRead
+static double seek_ns(const char *path){
+    framelogReader_t r;
+    uint8_t got[WIDTH * HEIGHT * 3];
+    if (framelogOpen(&r, path) != 0){
+        return 0;
+    }
+    int k;
+    // touch every page once so only the lookup is timed
+    for(k=0;k<(int)r.frames;k++){
+        framelogRead(&r, (uint32_t)k, got);
+    }
+    uint64_t t0 = now_ns();
+    for(k=0;k<SEEKS;k++){
+        framelogRead(&r, rnd() % r.frames, got);
+    }
+    double ns = (double)(now_ns() - t0) / SEEKS;
+    framelogClose(&r);
+    return ns;
+}
+
+int main(int argc, char **argv){
+    int frames = 2000;
+    const char *dir = "/tmp";
+    int i;
+    for (i = 1; i < argc - 1; i++){
+        if (strcmp(argv[i], "-n") == 0){
+            frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-d") == 0){
+            dir = argv[++i];
+        }
+    }
+    char path[512];
+    snprintf(path, sizeof(path), "%s/framelog_check_%d.log", dir, (int)getpid());
+    int bad = check_rle();
+
+    int format;
+    for(format=FRAMELOG_RGB565;format<=FRAMELOG_RGB888;format++){
+        if (write_log(path, frames, format, 1) != 0){
+            return 1;
+        }
+        bad += check_log(path, frames, format, 1, NULL);
+
+        pid_t pid = fork();
+        if (pid == 0){
+            write_log(path, 300, format, 0);
+        }
+        int status;
+        waitpid(pid, &status, 0);
+        bad += check_log(path, 300, format, 0, NULL);
+    }
+
+    // the same seek in a log 100 times longer
+    size_t shortBytes, longBytes;
+    write_log(path, frames / 100, FRAMELOG_RGB565, 1);
+    check_log(path, frames / 100, FRAMELOG_RGB565, 1, &shortBytes);
+    double shortNs = seek_ns(path);
+    write_log(path, frames, FRAMELOG_RGB565, 1);
+    check_log(path, frames, FRAMELOG_RGB565, 1, &longBytes);
+    double longNs = seek_ns(path);
+    printf("random frame read: %.0f ns in %d frames, %.0f ns in %d frames\n", shortNs, frames / 100, longNs, frames);
+    unlink(path);
+
+    // a long log misses the cache more, but must not scan
+    int ok = bad == 0 && longNs < shortNs * 4;
+    printf("%s\n", ok ? "frame log check passed" : "frame log check FAILED");
+    return ok ? 0 : 1;
+}
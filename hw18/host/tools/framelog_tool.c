@@ -0,0 +1,130 @@
+// Looks inside frame logs and makes them from raw frames.
+//
+// usage: framelog_tool info run.log
+//        framelog_tool ppm run.log frame out.ppm
+//        framelog_tool pack out.log width height [-z] file.raw ...
+// info lists the frames with their time, com and PWM. ppm writes one
+// frame out as an image. pack turns raw camera frames, like the corpus or
+// marker_bench -w, into an RGB565 log, RLE encoded with -z.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "framelog.h"
+
+static int info(const char *path){
+    framelogReader_t r;
+    if (framelogOpen(&r, path) != 0){
+        return 1;
+    }
+    const framelogHeader_t *h = r.header;
+    printf("%s: %ux%u %s, %u frames, %u dropped, %s\n", path, h->width, h->height,
+        h->format == FRAMELOG_RGB888 ? "rgb888" : "rgb565", r.frames, h->dropped,
+        h->indexOffset ? "indexed" : "unfinished, index rebuilt");
+    uint32_t i;
+    for(i=0;i<r.frames;i++){
+        const framelogEntry_t *e = framelogEntry(&r, i);
+        printf("%6u %10.3f s %s %6u bytes", i, e->timeUs / 1e6, e->encoding == FRAMELOG_RLE ? "rle" : "raw", e->bytes);
+        if (e->com != FRAMELOG_NO_VALUE){
+            printf("  com %d", e->com);
+        }
+        if (e->leftPwm != FRAMELOG_NO_VALUE){
+            printf("  pwm %d %d", e->leftPwm, e->rightPwm);
+        }
+        printf("\n");
+    }
+    framelogClose(&r);
+    return 0;
+}
+
+static int ppm(const char *path, uint32_t frame, const char *out){
+    framelogReader_t r;
+    if (framelogOpen(&r, path) != 0){
+        return 1;
+    }
+    uint32_t pixels = (uint32_t)r.header->width * r.header->height;
+    uint8_t *px = malloc(r.frameBytes);
+    uint8_t *rgb = malloc(pixels * 3);
+    int ret = 1;
+    if (px && rgb && framelogRead(&r, frame, px) == 0){
+        uint32_t k;
+        for(k=0;k<pixels;k++){
+            if (r.header->format == FRAMELOG_RGB888){
+                memcpy(rgb + k * 3, px + k * 3, 3);
+                continue;
+            }
+            // same expansion as convertImage()
+            rgb[k*3] = (px[k*2+1] >> 3) << 3;
+            rgb[k*3+1] = (((px[k*2+1] & 0b111) << 3) | px[k*2] >> 5) << 2;
+            rgb[k*3+2] = (px[k*2] & 0b11111) << 3;
+        }
+        FILE *f = fopen(out, "wb");
+        if (f){
+            fprintf(f, "P6\n%u %u\n255\n", r.header->width, r.header->height);
+            fwrite(rgb, 3, pixels, f);
+            fclose(f);
+            ret = 0;
+        }
+        else {
+            perror(out);
+        }
+    }
+    else {
+        fprintf(stderr, "%s: no frame %u\n", path, frame);
+    }
+    free(px);
+    free(rgb);
+    framelogClose(&r);
+    return ret;
+}
+
+static int pack(const char *out, int width, int height, int argc, char **argv){
+    framelogWriter_t w;
+    int encoding = FRAMELOG_RAW;
+    if (framelogCreate(&w, out, width, height, FRAMELOG_RGB565) != 0){
+        return 1;
+    }
+    int i;
+    for(i=0;i<argc;i++){
+        if (strcmp(argv[i], "-z") == 0){
+            encoding = FRAMELOG_RLE;
+            continue;
+        }
+        uint8_t *dst = framelogBegin(&w);
+        FILE *f = fopen(argv[i], "rb");
+        if (!dst || !f || fread(dst, 1, w.frameBytes, f) != w.frameBytes){
+            fprintf(stderr, "%s: not a %dx%d raw frame, skipped\n", argv[i], width, height);
+            if (f){
+                fclose(f);
+            }
+            continue;
+        }
+        fclose(f);
+        framelogEntry_t e = {0};
+        e.timeUs = w.header->frames; // no capture time, keep them in order
+        e.com = e.leftPwm = e.rightPwm = FRAMELOG_NO_VALUE;
+        framelogCommit(&w, &e, encoding);
+    }
+    uint32_t frames = w.header->frames;
+    if (framelogFinish(&w) != 0){
+        return 1;
+    }
+    printf("%u frames packed into %s\n", frames, out);
+    return 0;
+}
+
+int main(int argc, char **argv){
+    if (argc == 3 && strcmp(argv[1], "info") == 0){
+        return info(argv[2]);
+    }
+    if (argc == 5 && strcmp(argv[1], "ppm") == 0){
+        return ppm(argv[2], (uint32_t)atoi(argv[3]), argv[4]);
+    }
+    if (argc >= 5 && strcmp(argv[1], "pack") == 0){
+        return pack(argv[2], atoi(argv[3]), atoi(argv[4]), argc - 5, argv + 5);
+    }
+    fprintf(stderr, "usage: framelog_tool info run.log\n"
+        "       framelog_tool ppm run.log frame out.ppm\n"
+        "       framelog_tool pack out.log width height [-z] file.raw ...\n");
+    return 2;
+}
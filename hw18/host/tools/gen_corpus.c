@@ -0,0 +1,141 @@
+// Renders the synthetic frame corpus used by the vision benchmark.
+// Frames are written exactly as the capture ISR stores them in cameraData
+// (RGB565, low byte first) so they can be replayed through cam.c unchanged.
+//
+// usage: gen_corpus <output dir>
+// writes <scene>_<w>x<h>.raw for every scene and size, plus labels.txt with
+// the true line centre at a few rows of each frame.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+#define NUM_LABEL_ROWS 3
+
+typedef struct scene {
+    const char *name;
+    int floor;       // floor brightness 0-255
+    int line;        // line brightness 0-255
+    int noise;       // +- texture amplitude
+    float width;     // line width as a fraction of the frame width
+    int glare;       // peak added brightness of the glare spot, 0 for none
+    int crossing;    // draw a horizontal bar through the middle rows
+    int curved;      // line bends off to the right towards the top
+} scene_t;
+
+static const scene_t scenes[] = {
+    {"straight", 60, 220, 10, 0.08f, 0, 0, 0},
+    {"curved", 60, 220, 10, 0.08f, 0, 0, 1},
+    {"crossing", 60, 220, 10, 0.08f, 0, 1, 0},
+    {"lowlight", 18, 48, 8, 0.08f, 0, 0, 0},
+    {"glare", 50, 200, 10, 0.08f, 200, 0, 0},
+};
+#define NUM_SCENES (sizeof(scenes) / sizeof(scenes[0]))
+
+static const int sizes[][2] = {{80, 60}, {160, 120}};
+#define NUM_SIZES (sizeof(sizes) / sizeof(sizes[0]))
+
+static uint32_t seed = 1;
+
+// small LCG so the corpus is identical on every machine
+static int noise(int amplitude){
+    seed = seed * 1664525u + 1013904223u;
+    if (amplitude == 0){
+        return 0;
+    }
+    return (int)((seed >> 16) % (2 * amplitude + 1)) - amplitude;
+}
+
+// true line centre in pixels for row y
+static float line_center(const scene_t *s, int y, int w, int h){
+    float v = (float)y / h;
+    if (s->curved){
+        return w * (0.35f + 0.45f * (1.0f - v) * (1.0f - v));
+    }
+    if (s->crossing){
+        return w * 0.45f;
+    }
+    return w * (0.52f + 0.08f * (v - 0.5f));
+}
+
+static uint8_t clamp8(int v){
+    if (v < 0) return 0;
+    if (v > 255) return 255;
+    return (uint8_t)v;
+}
+
+static void render(const scene_t *s, int w, int h, uint8_t *raw){
+    int x, y;
+    for (y = 0; y < h; y++){
+        float cx = line_center(s, y, w, h);
+        float half = s->width * w / 2;
+        int bar = s->crossing && y >= h * 45 / 100 && y < h * 55 / 100;
+        for (x = 0; x < w; x++){
+            int v = s->floor;
+            if (fabsf(x + 0.5f - cx) < half || bar){
+                v = s->line;
+            }
+            if (s->glare){
+                float dx = (x - 0.15f * w) / (0.3f * w);
+                float dy = (y - 0.5f * h) / (0.3f * w);
+                float d = dx * dx + dy * dy;
+                if (d < 1.0f){
+                    v += (int)(s->glare * (1.0f - d));
+                }
+            }
+            v += noise(s->noise);
+            // slightly warm floor, like the lab carpet
+            uint8_t r = clamp8(v + 6);
+            uint8_t g = clamp8(v);
+            uint8_t b = clamp8(v - 6);
+            int i = (y * w + x) * 2;
+            raw[i] = (uint8_t)((((g >> 2) & 0x7) << 5) | (b >> 3));
+            raw[i + 1] = (uint8_t)((r & 0xF8) | (g >> 5));
+        }
+    }
+}
+
+int main(int argc, char **argv){
+    if (argc < 2){
+        fprintf(stderr, "usage: %s <output dir>\n", argv[0]);
+        return 1;
+    }
+    char path[512];
+    snprintf(path, sizeof(path), "%s/labels.txt", argv[1]);
+    FILE *labels = fopen(path, "w");
+    if (!labels){
+        perror(path);
+        return 1;
+    }
+    fprintf(labels, "# file width height row center\n");
+
+    unsigned int i, j, k;
+    for (j = 0; j < NUM_SIZES; j++){
+        int w = sizes[j][0];
+        int h = sizes[j][1];
+        uint8_t *raw = malloc((size_t)w * h * 2);
+        for (i = 0; i < NUM_SCENES; i++){
+            const scene_t *s = &scenes[i];
+            seed = 1 + i;
+            render(s, w, h, raw);
+
+            snprintf(path, sizeof(path), "%s/%s_%dx%d.raw", argv[1], s->name, w, h);
+            FILE *f = fopen(path, "wb");
+            if (!f){
+                perror(path);
+                return 1;
+            }
+            fwrite(raw, 1, (size_t)w * h * 2, f);
+            fclose(f);
+
+            for (k = 1; k <= NUM_LABEL_ROWS; k++){
+                int row = h * k / (NUM_LABEL_ROWS + 1);
+                fprintf(labels, "%s_%dx%d.raw %d %d %d %.1f\n", s->name, w, h, w, h, row, line_center(s, row, w, h));
+            }
+        }
+        free(raw);
+    }
+    fclose(labels);
+    return 0;
+}
@@ -0,0 +1,73 @@
+// Checks the Hough line finder against synthetic frames.
+// Renders a bright line at a sweep of known angles and offsets, replays it
+// through cam.c and hough.c and prints what was found next to the truth.
+// Exits non-zero if any frame is off by more than one angle bin or 2 px.
+//
+// usage: hough_sweep [-v]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "cam.h"
+#include "hough.h"
+
+#define LINE_WIDTH 6.0f
+#define ANGLE_TOL 5.7f // one HOUGH_ANGLES bin, degrees
+#define OFFSET_TOL 2.0f
+
+static uint8_t raw[IMAGESIZEX*IMAGESIZEY*2];
+
+// angle in degrees, positive leans right further up the image
+static void render_line(float angle, float offset){
+    float t = tanf(angle * (float)M_PI / 180.0f);
+    float half = LINE_WIDTH / 2 / cosf(angle * (float)M_PI / 180.0f);
+    uint32_t seed = 7;
+    int x, y;
+    for (y = 0; y < IMAGESIZEY; y++){
+        float cx = IMAGESIZEX / 2.0f + offset - (y + 0.5f - IMAGESIZEY / 2.0f) * t;
+        for (x = 0; x < IMAGESIZEX; x++){
+            seed = seed * 1664525u + 1013904223u;
+            int v = (fabsf(x + 0.5f - cx) < half) ? 220 : 60;
+            v += (int)((seed >> 16) % 17) - 8;
+            uint8_t g = (uint8_t)v;
+            int i = (y * IMAGESIZEX + x) * 2;
+            raw[i] = (uint8_t)((((g >> 2) & 0x7) << 5) | (g >> 3));
+            raw[i + 1] = (uint8_t)((g & 0xF8) | (g >> 5));
+        }
+    }
+}
+
+int main(int argc, char **argv){
+    int verbose = argc > 1 && strcmp(argv[1], "-v") == 0;
+    int a, o;
+    int cases = 0, failures = 0;
+    float maxAngleErr = 0, maxOffsetErr = 0;
+
+    for (a = -45; a <= 45; a += 5){
+        for (o = -20; o <= 20; o += 5){
+            render_line((float)a, (float)o);
+            loadRawImage(raw);
+            houghLine_t line;
+            int found = houghFindLine(&line) == 0;
+            float angleErr = found ? fabsf(line.angle / 10.0f - a) : 90.0f;
+            float offsetErr = found ? fabsf(line.offset - (float)o) : (float)IMAGESIZEX;
+            int bad = angleErr > ANGLE_TOL || offsetErr > OFFSET_TOL;
+            cases++;
+            failures += bad;
+            if (angleErr > maxAngleErr) maxAngleErr = angleErr;
+            if (offsetErr > maxOffsetErr) maxOffsetErr = offsetErr;
+            if (verbose || bad){
+                printf("angle %4d offset %4d -> %s angle %6.1f offset %4d votes %3d%s\n",
+                    a, o, found ? "found" : "none ", found ? line.angle / 10.0f : 0.0f,
+                    found ? line.offset : 0, found ? line.votes : 0, bad ? "  FAIL" : "");
+            }
+        }
+    }
+
+    printf("%d frames, %d outside tolerance, max angle error %.1f deg, max offset error %.1f px\n",
+        cases, failures, maxAngleErr, maxOffsetErr);
+    printf("accumulator %d bytes, %d votes per point\n",
+        HOUGH_ANGLES * HOUGH_RHO_BINS, HOUGH_ANGLES);
+    return failures ? 1 : 0;
+}
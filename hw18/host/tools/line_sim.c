@@ -0,0 +1,446 @@
+// Closed loop simulator for the line follower. The firmware's own main()
+// (hw18.c, built with main renamed hw18_main) runs unchanged on the stub
+// SDK: the simulated OV7670 sends it frames rendered from a track image
+// through the camera's geometry (sim_track.h), and the PWM the motor
+// driver leaves in the registers runs the simulated motors and encoders
+// (sim_encoder.h), whose wheels move the car. The car is held over blank
+// floor until the motors are set up, for the flat field calibration.
+//
+// Simulated time only moves in sleeps, waits and frames, so a lap takes
+// a fraction of a second. The firmware's processing takes no simulated
+// time; on the car it adds to the latency measured here.
+//
+// Reported, and as JSON with -o so runs can be compared across commits:
+// - lap times, the first from a standing start;
+// - the distance from the line at the axle, rms and worst;
+// - the control latency, from a frame's exposure to the first steering
+//   tick that drives on it, and how often estimates come.
+//
+// usage: line_sim [-t oval|bends|<track script>] [-n laps] [-s seconds]
+//                 [-k keys] [-b battery] [-l console.log] [-c trace.csv]
+//                 [-o out.json] [-w track.pgm] [-p params.bin] [-r run.log]
+//                 [-e laps]
+// -p puts a parameter record (params.h, from tools/tune.c) in flash for
+// the firmware to boot with. -r records every frame with the duty the
+// motors had, as frame_recv does on the car, for the replay tools. -k
+// types keys into the firmware's console at the start, e.g. -k e for
+// the edge detector or -k g to steer by pure pursuit. -l keeps the
+// firmware's console, -c logs the car every 10 ms and -w writes the
+// track image. The oval driven as a motion script, -n 1 -k ":S 1000;A
+// 350 180;S 1000;A 350 180;S 300", checks the car and the track against
+// each other: it stays within the wheel loops' few % of the line without
+// looking at it. -e makes it a check, it exits 1 unless that many laps
+// were driven without losing the line: with no -p, that the gains and
+// speeds a car boots with and no record follow the line.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "pico/stdlib.h"
+#include "hardware/pwm.h"
+#include "hardware/clocks.h"
+#include "hardware/flash.h"
+#include "cam.h"
+#include "steer.h"
+#include "encoder.h"
+#include "sim_sensor.h"
+#include "sim_encoder.h"
+#include "sim_track.h"
+#include "params.h"
+#include "framelog.h"
+
+// hw18.c's motor pins
+#define A_PHASE 16
+#define A_ENABLE 17
+#define B_PHASE 18
+#define B_ENABLE 19
+
+#define STEP_US 500 // the car moves on this often
+#define TRACE_US 10000
+#define MM_PER_COUNT 0.1 // what pose.c and the wheel loops assume
+#define TRACK_MM 120.0
+#define LOST_MM 150 // further off than the camera sees either side
+#define START_LIMIT_US 20000000 // no move by then, it never will
+#define FRAMES_KEPT 8
+#define LAPS_MAX 32
+
+int hw18_main();
+
+static simTrack_t track;
+static uint8_t frame[IMAGESIZEX * IMAGESIZEY * 2];
+static double carX, carY, carHeading; // the axle's middle, mm and radians
+static double wheelPos[ENCODER_WHEELS]; // counts, where the car last moved from
+static float battery = 1;
+static repeating_timer_t physicsTimer;
+static double wrapDebt[2]; // PWM periods not yet fired
+
+// the run
+static const char *keys = "";
+static int lapsWanted = 3;
+static uint64_t limitUs = 60000000;
+static int started, lost;
+static uint64_t startUs, lapStartUs, endUs;
+static int hint = -1;
+static float lastAlong;
+static double travelled; // mm round the centreline
+static int laps;
+static uint32_t lapMs[LAPS_MAX];
+static double errSq, errMax;
+static uint32_t errCount;
+static FILE *trace;
+static uint64_t traceUs;
+static framelogWriter_t recorder;
+static int recording;
+
+// latency, from the frames' exposures
+static uint64_t exposedAt[FRAMES_KEPT];
+static uint32_t framesSent, seenSeq, estimates;
+static double latencySum, captureSum;
+static uint64_t latencyMax;
+
+static bool motors_ready(){
+    return (pwm_hw->en & (1u << pwm_gpio_to_slice_num(A_ENABLE))) != 0;
+}
+
+static float duty(uint phase, uint enable);
+
+// the camera's view, just before the sensor sends the frame
+static void on_frame(){
+    sim_track_render(&track, (float)carX, (float)carY, (float)carHeading, !motors_ready(), frame);
+    exposedAt[framesSent++ % FRAMES_KEPT] = time_us_64();
+    if (recording){
+        framelogEntry_t meta = {0};
+        meta.timeUs = time_us_64();
+        meta.com = FRAMELOG_NO_VALUE;
+        // the car sends PWM out of 255
+        meta.leftPwm = (int16_t)lroundf(duty(A_PHASE, A_ENABLE) * 255);
+        meta.rightPwm = (int16_t)lroundf(duty(B_PHASE, B_ENABLE) * 255);
+        framelogAppend(&recorder, frame, &meta, FRAMELOG_RLE);
+    }
+}
+
+// the first motorSet() after a new estimate is the tick that steers on it
+void __real_motorSet(int left, int right);
+void __wrap_motorSet(int left, int right){
+    steerEstimate_t est;
+    uint32_t seq = (uint32_t)steerLatest(&est);
+    if (seq != 0 && seq != seenSeq){
+        seenSeq = seq;
+        // the newest frame in by the time it was captured
+        uint64_t now = time_us_64(), exposed = 0;
+        uint32_t i;
+        for (i = 0; i < FRAMES_KEPT && i < framesSent; i++){
+            uint64_t t = exposedAt[(framesSent - 1 - i) % FRAMES_KEPT];
+            if (t < est.timeUs && t > exposed){
+                exposed = t;
+            }
+        }
+        if (started && exposed){
+            uint64_t latency = now - exposed;
+            latencySum += latency;
+            captureSum += now - est.timeUs;
+            if (latency > latencyMax){
+                latencyMax = latency;
+            }
+            estimates++;
+        }
+    }
+    __real_motorSet(left, right);
+}
+
+static float duty(uint phase, uint enable){
+    uint slice = pwm_gpio_to_slice_num(enable);
+    float d = (float)hal_pwm_get_level(enable) / (hal_pwm_get_wrap(slice) + 1);
+    return gpio_get(phase) ? -d : d;
+}
+
+// the wrap interrupt ramps the motors a period at a time, fire it as
+// often as the slices wrapped in a step
+static void wrap_pwm(){
+    static const uint enables[2] = {A_ENABLE, B_ENABLE};
+    int i;
+    for (i = 0; i < 2; i++){
+        uint slice = pwm_gpio_to_slice_num(enables[i]);
+        if (!(hal_pwm_irq_enabled_mask() & (1u << slice))){
+            wrapDebt[i] = 0;
+            continue;
+        }
+        double hz = clock_get_hz(clk_sys) / (hal_pwm_get_clkdiv(slice) * (hal_pwm_get_wrap(slice) + 1.0));
+        wrapDebt[i] += hz * STEP_US / 1e6;
+        while (wrapDebt[i] >= 1){
+            hal_pwm_wrap(1u << slice);
+            wrapDebt[i] -= 1;
+        }
+    }
+}
+
+static void score(){
+    uint64_t now = time_us_64();
+    if (!started){
+        if (simEncoder.wheel[ENCODER_LEFT].duty == 0 && simEncoder.wheel[ENCODER_RIGHT].duty == 0){
+            return;
+        }
+        started = 1;
+        startUs = lapStartUs = now;
+        travelled = 0;
+    }
+    float offset;
+    float along = sim_track_locate(&track, (float)carX, (float)carY, &hint, &offset);
+    float step = along - lastAlong;
+    if (step > track.points / 2){
+        step -= track.points;
+    } else if (step < -track.points / 2){
+        step += track.points;
+    }
+    travelled += step;
+    lastAlong = along;
+    if (travelled >= (double)(laps + 1) * track.points && laps < LAPS_MAX){
+        lapMs[laps++] = (uint32_t)((now - lapStartUs) / 1000);
+        lapStartUs = now;
+    }
+    errSq += (double)offset * offset;
+    errCount++;
+    if (fabsf(offset) > errMax){
+        errMax = fabsf(offset);
+    }
+    if (fabsf(offset) > LOST_MM){
+        lost = 1;
+    }
+    if (trace && now >= traceUs){
+        fprintf(trace, "%.1f,%.1f,%.1f,%.2f,%.0f,%.1f,%.3f,%.3f\n", (now - startUs) / 1000.0, carX, carY,
+            carHeading * 180 / M_PI, travelled, offset, simEncoder.wheel[ENCODER_LEFT].duty,
+            simEncoder.wheel[ENCODER_RIGHT].duty);
+        traceUs = now + TRACE_US;
+    }
+}
+
+static bool physics(repeating_timer_t *rt){
+    (void)rt;
+    // the wheels up to now on the duty they had, then the car with them
+    sim_encoder_advance();
+    simEncoder.battery = battery; // encoderInit() resets it
+    double l = (simEncoder.wheel[ENCODER_LEFT].position - wheelPos[ENCODER_LEFT]) * MM_PER_COUNT;
+    double r = (simEncoder.wheel[ENCODER_RIGHT].position - wheelPos[ENCODER_RIGHT]) * MM_PER_COUNT;
+    wheelPos[ENCODER_LEFT] = simEncoder.wheel[ENCODER_LEFT].position;
+    wheelPos[ENCODER_RIGHT] = simEncoder.wheel[ENCODER_RIGHT].position;
+    double turn = (r - l) / TRACK_MM;
+    carX += (l + r) / 2 * cos(carHeading + turn / 2);
+    carY += (l + r) / 2 * sin(carHeading + turn / 2);
+    carHeading += turn;
+
+    // the duty the motor driver has set from here on
+    if (motors_ready()){
+        wrap_pwm();
+        simEncoder.wheel[ENCODER_LEFT].duty = duty(A_PHASE, A_ENABLE);
+        simEncoder.wheel[ENCODER_RIGHT].duty = duty(B_PHASE, B_ENABLE);
+    }
+    score();
+    return true;
+}
+
+// the firmware's console keys, then 'q' when the run is over
+static int next_key(){
+    uint64_t now = time_us_64();
+    if (*keys){
+        return *keys++;
+    }
+    if (started ? (lost || laps >= lapsWanted || now - startUs >= limitUs) : now >= START_LIMIT_US){
+        if (!endUs){
+            endUs = now;
+        }
+        return 'q';
+    }
+    return PICO_ERROR_TIMEOUT;
+}
+
+// a parameter record where the firmware looks for it
+static int load_params(const char *path){
+    static uint8_t page[FLASH_PAGE_SIZE];
+    FILE *f = fopen(path, "rb");
+    if (!f){
+        perror(path);
+        return -1;
+    }
+    memset(page, 0xFF, sizeof(page));
+    size_t n = fread(page, 1, sizeof(page), f);
+    fclose(f);
+    if (n != sizeof(params_t)){
+        fprintf(stderr, "%s: %lu bytes, a parameter record is %lu\n", path, (unsigned long)n,
+            (unsigned long)sizeof(params_t));
+        return -1;
+    }
+    flash_range_erase(PARAMS_FLASH_OFFSET, PARAMS_FLASH_BYTES);
+    flash_range_program(PARAMS_FLASH_OFFSET, page, sizeof(page));
+    return 0;
+}
+
+static double wall_s(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static const char *result(){
+    if (!started){
+        return "never started";
+    }
+    if (lost){
+        return "lost the line";
+    }
+    return laps >= lapsWanted ? "laps done" : "time limit";
+}
+
+static void report(FILE *out, const char *name, double simS, double wallS){
+    int i;
+    double rms = errCount ? sqrt(errSq / errCount) : 0;
+    fprintf(out, "{\n  \"track\": \"%s\",\n  \"track_mm\": %d,\n  \"result\": \"%s\",\n  \"laps\": %d,\n  \"lap_ms\": [",
+        name, track.points, result(), laps);
+    for (i = 0; i < laps; i++){
+        fprintf(out, "%s%lu", i ? ", " : "", (unsigned long)lapMs[i]);
+    }
+    fprintf(out, "],\n  \"distance_mm\": %.0f,\n  \"line_rms_mm\": %.2f,\n  \"line_max_mm\": %.2f,\n", travelled, rms,
+        errMax);
+    fprintf(out, "  \"latency_mean_ms\": %.2f,\n  \"latency_max_ms\": %.2f,\n  \"capture_to_steer_ms\": %.2f,\n",
+        estimates ? latencySum / estimates / 1000 : 0, latencyMax / 1000.0, estimates ? captureSum / estimates / 1000 : 0);
+    fprintf(out, "  \"estimates_per_s\": %.2f,\n  \"sim_s\": %.3f,\n  \"wall_s\": %.3f,\n  \"speedup\": %.1f\n}\n",
+        endUs > startUs && started ? estimates / ((endUs - startUs) / 1e6) : 0, simS, wallS, wallS > 0 ? simS / wallS : 0);
+}
+
+int main(int argc, char **argv){
+    const char *name = "oval", *script = TRACK_OVAL;
+    const char *consolePath = "/dev/null", *tracePath = NULL, *outPath = NULL, *imagePath = NULL, *paramsPath = NULL;
+    const char *logPath = NULL;
+    int i, lapsNeeded = 0;
+    for (i = 1; i < argc - 1; i++){
+        if (strcmp(argv[i], "-t") == 0){
+            name = argv[++i];
+            script = strcmp(name, "oval") == 0 ? TRACK_OVAL : (strcmp(name, "bends") == 0 ? TRACK_BENDS : name);
+        } else if (strcmp(argv[i], "-n") == 0){
+            lapsWanted = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0){
+            limitUs = (uint64_t)(atof(argv[++i]) * 1e6);
+        } else if (strcmp(argv[i], "-k") == 0){
+            keys = argv[++i];
+        } else if (strcmp(argv[i], "-b") == 0){
+            battery = (float)atof(argv[++i]);
+        } else if (strcmp(argv[i], "-l") == 0){
+            consolePath = argv[++i];
+        } else if (strcmp(argv[i], "-c") == 0){
+            tracePath = argv[++i];
+        } else if (strcmp(argv[i], "-o") == 0){
+            outPath = argv[++i];
+        } else if (strcmp(argv[i], "-w") == 0){
+            imagePath = argv[++i];
+        } else if (strcmp(argv[i], "-p") == 0){
+            paramsPath = argv[++i];
+        } else if (strcmp(argv[i], "-r") == 0){
+            logPath = argv[++i];
+        } else if (strcmp(argv[i], "-e") == 0){
+            lapsNeeded = atoi(argv[++i]);
+        }
+    }
+    if (lapsWanted > LAPS_MAX){
+        lapsWanted = LAPS_MAX;
+    }
+
+    sim_track_default(&track);
+    if (sim_track_make(&track, script) != 0){
+        fprintf(stderr, "bad track: %s\n", script);
+        return 1;
+    }
+    if (track.closure > 5){
+        fprintf(stderr, "track doesn't close, the end is %.0f mm off the start\n", track.closure);
+    }
+    if (imagePath && sim_track_write_pgm(&track, imagePath) != 0){
+        perror(imagePath);
+        return 1;
+    }
+    if (paramsPath && load_params(paramsPath) != 0){
+        return 1;
+    }
+    if (logPath){
+        if (framelogCreate(&recorder, logPath, IMAGESIZEX, IMAGESIZEY, FRAMELOG_RGB565) != 0){
+            perror(logPath);
+            return 1;
+        }
+        recording = 1;
+    }
+    if (tracePath){
+        trace = fopen(tracePath, "w");
+        if (!trace){
+            perror(tracePath);
+            return 1;
+        }
+        fprintf(trace, "ms,x_mm,y_mm,heading_deg,travelled_mm,offset_mm,left_duty,right_duty\n");
+    }
+    simCamera_t cam;
+    sim_camera_default(&cam);
+    sim_camera_setup(&cam);
+
+    sim_encoder_reset();
+    simSensor.frame = frame;
+    simSensor.onFrame = on_frame;
+    sim_sensor_install();
+    hal_set_input(next_key);
+    add_repeating_timer_us(-STEP_US, physics, NULL, &physicsTimer);
+
+    // the firmware's console goes to its own file
+    fflush(stdout);
+    int saved = dup(1);
+    int console = open(consolePath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (console < 0){
+        perror(consolePath);
+        return 1;
+    }
+    dup2(console, 1);
+    double wall = wall_s();
+    hw18_main();
+    wall = wall_s() - wall;
+    fflush(stdout);
+    dup2(saved, 1);
+    close(console);
+    if (trace){
+        fclose(trace);
+    }
+    if (recording){
+        framelogFinish(&recorder);
+    }
+    if (!endUs){
+        endUs = time_us_64();
+    }
+
+    double simS = time_us_64() / 1e6;
+    printf("track %s, %d mm: %s after %.1f s\n", name, track.points, result(),
+        started ? (endUs - startUs) / 1e6 : 0);
+    for (i = 0; i < laps; i++){
+        printf("lap %d: %lu ms%s\n", i + 1, (unsigned long)lapMs[i], i == 0 ? " from a standing start" : "");
+    }
+    printf("off the line at the axle: rms %.1f mm, worst %.1f mm\n", errCount ? sqrt(errSq / errCount) : 0, errMax);
+    printf("latency, exposure to steering: mean %.1f ms, worst %.1f ms, %.1f ms of it after the capture\n",
+        estimates ? latencySum / estimates / 1000 : 0, latencyMax / 1000.0, estimates ? captureSum / estimates / 1000 : 0);
+    printf("estimates: %.1f a second\n", started && endUs > startUs ? estimates / ((endUs - startUs) / 1e6) : 0);
+    printf("simulated %.1f s in %.2f s, %.0fx real time\n", simS, wall, wall > 0 ? simS / wall : 0);
+
+    if (outPath){
+        FILE *out = strcmp(outPath, "-") == 0 ? stdout : fopen(outPath, "w");
+        if (!out){
+            perror(outPath);
+            return 1;
+        }
+        report(out, name, simS, wall);
+        if (out != stdout){
+            fclose(out);
+        }
+    }
+    sim_track_free(&track);
+    if (lapsNeeded > 0){
+        int ok = !lost && laps >= lapsNeeded;
+        printf("%d of %d laps%s, %s\n", laps, lapsNeeded, lost ? ", then lost the line" : "", ok ? "ok" : "WRONG");
+        return !ok;
+    }
+    return 0;
+}
@@ -0,0 +1,246 @@
+// Benchmarks the fiducial marker detector (marker.c) on rendered markers.
+// Each frame has the line on a textured floor and one marker beside it,
+// with a random id, turn, cell size, foreshortening, keystone, lighting
+// and position, supersampled so cell edges blur like a real lens. Frames
+// without a marker, including the corpus, check for false detections.
+// Reports the detection rate by cell size, wrong ids and ns per frame.
+// Exits non-zero on any wrong id or false detection, or if fewer than 90%
+// of the markers with cells of 2.5 pixels or more are found.
+//
+// usage: marker_bench_WxH [-n frames] [-w dir]
+// -w also writes every frame as <dir>/marker_<n>_<w>x<h>.raw plus
+// markers.txt with what is in each, to replay on other code
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "cam.h"
+#include "marker.h"
+
+#define FRAME_BYTES (IMAGESIZEX*IMAGESIZEY*2)
+#define SCALE (IMAGESIZEX / 80.0) // cell sizes are given at 80x60
+#define NUM_BUCKETS 4
+#define SUPERSAMPLE 4
+
+static const char *corpus[] = {"straight", "curved", "crossing", "lowlight", "glare"};
+static const double bucketCell[NUM_BUCKETS + 1] = {2.0, 2.5, 3.0, 3.5, 4.5};
+
+typedef struct scene {
+    int id, rotation;
+    double cell; // cell width of the top edge in pixels
+    double aspect; // height over width, the floor is seen at an angle
+    double keystone; // bottom edge is this much wider
+    double x, y; // top left corner of the black square
+    double light; // paper brightness scale
+    double lineX; // line centre
+} scene_t;
+
+static uint8_t frame[FRAME_BYTES];
+static uint32_t seed = 3;
+
+static double rnd(){
+    seed = seed * 1664525u + 1013904223u;
+    return (seed >> 8) / 16777216.0;
+}
+
+static uint64_t now_ns(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// brightness at a point, -1 outside the marker and its quiet zone
+static double marker_value(const scene_t *s, uint16_t code, double px, double py){
+    double w = s->cell * 6, h = w * s->aspect;
+    double v = (py - s->y) / h; // 0 at the top edge, 1 at the bottom
+    double width = w * (1 + s->keystone * v);
+    double left = s->x - w * s->keystone * v / 2;
+    double u = (px - left) / width;
+    int ci = (int)floor(v * 6), cj = (int)floor(u * 6);
+    if (ci < -1 || ci > 6 || cj < -1 || cj > 6){
+        return -1;
+    }
+    double white = 235 * s->light, black = 25 * s->light;
+    if (ci == -1 || ci == 6 || cj == -1 || cj == 6){
+        return white;
+    }
+    if (ci == 0 || ci == 5 || cj == 0 || cj == 5){
+        return black;
+    }
+    return (code >> ((ci - 1) * 4 + (cj - 1))) & 1 ? white : black;
+}
+
+static void render(const scene_t *s, int withMarker){
+    int x, y, k, r;
+    uint16_t code = markerCode(s->id);
+    for (r = 0; r < s->rotation; r++){
+        code = markerRotate(code);
+    }
+    for (y = 0; y < IMAGESIZEY; y++){
+        for (x = 0; x < IMAGESIZEX; x++){
+            double sum = 0;
+            for (k = 0; k < SUPERSAMPLE * SUPERSAMPLE; k++){
+                double px = x + (k % SUPERSAMPLE + 0.5) / SUPERSAMPLE;
+                double py = y + (k / SUPERSAMPLE + 0.5) / SUPERSAMPLE;
+                double v = withMarker ? marker_value(s, code, px, py) : -1;
+                if (v < 0){
+                    v = fabs(px - s->lineX) < 3 * SCALE ? 220 : 60;
+                }
+                sum += v;
+            }
+            int v = (int)(sum / (SUPERSAMPLE * SUPERSAMPLE) + (rnd() * 2 - 1) * 8);
+            int c = v < 0 ? 0 : (v > 255 ? 255 : v);
+            uint16_t px = ((c >> 3) << 11) | ((c >> 2) << 5) | (c >> 3);
+            frame[(y * IMAGESIZEX + x) * 2] = px & 0xFF;
+            frame[(y * IMAGESIZEX + x) * 2 + 1] = px >> 8;
+        }
+    }
+}
+
+// a random marker that fits in the frame with its quiet zone, clear of
+// the line
+static void random_scene(scene_t *s){
+    s->id = (int)(rnd() * MARKER_IDS);
+    s->rotation = (int)(rnd() * 4);
+    s->cell = (bucketCell[0] + rnd() * (bucketCell[NUM_BUCKETS] - bucketCell[0])) * SCALE;
+    s->aspect = 0.6 + rnd() * 0.4;
+    s->keystone = rnd() * 0.2;
+    s->light = 0.7 + rnd() * 0.3;
+    double w = s->cell * 6, h = w * s->aspect;
+    double wide = w * (1 + s->keystone);
+    double margin = s->cell + 1;
+    s->x = margin + w * s->keystone / 2 + rnd() * (IMAGESIZEX - wide - 2 * margin);
+    s->y = margin + rnd() * (IMAGESIZEY - 1 - h - 2 * margin);
+    // the line on whichever side has more room
+    double mid = s->x + w / 2;
+    s->lineX = mid > IMAGESIZEX / 2 ? (mid - wide / 2 - s->cell) / 2 : (IMAGESIZEX + mid + wide / 2 + s->cell) / 2;
+}
+
+static int read_frame(const char *path){
+    FILE *f = fopen(path, "rb");
+    if (!f){
+        perror(path);
+        return -1;
+    }
+    size_t n = fread(frame, 1, FRAME_BYTES, f);
+    fclose(f);
+    return n == FRAME_BYTES ? 0 : -1;
+}
+
+static uint64_t detect_ns = 0;
+static int detects = 0;
+
+static int detect(marker_t *found){
+    loadRawImage(frame);
+    uint64_t t0 = now_ns();
+    int n = markerDetect(found, MARKER_MAX_FOUND);
+    detect_ns += now_ns() - t0;
+    detects++;
+    return n;
+}
+
+int main(int argc, char **argv){
+    int frames = 2000;
+    const char *dir = NULL;
+    int i, b;
+    for (i = 1; i < argc - 1; i++){
+        if (strcmp(argv[i], "-n") == 0){
+            frames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-w") == 0){
+            dir = argv[++i];
+        }
+    }
+    FILE *labels = NULL;
+    if (dir){
+        char path[512];
+        snprintf(path, sizeof(path), "%s/markers.txt", dir);
+        labels = fopen(path, "w");
+        if (!labels){
+            perror(path);
+            return 1;
+        }
+        fprintf(labels, "# file id rotation cell x y\n");
+    }
+
+    int total[NUM_BUCKETS] = {0}, hits[NUM_BUCKETS] = {0};
+    int wrongId = 0, wrongTurn = 0, falsePos = 0, fixedBits = 0;
+    marker_t found[MARKER_MAX_FOUND];
+    for (i = 0; i < frames; i++){
+        scene_t s;
+        random_scene(&s);
+        render(&s, 1);
+        if (labels){
+            char path[512];
+            snprintf(path, sizeof(path), "%s/marker_%d_%dx%d.raw", dir, i, IMAGESIZEX, IMAGESIZEY);
+            FILE *f = fopen(path, "wb");
+            if (f){
+                fwrite(frame, 1, FRAME_BYTES, f);
+                fclose(f);
+            }
+            fprintf(labels, "marker_%d_%dx%d.raw %d %d %.2f %.1f %.1f\n", i, IMAGESIZEX, IMAGESIZEY,
+                s.id, s.rotation, s.cell, s.x, s.y);
+        }
+        int n = detect(found);
+        for (b = 0; b < NUM_BUCKETS - 1 && s.cell / SCALE >= bucketCell[b + 1]; b++);
+        total[b]++;
+        int k, hit = 0;
+        for (k = 0; k < n; k++){
+            if (found[k].id == s.id){
+                hit = 1;
+                fixedBits += found[k].fixed;
+                wrongTurn += found[k].rotation != s.rotation;
+            } else {
+                wrongId++;
+            }
+        }
+        hits[b] += hit;
+
+        // the same floor and line without the marker
+        render(&s, 0);
+        falsePos += detect(found);
+    }
+    if (labels){
+        fclose(labels);
+    }
+    for (i = 0; i < (int)(sizeof(corpus) / sizeof(corpus[0])); i++){
+        char path[512];
+        snprintf(path, sizeof(path), "%s/%s_%dx%d.raw", CORPUS_DIR, corpus[i], IMAGESIZEX, IMAGESIZEY);
+        if (read_frame(path) == 0){
+            falsePos += detect(found);
+        }
+    }
+
+    // checkpoint log: start, 1 seen for two frames, 2, start again
+    marker_t m = {0};
+    static const int passIds[] = {0, 1, 1, 2, 0};
+    static const uint32_t passMs[] = {1000, 4000, 4100, 9000, 12500};
+    markerLogReset();
+    for (i = 0; i < 5; i++){
+        m.id = (uint8_t)passIds[i];
+        markerLogUpdate(&m, 1, passMs[i]);
+    }
+    int logOk = markerLogCount() == 4 && markerLaps() == 1 && markerLastLapMs() == 11500
+        && markerLogEntry(2)->segmentMs == 5000 && markerLogEntry(3)->lap == 1;
+    printf("checkpoint log: %d passes, %d laps, last lap %lu ms, %s\n", markerLogCount(), markerLaps(),
+        (unsigned long)markerLastLapMs(), logOk ? "ok" : "WRONG");
+
+    printf("%dx%d, %d frames with a marker and %d without\n", IMAGESIZEX, IMAGESIZEY, frames, frames + 5);
+    int bigTotal = 0, bigHits = 0;
+    for (b = 0; b < NUM_BUCKETS; b++){
+        printf("  cell %.1f-%.1f px at 80x60: %d/%d found (%.1f%%)\n", bucketCell[b], bucketCell[b + 1],
+            hits[b], total[b], total[b] ? 100.0 * hits[b] / total[b] : 0.0);
+        if (bucketCell[b] >= 2.5){
+            bigTotal += total[b];
+            bigHits += hits[b];
+        }
+    }
+    printf("  wrong ids %d, wrong turns %d, false detections %d, data bits corrected %d\n",
+        wrongId, wrongTurn, falsePos, fixedBits);
+    printf("  %llu ns per frame on this host, %d bytes of bitmap\n",
+        (unsigned long long)(detect_ns / detects), (int)((IMAGESIZEY - 1) * MARKER_WORDS * 4));
+    int ok = logOk && wrongId == 0 && wrongTurn == 0 && falsePos == 0 && bigHits * 100 >= bigTotal * 90;
+    printf("%s\n", ok ? "marker bench passed" : "marker bench FAILED");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,240 @@
+// Checks the motion profile executor (hw18/motion). Profiles of both
+// shapes over short and long distances: they must cover the distance and
+// keep to the speed and acceleration limits, and the S-curve must have
+// no step in acceleration. Then scripts on the stub SDK's timer: the old
+// square path queued in one line without the caller waiting, an arc, an
+// abort part way down a straight, X with and without moves and limits
+// after it in the same line, and bad commands.
+//
+// usage: motion_check
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "pico/stdlib.h"
+#include "motion.h"
+
+#define SCALE 1000 // output per full speed, fine enough to integrate
+#define SPEED 300
+#define ACCEL 600
+
+static int check_profiles(){
+    static const float distances[] = {20, 100, 500, 2000};
+    int shape, i, bad = 0;
+    printf("shape      distance  time s  peak mm/s  covered  max accel  max accel step\n");
+    for(shape=MOTION_TRAPEZOID;shape<=MOTION_SCURVE;shape++){
+        for(i=0;i<4;i++){
+            motionProfile_t p;
+            motionProfileMake(&p, distances[i], SPEED, ACCEL, shape);
+            float total = motionProfileTime(&p);
+            double covered = 0, maxAccel = 0, maxStep = 0, lastAccel = 0;
+            float dt = 0.0005f, t, last = 0;
+            for(t=dt;t<total+dt;t+=dt){
+                float v = motionProfileSpeed(&p, t);
+                covered += (v + last) / 2 * dt;
+                double a = (v - last) / dt;
+                if (fabs(a) > maxAccel) maxAccel = fabs(a);
+                if (t > dt && fabs(a - lastAccel) > maxStep) maxStep = fabs(a - lastAccel);
+                lastAccel = a;
+                last = v;
+            }
+            // a trapezoid's acceleration jumps by the whole limit, twice at each end
+            int ok = fabs(covered - distances[i]) < distances[i] * 0.005
+                && fabsf(motionProfileDistance(&p, total) - distances[i]) < 1e-3f
+                && p.peak <= SPEED + 1e-3f && maxAccel < ACCEL * 1.01
+                && (shape == MOTION_TRAPEZOID || maxStep < ACCEL * 0.05);
+            printf("%-9s  %8.0f  %6.3f  %9.1f  %7.1f  %9.0f  %14.0f  %s\n", shape ? "S-curve" : "trapezoid",
+                distances[i], total, p.peak, covered, maxAccel, maxStep, ok ? "ok" : "WRONG");
+            bad += !ok;
+        }
+    }
+    return bad;
+}
+
+// what the timer wrote, integrated into wheel travel
+static double travelLeft, travelRight;
+static int lastLeft, lastRight, outputs;
+static uint64_t lastOutputUs;
+
+static void output(int left, int right){
+    uint64_t now = time_us_64();
+    if (outputs){
+        double dt = (double)(now - lastOutputUs) * 1e-6;
+        travelLeft += (double)lastLeft / SCALE * 600 * dt;
+        travelRight += (double)lastRight / SCALE * 600 * dt;
+    }
+    lastOutputUs = now;
+    lastLeft = left;
+    lastRight = right;
+    outputs++;
+}
+
+static void reset_travel(){
+    travelLeft = travelRight = 0;
+    outputs = 0;
+    lastLeft = lastRight = 0;
+}
+
+// run until the script is done, returns how long it took
+static double run_script(){
+    uint64_t t0 = time_us_64();
+    while (motionBusy() && time_us_64() - t0 < 60000000){
+        sleep_ms(20); // the main loop would read USB here
+    }
+    return (double)(time_us_64() - t0) * 1e-6;
+}
+
+static int check_square(const motionConfig_t *cfg){
+    reset_travel();
+    uint64_t t0 = time_us_64();
+    int n = motionParse("S 500;T -90;S 500;T -90;S 500;T -90;S 500;T -90");
+    int waited = time_us_64() != t0;
+    double secs = run_script();
+
+    motionProfile_t straight, turn;
+    motionProfileMake(&straight, 500, cfg->maxSpeed, cfg->maxAccel, cfg->shape);
+    motionProfileMake(&turn, 3.14159265f / 2 * cfg->track / 2, cfg->maxSpeed, cfg->maxAccel, cfg->shape);
+    double expect = 4 * (motionProfileTime(&straight) + motionProfileTime(&turn));
+    double turnTravel = 2 * 3.14159265 * cfg->track / 2;
+    double heading = (travelRight - travelLeft) / cfg->track * 180 / 3.14159265;
+    int ok = n == 8 && !waited && fabs(travelLeft - (2000 + turnTravel)) < 10 && fabs(travelRight - (2000 - turnTravel)) < 10
+        && fabs(secs - expect) < 0.05 && lastLeft == 0 && lastRight == 0;
+    printf("square: %d segments queued in %s, %.2f s (profiles say %.2f), wheels %.0f %.0f mm, heading %.1f deg, %s\n",
+        n, waited ? "some time" : "no time", secs, expect, travelLeft, travelRight, heading, ok ? "ok" : "WRONG");
+    return !ok;
+}
+
+static int check_arc(const motionConfig_t *cfg){
+    reset_travel();
+    motionParse("A 200 90");
+    run_script();
+    double centre = (travelLeft + travelRight) / 2;
+    double turned = (travelRight - travelLeft) / cfg->track * 180 / 3.14159265;
+    int ok = fabs(centre - 3.14159265 / 2 * 200) < 3 && fabs(turned - 90) < 1;
+    printf("arc 200 mm 90 deg: centre %.1f mm, turned %.1f deg, %s\n", centre, turned, ok ? "ok" : "WRONG");
+    return !ok;
+}
+
+static int check_abort(const motionConfig_t *cfg){
+    reset_travel();
+    motionParse("S 1000;S 1000");
+    sleep_ms(1500);
+    int before = lastLeft;
+    motionAbort();
+    uint64_t t0 = time_us_64();
+    while (motionBusy() && time_us_64() - t0 < 5000000){
+        sleep_ms(1);
+    }
+    double stopS = (double)(time_us_64() - t0) * 1e-6;
+    int after = outputs;
+    sleep_ms(500);
+    double brake = cfg->maxSpeed / cfg->maxAccel;
+    int ok = before > 0 && stopS < brake + 0.01 && lastLeft == 0 && outputs == after && motionPending() == 0;
+    printf("abort at %.0f mm/s: stopped in %.3f s (limit %.3f s), queue %d, %s\n", (double)before / SCALE * 600, stopS,
+        brake, motionPending(), ok ? "ok" : "WRONG");
+    return !ok;
+}
+
+// X in a line: it stops what ran before the line, what follows it runs
+static int check_abort_line(const motionConfig_t *cfg){
+    char line[MOTION_LINE_MAX];
+    int bad = 0;
+
+    reset_travel();
+    motionParse("S 1000;S 1000");
+    sleep_ms(1000);
+    int n = motionParse("X");
+    run_script();
+    int ok = n == 0 && motionPending() == 0 && travelLeft < 1000 && lastLeft == 0;
+    printf("X: %d queued, stopped after %.0f mm, %s\n", n, travelLeft, ok ? "ok" : "WRONG");
+    bad += !ok;
+
+    reset_travel();
+    motionParse("S 1000;S 1000");
+    sleep_ms(1000);
+    double atX = travelLeft;
+    n = motionParse("X;S 100");
+    run_script();
+    // braking from under the top speed covers less than it takes at full
+    double after = travelLeft - atX;
+    ok = n == 1 && after > 99 && after < 100 + cfg->maxSpeed * cfg->maxSpeed / cfg->maxAccel && lastLeft == 0;
+    printf("X;S 100: %d queued, %.0f mm after the abort, %s\n", n, after, ok ? "ok" : "WRONG");
+    bad += !ok;
+
+    // the new limits are for the move after the stop, the brake keeps the old
+    reset_travel();
+    motionParse("S 1000;S 1000");
+    sleep_ms(1000);
+    double v = (double)lastLeft / SCALE * 600;
+    uint64_t t0 = time_us_64();
+    n = motionParse("X;V 150 300;S 100");
+    run_script();
+    double secs = (double)(time_us_64() - t0) * 1e-6;
+    motionProfile_t slow;
+    motionProfileMake(&slow, 100, 150, 300, cfg->shape);
+    double expect = v / cfg->maxAccel + motionProfileTime(&slow);
+    ok = n == 1 && fabs(secs - expect) < 0.05;
+    printf("X;V 150 300;S 100: %d queued, %.2f s (braking and the profile say %.2f), %s\n", n, secs, expect,
+        ok ? "ok" : "WRONG");
+    bad += !ok;
+    snprintf(line, sizeof(line), "V %d %d", SPEED, ACCEL);
+    motionParse(line);
+    run_script();
+    return bad;
+}
+
+static int check_parse(){
+    int bad = 0;
+    bad += motionParse("Q 5") != -1;
+    bad += motionParse("A -5 90") != -1;
+    bad += motionParse("S") != -1;
+    bad += motionParse("P T;S 10;P S;S 10") != 2;
+    bad += motionParse(" ") != 0;
+    run_script();
+    // a line with a bad command does none of it
+    bad += motionParse("S 500;T 90;Z") != -1;
+    bad += motionPending() != 0;
+    // one less than the ring
+    char line[MOTION_LINE_MAX];
+    int i, fits = 0;
+    for(i=0;i<MOTION_QUEUE;i++){
+        snprintf(line, sizeof(line), "S %d", 1000 + i);
+        if (motionParse(line) == 1){
+            fits++;
+        }
+    }
+    bad += fits != MOTION_QUEUE - 1;
+    motionAbort();
+    run_script();
+    printf("commands: %s\n", bad ? "WRONG" : "ok");
+    return bad;
+}
+
+int main(){
+    int bad = check_profiles();
+    motionConfig_t cfg;
+    motionDefaultConfig(&cfg);
+    cfg.maxSpeed = SPEED;
+    cfg.maxAccel = ACCEL;
+    cfg.outputScale = SCALE;
+    motionInit(&cfg);
+    if (!motionStart(output)){
+        printf("timer: couldn't start\n");
+        return 1;
+    }
+    int shape;
+    for(shape=MOTION_TRAPEZOID;shape<=MOTION_SCURVE;shape++){
+        cfg.shape = shape;
+        motionInit(&cfg);
+        printf("%s:\n", shape ? "S-curve" : "trapezoid");
+        bad += check_square(&cfg);
+        bad += check_arc(&cfg);
+        bad += check_abort(&cfg);
+        bad += check_abort_line(&cfg);
+    }
+    bad += check_parse();
+    motionStop();
+    printf("%s\n", bad ? "motion check FAILED" : "motion check passed");
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,322 @@
+// Checks the motor driver (hw18/motor) on the stub SDK's registers:
+// - the PWM frequency and resolution it picks, HW16's and the old 255 at
+//   full clock among them;
+// - set up once with both slices started on one write and the camera
+//   clock's slice left alone;
+// - each unlimited update's register writes, levels and direction pins,
+//   inverted and not, next to the writes the old per-motor set_motor()
+//   made;
+// - the slew limited ramps, run by firing the wrap interrupt a period at
+//   a time: from a stop, a reversal through zero, and the two motors at
+//   different frequencies arriving together;
+// - brake and coast on in/in wiring.
+//
+// usage: motor_check
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "pico/stdlib.h"
+#include "hardware/pwm.h"
+#include "hardware/clocks.h"
+#include "motor.h"
+
+#define WRAP 255
+#define CAMERA_SLICE 4 // some other slice already running
+
+// manual control's set_motor() before the driver, for its write count
+static void old_set_motor(int duty_percent, uint enbl, uint phase, bool invert_dir){
+    if (duty_percent > 100) duty_percent = 100;
+    if (duty_percent < -100) duty_percent = -100;
+    bool forward = duty_percent >= 0;
+    gpio_put(phase, invert_dir ? !forward : forward ? 0 : 1);
+    gpio_set_function(enbl, GPIO_FUNC_PWM);
+    uint slice = pwm_gpio_to_slice_num(enbl);
+    pwm_set_wrap(slice, WRAP);
+    pwm_set_clkdiv(slice, 1.0f);
+    pwm_set_chan_level(slice, pwm_gpio_to_channel(enbl), abs(duty_percent * WRAP / 100));
+    pwm_set_enabled(slice, true);
+}
+
+static uint32_t period(int motor){
+    uint32_t freq;
+    uint16_t top;
+    motorPwm(motor, &freq, &top);
+    return (uint32_t)top + 1;
+}
+
+static uint enable_slice(const motorConfig_t *cfg, int motor){
+    return pwm_gpio_to_slice_num(cfg->pins[motor].enable);
+}
+
+static int check_frequencies(){
+    static const struct {
+        uint32_t freq;
+        uint16_t top;
+    } asks[] = {{20000, 0}, {15000, 9999}, {585937, 255}, {1000, 0}, {100, 0}, {25, 0}, {1, 0}};
+    int i, bad = 0;
+    printf("asked Hz    top    got Hz    top  divider\n");
+    for(i=0;i<(int)(sizeof(asks) / sizeof(asks[0]));i++){
+        motorConfig_t cfg;
+        motorDefaultConfig(&cfg);
+        cfg.pins[MOTOR_LEFT].freqHz = cfg.pins[MOTOR_RIGHT].freqHz = asks[i].freq;
+        cfg.pins[MOTOR_LEFT].top = cfg.pins[MOTOR_RIGHT].top = asks[i].top;
+        if (motorInit(&cfg) != 0){
+            // under 150MHz / 256 / 65536 there's no divider for it
+            int ok = asks[i].freq < 10;
+            printf("%8u  %5u  can't be done     %s\n", (unsigned)asks[i].freq, asks[i].top, ok ? "ok" : "WRONG");
+            bad += !ok;
+            continue;
+        }
+        uint32_t freq;
+        uint16_t top;
+        motorPwm(MOTOR_LEFT, &freq, &top);
+        float div = hal_pwm_get_clkdiv(enable_slice(&cfg, MOTOR_LEFT));
+        double got = (double)clock_get_hz(clk_sys) / (div * (top + 1));
+        // the finest resolution fills 16 bits unless the divider is at 1
+        int ok = fabs((double)freq - asks[i].freq) < asks[i].freq * 0.01 && fabs(got - freq) < freq * 0.001 + 1
+            && hal_pwm_get_wrap(enable_slice(&cfg, MOTOR_LEFT)) == top
+            && (asks[i].top ? top == asks[i].top : (div == 1.0f || top > 32767));
+        printf("%8u  %5u  %8u  %5u  %7.4f  %s\n", (unsigned)asks[i].freq, asks[i].top, (unsigned)freq, top, div,
+            ok ? "ok" : "WRONG");
+        bad += !ok;
+    }
+    return bad;
+}
+
+static int check_init(const motorConfig_t *cfg){
+    pwm_set_enabled(CAMERA_SLICE, true);
+    uint32_t enabled = pwm_hw->en;
+    uint32_t before = hal_io_writes();
+    int err = motorInit(cfg);
+    uint32_t writes = hal_io_writes() - before;
+    uint left = enable_slice(cfg, MOTOR_LEFT);
+    uint right = enable_slice(cfg, MOTOR_RIGHT);
+    uint32_t want = enabled | (1u << left) | (1u << right);
+    int ok = err == 0 && pwm_hw->en == want && hal_pwm_get_wrap(left) == period(MOTOR_LEFT) - 1
+        && hal_pwm_get_wrap(right) == period(MOTOR_RIGHT) - 1 && pwm_get_counter(left) == 0 && pwm_get_counter(right) == 0
+        && hal_pwm_get_level(cfg->pins[MOTOR_LEFT].enable) == 0 && hal_pwm_get_level(cfg->pins[MOTOR_RIGHT].enable) == 0;
+    printf("init: %u writes, slices enabled 0x%03x, %s\n", (unsigned)writes, (unsigned)pwm_hw->en, ok ? "ok" : "WRONG");
+    return !ok;
+}
+
+// the level a speed comes to on a motor's period
+static int level_of(int motor, int speed){
+    int s = speed > WRAP ? WRAP : (speed < -WRAP ? -WRAP : speed);
+    return (int)((int64_t)abs(s) * period(motor) / WRAP);
+}
+
+// one unlimited update: its writes, the levels and the direction pins
+static int check_set(const motorConfig_t *cfg, int left, int right, uint32_t wantWrites){
+    static const char *side[MOTORS] = {"left", "right"};
+    int speed[MOTORS] = {left, right};
+    uint32_t before = hal_io_writes();
+    motorSet(left, right);
+    uint32_t writes = hal_io_writes() - before;
+    int i, ok = writes == wantWrites;
+    for(i=0;i<MOTORS;i++){
+        const motorPins_t *p = &cfg->pins[i];
+        bool high = (speed[i] < 0) != p->invert;
+        if (hal_pwm_get_level(p->enable) != level_of(i, speed[i]) || gpio_get(p->phase) != high){
+            printf("  %s: level %d pin %d, wanted %d %d\n", side[i], hal_pwm_get_level(p->enable), gpio_get(p->phase),
+                level_of(i, speed[i]), high);
+            ok = 0;
+        }
+    }
+    int l, r;
+    motorGet(&l, &r);
+    printf("set %4d %4d: %u writes, read back %d %d, %s\n", left, right, (unsigned)writes, l, r, ok ? "ok" : "WRONG");
+    return !ok;
+}
+
+static int check_updates(motorConfig_t *cfg, uint32_t writes){
+    static const int speeds[][2] = {{0, 0}, {128, 128}, {-60, 200}, {300, -300}, {-255, 0}, {0, 0}};
+    int i, bad = 0;
+    for(i=0;i<(int)(sizeof(speeds) / sizeof(speeds[0]));i++){
+        bad += check_set(cfg, speeds[i][0], speeds[i][1], writes);
+    }
+    return bad;
+}
+
+static int check_unlimited(){
+    motorConfig_t cfg;
+    int bad = 0;
+
+    printf("hw18 pins, no slew limit:\n");
+    motorDefaultConfig(&cfg);
+    cfg.slewPerS = 0;
+    bad += check_init(&cfg);
+    bad += check_updates(&cfg, 3);
+
+    printf("right motor inverted:\n");
+    cfg.pins[MOTOR_RIGHT].invert = true;
+    bad += check_init(&cfg);
+    bad += check_updates(&cfg, 3);
+
+    printf("both on one slice:\n");
+    cfg.pins[MOTOR_LEFT].phase = 14;
+    cfg.pins[MOTOR_LEFT].enable = 16;
+    cfg.pins[MOTOR_RIGHT].phase = 15;
+    cfg.pins[MOTOR_RIGHT].enable = 17;
+    bad += check_init(&cfg);
+    bad += check_updates(&cfg, 2);
+
+    uint32_t before = hal_io_writes();
+    old_set_motor(50, 17, 16, false);
+    old_set_motor(50, 19, 18, true);
+    printf("the old set_motor() pair: %u writes an update\n", (unsigned)(hal_io_writes() - before));
+    return bad;
+}
+
+// signed level of a phase/enable motor, from its pins
+static int signed_level(const motorConfig_t *cfg, int motor){
+    int level = hal_pwm_get_level(cfg->pins[motor].enable);
+    return gpio_get(cfg->pins[motor].phase) != cfg->pins[motor].invert ? -level : level;
+}
+
+typedef struct ramp {
+    int periods; // until it got there
+    int maxStep; // biggest change in a period
+    int flips; // direction changes, zero or not on the way
+    int backwards; // steps away from the target
+    uint32_t setWrites; // what motorSet() itself wrote
+} ramp_t;
+
+// set both motors and fire the wrap interrupt for their slices until
+// they get there, following the left level
+static void run_ramp(const motorConfig_t *cfg, int speed, ramp_t *r){
+    int target = speed < 0 ? -level_of(MOTOR_LEFT, speed) : level_of(MOTOR_LEFT, speed);
+    int last = signed_level(cfg, MOTOR_LEFT), sign = last > 0 ? 1 : (last < 0 ? -1 : 0);
+    uint32_t slices = (1u << enable_slice(cfg, MOTOR_LEFT)) | (1u << enable_slice(cfg, MOTOR_RIGHT));
+    r->periods = r->maxStep = r->flips = r->backwards = 0;
+    uint32_t before = hal_io_writes();
+    motorSet(speed, speed);
+    r->setWrites = hal_io_writes() - before;
+    while (motorRamping() && r->periods < 100000){
+        hal_pwm_wrap(slices);
+        r->periods++;
+        int level = signed_level(cfg, MOTOR_LEFT);
+        if (abs(level - last) > r->maxStep) r->maxStep = abs(level - last);
+        if (level != 0){
+            if (sign != 0 && (level > 0) != (sign > 0)) r->flips++;
+            sign = level > 0 ? 1 : -1;
+        }
+        if (abs(target - level) > abs(target - last)) r->backwards++;
+        last = level;
+    }
+}
+
+static int check_ramps(){
+    motorConfig_t cfg;
+    printf("hw18 pins, slew limited:\n");
+    motorDefaultConfig(&cfg);
+    int bad = check_init(&cfg);
+    uint32_t freq;
+    uint16_t top;
+    motorPwm(MOTOR_LEFT, &freq, &top);
+    double step = cfg.slewPerS * (top + 1) / freq; // levels a period
+
+    static const struct {
+        int speed;
+        int from; // where it starts
+        int flips; // through zero on the way
+    } moves[] = {{255, 0, 0}, {128, 255, 0}, {-255, 128, 1}, {0, -255, 0}, {-50, 0, 0}, {50, -50, 1}};
+    int i;
+    printf("ramp from   to  periods  expected     ms  largest step\n");
+    for(i=0;i<(int)(sizeof(moves) / sizeof(moves[0]));i++){
+        ramp_t r;
+        run_ramp(&cfg, moves[i].speed, &r);
+        double expect = fabs((double)moves[i].speed - moves[i].from) / WRAP * freq / cfg.slewPerS;
+        uint32_t irqs = hal_pwm_irq_enabled_mask() & ((1u << enable_slice(&cfg, MOTOR_LEFT))
+            | (1u << enable_slice(&cfg, MOTOR_RIGHT)));
+        int ok = fabs(r.periods - expect) <= expect * 0.01 + 2 && r.maxStep <= step + 1 && r.backwards == 0
+            && r.flips == moves[i].flips && !motorRamping() && irqs == 0 && r.setWrites == 1
+            && signed_level(&cfg, MOTOR_RIGHT) == signed_level(&cfg, MOTOR_LEFT);
+        printf("     %4d %4d  %7d  %8.0f  %5.1f  %12d  %s\n", moves[i].from, moves[i].speed, r.periods, expect,
+            r.periods * 1000.0 / freq, r.maxStep, ok ? "ok" : "WRONG");
+        bad += !ok;
+    }
+    // an unlimited step would have been the whole period in one
+    printf("slew %.0f full scales/s at %u Hz: %.2f of %u levels a period\n", cfg.slewPerS, (unsigned)freq, step,
+        (unsigned)(top + 1));
+    return bad;
+}
+
+// the left motor at 20kHz and the right at 10kHz take the same time
+static int check_mixed(){
+    motorConfig_t cfg;
+    motorDefaultConfig(&cfg);
+    cfg.pins[MOTOR_RIGHT].freqHz = 10000;
+    printf("right motor at 10kHz:\n");
+    int bad = check_init(&cfg);
+    uint left = enable_slice(&cfg, MOTOR_LEFT), right = enable_slice(&cfg, MOTOR_RIGHT);
+    motorSet(200, 200);
+    int t, leftDone = -1, rightDone = -1;
+    // 25us steps, the left slice wraps every other one and the right every fourth
+    for(t=1;t<20000 && (leftDone < 0 || rightDone < 0);t++){
+        uint32_t mask = (t % 2 == 0 ? 1u << left : 0) | (t % 4 == 0 ? 1u << right : 0);
+        if (mask) hal_pwm_wrap(mask);
+        if (leftDone < 0 && hal_pwm_get_level(cfg.pins[MOTOR_LEFT].enable) == level_of(MOTOR_LEFT, 200)) leftDone = t;
+        if (rightDone < 0 && hal_pwm_get_level(cfg.pins[MOTOR_RIGHT].enable) == level_of(MOTOR_RIGHT, 200)) rightDone = t;
+    }
+    double expect = 200.0 / WRAP / cfg.slewPerS * 1000;
+    int ok = leftDone > 0 && rightDone > 0 && fabs(leftDone * 0.025 - expect) < 1 && fabs(rightDone * 0.025 - expect) < 1;
+    printf("both to 200: %.1f and %.1f ms, expected %.1f, %s\n", leftDone * 0.025, rightDone * 0.025, expect,
+        ok ? "ok" : "WRONG");
+    return bad + !ok;
+}
+
+// in/in: brake holds a side high and both high when off, coast drives one
+// side and both low when off
+static int check_decay(){
+    motorConfig_t cfg;
+    int bad = 0, decay;
+    for(decay=MOTOR_BRAKE;decay<=MOTOR_COAST;decay++){
+        motorDefaultConfig(&cfg);
+        cfg.slewPerS = 0;
+        int i;
+        for(i=0;i<MOTORS;i++){
+            cfg.pins[i].mode = MOTOR_IN_IN;
+            cfg.pins[i].decay = (uint8_t)decay;
+        }
+        if (motorInit(&cfg) != 0){
+            printf("in/in init failed, WRONG\n");
+            bad++;
+            continue;
+        }
+        int full = (int)period(MOTOR_LEFT);
+        static const int speeds[][2] = {{128, -128}, {0, 0}, {255, -255}};
+        for(i=0;i<3;i++){
+            uint32_t before = hal_io_writes();
+            motorSet(speeds[i][0], speeds[i][1]);
+            uint32_t writes = hal_io_writes() - before;
+            int mag = level_of(MOTOR_LEFT, speeds[i][0]);
+            int a1 = hal_pwm_get_level(cfg.pins[MOTOR_LEFT].phase), a2 = hal_pwm_get_level(cfg.pins[MOTOR_LEFT].enable);
+            int b1 = hal_pwm_get_level(cfg.pins[MOTOR_RIGHT].phase), b2 = hal_pwm_get_level(cfg.pins[MOTOR_RIGHT].enable);
+            int ok = decay == MOTOR_BRAKE
+                ? a1 == full && a2 == full - mag && b1 == full - mag && b2 == full
+                : a1 == mag && a2 == 0 && b1 == 0 && b2 == mag;
+            ok = ok && writes == 2;
+            printf("%s %4d %4d: IN1/IN2 left %d/%d right %d/%d of %d, %u writes, %s\n",
+                decay == MOTOR_BRAKE ? "brake" : "coast", speeds[i][0], speeds[i][1], a1, a2, b1, b2, full,
+                (unsigned)writes, ok ? "ok" : "WRONG");
+            bad += !ok;
+        }
+    }
+    // a phase/enable driver decides its own decay
+    motorDefaultConfig(&cfg);
+    cfg.pins[MOTOR_LEFT].decay = MOTOR_COAST;
+    int refused = motorInit(&cfg) != 0;
+    printf("coast on phase/enable wiring: %s, %s\n", refused ? "refused" : "accepted", refused ? "ok" : "WRONG");
+    return bad + !refused;
+}
+
+int main(){
+    int bad = check_frequencies();
+    bad += check_unlimited();
+    bad += check_ramps();
+    bad += check_mixed();
+    bad += check_decay();
+    printf("%s\n", bad ? "motor check FAILED" : "motor check passed");
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,144 @@
+// Checks the nn.c kernels bit for bit against nn_ref.c and times each layer.
+// Built twice: nn_check uses the plain C kernels the M0+ runs, and
+// nn_check_simd the M33 DSP path with the instructions emulated.
+// Exits non-zero on any mismatch.
+//
+// usage: nn_check [-n inputs] [model.bin]
+// Without a file the model compiled into the firmware (nn_model.h) is used.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "cam.h"
+#include "nn.h"
+#include "nn_ref.h"
+#include "nn_model.h"
+
+static const char *layer_names[] = {"?", "conv", "depthwise", "maxpool", "dense"};
+
+static uint64_t now_ns(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t seed = 12345;
+
+static int8_t random_byte(){
+    seed = seed * 1664525u + 1013904223u;
+    return (int8_t)(seed >> 24);
+}
+
+static uint32_t layer_macs(const nnLayer_t *l){
+    switch (l->type){
+        case NN_LAYER_CONV: return (uint32_t)l->outX * l->outY * l->outC * l->k * l->k * l->inC;
+        case NN_LAYER_DEPTHWISE: return (uint32_t)l->outX * l->outY * l->outC * l->k * l->k;
+        case NN_LAYER_DENSE: return (uint32_t)l->outC * l->inX * l->inY * l->inC;
+    }
+    return 0;
+}
+
+static uint8_t *read_file(const char *path, uint32_t *len){
+    FILE *f = fopen(path, "rb");
+    if (!f){
+        perror(path);
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *blob = malloc(size > 0 ? (size_t)size : 1);
+    if (fread(blob, 1, (size_t)size, f) != (size_t)size){
+        fclose(f);
+        free(blob);
+        return NULL;
+    }
+    fclose(f);
+    *len = (uint32_t)size;
+    return blob;
+}
+
+int main(int argc, char **argv){
+    int numInputs = 100;
+    const uint8_t *blob = nn_model;
+    uint32_t len = NN_MODEL_SIZE;
+    int i, j, n;
+    for (i = 1; i < argc; i++){
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc){
+            numInputs = atoi(argv[++i]);
+        } else {
+            blob = read_file(argv[i], &len);
+            if (!blob){
+                return 1;
+            }
+        }
+    }
+
+    int err = nnLoad(blob, len);
+    if (err != NN_OK){
+        fprintf(stderr, "nnLoad failed: %d\n", err);
+        return 1;
+    }
+
+    static int8_t input[NN_INPUT_X*NN_INPUT_Y];
+    static int8_t refA[NN_ARENA_SIZE], refB[NN_ARENA_SIZE];
+    uint64_t layerNs[NN_MAX_LAYERS] = {0};
+    int mismatches[NN_MAX_LAYERS] = {0};
+    int totalMismatches = 0;
+
+    for (n = 0; n < numInputs; n++){
+        for (i = 0; i < NN_INPUT_X*NN_INPUT_Y; i++){
+            input[i] = random_byte();
+        }
+        nnSetInput(input);
+        memcpy(refA, input, sizeof(input));
+        int8_t *refIn = refA, *refOut = refB;
+        for (i = 0; i < nnNumLayers(); i++){
+            const nnLayer_t *l = nnGetLayer(i);
+            uint64_t t0 = now_ns();
+            nnRunLayer(i);
+            layerNs[i] += now_ns() - t0;
+
+            nn_ref_layer(l, refIn, refOut);
+            const int8_t *got = nnGetLayerOutput(i);
+            int size = l->outX * l->outY * l->outC;
+            for (j = 0; j < size; j++){
+                if (got[j] != refOut[j]){
+                    if (mismatches[i] == 0){
+                        fprintf(stderr, "layer %d input %d: element %d is %d, reference %d\n",
+                            i, n, j, got[j], refOut[j]);
+                    }
+                    mismatches[i]++;
+                    totalMismatches++;
+                }
+            }
+            int8_t *t = refIn;
+            refIn = refOut;
+            refOut = t;
+        }
+    }
+
+#if defined(NN_EMULATE_SIMD32)
+    printf("M33 DSP kernels (emulated), %d inputs\n", numInputs);
+#else
+    printf("generic C kernels, %d inputs\n", numInputs);
+#endif
+    printf("%-3s %-10s %-14s %-14s %8s %10s %s\n", "#", "layer", "in", "out", "MACs", "ns", "mismatches");
+    uint64_t totalNs = 0;
+    uint32_t totalMacs = 0;
+    for (i = 0; i < nnNumLayers(); i++){
+        const nnLayer_t *l = nnGetLayer(i);
+        char in[32], out[32];
+        snprintf(in, sizeof(in), "%dx%dx%d", l->inX, l->inY, l->inC);
+        snprintf(out, sizeof(out), "%dx%dx%d", l->outX, l->outY, l->outC);
+        uint64_t ns = layerNs[i] / (numInputs ? numInputs : 1);
+        printf("%-3d %-10s %-14s %-14s %8u %10llu %d\n", i, layer_names[l->type < 5 ? l->type : 0],
+            in, out, layer_macs(l), (unsigned long long)ns, mismatches[i]);
+        totalNs += ns;
+        totalMacs += layer_macs(l);
+    }
+    printf("total %u MACs, %llu ns per frame on this host, %d mismatches\n",
+        totalMacs, (unsigned long long)totalNs, totalMismatches);
+    return totalMismatches ? 1 : 0;
+}
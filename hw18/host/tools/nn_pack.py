@@ -0,0 +1,129 @@
+# Packs a quantized model description into the blob nn.c loads.
+#
+# The JSON lists the layers in order. Every layer has a "type" (conv,
+# depthwise, maxpool, dense) and, where it applies, "k", "stride", "out",
+# "relu", the requantization "mult" (Q31) and "shift", and the int8
+# "weights" / int32 "bias" exported by training. Weight order is
+# [out][k][k][in] for conv, [k][k][C] for depthwise, [out][in] for dense,
+# with activations stored height, width, channel.
+#
+# usage: python3 nn_pack.py model.json -o model.bin [-c nn_model.h] [--random SEED]
+# --random fills in missing weights with repeatable noise scaled so the
+# activations stay in range, for timing and kernel checks before a
+# trained model exists.
+
+import argparse
+import json
+import math
+import random
+import struct
+
+MAGIC = 0x31424E4E
+TYPES = {'conv': 1, 'depthwise': 2, 'maxpool': 3, 'dense': 4}
+
+
+def out_shape(layer, x, y, c):
+    t = layer['type']
+    s = layer.get('stride', 1)
+    if t == 'conv':
+        return (x + s - 1) // s, (y + s - 1) // s, layer['out']
+    if t == 'depthwise':
+        return (x + s - 1) // s, (y + s - 1) // s, c
+    if t == 'maxpool':
+        return x // layer['k'], y // layer['k'], c
+    return 1, 1, layer['out']
+
+
+def num_weights(layer, x, y, c):
+    t = layer['type']
+    k = layer.get('k', 0)
+    if t == 'conv':
+        return layer['out'] * k * k * c
+    if t == 'depthwise':
+        return k * k * c
+    if t == 'dense':
+        return layer['out'] * x * y * c
+    return 0
+
+
+def fill_random(layer, x, y, c, rng):
+    n = num_weights(layer, x, y, c)
+    if n == 0:
+        return
+    _, _, outc = out_shape(layer, x, y, c)
+    if 'weights' not in layer:
+        layer['weights'] = [rng.randint(-64, 64) for _ in range(n)]
+    if 'bias' not in layer:
+        layer['bias'] = [rng.randint(-256, 256) for _ in range(outc)]
+    if 'mult' not in layer:
+        # sums of fan_in products of ~64 x ~64 should land around +-64
+        fan_in = n // outc if layer['type'] != 'depthwise' else n // c
+        scale = 1.0 / (math.sqrt(fan_in) * 64)
+        shift = 0
+        while scale < 0.5:
+            scale *= 2
+            shift += 1
+        layer['mult'] = int(round(scale * (1 << 31))) if scale < 1 else (1 << 31) - 1
+        layer['shift'] = shift
+
+
+def pack(model, rng=None):
+    x, y, c = model['input']
+    layers = model['layers']
+    scales = [int(round(v * 65536)) for v in model['out_scale']]
+    blob = struct.pack('<IHHHH2i', MAGIC, x, y, c, len(layers), *scales)
+    for layer in layers:
+        if rng is not None:
+            fill_random(layer, x, y, c, rng)
+        n = num_weights(layer, x, y, c)
+        outx, outy, outc = out_shape(layer, x, y, c)
+        blob += struct.pack('<4BHHii', TYPES[layer['type']], layer.get('k', 0),
+                            layer.get('stride', 1), 1 if layer.get('relu') else 0,
+                            layer.get('out', 0), 0, layer.get('mult', 0), layer.get('shift', 0))
+        if layer['type'] != 'maxpool':
+            if len(layer['weights']) != n or len(layer['bias']) != outc:
+                raise SystemExit('layer %s: expected %d weights and %d biases' % (layer['type'], n, outc))
+            blob += struct.pack('<%di' % outc, *layer['bias'])
+            blob += struct.pack('<%db' % n, *layer['weights'])
+            blob += b'\0' * ((4 - n % 4) % 4)
+        x, y, c = outx, outy, outc
+    return blob
+
+
+def write_header(path, blob, source, placeholder):
+    with open(path, 'w') as f:
+        f.write('#ifndef NN_MODEL_h\n#define NN_MODEL_h\n\n')
+        f.write('// generated by host/tools/nn_pack.py from %s, do not edit\n' % source)
+        if placeholder:
+            f.write('// random placeholder weights, only good for timing until a trained model exists\n')
+            f.write('#define NN_MODEL_PLACEHOLDER 1\n')
+        f.write('\n')
+        f.write('#include <stdint.h>\n\n')
+        f.write('#define NN_MODEL_SIZE %d\n\n' % len(blob))
+        f.write('static const uint8_t nn_model[NN_MODEL_SIZE] __attribute__((aligned(4))) = {\n')
+        for i in range(0, len(blob), 16):
+            f.write('    ' + ', '.join('0x%02x' % b for b in blob[i:i + 16]) + ',\n')
+        f.write('};\n\n#endif\n')
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument('model')
+    ap.add_argument('-o', '--output', required=True)
+    ap.add_argument('-c', '--header')
+    ap.add_argument('--random', type=int)
+    args = ap.parse_args()
+
+    with open(args.model) as f:
+        model = json.load(f)
+    rng = random.Random(args.random) if args.random is not None else None
+    blob = pack(model, rng)
+    with open(args.output, 'wb') as f:
+        f.write(blob)
+    if args.header:
+        write_header(args.header, blob, args.model.split('/')[-1], rng is not None)
+    print('%s: %d layers, %d bytes' % (args.output, len(model['layers']), len(blob)))
+
+
+if __name__ == '__main__':
+    main()
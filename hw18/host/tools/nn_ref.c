@@ -0,0 +1,63 @@
+// Reference int8 layers for checking nn.c on the host.
+// Written for clarity rather than speed: one output element at a time,
+// every tap bounds checked, same quantization as nnRequant().
+
+#include "nn_ref.h"
+
+static int8_t ref_requant(int32_t acc, const nnLayer_t *l){
+    int64_t p = (int64_t)acc * l->mult;
+    int total = 31 + l->shift;
+    p = (p + ((int64_t)1 << (total - 1))) >> total;
+    if (l->relu && p < 0) p = 0;
+    if (p < -128) p = -128;
+    if (p > 127) p = 127;
+    return (int8_t)p;
+}
+
+static int8_t ref_in(const nnLayer_t *l, const int8_t *in, int x, int y, int c){
+    return in[(y*l->inX + x)*l->inC + c];
+}
+
+void nn_ref_layer(const nnLayer_t *l, const int8_t *in, int8_t *out){
+    int ox, oy, oc, kx, ky, ic;
+    int pad = l->k / 2;
+    for (oy = 0; oy < l->outY; oy++){
+        for (ox = 0; ox < l->outX; ox++){
+            for (oc = 0; oc < l->outC; oc++){
+                int32_t acc = l->bias ? l->bias[oc] : 0;
+                int8_t best = -128;
+                for (ky = 0; ky < l->k; ky++){
+                    for (kx = 0; kx < l->k; kx++){
+                        if (l->type == NN_LAYER_MAXPOOL){
+                            int8_t v = ref_in(l, in, ox*l->k + kx, oy*l->k + ky, oc);
+                            if (v > best) best = v;
+                            continue;
+                        }
+                        int ix = ox*l->stride - pad + kx;
+                        int iy = oy*l->stride - pad + ky;
+                        if (ix < 0 || iy < 0 || ix >= l->inX || iy >= l->inY){
+                            continue; // zero padding
+                        }
+                        if (l->type == NN_LAYER_DEPTHWISE){
+                            acc += ref_in(l, in, ix, iy, oc) * l->weights[(ky*l->k + kx)*l->inC + oc];
+                        } else {
+                            for (ic = 0; ic < l->inC; ic++){
+                                int w = l->weights[((oc*l->k + ky)*l->k + kx)*l->inC + ic];
+                                acc += ref_in(l, in, ix, iy, ic) * w;
+                            }
+                        }
+                    }
+                }
+                if (l->type == NN_LAYER_DENSE){
+                    int n = l->inX * l->inY * l->inC;
+                    int i;
+                    for (i = 0; i < n; i++){
+                        acc += in[i] * l->weights[oc*n + i];
+                    }
+                }
+                out[(oy*l->outX + ox)*l->outC + oc] =
+                    l->type == NN_LAYER_MAXPOOL ? best : ref_requant(acc, l);
+            }
+        }
+    }
+}
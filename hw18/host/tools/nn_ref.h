@@ -0,0 +1,9 @@
+#ifndef NN_REF_h
+#define NN_REF_h
+
+#include "nn.h"
+
+// runs one layer the slow obvious way, out must hold outX*outY*outC
+void nn_ref_layer(const nnLayer_t *l, const int8_t *in, int8_t *out);
+
+#endif
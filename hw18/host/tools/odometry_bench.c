@@ -0,0 +1,154 @@
+// Host benchmark for the block matching odometry in odometry.c.
+// By default renders textured floors sliding by known amounts per frame
+// and reports the shift error and time per frame. Given raw frames
+// (e.g. a recorded run) it prints the motion measured between them.
+//
+// usage: odometry_bench [-n frames] [-fps rate] [file.raw ...]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "cam.h"
+#include "odometry.h"
+
+#define FRAME_BYTES (IMAGESIZEX*IMAGESIZEY*2)
+
+typedef struct sequence {
+    const char *name;
+    float lateral; // floor shift per frame at full resolution, pixels
+    float forward;
+    int contrast; // texture amplitude, 0 is a plain floor
+} sequence_t;
+
+static const sequence_t sequences[] = {
+    {"still", 0.0f, 0.0f, 40},
+    {"forward_slow", 0.0f, 2.0f, 40},
+    {"forward_fast", 0.0f, 6.0f, 40},
+    {"forward_half_px", 0.0f, 3.0f, 40},
+    {"turning", 2.5f, 4.0f, 40},
+    {"reversing", -1.0f, -3.0f, 40},
+    {"low_texture", 0.0f, 4.0f, 6},
+    {"plain_floor", 0.0f, 4.0f, 0},
+};
+#define NUM_SEQUENCES (sizeof(sequences) / sizeof(sequences[0]))
+
+static uint8_t raw[FRAME_BYTES];
+
+static uint64_t now_ns(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+// repeatable pseudo random value for a floor grid point
+static float hash(int x, int y){
+    uint32_t h = (uint32_t)x * 374761393u + (uint32_t)y * 668265263u;
+    h = (h ^ (h >> 13)) * 1274126177u;
+    return (float)((h ^ (h >> 16)) & 0xFFFF) / 65535.0f;
+}
+
+// carpet like texture, value noise on a 3 pixel grid
+static float floor_texture(float x, float y){
+    int ix = (int)floorf(x / 3), iy = (int)floorf(y / 3);
+    float fx = x / 3 - ix, fy = y / 3 - iy;
+    float a = hash(ix, iy), b = hash(ix + 1, iy);
+    float c = hash(ix, iy + 1), d = hash(ix + 1, iy + 1);
+    return (a * (1 - fx) + b * fx) * (1 - fy) + (c * (1 - fx) + d * fx) * fy;
+}
+
+static void render_floor(const sequence_t *s, int t){
+    int x, y;
+    for (y = 0; y < IMAGESIZEY; y++){
+        for (x = 0; x < IMAGESIZEX; x++){
+            float wx = x - s->lateral * t + 1000;
+            float wy = y - s->forward * t + 1000;
+            int v = 90 + (int)(s->contrast * (floor_texture(wx, wy) - 0.5f) * 2);
+            uint8_t g = (uint8_t)v;
+            int i = (y * IMAGESIZEX + x) * 2;
+            raw[i] = (uint8_t)((((g >> 2) & 0x7) << 5) | (g >> 3));
+            raw[i + 1] = (uint8_t)((g & 0xF8) | (g >> 5));
+        }
+    }
+}
+
+static void run_synthetic(int numFrames, uint32_t frameUs){
+    unsigned int k;
+    int t;
+    uint64_t totalNs = 0;
+    int totalFrames = 0;
+    printf("%-16s %8s %8s %8s %8s %6s\n", "sequence", "true x", "true y", "err x", "err y", "valid");
+    for (k = 0; k < NUM_SEQUENCES; k++){
+        const sequence_t *s = &sequences[k];
+        float errX = 0, errY = 0;
+        int valid = 0;
+        odometryReset();
+        for (t = 0; t < numFrames; t++){
+            render_floor(s, t);
+            loadRawImage(raw);
+            odomMotion_t m;
+            uint64_t t0 = now_ns();
+            odometryUpdate(frameUs, &m);
+            totalNs += now_ns() - t0;
+            totalFrames++;
+            if (m.valid){
+                // odometry runs at half resolution
+                errX += fabsf(m.lateral / 256.0f - s->lateral / 2);
+                errY += fabsf(m.forward / 256.0f - s->forward / 2);
+                valid++;
+            }
+        }
+        printf("%-16s %8.2f %8.2f %8.3f %8.3f %3d/%-3d\n", s->name, s->lateral / 2, s->forward / 2,
+            valid ? errX / valid : 0.0f, valid ? errY / valid : 0.0f, valid, numFrames - 1);
+    }
+    double ns = (double)totalNs / totalFrames;
+    printf("%dx%d search +-%d: %.0f ns/frame on this host, %.3f%% of a %u us frame\n",
+        ODOM_SIZEX, ODOM_SIZEY, ODOM_RANGE, ns, ns / (frameUs * 10.0), frameUs);
+}
+
+static int run_files(int count, char **files, uint32_t frameUs){
+    int i;
+    odometryReset();
+    for (i = 0; i < count; i++){
+        FILE *f = fopen(files[i], "rb");
+        if (!f || fread(raw, 1, FRAME_BYTES, f) != FRAME_BYTES){
+            fprintf(stderr, "could not read a %dx%d frame from %s\n", IMAGESIZEX, IMAGESIZEY, files[i]);
+            if (f){
+                fclose(f);
+            }
+            return 1;
+        }
+        fclose(f);
+        loadRawImage(raw);
+        odomMotion_t m;
+        odometryUpdate(frameUs, &m);
+        printf("%s lateral %.2f forward %.2f px/frame sad %u %s\n", files[i],
+            m.lateral / 256.0f, m.forward / 256.0f, m.sad, m.valid ? "" : "(invalid)");
+    }
+    return 0;
+}
+
+int main(int argc, char **argv){
+    int numFrames = 50;
+    int fps = 30;
+    int i;
+    for (i = 1; i < argc; i++){
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc){
+            numFrames = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-fps") == 0 && i + 1 < argc){
+            fps = atoi(argv[++i]);
+        } else {
+            break;
+        }
+    }
+    if (fps < 1){
+        fps = 1;
+    }
+    uint32_t frameUs = 1000000 / fps;
+    if (i < argc){
+        return run_files(argc - i, argv + i, frameUs);
+    }
+    run_synthetic(numFrames < 2 ? 2 : numFrames, frameUs);
+    return 0;
+}
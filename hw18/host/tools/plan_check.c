@@ -0,0 +1,322 @@
+// Checks the speed planner (speedplan.c) and the floor map under it
+// (ground.c) on frames the line simulator renders (sim_track.h), whose
+// camera is worked out separately, ray by ray.
+// - ground: the line seen at offsets and angles lands where it is on the
+//   floor, within 3 mm plus 2% of the distance ahead;
+// - curvature: on arcs of a known radius, both ways, and on a straight,
+//   within 25% and 1/2500 mm;
+// - speed: the lateral limit in a bend, the top speed on a straight and
+//   the climb back at the acceleration limit.
+// Then the time a frame's planning takes here. Prints ok or WRONG for
+// each check and exits non-zero on any WRONG.
+//
+// usage: plan_check [run.log]
+// With a frame log (framelog.h), the planner replays the run instead:
+// each frame's curvature and planned speed next to the speed the car was
+// driven at, and how long the run would have taken at the planned speeds
+// over the same ground.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "cam.h"
+#include "ground.h"
+#include "speedplan.h"
+#include "sim_track.h"
+#include "framelog.h"
+
+#define TOP_MMS 500.0f
+#define FULL_MMS 600.0f // full PWM, WHEEL_MAX_CPS counts of 0.1 mm
+#define WRAP 255
+#define CURVATURE_TOL (1 / 2500.0f) // a pixel's rounding in the far rows, 1/mm
+
+static uint8_t frame[IMAGESIZEX * IMAGESIZEY * 2];
+static int failures;
+
+static void check(int ok, const char *what){
+    printf("%-60s %s\n", what, ok ? "ok" : "WRONG");
+    failures += !ok;
+}
+
+// the planner's rows out of the frame, from the edge finder like hw18
+// does: it says when a row has no line
+static void detect_rows(const uint8_t *raw, int *cols){
+    int i;
+    loadRawImage(raw);
+    for (i = 0; i < PLAN_ROWS; i++){
+        cols[i] = findLineEdges(planRow(i), NULL);
+    }
+}
+
+// a straight line along x through 0, 0, the car off it and turned
+static int check_ground(){
+    simTrack_t t;
+    sim_track_default(&t);
+    t.noise = 0;
+    if (sim_track_make(&t, "S 4000") != 0){
+        return -1;
+    }
+    static const float offsets[] = {-40, -15, 0, 20, 45};
+    static const float angles[] = {-15, 0, 10};
+    float worst = -1e9f, worstMm = 0;
+    int o, a, i, points = 0;
+    for (o = 0; o < 5; o++){
+        for (a = 0; a < 3; a++){
+            float th = angles[a] * (float)M_PI / 180;
+            sim_track_render(&t, 1000, offsets[o], th, 0, frame);
+            int cols[PLAN_ROWS];
+            detect_rows(frame, cols);
+            for (i = 0; i < PLAN_ROWS; i++){
+                int32_t ahead, left;
+                if (cols[i] < 0 || groundPoint(planRow(i), cols[i], &ahead, &left) != 0){
+                    continue;
+                }
+                float x = (float)ahead / GROUND_ONE, y = (float)left / GROUND_ONE;
+                // where the line crosses the row's distance ahead, in the car's frame
+                float want = -(offsets[o] + x * sinf(th)) / cosf(th);
+                float err = fabsf(y - want) - 0.02f * x;
+                if (err > worst) worst = err;
+                if (fabsf(y - want) > worstMm) worstMm = fabsf(y - want);
+                points++;
+            }
+        }
+    }
+    sim_track_free(&t);
+    char what[96];
+    snprintf(what, sizeof(what), "ground: %d points, worst %.1f mm off", points, worstMm);
+    check(points > 100 && worst < 3, what);
+    return 0;
+}
+
+// on circles of the radii, + anticlockwise, a few frames round each
+static int check_curvature(){
+    static const float radii[] = {350, 500, 1000, -350, -500, -1000};
+    simTrack_t t;
+    int r, f;
+    char what[96];
+    for (r = 0; r < 6; r++){
+        char script[32];
+        snprintf(script, sizeof(script), "A %.0f %d", fabsf(radii[r]), radii[r] > 0 ? 360 : -360);
+        sim_track_default(&t);
+        if (sim_track_make(&t, script) != 0){
+            return -1;
+        }
+        // a few places round it, on the line and facing along it
+        float sum = 0;
+        int got = 0;
+        for (f = 0; f < 8; f++){
+            int p = t.points * f / 8, q = (p + 1) % t.points;
+            float heading = atan2f(t.y[q] - t.y[p], t.x[q] - t.x[p]);
+            sim_track_render(&t, t.x[p], t.y[p], heading, 0, frame);
+            int cols[PLAN_ROWS];
+            float curvature, fit;
+            detect_rows(frame, cols);
+            if (planCurvature(cols, &curvature, &fit) == 0){
+                sum += curvature;
+                got++;
+            }
+        }
+        sim_track_free(&t);
+        float radius = got ? got / sum : 0, want = 1 / radii[r];
+        snprintf(what, sizeof(what), "curvature: radius %.0f mm seen as %.0f mm, %d of 8 frames", radii[r], radius, got);
+        check(got >= 6 && fabsf(sum / got - want) < 0.25f * fabsf(want) + CURVATURE_TOL, what);
+    }
+    // too sharp to see from on the line, from inside it the line runs out
+    // of the side of the view
+    sim_track_default(&t);
+    if (sim_track_make(&t, "A 250 360") != 0){
+        return -1;
+    }
+    int cols[PLAN_ROWS], seen = 0, tighter = 0;
+    for (f = 0; f < 8; f++){
+        float curvature, fit;
+        sim_track_render(&t, 0, 15 + 5 * (f % 4), (f / 4) * 4 * (float)M_PI / 180, 0, frame);
+        detect_rows(frame, cols);
+        if (planCurvature(cols, &curvature, &fit) == 0){
+            seen++;
+            tighter += curvature > 1 / 500.0f;
+        }
+    }
+    sim_track_free(&t);
+    snprintf(what, sizeof(what), "curvature: radius 250 mm from inside, tighter than 500 %d of %d", tighter, seen);
+    check(seen >= 4 && tighter == seen, what);
+
+    sim_track_default(&t);
+    if (sim_track_make(&t, "S 4000") != 0){
+        return -1;
+    }
+    sim_track_render(&t, 1000, 0, 0, 0, frame);
+    float curvature = 1, fit = 0;
+    detect_rows(frame, cols);
+    int ok = planCurvature(cols, &curvature, &fit) == 0;
+    snprintf(what, sizeof(what), "curvature: straight seen as radius %.0f mm, fit %.1f mm", ok ? 1 / curvature : 0, fit);
+    check(ok && fabsf(curvature) < CURVATURE_TOL && fit < 2, what);
+    sim_track_free(&t);
+    return 0;
+}
+
+// the line through the rows' points as a circle of the radius, -1 no line
+static void circle_cols(float radius, int *cols){
+    int i;
+    for (i = 0; i < PLAN_ROWS; i++){
+        int32_t ahead, left;
+        int lo = 0, best = -1;
+        float bestErr = 1e9f;
+        for (lo = 0; lo < IMAGESIZEX; lo++){
+            groundPoint(planRow(i), lo, &ahead, &left);
+            float x = (float)ahead / GROUND_ONE, y = (float)left / GROUND_ONE;
+            float want = radius == 0 ? 0 : radius - copysignf(sqrtf(fmaxf(radius * radius - x * x, 0)), radius);
+            if (fabsf(y - want) < bestErr){
+                bestErr = fabsf(y - want);
+                best = lo;
+            }
+        }
+        cols[i] = bestErr < 5 ? best : -1;
+    }
+}
+
+static void check_speed(){
+    plan_t p;
+    planConfig_t cfg;
+    int cols[PLAN_ROWS];
+    char what[96];
+    planDefaultConfig(&cfg);
+    cfg.latAccel = 250; // 500 mm/s round 1 m
+    planInit(&p, &cfg);
+
+    circle_cols(0, cols);
+    float v = planSpeed(&p, cols, TOP_MMS, 0);
+    snprintf(what, sizeof(what), "speed: straight %.0f mm/s, top %.0f", v, TOP_MMS);
+    check(fabsf(v - TOP_MMS) < 1, what);
+
+    // a bend at once, then straight again
+    circle_cols(-600, cols);
+    v = planSpeed(&p, cols, TOP_MMS, 100000);
+    float want = sqrtf(cfg.latAccel * 600);
+    snprintf(what, sizeof(what), "speed: radius -600 mm %.0f mm/s, want %.0f", v, want);
+    check(fabsf(v - want) < 0.1f * want, what);
+    circle_cols(0, cols);
+    float v1 = planSpeed(&p, cols, TOP_MMS, 200000);
+    snprintf(what, sizeof(what), "speed: straight again %.0f mm/s after 0.1 s, want %.0f", v1,
+        fminf(v + cfg.accel * 0.1f, TOP_MMS));
+    check(fabsf(v1 - fminf(v + cfg.accel * 0.1f, TOP_MMS)) < 1, what);
+
+    // no line in most rows keeps the speed
+    int lost[PLAN_ROWS], i;
+    for (i = 0; i < PLAN_ROWS; i++){
+        lost[i] = i == PLAN_ROWS / 2 ? IMAGESIZEX / 2 : -1;
+    }
+    float v2 = planSpeed(&p, lost, TOP_MMS, 300000);
+    snprintf(what, sizeof(what), "speed: line lost %.0f mm/s, kept climbing from %.0f", v2, v1);
+    check(v2 > v1 && v2 <= TOP_MMS, what);
+
+    // a tighter one, and the floor under it
+    circle_cols(400, cols);
+    v = planSpeed(&p, cols, TOP_MMS, 400000);
+    want = sqrtf(cfg.latAccel * 400);
+    snprintf(what, sizeof(what), "speed: radius 400 mm %.0f mm/s, want %.0f", v, want);
+    check(fabsf(v - want) < 0.1f * want, what);
+    p.cfg.minMmS = 350;
+    v = planSpeed(&p, cols, TOP_MMS, 500000);
+    snprintf(what, sizeof(what), "speed: radius 400 mm %.0f mm/s, floor 350", v);
+    check(fabsf(v - 350) < 1, what);
+    cfg.latAccel = 0;
+    planInit(&p, &cfg);
+    v = planSpeed(&p, cols, TOP_MMS, 0);
+    snprintf(what, sizeof(what), "speed: not planning %.0f mm/s", v);
+    check(v == TOP_MMS, what);
+}
+
+static void time_plan(){
+    plan_t p;
+    planConfig_t cfg;
+    int cols[PLAN_ROWS], i;
+    planDefaultConfig(&cfg);
+    planInit(&p, &cfg);
+    circle_cols(400, cols);
+    struct timespec a, b;
+    volatile float sink = 0;
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    for (i = 0; i < 1000000; i++){
+        sink += planSpeed(&p, cols, TOP_MMS, (uint64_t)i * 10000);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    (void)sink;
+    printf("planning a frame: %.0f ns here\n", ((b.tv_sec - a.tv_sec) * 1e9 + (b.tv_nsec - a.tv_nsec)) / 1e6);
+}
+
+// the planner over a recorded run, next to what the car did
+static int replay(const char *path){
+    framelogReader_t r;
+    if (framelogOpen(&r, path) != 0){
+        return 1;
+    }
+    if (r.header->width != IMAGESIZEX || r.header->height != IMAGESIZEY){
+        fprintf(stderr, "%s: %ux%u frames, built for %dx%d\n", path, r.header->width, r.header->height, IMAGESIZEX,
+            IMAGESIZEY);
+        framelogClose(&r);
+        return 1;
+    }
+    plan_t p;
+    planConfig_t cfg;
+    planDefaultConfig(&cfg);
+    planInit(&p, &cfg);
+    uint8_t *raw = malloc(IMAGESIZEX * IMAGESIZEY * 2);
+    double drivenS = 0, plannedS = 0, ground = 0;
+    uint32_t i, used = 0;
+    printf("frame      s  radius mm  fit mm  planned mm/s  driven mm/s\n");
+    for (i = 0; i < r.frames; i++){
+        const framelogEntry_t *e = framelogEntry(&r, i);
+        if (framelogReadCamera(&r, i, raw) != 0){
+            continue;
+        }
+        int cols[PLAN_ROWS];
+        detect_rows(raw, cols);
+        float v = planSpeed(&p, cols, TOP_MMS, e->timeUs);
+        float driven = -1;
+        if (e->leftPwm != FRAMELOG_NO_VALUE && i + 1 < r.frames){
+            driven = (e->leftPwm + e->rightPwm) / 2.0f * FULL_MMS / WRAP;
+            // the same ground at the planned speed
+            double dt = (framelogEntry(&r, i + 1)->timeUs - e->timeUs) / 1e6;
+            if (driven > 0){
+                drivenS += dt;
+                plannedS += dt * driven / v;
+                ground += dt * driven;
+                used++;
+            }
+        }
+        printf("%5u %7.2f %10.0f %7.1f %13.0f %12.0f\n", i, e->timeUs / 1e6,
+            p.curvature != 0 ? 1 / p.curvature : 0, p.fitMm, v, driven);
+    }
+    if (used){
+        printf("%.0f mm over %u frames: driven in %.2f s, %.2f s at the planned speeds (top %.0f mm/s)\n", ground, used,
+            drivenS, plannedS, TOP_MMS);
+    } else {
+        printf("no PWM in the log, nothing to compare the planned speeds with\n");
+    }
+    free(raw);
+    framelogClose(&r);
+    return 0;
+}
+
+int main(int argc, char **argv){
+    groundCamera_t cam;
+    groundDefaultCamera(&cam);
+    groundInit(&cam);
+    simCamera_t simCam;
+    sim_camera_default(&simCam);
+    sim_camera_setup(&simCam);
+    if (argc > 1){
+        return replay(argv[1]);
+    }
+
+    if (check_ground() != 0 || check_curvature() != 0){
+        fprintf(stderr, "can't make the test tracks\n");
+        return 1;
+    }
+    check_speed();
+    time_plan();
+    return failures ? 1 : 0;
+}
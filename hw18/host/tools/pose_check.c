@@ -0,0 +1,169 @@
+// Checks the pose estimator (pose.c) against the simulated car. Motion
+// scripts drive the wheel loops on the simulated motors at the steering
+// rate, and two estimates follow along: one on the encoder counts, one on
+// the PWM through the motor model. The truth is the simulator's wheel
+// positions integrated in doubles every 100 us. Then the fixed point sin
+// and cos, and blending in a heading.
+//
+// usage: pose_check
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "pico/stdlib.h"
+#include "encoder.h"
+#include "wheel.h"
+#include "pose.h"
+#include "motion.h"
+#include "sim_encoder.h"
+
+#define WRAP 255
+#define TICK_US 2000
+#define STEPS 20 // truth steps per tick
+#define MM_PER_COUNT 0.1
+#define TRACK_MM 120.0
+
+static int pwm_left, pwm_right;
+
+static void output(int left, int right){
+    sim_encoder_output(left, right);
+    pwm_left = left;
+    pwm_right = right;
+}
+
+// the true pose, mm and radians
+static double true_x, true_y, true_theta, true_left, true_right;
+
+static void truth_step(){
+    sim_encoder_advance();
+    double l = (simEncoder.wheel[ENCODER_LEFT].position - true_left) * MM_PER_COUNT;
+    double r = (simEncoder.wheel[ENCODER_RIGHT].position - true_right) * MM_PER_COUNT;
+    true_left = simEncoder.wheel[ENCODER_LEFT].position;
+    true_right = simEncoder.wheel[ENCODER_RIGHT].position;
+    double turn = (r - l) / TRACK_MM;
+    true_x += (l + r) / 2 * cos(true_theta + turn / 2);
+    true_y += (l + r) / 2 * sin(true_theta + turn / 2);
+    true_theta += turn;
+}
+
+typedef struct errors {
+    double pos, heading; // worst along the way, mm and degrees
+} errors_t;
+
+static void compare(const pose_t *p, errors_t *e){
+    poseState_t s;
+    poseRead(p, &s);
+    double dx = s.x / 1000.0 - true_x, dy = s.y / 1000.0 - true_y;
+    double dh = remainder(s.theta * (2 * M_PI / POSE_TURN) - true_theta, 2 * M_PI) * 180 / M_PI;
+    if (hypot(dx, dy) > e->pos) e->pos = hypot(dx, dy);
+    if (fabs(dh) > e->heading) e->heading = fabs(dh);
+}
+
+// drive a script, the worst errors of both estimates
+static void drive(const char *script, float battery, errors_t *counts, errors_t *model, double *length){
+    wheelGains_t g;
+    wheelDefaultGains(&g);
+    encoderInit();
+    simEncoder.battery = battery;
+    wheelInit(&g, WRAP, output);
+    motionConfig_t mc;
+    motionDefaultConfig(&mc);
+    mc.outputScale = WRAP;
+    motionInit(&mc);
+    poseConfig_t pc;
+    poseDefaultConfig(&pc);
+    static pose_t enc, mod;
+    poseReset(&enc, &pc);
+    poseReset(&mod, &pc);
+    true_x = true_y = true_theta = 0;
+    true_left = true_right = 0;
+    pwm_left = pwm_right = 0;
+    counts->pos = counts->heading = model->pos = model->heading = 0;
+    *length = 0;
+
+    motionParse(script);
+    int t;
+    for(t=0;t<30000 && motionBusy();t++){
+        int left = 0, right = 0;
+        uint64_t now = time_us_64();
+        motionTick(now, &left, &right);
+        wheelDrive(left, right);
+        poseUpdateCounts(&enc, encoderCount(ENCODER_LEFT), encoderCount(ENCODER_RIGHT), now);
+        poseUpdatePwm(&mod, pwm_left, pwm_right, now);
+        compare(&enc, counts);
+        compare(&mod, model);
+        int i;
+        double before = true_left + true_right;
+        for(i=0;i<STEPS;i++){
+            sleep_us(TICK_US / STEPS);
+            truth_step();
+        }
+        *length += fabs(true_left + true_right - before) / 2 * MM_PER_COUNT;
+    }
+}
+
+static int check_paths(){
+    static const char *scripts[] = {
+        "S 500;T -90;S 500;T -90;S 500;T -90;S 500;T -90",
+        "A 300 360",
+        "A 250 360;A 250 -360",
+        "S 2000;T 180;S 2000;T 180",
+    };
+    int i, bad = 0;
+    printf("path                                              mm    encoders mm deg    model mm deg    flat battery model mm deg\n");
+    for(i=0;i<4;i++){
+        errors_t enc, mod, flatEnc, flatMod;
+        double length, flatLength;
+        drive(scripts[i], 1.0f, &enc, &mod, &length);
+        drive(scripts[i], 0.8f, &flatEnc, &flatMod, &flatLength);
+        // the encoders see everything but a part count, the model only
+        // knows the PWM so a few % of the way, more on a flat battery
+        int ok = enc.pos < 1.0 && enc.heading < 0.5 && flatEnc.pos < 1.0
+            && mod.pos < length * 0.02 && mod.heading < 2;
+        printf("%-48s  %5.0f  %11.2f %5.2f  %8.1f %5.2f  %18.1f %5.2f  %s\n", scripts[i], length, enc.pos, enc.heading,
+            mod.pos, mod.heading, flatMod.pos, flatMod.heading, ok ? "ok" : "WRONG");
+        bad += !ok;
+    }
+    return bad;
+}
+
+static int check_trig(){
+    double worst = 0;
+    uint32_t a;
+    for(a=0;a<0xFFFF0000u;a+=0x10001u){
+        double angle = a * (2 * M_PI / POSE_TURN);
+        double es = fabs(poseSin(a) / 32768.0 - sin(angle));
+        double ec = fabs(poseCos(a) / 32768.0 - cos(angle));
+        if (es > worst) worst = es;
+        if (ec > worst) worst = ec;
+    }
+    int ok = worst < 1e-4;
+    printf("sin/cos: worst error %.6f, %s\n", worst, ok ? "ok" : "WRONG");
+    return !ok;
+}
+
+// blending in a heading goes the short way round the wrap
+static int check_fuse(){
+    poseConfig_t pc;
+    poseDefaultConfig(&pc);
+    pose_t p;
+    poseReset(&p, &pc);
+    p.theta = (uint32_t)(POSE_TURN * 350 / 360);
+    int i;
+    for(i=0;i<40;i++){
+        poseFuseHeading(&p, (uint32_t)(POSE_TURN * 10 / 360), 32);
+    }
+    poseState_t s;
+    poseRead(&p, &s);
+    int ok = abs(s.headingMdeg - 10000) < 100;
+    printf("heading fused from 350 towards 10 deg: %.2f deg, %s\n", s.headingMdeg / 1000.0, ok ? "ok" : "WRONG");
+    return !ok;
+}
+
+int main(){
+    int bad = check_trig();
+    bad += check_fuse();
+    bad += check_paths();
+    printf("%s\n", bad ? "pose check FAILED" : "pose check passed");
+    return bad ? 1 : 0;
+}
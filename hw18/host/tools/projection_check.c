@@ -0,0 +1,146 @@
+// Checks the row projection the capture ISR computes against findLine()
+// on the same frames. Each frame is clocked through the real ISR by the
+// simulated sensor with LINE_DETECTOR_PROJECTION on, then loaded into
+// cameraData and run through convertImage() and findLine() row by row.
+// Random frames are also run with random flat field gains.
+// Exits non-zero on any mismatch.
+//
+// usage: projection_check [-n random frames] [raw frames...]
+// Without files the 80x60 corpus frames are used.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "pico/stdlib.h"
+#include "cam.h"
+#include "sim_sensor.h"
+
+#define FRAME_BYTES (IMAGESIZEX*IMAGESIZEY*2)
+
+static const char *corpus[] = {"straight", "curved", "crossing", "lowlight", "glare"};
+
+static uint64_t now_ns(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static int read_frame(const char *path, uint8_t *frame){
+    FILE *f = fopen(path, "rb");
+    if (!f){
+        perror(path);
+        return -1;
+    }
+    size_t n = fread(frame, 1, FRAME_BYTES, f);
+    fclose(f);
+    if (n != FRAME_BYTES){
+        fprintf(stderr, "%s: expected %d bytes\n", path, FRAME_BYTES);
+        return -1;
+    }
+    return 0;
+}
+
+static int rows_checked = 0, mismatches = 0;
+static uint64_t post_ns = 0;
+
+// one frame through both paths, returns the mismatches
+static int check_frame(const char *name, const uint8_t *frame){
+    int row, bad = 0;
+    simSensor.frame = frame;
+    setLineDetector(LINE_DETECTOR_PROJECTION);
+    if (captureFrame(NULL) != CAPTURE_OK){
+        fprintf(stderr, "%s: capture failed\n", name);
+        return 1;
+    }
+    int rows = getProjectionRows();
+    int16_t proj[IMAGESIZEY];
+    for (row = 0; row < rows; row++){
+        proj[row] = findLineProjection(row);
+    }
+
+    // what the stored frame path does after the last HS
+    setLineDetector(LINE_DETECTOR_CENTROID);
+    loadRawImage(frame);
+    uint64_t t0 = now_ns();
+    convertImage();
+    int ref[IMAGESIZEY];
+    for (row = 0; row < IMAGESIZEY; row++){
+        ref[row] = findLine(row);
+    }
+    post_ns += now_ns() - t0;
+
+    for (row = 0; row < rows; row++){
+        if (proj[row] != ref[row]){
+            if (bad == 0){
+                fprintf(stderr, "%s row %d: projection %d, findLine %d\n", name, row, proj[row], ref[row]);
+            }
+            bad++;
+        }
+    }
+    rows_checked += rows;
+    return bad;
+}
+
+int main(int argc, char **argv){
+    static uint8_t frame[FRAME_BYTES];
+    int numRandom = 50;
+    int frames = 0;
+    int i, j;
+    int files = 0;
+
+    init_camera_pins();
+    sim_sensor_install();
+
+    for (i = 1; i < argc; i++){
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc){
+            numRandom = atoi(argv[++i]);
+        } else {
+            files++;
+            if (read_frame(argv[i], frame) != 0){
+                return 1;
+            }
+            mismatches += check_frame(argv[i], frame);
+            frames++;
+        }
+    }
+    if (files == 0){
+        for (i = 0; i < (int)(sizeof(corpus) / sizeof(corpus[0])); i++){
+            char path[512];
+            snprintf(path, sizeof(path), "%s/%s_%dx%d.raw", CORPUS_DIR, corpus[i], IMAGESIZEX, IMAGESIZEY);
+            if (read_frame(path, frame) != 0){
+                return 1;
+            }
+            mismatches += check_frame(corpus[i], frame);
+            frames++;
+        }
+    }
+    // random bytes hit every threshold corner case, the second time round
+    // with random flat field gains too
+    static uint8_t gains[IMAGESIZEX*IMAGESIZEY];
+    uint32_t seed = 1;
+    int pass;
+    for (pass = 0; pass < 2; pass++){
+        for (j = 0; j < IMAGESIZEX*IMAGESIZEY; j++){
+            seed = seed * 1664525u + 1013904223u;
+            gains[j] = 1 + (seed >> 24) % 255;
+        }
+        setFlatField(pass ? gains : NULL);
+        for (i = 0; i < numRandom; i++){
+            for (j = 0; j < FRAME_BYTES; j++){
+                seed = seed * 1664525u + 1013904223u;
+                frame[j] = (uint8_t)(seed >> 24);
+            }
+            mismatches += check_frame(pass ? "random, flat field" : "random", frame);
+            frames++;
+        }
+    }
+    setFlatField(NULL);
+
+    printf("%d frames, %d rows compared, %d mismatches\n", frames, rows_checked, mismatches);
+    printf("stored frame: %d bytes, convertImage + findLine after the last HS %llu ns per frame on this host\n",
+        FRAME_BYTES + IMAGESIZEX*IMAGESIZEY*3, (unsigned long long)(post_ns / (frames ? frames : 1)));
+    printf("projection: %d bytes of row state, rows are ready when the last HS lands\n",
+        (int)(IMAGESIZEX * sizeof(uint16_t) + IMAGESIZEY * sizeof(int16_t)));
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,315 @@
+// Checks the pure pursuit steering (pursuit.c), its fixed point against
+// the same sums in double, and the whole of it on frames the line
+// simulator renders (sim_track.h):
+// - lookahead: the minimum standing still, growing with speed, capped;
+// - target: where points on a line and on an arc cross the lookahead
+//   circle, and the nearest or furthest point when they don't;
+// - curvature and turn: within 0.5% of the float formulas, the turn's
+//   sign the way steerMix() takes it, under 2 turning on the spot;
+// - frames: on circles of a known radius the arc aimed along is the
+//   circle itself, within 15%;
+// - edge: a line going out of the side of the view turns the car harder
+//   and, until it's back in the near rows, towards that edge;
+// - a car put 40 mm off a straight line and driven on the pursuit's
+//   curvature comes back to it without swinging past.
+// Then the time a frame's steering takes here. Prints ok or WRONG for
+// each check and exits non-zero on any WRONG.
+//
+// usage: pursuit_check
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "cam.h"
+#include "ground.h"
+#include "speedplan.h"
+#include "pursuit.h"
+#include "sim_track.h"
+
+#define MM(v) ((int32_t)lround((v) * GROUND_ONE))
+#define TO_MM(v) ((double)(v) / GROUND_ONE)
+#define CURVATURE(k) ((double)(k) / (1 << PURSUIT_SHIFT))
+
+static uint8_t frame[IMAGESIZEX * IMAGESIZEY * 2];
+static int failures;
+
+static void check(int ok, const char *what){
+    printf("%-60s %s\n", what, ok ? "ok" : "WRONG");
+    failures += !ok;
+}
+
+static void check_lookahead(){
+    pursuitConfig_t cfg;
+    char what[96];
+    pursuitDefaultConfig(&cfg);
+    static const int32_t speeds[] = {-100, 0, 200, 400, 3000};
+    int i;
+    for (i = 0; i < 5; i++){
+        double want = cfg.lookMinMm + (speeds[i] > 0 ? speeds[i] * cfg.lookMs / 1000.0 : 0);
+        if (want > cfg.lookMaxMm) want = cfg.lookMaxMm;
+        double got = TO_MM(pursuitLookahead(&cfg, speeds[i]));
+        snprintf(what, sizeof(what), "lookahead: %ld mm/s %.0f mm, want %.0f", (long)speeds[i], got, want);
+        check(fabs(got - want) < 1, what);
+    }
+}
+
+// points every 17 mm ahead from 140 to 310, like the camera's rows
+static int line_points(double offset, double slope, double radius, int32_t *ahead, int32_t *left){
+    int n = 0;
+    double x;
+    for (x = 140; x <= 310; x += 17){
+        double y = offset + slope * x;
+        if (radius != 0){
+            // a circle tangent to the car's heading, offset sideways
+            y = offset + radius - copysign(sqrt(fmax(radius * radius - x * x, 0)), radius);
+        }
+        ahead[n] = MM(x);
+        left[n] = MM(y);
+        n++;
+    }
+    return n;
+}
+
+static void check_target(){
+    int32_t ahead[16], left[16], ta, tl;
+    char what[96];
+    int n, ok;
+
+    // a straight line 30 mm to the right, the circle crosses it at
+    // sqrt(l^2 - 30^2) ahead
+    n = line_points(-30, 0, 0, ahead, left);
+    ok = pursuitTarget(ahead, left, n, MM(220), &ta, &tl) == 0;
+    double wantX = sqrt(220.0 * 220 - 30 * 30);
+    snprintf(what, sizeof(what), "target: line 30 mm right at %.1f, %.1f, want %.1f, -30", TO_MM(ta), TO_MM(tl), wantX);
+    check(ok && fabs(TO_MM(ta) - wantX) < 1 && fabs(TO_MM(tl) + 30) < 0.1, what);
+
+    // an arc of 400 mm to the left through the axle
+    n = line_points(0, 0, 400, ahead, left);
+    ok = pursuitTarget(ahead, left, n, MM(250), &ta, &tl) == 0;
+    // on the circle x^2 + (y - r)^2 = r^2 with x^2 + y^2 = l^2, y = l^2 / 2r
+    double wantY = 250.0 * 250 / 800;
+    wantX = sqrt(250.0 * 250 - wantY * wantY);
+    double off = fabs(hypot(TO_MM(ta), TO_MM(tl)) - 250);
+    snprintf(what, sizeof(what), "target: arc 400 mm left at %.1f, %.1f, want %.1f, %.1f", TO_MM(ta), TO_MM(tl), wantX, wantY);
+    check(ok && fabs(TO_MM(ta) - wantX) < 1 && fabs(TO_MM(tl) - wantY) < 1 && off < 1, what);
+
+    n = line_points(10, 0, 0, ahead, left);
+    ok = pursuitTarget(ahead, left, n, MM(100), &ta, &tl) == 0;
+    snprintf(what, sizeof(what), "target: circle inside the view, the nearest point %.0f mm", TO_MM(ta));
+    check(ok && ta == ahead[0] && tl == left[0], what);
+    ok = pursuitTarget(ahead, left, n, MM(400), &ta, &tl) == 0;
+    snprintf(what, sizeof(what), "target: circle beyond the view, the furthest point %.0f mm", TO_MM(ta));
+    check(ok && ta == ahead[n - 1] && tl == left[n - 1], what);
+    check(pursuitTarget(ahead, left, 0, MM(200), &ta, &tl) == -1, "target: no points, none");
+}
+
+static void check_curvature(){
+    char what[96];
+    double worst = 0;
+    int a, l;
+    for (a = 60; a <= 400; a += 20){
+        for (l = -160; l <= 160; l += 8){
+            int32_t k = pursuitCurvature(MM(a), MM(l));
+            double want = 2.0 * l / ((double)a * a + (double)l * l);
+            // and the last bit's rounding on the gentlest
+            double err = (fabs(CURVATURE(k) - want) - 1.0 / (1 << PURSUIT_SHIFT)) / fabs(want ? want : 1);
+            if (err > worst) worst = err;
+        }
+    }
+    snprintf(what, sizeof(what), "curvature: 2 y / d^2, worst %.3f%% off", worst * 100);
+    check(worst < 0.005, what);
+
+    static const double radii[] = {80, 150, 400, 1500, 8000, -80, -400, -8000};
+    int r, ok = 1;
+    worst = 0;
+    for (r = 0; r < 8; r++){
+        int32_t k = (int32_t)lround((1 << PURSUIT_SHIFT) / radii[r]);
+        double w = 120 / fabs(radii[r]);
+        double want = w / (1 + w / 2);
+        double got = (double)pursuitTurn(k, 120) / PURSUIT_TURN_ONE;
+        // left, + radius, slows the left wheel: negative
+        ok &= radii[r] > 0 ? got < 0 : got > 0;
+        double err = fabs(fabs(got) - want) / want;
+        if (err > worst) worst = err;
+    }
+    snprintf(what, sizeof(what), "turn: k w / (1 + k w / 2), worst %.3f%% off, signs %s", worst * 100, ok ? "right" : "wrong");
+    check(ok && worst < 0.005, what);
+    // turning on the spot the inner wheel goes backwards as fast
+    double spin = -(double)pursuitTurn(1 << PURSUIT_SHIFT, 120) / PURSUIT_TURN_ONE;
+    snprintf(what, sizeof(what), "turn: radius 1 mm %.2f of a wheel, under 2", spin);
+    check(spin > 1.9 && spin < 2, what);
+    check(pursuitTurn(0, 120) == 0, "turn: straight, none");
+}
+
+// the planner's rows out of the frame, from the edge finder like hw18 does
+static void detect_rows(const uint8_t *raw, int *cols){
+    int i;
+    loadRawImage(raw);
+    for (i = 0; i < PLAN_ROWS; i++){
+        cols[i] = findLineEdges(planRow(i), NULL);
+    }
+}
+
+// on the line and along it, the arc the pursuit aims along is the circle
+static int check_frames(){
+    static const float radii[] = {500, 1000, -500, -1000};
+    pursuitConfig_t cfg;
+    pursuit_t p;
+    simTrack_t t;
+    char what[96];
+    int r, f;
+    pursuitDefaultConfig(&cfg);
+    pursuitInit(&p, &cfg);
+    for (r = 0; r < 4; r++){
+        char script[32];
+        snprintf(script, sizeof(script), "A %.0f %d", fabsf(radii[r]), radii[r] > 0 ? 360 : -360);
+        sim_track_default(&t);
+        if (sim_track_make(&t, script) != 0){
+            return -1;
+        }
+        double sum = 0;
+        int got = 0;
+        for (f = 0; f < 8; f++){
+            int i = t.points * f / 8, j = (i + 1) % t.points;
+            float heading = atan2f(t.y[j] - t.y[i], t.x[j] - t.x[i]);
+            int cols[PLAN_ROWS];
+            sim_track_render(&t, t.x[i], t.y[i], heading, 0, frame);
+            detect_rows(frame, cols);
+            if (pursuitSteer(&p, cols, 300) == 0){
+                sum += CURVATURE(p.curvature);
+                got++;
+            }
+        }
+        sim_track_free(&t);
+        double want = 1 / radii[r];
+        snprintf(what, sizeof(what), "frames: radius %.0f mm steered at %.0f mm, %d of 8", radii[r], got ? got / sum : 0, got);
+        check(got >= 6 && fabs(sum / got - want) < 0.15 * fabs(want), what);
+    }
+    // a straight, and the line gone keeps the last
+    sim_track_default(&t);
+    if (sim_track_make(&t, "S 4000") != 0){
+        return -1;
+    }
+    int cols[PLAN_ROWS], ok;
+    sim_track_render(&t, 1000, 0, 0, 0, frame);
+    detect_rows(frame, cols);
+    ok = pursuitSteer(&p, cols, 300) == 0;
+    snprintf(what, sizeof(what), "frames: straight, turn %.4f of a wheel", (double)p.turn / PURSUIT_TURN_ONE);
+    check(ok && abs(p.turn) < PURSUIT_TURN_ONE / 100, what);
+    int32_t last = p.turn;
+    for (f = 0; f < PLAN_ROWS; f++){
+        cols[f] = -1;
+    }
+    ok = pursuitSteer(&p, cols, 300) == -1;
+    check(ok && p.turn == last && p.points == 0, "frames: no line, the last turn kept");
+    sim_track_free(&t);
+    return 0;
+}
+
+// the line going out of the left of the view in the near rows: aimed
+// where it went out, then at the edge while it's gone, whatever the far
+// rows find
+static void check_edge(){
+    pursuitConfig_t cfg;
+    pursuit_t p;
+    char what[96];
+    int cols[PLAN_ROWS], i;
+    pursuitDefaultConfig(&cfg);
+    pursuitInit(&p, &cfg);
+    for (i = 0; i < PLAN_ROWS; i++){
+        cols[i] = -1;
+    }
+    cols[PLAN_ROWS - 1] = 4;
+    cols[PLAN_ROWS - 2] = 2;
+    int32_t a, l;
+    groundPoint(planRow(PLAN_ROWS - 3), 0, &a, &l);
+    int ok = pursuitSteer(&p, cols, 300) == 0;
+    snprintf(what, sizeof(what), "edge: going out, radius %.0f mm, at the left edge past it", 1 / CURVATURE(p.curvature));
+    check(ok && p.side > 0 && p.targetAhead == a && p.targetLeft == l, what);
+
+    for (i = 0; i < PLAN_ROWS; i++){
+        cols[i] = -1;
+    }
+    cols[2] = IMAGESIZEX * 3 / 4; // something on the right, far up
+    groundPoint(planRow(PLAN_ROWS - 1), 0, &a, &l);
+    ok = pursuitSteer(&p, cols, 300) == 0;
+    snprintf(what, sizeof(what), "edge: gone, radius %.0f mm, at the left edge", 1 / CURVATURE(p.curvature));
+    check(ok && p.side > 0 && p.targetAhead == a && p.targetLeft == l, what);
+
+    for (i = 0; i < PLAN_ROWS; i++){
+        cols[i] = IMAGESIZEX / 2;
+    }
+    ok = pursuitSteer(&p, cols, 300) == 0;
+    check(ok && p.side == 0 && abs(p.turn) < PURSUIT_TURN_ONE / 100, "edge: back in the near rows, steered on again");
+}
+
+// a car 40 mm left of the line along x, facing along it, driven at
+// 300 mm/s on the curvature, a new one each 20 ms
+static void check_converge(){
+    pursuitConfig_t cfg;
+    char what[96];
+    pursuitDefaultConfig(&cfg);
+    double y = 40, th = 0, worstPast = 0;
+    int step;
+    for (step = 0; step < 200; step++){
+        int32_t ahead[16], left[16], ta, tl;
+        int n = 0;
+        double x;
+        // the line's points in the car's frame, at the rows' distances ahead
+        for (x = 140; x <= 310; x += 17){
+            ahead[n] = MM(x);
+            left[n] = MM(-(y + x * sin(th)) / cos(th));
+            n++;
+        }
+        pursuitTarget(ahead, left, n, pursuitLookahead(&cfg, 300), &ta, &tl);
+        double k = CURVATURE(pursuitCurvature(ta, tl));
+        double ds = 300 * 0.02;
+        th += k * ds;
+        y += ds * sin(th);
+        if (-y > worstPast) worstPast = -y;
+    }
+    snprintf(what, sizeof(what), "converge: 40 mm off, %.1f mm after 4 s, %.1f mm past", y, worstPast);
+    check(fabs(y) < 2 && worstPast < 4, what);
+}
+
+static void check_time(){
+    pursuitConfig_t cfg;
+    pursuit_t p;
+    int cols[PLAN_ROWS], i, rounds = 200000;
+    pursuitDefaultConfig(&cfg);
+    pursuitInit(&p, &cfg);
+    for (i = 0; i < PLAN_ROWS; i++){
+        cols[i] = IMAGESIZEX / 2 + i;
+    }
+    struct timespec a, b;
+    clock_gettime(CLOCK_MONOTONIC, &a);
+    for (i = 0; i < rounds; i++){
+        cols[i % PLAN_ROWS] ^= 1;
+        pursuitSteer(&p, cols, i & 511);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &b);
+    double ns = ((b.tv_sec - a.tv_sec) * 1e9 + (b.tv_nsec - a.tv_nsec)) / rounds;
+    printf("steering a frame: %.0f ns here\n", ns);
+}
+
+int main(){
+    groundCamera_t cam;
+    groundDefaultCamera(&cam);
+    groundInit(&cam);
+    simCamera_t simCam;
+    sim_camera_default(&simCam);
+    sim_camera_setup(&simCam);
+    check_lookahead();
+    check_target();
+    check_curvature();
+    if (check_frames() != 0){
+        printf("bad track script\n");
+        return 1;
+    }
+    check_edge();
+    check_converge();
+    check_time();
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,76 @@
+// Simulated motors and encoders, see sim_encoder.h.
+
+#include <math.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "sim_encoder.h"
+
+simEncoder_t simEncoder;
+
+void sim_encoder_reset(){
+    memset(&simEncoder, 0, sizeof(simEncoder));
+    simEncoder.maxCps = 6000;
+    simEncoder.battery = 1;
+    simEncoder.friction = 0.06f;
+    simEncoder.tauS = 0.06f;
+    simEncoder.phaseError = 0.1f;
+    simEncoder.wrap = 255;
+    simEncoder.lastUs = time_us_64();
+}
+
+// speed the motor settles at for its duty
+static float steady_cps(float duty){
+    float drive = duty * simEncoder.battery;
+    if (fabsf(drive) <= simEncoder.friction){
+        return 0;
+    }
+    drive += drive > 0 ? -simEncoder.friction : simEncoder.friction;
+    return drive * simEncoder.maxCps;
+}
+
+// run the wheels up to the stub's clock, exactly for a first order lag
+void sim_encoder_advance(){
+    uint64_t now = time_us_64();
+    double dt = (double)(now - simEncoder.lastUs) * 1e-6;
+    simEncoder.lastUs = now;
+    int i;
+    for(i=0;i<ENCODER_WHEELS;i++){
+        simWheel_t *w = &simEncoder.wheel[i];
+        if (simEncoder.fixedSpeed){
+            w->position += w->cps * dt;
+            continue;
+        }
+        double target = steady_cps(w->duty);
+        double decay = exp(-dt / simEncoder.tauS);
+        w->position += target * dt + (w->cps - target) * simEncoder.tauS * (1 - decay);
+        w->cps = (float)(target + (w->cps - target) * decay);
+    }
+}
+
+// wheelOutput_t for the wheel loops
+void sim_encoder_output(int left, int right){
+    sim_encoder_advance();
+    simEncoder.wheel[ENCODER_LEFT].duty = (float)left / simEncoder.wrap;
+    simEncoder.wheel[ENCODER_RIGHT].duty = (float)right / simEncoder.wrap;
+}
+
+// where edge k really is: the A and B edges sit a little off a quarter cycle
+static double edge_at(int32_t k){
+    static const int offset[4] = {0, 1, 0, -1};
+    return k + offset[k & 3] * simEncoder.phaseError;
+}
+
+int encoderInit(){
+    sim_encoder_reset();
+    return 0;
+}
+
+int32_t encoderCount(int wheel){
+    sim_encoder_advance();
+    double pos = simEncoder.wheel[wheel].position;
+    int32_t k = (int32_t)floor(pos) + 1;
+    while (edge_at(k) > pos){
+        k--;
+    }
+    return k;
+}
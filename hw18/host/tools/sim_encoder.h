@@ -0,0 +1,38 @@
+#ifndef SIM_ENCODER_h
+#define SIM_ENCODER_h
+
+#include <stdint.h>
+#include "encoder.h"
+
+// Simulated drive motors and wheel encoders for host tools, behind the
+// same encoderInit()/encoderCount() the firmware's PIO decoder has. The
+// wheels turn on the stub SDK's clock: each motor is a first order lag
+// towards a speed set by its duty, the battery and a friction deadband,
+// and the count is integrated up to now whenever it's read. Edges can be
+// unevenly spaced like a real encoder's phases.
+
+typedef struct simWheel {
+    float duty; // -1 to 1
+    float cps; // true speed, counts per second
+    double position; // counts
+} simWheel_t;
+
+typedef struct simEncoder {
+    float maxCps; // speed at full duty and a full battery
+    float battery; // 1 is full, speed scales with it
+    float friction; // duty lost to friction, nothing moves below it
+    float tauS; // motor time constant
+    float phaseError; // edges off their even spacing, in counts
+    int wrap; // full PWM for simEncoderOutput()
+    int fixedSpeed; // 1: wheels keep wheel[].cps whatever the duty
+    simWheel_t wheel[ENCODER_WHEELS];
+    uint64_t lastUs;
+} simEncoder_t;
+
+extern simEncoder_t simEncoder;
+
+void sim_encoder_reset();
+void sim_encoder_output(int left, int right);
+void sim_encoder_advance();
+
+#endif
@@ -0,0 +1,143 @@
+#include <stdlib.h>
+#include "pico/stdlib.h"
+#include "hardware/pwm.h"
+#include "hardware/i2c.h"
+#include "hardware/clocks.h"
+#include "cam.h"
+#include "sim_sensor.h"
+
+// the firmware never writes this to COM7, so it marks a locked up sensor
+// until init_camera()'s software reset overwrites it
+#define SIM_LOCKED_COM7 0xFF
+
+simSensor_t simSensor = {
+    .limitHz = 1500000,
+    .stuckLine = -1,
+};
+
+static uint32_t rng = 99;
+
+static double uniform(){
+    rng = rng * 1664525u + 1013904223u;
+    return (rng >> 8) / 16777216.0;
+}
+
+// the 8 OV7670 bars in RGB565: white yellow cyan green magenta red blue black
+static const uint16_t bars[8] = {0xFFFF, 0xFFE0, 0x07FF, 0x07E0, 0xF81F, 0xF800, 0x001F, 0x0000};
+
+void sim_sensor_install(){
+    hal_set_idle_hook(sim_sensor_frame);
+}
+
+static uint32_t sim_internal_hz(){
+    uint32_t sysHz = clock_get_hz(clk_sys);
+    float div = hal_pwm_get_clkdiv(pwm_gpio_to_slice_num(MCLK));
+    uint32_t period = hal_pwm_get_wrap(pwm_gpio_to_slice_num(MCLK)) + 1;
+    uint32_t mclk = (uint32_t)(sysHz / (div > 0 ? div : 1) / period);
+    return clockplanInternalHz(mclk, hal_i2c_get_register(OV7670_REG_CLKRC), hal_i2c_get_register(OV7670_REG_DBLV));
+}
+
+uint32_t sim_sensor_pclk_hz(){
+    uint8_t com14 = hal_i2c_get_register(OV7670_REG_COM14);
+    uint32_t internal = sim_internal_hz();
+    return (com14 & OV7670_COM14_DCWEN) ? internal >> (com14 & 7) : internal;
+}
+
+static void sim_advance_frame(){
+    uint32_t internal = sim_internal_hz();
+    hal_advance_us(internal ? (uint64_t)CLOCKPLAN_LINE_CLOCKS * CLOCKPLAN_FRAME_LINES * 1000000 / internal : 100000);
+}
+
+// clock one frame through the capture ISR
+void sim_sensor_frame(){
+    simSensor_t *s = &simSensor;
+
+    if (s->locked){
+        if (hal_i2c_get_register(OV7670_REG_COM7) == SIM_LOCKED_COM7){
+            sim_advance_frame();
+            return;
+        }
+        s->locked = 0;
+        s->recoveries++;
+    }
+    if (s->outage > 0){
+        s->outage--;
+        sim_advance_frame();
+        return;
+    }
+    if (s->lockup > 0 && uniform() < s->lockup){
+        s->locked = 1;
+        s->lockups++;
+        hal_i2c_set_register(OV7670_REG_COM7, SIM_LOCKED_COM7);
+        sim_advance_frame();
+        return;
+    }
+    if (s->vsLoss > 0 && uniform() < s->vsLoss){
+        s->outage = 1 + (int)(uniform() * 10);
+        s->outages++;
+        sim_advance_frame();
+        return;
+    }
+    if (s->onFrame){
+        s->onFrame();
+    }
+    int glitchRow = -1;
+    if (s->hsGlitch > 0 && uniform() < s->hsGlitch){
+        glitchRow = (int)(uniform() * IMAGESIZEY);
+        s->glitches++;
+    }
+
+    uint32_t pclk = sim_sensor_pclk_hz();
+    // test pattern select is bit 7 of SCALING_XSC and SCALING_YSC, colour bars are 2
+    int pattern = (hal_i2c_get_register(OV7670_REG_SCALING_XSC) >> 7)
+        | (hal_i2c_get_register(OV7670_REG_SCALING_YSC) >> 7) << 1;
+    double ber = s->ber;
+    int dropEvery = 0;
+    if (pclk > s->limitHz){
+        double r = (double)pclk / s->limitHz;
+        ber += 1e-4 * r * r * r * r;
+        if (pclk > 2 * s->limitHz){
+            dropEvery = 97; // the ISR misses a byte now and then
+        }
+    }
+
+    hal_gpio_irq(VS, GPIO_IRQ_EDGE_FALL);
+    int row, i, b, count = 0;
+    for (row = 0; row < IMAGESIZEY; row++){
+        hal_gpio_irq(HS, GPIO_IRQ_EDGE_RISE);
+        if (row == glitchRow){
+            hal_gpio_irq(HS, GPIO_IRQ_EDGE_RISE);
+        }
+        for (i = 0; i < IMAGESIZEX * 2; i++){
+            uint8_t byte;
+            if (pattern == OV7670_TEST_PATTERN_COLOR_BAR){
+                uint16_t px = bars[(i / 2) * 8 / IMAGESIZEX];
+                byte = (i & 1) ? (uint8_t)(px >> 8) : (uint8_t)(px & 0xFF);
+            } else if (s->frame){
+                byte = s->frame[row * IMAGESIZEX * 2 + i];
+            } else {
+                byte = (uint8_t)(uniform() * 256);
+            }
+            if (s->stuckLine >= 0){
+                byte &= ~(1 << s->stuckLine); // in captest's reference too
+            }
+            uint8_t sent = byte;
+            for (b = 0; b < 8; b++){
+                if (b != s->stuckLine && ber > 0 && uniform() < ber){
+                    byte ^= 1 << b;
+                }
+            }
+            if (dropEvery && ++count % dropEvery == 0){
+                continue;
+            }
+            // only bytes the ISR keeps can be counted by the tester
+            if (getSaveImage()){
+                s->injected += __builtin_popcount(sent ^ byte);
+            }
+            hal_gpio_set_all(byte);
+            hal_gpio_irq(PCLK, GPIO_IRQ_EDGE_RISE);
+        }
+    }
+    s->frames++;
+    sim_advance_frame();
+}
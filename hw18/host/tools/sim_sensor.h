@@ -0,0 +1,35 @@
+#ifndef SIM_SENSOR_h
+#define SIM_SENSOR_h
+
+#include <stdint.h>
+
+// Simulated OV7670 for host tools. Installed as the HAL idle hook, it
+// clocks one frame through the real GPIO ISR in cam.c every time the
+// firmware spins in tight_loop_contents(), at the frame rate the sensor
+// registers and MCLK give, with errors and glitches injected on request.
+
+typedef struct simSensor {
+    const uint8_t *frame; // raw RGB565 frame to send, random bytes if NULL
+    void (*onFrame)(void); // called before each frame is sent, can change frame
+    // data errors
+    double ber; // chance each bit is flipped
+    uint32_t limitHz; // above this PCLK errors climb, above twice it bytes are lost
+    int stuckLine; // data line held low, -1 for none
+    // sync glitches, chance per frame
+    double hsGlitch; // an extra HS pulse, the frame ends short
+    double vsLoss; // VS and HS stop for a few frames, then come back
+    double lockup; // the sensor stops until init_camera() resets it
+    // what was injected
+    uint64_t injected; // flipped bits in bytes the ISR stored
+    uint32_t frames, glitches, outages, lockups, recoveries;
+    int outage; // frames left in the current VS loss
+    int locked;
+} simSensor_t;
+
+extern simSensor_t simSensor;
+
+void sim_sensor_install();
+uint32_t sim_sensor_pclk_hz();
+void sim_sensor_frame();
+
+#endif
@@ -0,0 +1,290 @@
+// Simulated track and camera, see sim_track.h.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "cam.h"
+#include "sim_track.h"
+
+#define TRACK_SEGMENTS 64
+#define SUB 4 // rays a pixel, 2 x 2, the sensor averages what it bins
+
+// a segment of the script and the pose it starts from
+typedef struct segment {
+    float length; // mm along the centreline
+    float radius; // 0 for a straight
+    float turn; // radians, + anticlockwise
+    float x, y, heading;
+} segment_t;
+
+// where each ray meets the floor, mm ahead of the axle and to the left
+static float rayAhead[IMAGESIZEX * IMAGESIZEY * SUB];
+static float rayLeft[IMAGESIZEX * IMAGESIZEY * SUB];
+static uint8_t rayFloor[IMAGESIZEX * IMAGESIZEY * SUB];
+
+static uint32_t rng = 7;
+
+static int noise(int amplitude){
+    rng = rng * 1664525u + 1013904223u;
+    return amplitude ? (int)((rng >> 16) % (2 * amplitude + 1)) - amplitude : 0;
+}
+
+// the floor's own texture, fixed to the floor so it moves in the image
+static int texture(const simTrack_t *t, int x, int y){
+    uint32_t h = (uint32_t)x * 73856093u ^ (uint32_t)y * 19349663u;
+    h ^= h >> 13;
+    h *= 0x5bd1e995u;
+    h ^= h >> 15;
+    return t->texture ? (int)(h % (2 * t->texture + 1)) - t->texture : 0;
+}
+
+// hw18's camera: the usual OV7670 module lens, high on the front of the
+// chassis looking down at the floor ahead
+void sim_camera_default(simCamera_t *c){
+    c->heightMm = 90;
+    c->aheadMm = 100;
+    c->pitchDeg = 45;
+    c->hfovDeg = 56;
+}
+
+// a pinhole camera pitched down, image x to the right and y down
+void sim_camera_setup(const simCamera_t *c){
+    float pitch = c->pitchDeg * (float)M_PI / 180;
+    float focal = (IMAGESIZEX / 2) / tanf(c->hfovDeg * (float)M_PI / 360);
+    int row, col, k;
+    for (row = 0; row < IMAGESIZEY; row++){
+        for (col = 0; col < IMAGESIZEX; col++){
+            for (k = 0; k < SUB; k++){
+                int i = (row * IMAGESIZEX + col) * SUB + k;
+                float u = (col + 0.25f + 0.5f * (k & 1) - IMAGESIZEX / 2.0f) / focal;
+                float v = (row + 0.25f + 0.5f * (k >> 1) - IMAGESIZEY / 2.0f) / focal;
+                // the ray ahead, left and up from the lens
+                float ahead = cosf(pitch) - v * sinf(pitch);
+                float up = -sinf(pitch) - v * cosf(pitch);
+                rayFloor[i] = up < -1e-3f;
+                if (!rayFloor[i]){
+                    continue; // above the horizon, never with hw18's pitch
+                }
+                float dist = c->heightMm / -up;
+                rayAhead[i] = c->aheadMm + dist * ahead;
+                rayLeft[i] = -dist * u;
+            }
+        }
+    }
+}
+
+void sim_track_default(simTrack_t *t){
+    memset(t, 0, sizeof(*t));
+    t->lineMm = 19; // electrical tape
+    t->floor = 60;
+    t->line = 220;
+    t->texture = 10;
+    t->noise = 3;
+}
+
+static int parse(const char *script, segment_t *seg){
+    int n = 0;
+    const char *p = script;
+    while (*p){
+        char kind;
+        float a, b = 0;
+        int got = sscanf(p, " %c %f %f", &kind, &a, &b);
+        if (n == TRACK_SEGMENTS || got < 2){
+            return -1;
+        }
+        if ((kind == 'S' || kind == 's') && a > 0){
+            seg[n].length = a;
+            seg[n].radius = 0;
+            seg[n].turn = 0;
+        } else if ((kind == 'A' || kind == 'a') && got == 3 && a > 0 && b != 0){
+            seg[n].radius = a;
+            seg[n].turn = b * (float)M_PI / 180;
+            seg[n].length = a * fabsf(seg[n].turn);
+        } else {
+            return -1; // turns on the spot aren't a line
+        }
+        n++;
+        p = strchr(p, ';');
+        if (!p){
+            break;
+        }
+        p++;
+    }
+    return n;
+}
+
+// the pose d mm into a segment
+static void walk(const segment_t *s, float d, float *x, float *y, float *heading){
+    if (s->radius == 0){
+        *x = s->x + d * cosf(s->heading);
+        *y = s->y + d * sinf(s->heading);
+        *heading = s->heading;
+        return;
+    }
+    float side = s->turn > 0 ? 1 : -1; // the centre is on the left for +
+    float a = side * d / s->radius;
+    float cx = s->x - side * s->radius * sinf(s->heading);
+    float cy = s->y + side * s->radius * cosf(s->heading);
+    *heading = s->heading + a;
+    *x = cx + side * s->radius * sinf(*heading);
+    *y = cy - side * s->radius * cosf(*heading);
+}
+
+// the centreline a mm a point and the image with the line drawn on it
+int sim_track_make(simTrack_t *t, const char *script){
+    segment_t seg[TRACK_SEGMENTS];
+    int n = parse(script, seg);
+    int i, k;
+    if (n <= 0){
+        return -1;
+    }
+    float x = 0, y = 0, heading = 0, total = 0;
+    for (i = 0; i < n; i++){
+        seg[i].x = x;
+        seg[i].y = y;
+        seg[i].heading = heading;
+        walk(&seg[i], seg[i].length, &x, &y, &heading);
+        total += seg[i].length;
+    }
+    t->closure = hypotf(x, y);
+    t->points = (int)total;
+    if (t->points < 100 || t->points > TRACK_POINTS_MAX){
+        return -1;
+    }
+    t->x = malloc(sizeof(float) * t->points);
+    t->y = malloc(sizeof(float) * t->points);
+    if (!t->x || !t->y){
+        return -1;
+    }
+    float start = 0, minX = 0, maxX = 0, minY = 0, maxY = 0;
+    for (i = 0, k = 0; i < t->points; i++){
+        while (k < n - 1 && i >= start + seg[k].length){
+            start += seg[k++].length;
+        }
+        walk(&seg[k], i - start, &t->x[i], &t->y[i], &heading);
+        minX = fminf(minX, t->x[i]);
+        maxX = fmaxf(maxX, t->x[i]);
+        minY = fminf(minY, t->y[i]);
+        maxY = fmaxf(maxY, t->y[i]);
+    }
+
+    t->originX = floorf(minX) - TRACK_MARGIN_MM;
+    t->originY = floorf(minY) - TRACK_MARGIN_MM;
+    t->width = (int)(maxX - minX) + 2 * TRACK_MARGIN_MM;
+    t->height = (int)(maxY - minY) + 2 * TRACK_MARGIN_MM;
+    t->image = malloc((size_t)t->width * t->height);
+    if (!t->image){
+        return -1;
+    }
+    int px, py;
+    for (py = 0; py < t->height; py++){
+        for (px = 0; px < t->width; px++){
+            t->image[py * t->width + px] = (uint8_t)(t->floor + texture(t, px + (int)t->originX, py + (int)t->originY));
+        }
+    }
+    // the line a disc at each point, they overlap a mm apart
+    float r = t->lineMm / 2;
+    int reach = (int)ceilf(r);
+    for (i = 0; i < t->points; i++){
+        float cx = t->x[i] - t->originX, cy = t->y[i] - t->originY;
+        for (py = (int)cy - reach; py <= (int)cy + reach + 1; py++){
+            for (px = (int)cx - reach; px <= (int)cx + reach + 1; px++){
+                float dx = px + 0.5f - cx, dy = py + 0.5f - cy;
+                if (dx * dx + dy * dy <= r * r){
+                    int v = t->line + texture(t, px + (int)t->originX, py + (int)t->originY) / 2;
+                    t->image[py * t->width + px] = (uint8_t)(v > 255 ? 255 : v);
+                }
+            }
+        }
+    }
+    return 0;
+}
+
+void sim_track_free(simTrack_t *t){
+    free(t->image);
+    free(t->x);
+    free(t->y);
+    t->image = NULL;
+    t->x = t->y = NULL;
+}
+
+// the drawn track, y up like the world
+int sim_track_write_pgm(const simTrack_t *t, const char *path){
+    FILE *f = fopen(path, "wb");
+    int row;
+    if (!f){
+        return -1;
+    }
+    fprintf(f, "P5\n%d %d\n255\n", t->width, t->height);
+    for (row = t->height - 1; row >= 0; row--){
+        fwrite(t->image + (size_t)row * t->width, 1, t->width, f);
+    }
+    return fclose(f);
+}
+
+static int floor_at(const simTrack_t *t, float x, float y, int blank){
+    int px = (int)floorf(x - t->originX), py = (int)floorf(y - t->originY);
+    if (blank || px < 0 || py < 0 || px >= t->width || py >= t->height){
+        return t->floor + texture(t, (int)floorf(x), (int)floorf(y));
+    }
+    return t->image[py * t->width + px];
+}
+
+// what the camera sees with the axle at x, y facing heading (radians,
+// anticlockwise from x). blank leaves the line out, plain floor.
+void sim_track_render(const simTrack_t *t, float x, float y, float heading, int blank, uint8_t *frame){
+    float c = cosf(heading), s = sinf(heading);
+    int i, k;
+    for (i = 0; i < IMAGESIZEX * IMAGESIZEY; i++){
+        int sum = 0;
+        for (k = 0; k < SUB; k++){
+            int r = i * SUB + k;
+            if (!rayFloor[r]){
+                sum += t->floor;
+                continue;
+            }
+            float wx = x + rayAhead[r] * c - rayLeft[r] * s;
+            float wy = y + rayAhead[r] * s + rayLeft[r] * c;
+            sum += floor_at(t, wx, wy, blank);
+        }
+        int v = sum / SUB + noise(t->noise);
+        v = v < 0 ? 0 : (v > 255 ? 255 : v);
+        // RGB565, low byte first as the ISR stores it
+        uint16_t px = (uint16_t)((v >> 3) << 11 | (v >> 2) << 5 | (v >> 3));
+        frame[2 * i] = (uint8_t)(px & 0xFF);
+        frame[2 * i + 1] = (uint8_t)(px >> 8);
+    }
+}
+
+// how far round the centreline x, y is in mm, and how far to its left in
+// offset. hint is the last point found, -1 to search the whole track.
+float sim_track_locate(const simTrack_t *t, float x, float y, int *hint, float *offset){
+    int from = 0, count = t->points, i, best = 0;
+    float bestD = INFINITY;
+    if (*hint >= 0){
+        from = *hint - 200;
+        count = 401;
+    }
+    for (i = 0; i < count; i++){
+        int p = ((from + i) % t->points + t->points) % t->points;
+        float dx = x - t->x[p], dy = y - t->y[p];
+        float d = dx * dx + dy * dy;
+        if (d < bestD){
+            bestD = d;
+            best = p;
+        }
+    }
+    int next = (best + 1) % t->points;
+    float tx = t->x[next] - t->x[best], ty = t->y[next] - t->y[best];
+    float len = hypotf(tx, ty);
+    if (len > 0){
+        tx /= len;
+        ty /= len;
+    }
+    float dx = x - t->x[best], dy = y - t->y[best];
+    *offset = tx * dy - ty * dx;
+    *hint = best;
+    float along = best + tx * dx + ty * dy;
+    return along < 0 ? along + t->points : (along >= t->points ? along - t->points : along);
+}
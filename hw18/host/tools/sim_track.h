@@ -0,0 +1,54 @@
+#ifndef SIM_TRACK_h
+#define SIM_TRACK_h
+
+#include <stdint.h>
+
+// Simulated track and camera for the closed loop simulator. A track is a
+// closed centreline in the motion script notation, "S mm" straights and
+// "A radius degrees" arcs, + anticlockwise, drawn as a bright line on a
+// textured floor into an image a mm a pixel. The camera looks at that
+// image through the OV7670's geometry and renders IMAGESIZEX x IMAGESIZEY
+// RGB565 as the capture ISR stores it. The centreline says how far round
+// the car is and how far off the line.
+//
+// World coordinates are mm, the track starts at 0, 0 heading along x.
+
+#define TRACK_POINTS_MAX 40000 // centreline points a mm apart
+#define TRACK_MARGIN_MM 400 // floor drawn around the track, more than the camera sees
+
+// built in tracks
+#define TRACK_OVAL "S 1000;A 350 180;S 1000;A 350 180"
+#define TRACK_BENDS "S 1000;A 300 90;S 300;A 300 90;A 250 90;A 250 -180;A 250 90;A 300 90;S 300;A 300 90"
+
+typedef struct simCamera {
+    float heightMm; // lens above the floor
+    float aheadMm; // lens ahead of the axle
+    float pitchDeg; // down from level
+    float hfovDeg; // across the image
+} simCamera_t;
+
+typedef struct simTrack {
+    float lineMm; // line width
+    int floor, line; // brightness 0-255
+    int texture; // floor texture +-, the odometry tracks it
+    int noise; // sensor noise +- each frame
+    // the drawn track
+    uint8_t *image;
+    int width, height; // pixels, a mm each
+    float originX, originY; // world position of pixel 0, 0
+    // the centreline
+    float *x, *y;
+    int points;
+    float closure; // mm the script's end misses its start by
+} simTrack_t;
+
+void sim_camera_default(simCamera_t *c);
+void sim_camera_setup(const simCamera_t *c);
+void sim_track_default(simTrack_t *t);
+int sim_track_make(simTrack_t *t, const char *script);
+void sim_track_free(simTrack_t *t);
+int sim_track_write_pgm(const simTrack_t *t, const char *path);
+void sim_track_render(const simTrack_t *t, float x, float y, float heading, int blank, uint8_t *frame);
+float sim_track_locate(const simTrack_t *t, float x, float y, int *hint, float *offset);
+
+#endif
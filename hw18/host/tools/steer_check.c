@@ -0,0 +1,271 @@
+// Checks the steering controller (steer.c). The PID on its own: with only
+// the P term it must match the old proportional map, the derivative must
+// follow a ramp seen at the frame rate without a spike on every new frame
+// and filter noise, the integral must not wind up while saturated, and
+// the feed-forward adds straight to the output. Then the whole loop on
+// the stub SDK's timer, with frames posted at a jittery camera rate: tick
+// timing, hold, estimates that carry their own output, stale estimates
+// and stopping.
+//
+// usage: steer_check [-s seconds]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "pico/stdlib.h"
+#include "steer.h"
+
+#define WRAP 255
+#define FRAME_US 50000 // 20 fps
+
+static uint32_t seed = 11;
+
+static uint32_t rnd(){
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 8;
+}
+
+static float noise(){
+    return (float)(rnd() % 2001) / 1000.0f - 1.0f;
+}
+
+static void gains_only(steerGains_t *g, float kp, float ki, float kd, float kff){
+    steerDefaultGains(g);
+    g->kp = kp;
+    g->ki = ki;
+    g->kd = kd;
+    g->kff = kff;
+}
+
+// the map set_motor_speeds() had before the controller
+static void old_map(int com, int base, int *left, int *right){
+    int line_pos = ((com - 40) * 100) / 40;
+    if (line_pos > 100) line_pos = 100;
+    if (line_pos < -100) line_pos = -100;
+    int adjust = (WRAP * abs(line_pos)) / 100;
+    *left = *right = base;
+    if (line_pos > 0) *right -= adjust;
+    else if (line_pos < 0) *left -= adjust;
+}
+
+static int check_proportional(){
+    steerGains_t g;
+    steerPid_t pid;
+    gains_only(&g, 1, 0, 0, 0);
+    steerPidInit(&pid, &g);
+    int com, worst = 0;
+    for(com=0;com<80;com++){
+        steerEstimate_t est = {.position = (com - 40) / 40.0f, .heading = 0, .baseSpeed = 140, .timeUs = (uint64_t)(com + 1) * FRAME_US};
+        int l, r, ol, or;
+        steerMix(steerPidUpdate(&pid, &est, true, STEER_PERIOD_US), est.baseSpeed, WRAP, &l, &r);
+        old_map(com, est.baseSpeed, &ol, &or);
+        if (abs(l - ol) > worst) worst = abs(l - ol);
+        if (abs(r - or) > worst) worst = abs(r - or);
+    }
+    printf("P only vs the old map: worst %d PWM, %s\n", worst, worst <= 3 ? "ok" : "WRONG");
+    return worst > 3;
+}
+
+// the line drifts across at a steady rate, seen once a frame by the 500 Hz loop
+static int check_derivative(){
+    steerGains_t g;
+    steerPid_t pid;
+    gains_only(&g, 0, 0, 1, 0);
+    float slope = 0.4f; // position per second
+    int bad = 0;
+
+    // filtered, taken between frames
+    steerPidInit(&pid, &g);
+    float peak = 0, last = 0;
+    uint64_t t;
+    for(t=0;t<2000000;t+=STEER_PERIOD_US){
+        uint64_t frame = t / FRAME_US * FRAME_US;
+        steerEstimate_t est = {.position = slope * frame * 1e-6f, .heading = 0, .baseSpeed = 0, .timeUs = frame};
+        float out = steerPidUpdate(&pid, &est, t % FRAME_US == 0, STEER_PERIOD_US);
+        if (fabsf(out) > peak) peak = fabsf(out);
+        last = out;
+    }
+    // per tick, what a loop that ignored the frame times would see
+    float naive = slope * FRAME_US / STEER_PERIOD_US;
+    int ok = fabsf(last - slope) < slope * 0.05f && peak < slope * 1.05f;
+    printf("ramp %.2f/s: D settles at %.3f, peak %.3f (per tick it would spike to %.1f), %s\n",
+        slope, last, peak, naive, ok ? "ok" : "WRONG");
+    bad += !ok;
+
+    // noisy position: the filter against no filter
+    float sum[2] = {0, 0};
+    int k, n = 0;
+    for(k=0;k<2;k++){
+        g.dTauS = k ? 0.05f : 0;
+        steerPidInit(&pid, &g);
+        seed = 3;
+        n = 0;
+        for(t=FRAME_US;t<20000000;t+=FRAME_US){
+            steerEstimate_t est = {.position = 0.05f * noise(), .heading = 0, .baseSpeed = 0, .timeUs = t};
+            float out = steerPidUpdate(&pid, &est, true, FRAME_US);
+            sum[k] += out * out;
+            n++;
+        }
+    }
+    float rmsRaw = sqrtf(sum[0] / n), rmsFilt = sqrtf(sum[1] / n);
+    ok = rmsFilt < rmsRaw * 0.75f;
+    printf("noise: D rms %.3f unfiltered, %.3f filtered, %s\n", rmsRaw, rmsFilt, ok ? "ok" : "WRONG");
+    bad += !ok;
+    return bad;
+}
+
+static int check_windup(){
+    steerGains_t g;
+    steerPid_t pid;
+    int bad = 0;
+    gains_only(&g, 1, 2, 0, 0);
+    steerPidInit(&pid, &g);
+
+    // pinned against the limit for 5 s, far off to the right
+    uint64_t t = 0;
+    int ticks;
+    for(ticks=0;ticks<5*STEER_RATE_HZ;ticks++){
+        steerEstimate_t est = {.position = 1.0f, .heading = 0, .baseSpeed = 0, .timeUs = t += STEER_PERIOD_US};
+        steerPidUpdate(&pid, &est, true, STEER_PERIOD_US);
+    }
+    float wound = pid.integral;
+    // back across the line, the output has to turn round straight away
+    steerEstimate_t est = {.position = -0.2f, .heading = 0, .baseSpeed = 0, .timeUs = t += STEER_PERIOD_US};
+    float out = steerPidUpdate(&pid, &est, true, STEER_PERIOD_US);
+    int ok = fabsf(wound) < 0.01f && out < 0;
+    printf("saturated 5 s: integral %.3f, one tick after crossing back %.3f, %s\n", wound, out, ok ? "ok" : "WRONG");
+    bad += !ok;
+
+    // a small steady offset that never saturates, held by the clamp
+    steerPidInit(&pid, &g);
+    for(ticks=0;ticks<10*STEER_RATE_HZ;ticks++){
+        steerEstimate_t e = {.position = 0.1f, .heading = 0, .baseSpeed = 0, .timeUs = t += STEER_PERIOD_US};
+        steerPidUpdate(&pid, &e, true, STEER_PERIOD_US);
+    }
+    ok = fabsf(pid.integral - g.iLimit) < 1e-4f;
+    printf("steady offset 10 s: integral %.3f, limit %.3f, %s\n", pid.integral, g.iLimit, ok ? "ok" : "WRONG");
+    bad += !ok;
+    return bad;
+}
+
+static int check_feedforward(){
+    steerGains_t g;
+    steerPid_t pid;
+    gains_only(&g, 1, 0, 0, 0.5f);
+    steerPidInit(&pid, &g);
+    steerEstimate_t est = {.position = 0.1f, .heading = 0.4f, .baseSpeed = 0, .timeUs = FRAME_US};
+    float out = steerPidUpdate(&pid, &est, true, STEER_PERIOD_US);
+    int ok = fabsf(out - 0.3f) < 1e-5f;
+    printf("feed-forward: %.3f for position 0.1 heading 0.4, %s\n", out, ok ? "ok" : "WRONG");
+    return !ok;
+}
+
+// the timer loop on the stub's clock
+static int outputs = 0;
+static int outLeft, outRight;
+
+static void output(int left, int right){
+    outputs++;
+    outLeft = left;
+    outRight = right;
+}
+
+static void post(float position, int base){
+    steerEstimate_t est = {.position = position, .heading = 0, .baseSpeed = base, .timeUs = time_us_64()};
+    steerPost(&est);
+}
+
+static int check_loop(int seconds){
+    steerGains_t g;
+    steerTiming_t tm;
+    int bad = 0, ok;
+    steerDefaultGains(&g);
+    if (!steerStart(&g, WRAP, output)){
+        printf("timer: couldn't start\n");
+        return 1;
+    }
+    // held until the first estimate
+    sleep_ms(20);
+    ok = outputs == 10 && outLeft == 0 && outRight == 0;
+    printf("before the first estimate: %d ticks, motors %d %d, %s\n", outputs, outLeft, outRight, ok ? "ok" : "WRONG");
+    bad += !ok;
+    steerGetTiming(&tm);
+
+    // frames every 30 to 70 ms, the loop must keep its own pace
+    uint64_t start = time_us_64();
+    uint64_t end = start + (uint64_t)seconds * 1000000;
+    int frames = 0;
+    while (time_us_64() < end){
+        post(0.2f * noise(), 140);
+        frames++;
+        sleep_us(30000 + rnd() % 40000);
+    }
+    steerGetTiming(&tm);
+    int expect = (int)((time_us_64() - start) / STEER_PERIOD_US);
+    printf("%d s: %lu ticks, period %lu..%lu us, %lu late, %lu estimates of %d, oldest %lu ms\n", seconds,
+        (unsigned long)tm.ticks, (unsigned long)tm.periodMinUs, (unsigned long)tm.periodMaxUs, (unsigned long)tm.late,
+        (unsigned long)tm.estimates, frames, (unsigned long)(tm.ageMaxUs / 1000));
+    ok = abs((int)tm.ticks - expect) <= 1 && tm.periodMinUs == STEER_PERIOD_US
+        && tm.periodMaxUs == STEER_PERIOD_US && tm.late == 0 && (int)tm.estimates == frames && tm.ageMaxUs < 70000;
+    printf("fixed rate: %s\n", ok ? "ok" : "WRONG");
+    bad += !ok;
+
+    // hold stops on the next tick, a new estimate drives again
+    post(0, 140);
+    sleep_ms(10);
+    steerHold();
+    sleep_us(STEER_PERIOD_US);
+    int heldLeft = outLeft, heldRight = outRight;
+    post(0, 140);
+    sleep_us(STEER_PERIOD_US);
+    ok = heldLeft == 0 && heldRight == 0 && outLeft == 140 && outRight == 140;
+    printf("hold: %d %d, then %d %d, %s\n", heldLeft, heldRight, outLeft, outRight, ok ? "ok" : "WRONG");
+    bad += !ok;
+
+    // an output worked out already is driven as it is, however far off
+    // the position says the line is
+    steerEstimate_t direct = {.position = 1.0f, .heading = 0, .baseSpeed = 140, .timeUs = time_us_64(), .direct = true, .turn = -0.1f};
+    steerPost(&direct);
+    sleep_us(3 * STEER_PERIOD_US);
+    int directLeft = outLeft, directRight = outRight;
+    post(0, 140);
+    sleep_us(STEER_PERIOD_US);
+    ok = directLeft == 140 - (int)(0.1f * WRAP) && directRight == 140 && outLeft == 140 && outRight == 140;
+    printf("direct output -0.1: %d %d, then the PID again %d %d, %s\n", directLeft, directRight, outLeft, outRight,
+        ok ? "ok" : "WRONG");
+    bad += !ok;
+
+    // the camera goes quiet
+    sleep_us(STEER_STALE_US - 2 * STEER_PERIOD_US);
+    int beforeLeft = outLeft;
+    sleep_us(2 * STEER_PERIOD_US);
+    ok = beforeLeft != 0 && outLeft == 0 && outRight == 0;
+    printf("stale estimate: %d before %d ms, %d after, %s\n", beforeLeft, STEER_STALE_US / 1000, outLeft, ok ? "ok" : "WRONG");
+    bad += !ok;
+
+    steerStop();
+    int count = outputs;
+    sleep_ms(100);
+    ok = outputs == count && outLeft == 0 && outRight == 0;
+    printf("stopped: %d ticks after, motors %d %d, %s\n", outputs - count, outLeft, outRight, ok ? "ok" : "WRONG");
+    bad += !ok;
+    return bad;
+}
+
+int main(int argc, char **argv){
+    int seconds = 60;
+    int i;
+    for (i = 1; i < argc - 1; i++){
+        if (strcmp(argv[i], "-s") == 0){
+            seconds = atoi(argv[++i]);
+        }
+    }
+    int bad = check_proportional();
+    bad += check_derivative();
+    bad += check_windup();
+    bad += check_feedforward();
+    bad += check_loop(seconds);
+    printf("%s\n", bad ? "steer check FAILED" : "steer check passed");
+    return bad ? 1 : 0;
+}
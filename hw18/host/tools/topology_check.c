@@ -0,0 +1,415 @@
+// Checks the track topology classifier (topology.c) and its path policy.
+// Synthetic junctions are rendered at random positions, tilts and lighting
+// and clocked through the real capture ISR by the simulated sensor, then
+// labelled. Recorded frames are given on the command line with the label
+// they should get, the 80x60 corpus is used when there are none.
+// Last, a lap of junctions driven through the policy with a lap script.
+// Exits non-zero on any wrong recorded label or policy decision, or if
+// more than 1% of the synthetic frames are wrong. Those are forks that
+// split right at the bottom of the frame, where either line could be the
+// one the robot is on; the policy's TOPO_CONFIRM_FRAMES rides them out.
+//
+// usage: topology_check [-n frames per scene] [frame.raw label ...]
+// labels are lost, straight, left, right, cross, end, stop
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "pico/stdlib.h"
+#include "cam.h"
+#include "topology.h"
+#include "sim_sensor.h"
+
+#define FRAME_BYTES (IMAGESIZEX*IMAGESIZEY*2)
+#define MAX_PIECES 16
+#define HALF_WIDTH 3.0 // lines are 6 pixels wide, like the corpus
+
+static const char *corpus[][2] = {
+    {"straight", "straight"}, {"curved", "straight"}, {"crossing", "cross"},
+    {"lowlight", "straight"}, {"glare", "straight"},
+};
+
+typedef struct piece {
+    double x0, y0, x1, y1;
+} piece_t;
+
+typedef struct scene {
+    const char *name;
+    int label;
+} scene_t;
+
+enum {
+    SC_STRAIGHT, SC_CURVE, SC_LEFT_T, SC_RIGHT_T, SC_LEFT_CORNER, SC_RIGHT_CORNER,
+    SC_LEFT_FORK, SC_RIGHT_FORK, SC_CROSS, SC_T, SC_END, SC_STOP, SC_BLANK, NUM_SCENES
+};
+
+static const scene_t scenes[NUM_SCENES] = {
+    {"straight", TOPO_STRAIGHT}, {"curve", TOPO_STRAIGHT},
+    {"left T", TOPO_LEFT}, {"right T", TOPO_RIGHT},
+    {"left corner", TOPO_LEFT}, {"right corner", TOPO_RIGHT},
+    {"left fork", TOPO_LEFT}, {"right fork", TOPO_RIGHT},
+    {"crossing", TOPO_CROSS}, {"T", TOPO_CROSS},
+    {"end", TOPO_END}, {"stop bar", TOPO_STOP}, {"blank", TOPO_LOST},
+};
+
+static uint8_t frame[FRAME_BYTES];
+static piece_t pieces[MAX_PIECES];
+static int numPieces;
+static uint32_t seed = 1;
+
+static double rnd(){
+    seed = seed * 1664525u + 1013904223u;
+    return (seed >> 8) / 16777216.0;
+}
+
+static uint64_t now_ns(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void add_piece(double x0, double y0, double x1, double y1){
+    if (numPieces < MAX_PIECES){
+        pieces[numPieces].x0 = x0;
+        pieces[numPieces].y0 = y0;
+        pieces[numPieces].x1 = x1;
+        pieces[numPieces].y1 = y1;
+        numPieces++;
+    }
+}
+
+static double dist_to_piece(const piece_t *p, double x, double y){
+    double dx = p->x1 - p->x0, dy = p->y1 - p->y0;
+    double t = ((x - p->x0) * dx + (y - p->y0) * dy) / (dx * dx + dy * dy);
+    if (t < 0) t = 0;
+    if (t > 1) t = 1;
+    double ex = p->x0 + t * dx - x, ey = p->y0 + t * dy - y;
+    return sqrt(ex * ex + ey * ey);
+}
+
+// the pieces as bright lines on a textured floor, stored as the ISR would
+static void render(int floor, int line, int noise, int glare){
+    int x, y, i;
+    for (y = 0; y < IMAGESIZEY; y++){
+        for (x = 0; x < IMAGESIZEX; x++){
+            int v = floor;
+            for (i = 0; i < numPieces; i++){
+                if (dist_to_piece(&pieces[i], x + 0.5, y + 0.5) < HALF_WIDTH){
+                    v = line;
+                    break;
+                }
+            }
+            if (glare){
+                double dx = (x - 0.15 * IMAGESIZEX) / (0.3 * IMAGESIZEX);
+                double dy = (y - 0.5 * IMAGESIZEY) / (0.3 * IMAGESIZEX);
+                double d = dx * dx + dy * dy;
+                if (d < 1){
+                    v += (int)(glare * (1 - d));
+                }
+            }
+            v += (int)((rnd() * 2 - 1) * noise);
+            int r = v + 6, g = v, b = v - 6; // warm floor, as in the corpus
+            r = r < 0 ? 0 : (r > 255 ? 255 : r);
+            g = g < 0 ? 0 : (g > 255 ? 255 : g);
+            b = b < 0 ? 0 : (b > 255 ? 255 : b);
+            uint16_t px = ((r >> 3) << 11) | ((g >> 2) << 5) | (b >> 3);
+            frame[(y * IMAGESIZEX + x) * 2] = px & 0xFF;
+            frame[(y * IMAGESIZEX + x) * 2 + 1] = px >> 8;
+        }
+    }
+}
+
+// the followed line runs from (cx, bottom) to (cx + tilt, top)
+static double main_x(double cx, double tilt, double y){
+    return cx + tilt * (1 - y / IMAGESIZEY);
+}
+
+// one random frame of a scene, barY is the bar or split row
+static void make_scene(int sc, double cx, double tilt, double barY, double bend){
+    double H = IMAGESIZEY, W = IMAGESIZEX;
+    double bx = main_x(cx, tilt, barY);
+    int i;
+    numPieces = 0;
+    switch (sc){
+    case SC_CURVE:
+        // x = cx + bend * (1 - y/H)^2 in 8 pieces
+        for (i = 0; i < 8; i++){
+            double ya = H + 4 - (H + 8) * i / 8, yb = H + 4 - (H + 8) * (i + 1) / 8;
+            double va = 1 - ya / H, vb = 1 - yb / H;
+            add_piece(cx + bend * va * va, ya, cx + bend * vb * vb, yb);
+        }
+        break;
+    case SC_LEFT_CORNER:
+    case SC_RIGHT_CORNER:
+    case SC_T:
+    case SC_END:
+        add_piece(main_x(cx, tilt, H + 4), H + 4, bx, barY);
+        break;
+    case SC_BLANK:
+        break;
+    default:
+        add_piece(main_x(cx, tilt, H + 4), H + 4, main_x(cx, tilt, -4), -4);
+        break;
+    }
+    switch (sc){
+    case SC_LEFT_T:
+    case SC_LEFT_CORNER:
+        add_piece(bx, barY, -8, barY);
+        break;
+    case SC_RIGHT_T:
+    case SC_RIGHT_CORNER:
+        add_piece(bx, barY, W + 8, barY);
+        break;
+    case SC_LEFT_FORK:
+        add_piece(bx, barY, bx - 32, -6);
+        break;
+    case SC_RIGHT_FORK:
+        add_piece(bx, barY, bx + 32, -6);
+        break;
+    case SC_CROSS:
+    case SC_T:
+        add_piece(-8, barY, W + 8, barY);
+        break;
+    case SC_STOP:
+        add_piece(bx - 14, barY, bx + 14, barY);
+        break;
+    }
+}
+
+static int capture(const uint8_t *raw){
+    simSensor.frame = raw;
+    return captureFrame(NULL) == CAPTURE_OK ? 0 : -1;
+}
+
+static uint64_t classify_ns = 0;
+static int classified = 0;
+
+static void classify(topoFrame_t *f){
+    uint64_t t0 = now_ns();
+    topoClassify(f);
+    classify_ns += now_ns() - t0;
+    classified++;
+}
+
+static int label_from_name(const char *name){
+    int i;
+    for (i = 0; i < TOPO_LABELS; i++){
+        if (strcmp(name, topoLabelName(i)) == 0){
+            return i;
+        }
+    }
+    return -1;
+}
+
+static int read_frame(const char *path, uint8_t *raw){
+    FILE *f = fopen(path, "rb");
+    if (!f){
+        perror(path);
+        return -1;
+    }
+    size_t n = fread(raw, 1, FRAME_BYTES, f);
+    fclose(f);
+    if (n != FRAME_BYTES){
+        fprintf(stderr, "%s: expected %d bytes\n", path, FRAME_BYTES);
+        return -1;
+    }
+    return 0;
+}
+
+// a recorded frame, returns 1 if it got the wrong label
+static int check_recorded(const char *name, const uint8_t *raw, int want){
+    topoFrame_t f;
+    topoReset();
+    if (capture(raw) != 0){
+        fprintf(stderr, "%s: capture failed\n", name);
+        return 1;
+    }
+    classify(&f);
+    printf("  %-40s %-8s (want %s) line %d exits %c%c%c junction row %d\n", name, topoLabelName(f.label),
+        topoLabelName(want), f.mainX, f.exits & TOPO_EXIT_LEFT ? 'L' : '-',
+        f.exits & TOPO_EXIT_STRAIGHT ? 'S' : '-', f.exits & TOPO_EXIT_RIGHT ? 'R' : '-', f.junctionY);
+    return f.label != want;
+}
+
+// junctions of a lap as the robot drives up to them: the bar comes down
+// the image a few rows a frame, then the track is plain for a while
+typedef struct lapStep {
+    int scene;
+    char expect; // 'L', 'S', 'R' for the com the policy gives, 'X' stop
+} lapStep_t;
+
+static int drive_junction(topoPolicy_t *p, const lapStep_t *step, int *stopped){
+    const double cx = IMAGESIZEX / 2.0;
+    topoFrame_t f;
+    int y, n, bad = 0, turns = 0, com;
+    for (y = 6; y < IMAGESIZEY + 12; y += 4){
+        if (y < IMAGESIZEY - 4){
+            make_scene(step->scene, cx, 0, y, 0);
+        }
+        else {
+            make_scene(SC_STRAIGHT, cx, 0, 0, 0); // the junction is under the robot
+        }
+        render(60, 220, 10, 0);
+        if (capture(frame) != 0){
+            return 1;
+        }
+        classify(&f);
+        int action = topoPolicySteer(p, &f, &com);
+        if (action == TOPO_ACTION_STOP){
+            *stopped = 1;
+            return step->expect != 'X';
+        }
+        // once the junction is out of view the policy follows the line
+        // until it clears, only judge frames that still show it
+        if (action != TOPO_ACTION_TURN || f.label == TOPO_STRAIGHT){
+            continue;
+        }
+        turns++;
+        char got = com < f.mainX - 8 ? 'L' : (com > f.mainX + 8 ? 'R' : 'S');
+        if (got != step->expect){
+            bad++;
+        }
+    }
+    for (n = 0; n < TOPO_CLEAR_FRAMES + 1; n++){
+        make_scene(SC_STRAIGHT, cx, 0, 0, 0);
+        render(60, 220, 10, 0);
+        if (capture(frame) != 0){
+            return 1;
+        }
+        classify(&f);
+        topoPolicySteer(p, &f, &com);
+    }
+    printf("  %-10s %d turn frames, %s\n", scenes[step->scene].name, turns,
+        step->expect == 'X' ? "missed the stop" : (bad || !turns ? "WRONG way" : "ok"));
+    return bad || !turns || step->expect == 'X';
+}
+
+int main(int argc, char **argv){
+    static uint8_t raw[FRAME_BYTES];
+    int perScene = 40;
+    int i, j, k;
+    int fails = 0, files = 0;
+
+    init_camera_pins();
+    sim_sensor_install();
+    setLineDetector(LINE_DETECTOR_CENTROID);
+
+    for (i = 1; i < argc; i++){
+        if (strcmp(argv[i], "-n") == 0 && i + 1 < argc){
+            perScene = atoi(argv[++i]);
+        }
+    }
+
+    // 1. synthetic frames
+    static int confusion[NUM_SCENES][TOPO_LABELS];
+    int synthBad = 0;
+    for (i = 0; i < NUM_SCENES; i++){
+        for (j = 0; j < perScene; j++){
+            double cx = 28 + rnd() * 24;
+            double tilt = (rnd() * 2 - 1) * 8;
+            double barY = 18 + rnd() * 24;
+            double bend = (rnd() < 0.5 ? -1 : 1) * (10 + rnd() * 20);
+            if (i == SC_LEFT_FORK || i == SC_RIGHT_FORK){
+                barY = 30 + rnd() * 16; // needs room above to split
+            }
+            make_scene(i, cx, tilt, barY, bend);
+            // every 4th frame dim, every 4th with a glare spot that doesn't
+            // quite wash the line out
+            if (j % 4 == 1){
+                render(18, 48, 6, 0);
+            } else if (j % 4 == 3){
+                render(50, 200, 10, 100);
+            } else {
+                render(60, 220, 10, 0);
+            }
+            topoFrame_t f;
+            topoReset();
+            if (capture(frame) != 0){
+                fprintf(stderr, "%s: capture failed\n", scenes[i].name);
+                return 1;
+            }
+            classify(&f);
+            confusion[i][f.label]++;
+            if (f.label != scenes[i].label){
+                if (synthBad < 10){
+                    printf("  %s cx %.1f tilt %.1f row %.1f: got %s\n", scenes[i].name, cx, tilt, barY,
+                        topoLabelName(f.label));
+                }
+                synthBad++;
+            }
+        }
+    }
+    printf("synthetic, %d frames per scene:\n%-14s", perScene, "scene");
+    for (k = 0; k < TOPO_LABELS; k++){
+        printf(" %8s", topoLabelName(k));
+    }
+    printf("\n");
+    for (i = 0; i < NUM_SCENES; i++){
+        printf("%-14s", scenes[i].name);
+        for (k = 0; k < TOPO_LABELS; k++){
+            printf(" %8d", confusion[i][k]);
+        }
+        printf("\n");
+    }
+    printf("%d of %d synthetic frames labelled wrong\n", synthBad, NUM_SCENES * perScene);
+    if (synthBad * 100 > NUM_SCENES * perScene){
+        fails++;
+    }
+
+    // 2. recorded frames
+    printf("recorded:\n");
+    for (i = 1; i < argc; i++){
+        if (strcmp(argv[i], "-n") == 0){
+            i++;
+            continue;
+        }
+        if (i + 1 >= argc || label_from_name(argv[i + 1]) < 0){
+            fprintf(stderr, "%s: give the label after the file\n", argv[i]);
+            return 1;
+        }
+        if (read_frame(argv[i], raw) != 0){
+            return 1;
+        }
+        fails += check_recorded(argv[i], raw, label_from_name(argv[i + 1]));
+        files++;
+        i++;
+    }
+    if (files == 0){
+        for (i = 0; i < (int)(sizeof(corpus) / sizeof(corpus[0])); i++){
+            char path[512];
+            snprintf(path, sizeof(path), "%s/%s_%dx%d.raw", CORPUS_DIR, corpus[i][0], IMAGESIZEX, IMAGESIZEY);
+            if (read_frame(path, raw) != 0){
+                return 1;
+            }
+            fails += check_recorded(corpus[i][0], raw, label_from_name(corpus[i][1]));
+        }
+    }
+
+    // 3. two laps with a lap script, stopping at the second stop bar. The
+    // left T has no right branch, the script's R there falls back to straight on.
+    static const lapStep_t lap[] = {
+        {SC_CROSS, 'L'}, {SC_LEFT_T, 'S'}, {SC_RIGHT_T, 'R'}, {SC_CROSS, 'L'}, {SC_STOP, 'S'},
+        {SC_CROSS, 'L'}, {SC_STOP, 'X'},
+    };
+    topoPolicy_t policy;
+    topoPolicyInit(&policy, TOPO_POLICY_SCRIPT, "LRRL", 2);
+    topoReset();
+    int stopped = 0;
+    printf("lap script \"LRRL\", stop at lap 2:\n");
+    for (i = 0; i < (int)(sizeof(lap) / sizeof(lap[0])) && !stopped; i++){
+        fails += drive_junction(&policy, &lap[i], &stopped);
+    }
+    if (!stopped){
+        printf("  never stopped\n");
+        fails++;
+    }
+    printf("  %d laps, %s\n", policy.laps, stopped ? "stopped" : "still driving");
+
+    printf("classifier: %llu ns per frame on this host, %d bytes of state\n",
+        (unsigned long long)(classify_ns / (classified ? classified : 1)),
+        (int)((IMAGESIZEY - 1) * IMAGESIZEX + (TOPO_ROWS + TOPO_COLS) * (TOPO_MAX_SEGS * 2 + 1)));
+    printf("%s\n", fails ? "topology check FAILED" : "topology check passed");
+    return fails ? 1 : 0;
+}
@@ -0,0 +1,595 @@
+// Steering gain and speed tuner, on the closed loop simulator.
+// Every candidate is driven round each track by line_sim, the firmware
+// booting with the candidate's parameter record (params.h) in flash, and
+// scored by its lap time; a run that's off the line by more than the rms
+// limit pays for every mm over it, and one that doesn't finish costs more
+// than any that does, less the further it got.
+//
+// A coarse grid over base speed, kp, ki, kd and the speed planner's
+// lateral acceleration (speedplan.h, 0 is off) finds a start, then a
+// Nelder-Mead simplex walks down from the best grid point. Each simplex
+// step tries reflect, expand and both contractions at once, so there are
+// always a few runs to share out.
+//
+// The runs go to a pool of threads, one per core by default. hw18.c keeps
+// its state in globals and its time in the stub SDK's, so one firmware
+// can't run on several threads in a process; each thread runs line_sim as
+// its own process instead and waits for it. The runs take a fraction of
+// a second each, the fork is small next to that.
+//
+// The defaults the car runs without a record are driven first as the
+// baseline. The best candidate is written as a parameter record for the
+// car if it beats them, see params.h for getting it into flash; without
+// one the car still follows the line. -c runs the grid again on one
+// thread and reports the measured speedup; the CPU time the runs took
+// over the wall time is always reported, which is about the same.
+//
+// usage: tune [-j threads] [-t oval,bends] [-n laps] [-r rms limit mm]
+//             [-i iterations] [-c] [-x line_sim] [-o params.bin]
+// Exits non-zero if nothing, the defaults included, met the rms limit on
+// every track.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <spawn.h>
+#include <pthread.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include "params.h"
+
+#define DIMS 5 // base speed, kp, ki, kd, lateral acceleration
+#define TRACKS_MAX 4
+#define THREADS_MAX 64
+#define POINTS_MAX 160 // one batch
+#define LAP_LIMIT_S 60 // a run's time limit, a lap
+#define FAIL_S 1000.0 // a run that didn't finish
+#define OVER_S_PER_MM 2.0 // a run over the rms limit
+#define SIMPLEX_STEP 0.15 // the first simplex's size, of each range
+#define SIMPLEX_MIN 0.002 // stop once it's this small
+#define RP2350_XIP_BASE 0x10000000u // XIP_BASE on the host is the stub's flash
+
+extern char **environ;
+
+static const char *dimName[DIMS] = {"base", "kp", "ki", "kd", "lat"};
+static const double dimLo[DIMS] = {15, 0.02, 0, 0, 0};
+static const double dimHi[DIMS] = {100, 1.5, 1.0, 0.3, 1000};
+
+// the grid, in each dimension's units
+static const double gridBase[] = {30, 40, 55, 70};
+static const double gridKp[] = {0.1, 0.2, 0.3, 0.45};
+static const double gridKi[] = {0};
+static const double gridKd[] = {0, 0.03, 0.06};
+static const double gridLat[] = {0, 150, 300};
+
+// one candidate, x scaled to 0..1 of each range
+typedef struct point {
+    double x[DIMS];
+    double cost; // seconds a lap with the penalties, over the tracks
+    bool ok; // finished every track within the rms limit
+} point_t;
+
+// one candidate on one track
+typedef struct run {
+    point_t *point;
+    int track;
+    bool done;
+    double lapS, rmsMm, fraction; // mean lap, off the line, of the laps driven
+    double cpuS;
+} run_t;
+
+// the runs in a batch go to whichever thread is free
+typedef struct pool {
+    pthread_t thread[THREADS_MAX];
+    int threads;
+    pthread_mutex_t lock;
+    pthread_cond_t work, done;
+    run_t *runs;
+    int count, next, finished;
+    bool quit;
+} pool_t;
+
+static const char *simPath;
+static const char *tracks[TRACKS_MAX];
+static int numTracks;
+static int laps = 2; // a standing start and a flying lap, one lap can be luck
+static double rmsLimit = 30; // mm, the 100 mm look ahead alone cuts the 250 mm bends by 20
+static const char *tmpDir = "/tmp";
+static double cpuTotal;
+static int runsTotal;
+static pthread_mutex_t statsLock = PTHREAD_MUTEX_INITIALIZER;
+
+static double wall_s(){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static double value(const point_t *p, int d){
+    return dimLo[d] + p->x[d] * (dimHi[d] - dimLo[d]);
+}
+
+static double scaled(int d, double v){
+    return (v - dimLo[d]) / (dimHi[d] - dimLo[d]);
+}
+
+// the record the firmware boots with. The simulated tracks have no
+// markers, so the per segment speeds are left at 0: a marker doesn't
+// override the tuned speed on the car either.
+static void make_params(const point_t *p, params_t *rec){
+    paramsDefault(rec);
+    rec->basePercent = (uint8_t)lround(value(p, 0));
+    rec->kp = (float)value(p, 1);
+    rec->ki = (float)value(p, 2);
+    rec->kd = (float)value(p, 3);
+    rec->latAccel = (uint16_t)lround(value(p, 4));
+    memset(rec->segmentPercent, 0, sizeof(rec->segmentPercent));
+    paramsSeal(rec);
+}
+
+static int write_params(const point_t *p, const char *path){
+    params_t rec;
+    make_params(p, &rec);
+    FILE *f = fopen(path, "wb");
+    if (!f){
+        return -1;
+    }
+    size_t n = fwrite(&rec, sizeof(rec), 1, f);
+    return fclose(f) == 0 && n == 1 ? 0 : -1;
+}
+
+static double json_number(const char *json, const char *key){
+    char pattern[64];
+    snprintf(pattern, sizeof(pattern), "\"%s\":", key);
+    const char *s = strstr(json, pattern);
+    return s ? strtod(s + strlen(pattern), NULL) : 0;
+}
+
+// line_sim's report, what the run is scored on
+static int read_report(const char *path, run_t *r){
+    char json[2048];
+    FILE *f = fopen(path, "r");
+    if (!f){
+        return -1;
+    }
+    size_t n = fread(json, 1, sizeof(json) - 1, f);
+    fclose(f);
+    json[n] = 0;
+    const char *lap = strstr(json, "\"lap_ms\": [");
+    if (!lap){
+        return -1;
+    }
+    lap += strlen("\"lap_ms\": [");
+    double sum = 0;
+    int count = 0;
+    while (*lap != ']' && *lap){
+        char *end;
+        double ms = strtod(lap, &end);
+        if (end == lap){
+            break;
+        }
+        sum += ms;
+        count++;
+        lap = end + (*end == ',');
+    }
+    r->done = strstr(json, "\"result\": \"laps done\"") != NULL && count > 0;
+    r->lapS = count ? sum / count / 1000 : 0;
+    r->rmsMm = json_number(json, "line_rms_mm");
+    double trackMm = json_number(json, "track_mm");
+    r->fraction = trackMm > 0 ? json_number(json, "distance_mm") / (trackMm * laps) : 0;
+    if (r->fraction > 1) r->fraction = 1;
+    return 0;
+}
+
+// one candidate round one track, in its own line_sim process
+static void run_sim(run_t *r, int id){
+    char bin[256], json[256], simS[16], lapsArg[16];
+    snprintf(bin, sizeof(bin), "%s/tune_%d_%d.bin", tmpDir, (int)getpid(), id);
+    snprintf(json, sizeof(json), "%s/tune_%d_%d.json", tmpDir, (int)getpid(), id);
+    snprintf(simS, sizeof(simS), "%d", LAP_LIMIT_S * laps);
+    snprintf(lapsArg, sizeof(lapsArg), "%d", laps);
+    r->done = false;
+    r->lapS = r->rmsMm = r->fraction = r->cpuS = 0;
+    remove(json);
+    if (write_params(r->point, bin) != 0){
+        perror(bin);
+        return;
+    }
+    char *argv[] = {(char *)simPath, "-t", (char *)tracks[r->track], "-n", lapsArg, "-s", simS, "-p", bin, "-o", json,
+        NULL};
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, 1, "/dev/null", O_WRONLY, 0);
+    pid_t pid;
+    int err = posix_spawn(&pid, simPath, &actions, NULL, argv, environ);
+    posix_spawn_file_actions_destroy(&actions);
+    if (err != 0){
+        fprintf(stderr, "can't run %s: %s\n", simPath, strerror(err));
+        remove(bin);
+        return;
+    }
+    int status;
+    struct rusage ru;
+    if (wait4(pid, &status, 0, &ru) == pid){
+        r->cpuS = ru.ru_utime.tv_sec + ru.ru_utime.tv_usec * 1e-6 + ru.ru_stime.tv_sec + ru.ru_stime.tv_usec * 1e-6;
+        if (WIFEXITED(status) && WEXITSTATUS(status) == 0){
+            read_report(json, r);
+        }
+    }
+    remove(bin);
+    remove(json);
+    pthread_mutex_lock(&statsLock);
+    cpuTotal += r->cpuS;
+    runsTotal++;
+    pthread_mutex_unlock(&statsLock);
+}
+
+static void *worker(void *arg){
+    pool_t *pool = arg;
+    pthread_mutex_lock(&pool->lock);
+    while (true){
+        while (!pool->quit && pool->next >= pool->count){
+            pthread_cond_wait(&pool->work, &pool->lock);
+        }
+        if (pool->quit){
+            break;
+        }
+        int i = pool->next++;
+        pthread_mutex_unlock(&pool->lock);
+        run_sim(&pool->runs[i], i); // a batch at a time, the index names its files
+        pthread_mutex_lock(&pool->lock);
+        if (++pool->finished == pool->count){
+            pthread_cond_signal(&pool->done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+static int pool_start(pool_t *pool, int threads){
+    int i;
+    memset(pool, 0, sizeof(*pool));
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    for (i = 0; i < threads; i++){
+        if (pthread_create(&pool->thread[i], NULL, worker, pool) != 0){
+            break;
+        }
+        pool->threads++;
+    }
+    return pool->threads;
+}
+
+static void pool_stop(pool_t *pool){
+    int i;
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = true;
+    pthread_cond_broadcast(&pool->work);
+    pthread_mutex_unlock(&pool->lock);
+    for (i = 0; i < pool->threads; i++){
+        pthread_join(pool->thread[i], NULL);
+    }
+}
+
+// every run in the batch, back when they're all done
+static void pool_run(pool_t *pool, run_t *runs, int count){
+    pthread_mutex_lock(&pool->lock);
+    pool->runs = runs;
+    pool->count = count;
+    pool->next = pool->finished = 0;
+    pthread_cond_broadcast(&pool->work);
+    while (pool->finished < count){
+        pthread_cond_wait(&pool->done, &pool->lock);
+    }
+    pool->count = 0;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+// seconds a lap, with the penalties
+static double run_cost(const run_t *r){
+    if (!r->done){
+        return FAIL_S * (2 - r->fraction);
+    }
+    double cost = r->lapS;
+    if (r->rmsMm > rmsLimit){
+        cost += OVER_S_PER_MM * (r->rmsMm - rmsLimit);
+    }
+    return cost;
+}
+
+// the candidates on every track, a mean lap over the tracks
+static void evaluate(pool_t *pool, point_t *points, int count, run_t *runs){
+    int i, t;
+    for (i = 0; i < count; i++){
+        for (t = 0; t < numTracks; t++){
+            runs[i * numTracks + t].point = &points[i];
+            runs[i * numTracks + t].track = t;
+        }
+    }
+    pool_run(pool, runs, count * numTracks);
+    for (i = 0; i < count; i++){
+        points[i].cost = 0;
+        points[i].ok = true;
+        for (t = 0; t < numTracks; t++){
+            const run_t *r = &runs[i * numTracks + t];
+            points[i].cost += run_cost(r);
+            points[i].ok = points[i].ok && r->done && r->rmsMm <= rmsLimit;
+        }
+        points[i].cost /= numTracks;
+    }
+}
+
+static void clamp(point_t *p){
+    int d;
+    for (d = 0; d < DIMS; d++){
+        if (p->x[d] < 0) p->x[d] = 0;
+        if (p->x[d] > 1) p->x[d] = 1;
+    }
+}
+
+static void print_point(const char *label, const point_t *p){
+    int d;
+    printf("%-10s %8.2f s a lap%s |", label, p->cost, p->ok ? "" : " (over)");
+    for (d = 0; d < DIMS; d++){
+        printf(" %s %.3g", dimName[d], d == 0 || d == 4 ? (double)lround(value(p, d)) : value(p, d));
+    }
+    printf("\n");
+}
+
+static int by_cost(const void *a, const void *b){
+    double ca = ((const point_t *)a)->cost, cb = ((const point_t *)b)->cost;
+    return ca < cb ? -1 : (ca > cb ? 1 : 0);
+}
+
+static int grid(point_t *points){
+    int a, b, c, d, e, n = 0;
+    for (a = 0; a < (int)(sizeof(gridBase) / sizeof(gridBase[0])); a++){
+        for (b = 0; b < (int)(sizeof(gridKp) / sizeof(gridKp[0])); b++){
+            for (c = 0; c < (int)(sizeof(gridKi) / sizeof(gridKi[0])); c++){
+                for (d = 0; d < (int)(sizeof(gridKd) / sizeof(gridKd[0])); d++){
+                    for (e = 0; e < (int)(sizeof(gridLat) / sizeof(gridLat[0])); e++){
+                        point_t *p = &points[n++];
+                        p->x[0] = scaled(0, gridBase[a]);
+                        p->x[1] = scaled(1, gridKp[b]);
+                        p->x[2] = scaled(2, gridKi[c]);
+                        p->x[3] = scaled(3, gridKd[d]);
+                        p->x[4] = scaled(4, gridLat[e]);
+                    }
+                }
+            }
+        }
+    }
+    return n;
+}
+
+// Nelder-Mead from a start, the four ways a step can go tried together
+static point_t simplex_search(pool_t *pool, const point_t *start, int iterations, run_t *runs){
+    point_t s[DIMS + 1], trial[4];
+    int i, d, it;
+    s[0] = *start;
+    for (i = 1; i <= DIMS; i++){
+        s[i] = *start;
+        s[i].x[i - 1] += s[i].x[i - 1] + SIMPLEX_STEP <= 1 ? SIMPLEX_STEP : -SIMPLEX_STEP;
+    }
+    evaluate(pool, s + 1, DIMS, runs);
+    for (it = 0; it < iterations; it++){
+        qsort(s, DIMS + 1, sizeof(point_t), by_cost);
+        double size = 0;
+        for (i = 1; i <= DIMS; i++){
+            for (d = 0; d < DIMS; d++){
+                size = fmax(size, fabs(s[i].x[d] - s[0].x[d]));
+            }
+        }
+        if (size < SIMPLEX_MIN){
+            break;
+        }
+        // reflect, expand, contract outside and inside, about the centroid
+        static const double scale[4] = {1, 2, 0.5, -0.5};
+        double centroid[DIMS] = {0};
+        for (i = 0; i < DIMS; i++){
+            for (d = 0; d < DIMS; d++){
+                centroid[d] += s[i].x[d] / DIMS;
+            }
+        }
+        for (i = 0; i < 4; i++){
+            for (d = 0; d < DIMS; d++){
+                trial[i].x[d] = centroid[d] + scale[i] * (centroid[d] - s[DIMS].x[d]);
+            }
+            clamp(&trial[i]);
+        }
+        evaluate(pool, trial, 4, runs);
+        const point_t *r = &trial[0], *e = &trial[1], *oc = &trial[2], *ic = &trial[3];
+        bool shrink = false;
+        if (r->cost < s[0].cost){
+            s[DIMS] = e->cost < r->cost ? *e : *r;
+        } else if (r->cost < s[DIMS - 1].cost){
+            s[DIMS] = *r;
+        } else if (r->cost < s[DIMS].cost){
+            if (oc->cost <= r->cost){
+                s[DIMS] = *oc;
+            } else {
+                shrink = true;
+            }
+        } else if (ic->cost < s[DIMS].cost){
+            s[DIMS] = *ic;
+        } else {
+            shrink = true;
+        }
+        if (shrink){
+            // everything halfway to the best
+            for (i = 1; i <= DIMS; i++){
+                for (d = 0; d < DIMS; d++){
+                    s[i].x[d] = (s[i].x[d] + s[0].x[d]) / 2;
+                }
+            }
+            evaluate(pool, s + 1, DIMS, runs);
+        }
+        if (s[DIMS].cost < s[0].cost || shrink){
+            char label[16];
+            qsort(s, DIMS + 1, sizeof(point_t), by_cost);
+            snprintf(label, sizeof(label), "step %d", it + 1);
+            print_point(label, &s[0]);
+        }
+    }
+    qsort(s, DIMS + 1, sizeof(point_t), by_cost);
+    return s[0];
+}
+
+// each track's lap and rms for a candidate just evaluated on its own
+static void print_runs(const run_t *runs){
+    int t;
+    for (t = 0; t < numTracks; t++){
+        const run_t *r = &runs[t];
+        if (r->done){
+            printf("  %-8s lap %.2f s, off the line rms %.1f mm\n", tracks[t], r->lapS, r->rmsMm);
+        } else {
+            printf("  %-8s lost after %.0f%% of the laps, rms %.1f mm\n", tracks[t], r->fraction * 100, r->rmsMm);
+        }
+    }
+}
+
+static void print_tracks(pool_t *pool, point_t *p, run_t *runs){
+    evaluate(pool, p, 1, runs);
+    print_runs(runs);
+}
+
+int main(int argc, char **argv){
+    static point_t points[POINTS_MAX];
+    static run_t runs[POINTS_MAX * TRACKS_MAX];
+    static char defaultSim[1024];
+    const char *outPath = "params.bin", *trackList = "oval,bends";
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN), iterations = 60, i, d;
+    bool compare = false;
+    for (i = 1; i < argc; i++){
+        if (strcmp(argv[i], "-c") == 0){
+            compare = true;
+        } else if (i + 1 >= argc){
+            break;
+        } else if (strcmp(argv[i], "-j") == 0){
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-t") == 0){
+            trackList = argv[++i];
+        } else if (strcmp(argv[i], "-n") == 0){
+            laps = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-r") == 0){
+            rmsLimit = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-i") == 0){
+            iterations = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-x") == 0){
+            simPath = argv[++i];
+        } else if (strcmp(argv[i], "-o") == 0){
+            outPath = argv[++i];
+        }
+    }
+    if (threads < 1) threads = 1;
+    if (threads > THREADS_MAX) threads = THREADS_MAX;
+    if (laps < 1) laps = 1;
+    if (getenv("TMPDIR")){
+        tmpDir = getenv("TMPDIR");
+    }
+    // line_sim is built next to this
+    if (!simPath){
+        const char *slash = strrchr(argv[0], '/');
+        snprintf(defaultSim, sizeof(defaultSim), "%.*sline_sim", slash ? (int)(slash - argv[0] + 1) : 0, argv[0]);
+        simPath = slash ? defaultSim : "./line_sim";
+    }
+    if (access(simPath, X_OK) != 0){
+        fprintf(stderr, "no simulator at %s, -x says where\n", simPath);
+        return 1;
+    }
+    static char trackBuf[256];
+    snprintf(trackBuf, sizeof(trackBuf), "%s", trackList);
+    char *save, *name;
+    for (name = strtok_r(trackBuf, ",", &save); name && numTracks < TRACKS_MAX; name = strtok_r(NULL, ",", &save)){
+        tracks[numTracks++] = name;
+    }
+
+    pool_t pool;
+    threads = pool_start(&pool, threads);
+    if (threads == 0){
+        fprintf(stderr, "no threads\n");
+        return 1;
+    }
+    printf("%d threads, %d track%s of %d lap%s, rms limit %.1f mm\n", threads, numTracks, numTracks == 1 ? "" : "s", laps,
+        laps == 1 ? "" : "s", rmsLimit);
+
+    double start = wall_s();
+    point_t defaults;
+    params_t rec;
+    paramsDefault(&rec);
+    defaults.x[0] = scaled(0, rec.basePercent);
+    defaults.x[1] = scaled(1, rec.kp);
+    defaults.x[2] = scaled(2, rec.ki);
+    defaults.x[3] = scaled(3, rec.kd);
+    defaults.x[4] = scaled(4, rec.latAccel);
+    // what the car runs without a record, the baseline
+    evaluate(&pool, &defaults, 1, runs);
+    print_point("defaults", &defaults);
+    print_runs(runs);
+
+    int n = grid(points);
+    double gridStart = wall_s();
+    evaluate(&pool, points, n, runs);
+    double gridWall = wall_s() - gridStart;
+    qsort(points, n, sizeof(point_t), by_cost);
+    for (i = 0; i < 3 && i < n; i++){
+        print_point(i == 0 ? "grid best" : "", &points[i]);
+    }
+    point_t best = points[0];
+    if (defaults.cost < best.cost){
+        best = defaults;
+    }
+    printf("grid: %d candidates, %d runs in %.1f s\n", n, n * numTracks, gridWall);
+
+    best = simplex_search(&pool, &best, iterations, runs);
+    double wall = wall_s() - start;
+    print_point("best", &best);
+    print_tracks(&pool, &best, runs);
+
+    printf("%d runs in %.1f s on %d threads, %.1f s of CPU: %.1fx serial\n", runsTotal, wall, threads, cpuTotal,
+        wall > 0 ? cpuTotal / wall : 0);
+    pool_stop(&pool);
+    if (compare){
+        // the same grid again on one thread
+        pool_t serial;
+        pool_start(&serial, 1);
+        n = grid(points);
+        double serialStart = wall_s();
+        evaluate(&serial, points, n, runs);
+        double serialWall = wall_s() - serialStart;
+        pool_stop(&serial);
+        printf("grid on 1 thread %.1f s, on %d %.1f s: %.2fx\n", serialWall, threads, gridWall,
+            gridWall > 0 ? serialWall / gridWall : 0);
+    }
+
+    // the record is only worth loading if it beats what the car runs without one
+    if (defaults.ok && (!best.ok || best.cost >= defaults.cost)){
+        printf("nothing beat the defaults, no parameters written, the car runs them without a record\n");
+        return 0;
+    }
+    if (!best.ok){
+        printf("nothing finished every track within %.1f mm, no parameters written\n", rmsLimit);
+        return 1;
+    }
+    if (defaults.ok){
+        printf("%.2f s a lap against the defaults' %.2f s\n", best.cost, defaults.cost);
+    }
+    if (write_params(&best, outPath) != 0){
+        perror(outPath);
+        return 1;
+    }
+    make_params(&best, &rec);
+    printf("wrote %s:", outPath);
+    for (d = 0; d < DIMS; d++){
+        printf(" %s %.3g", dimName[d], d == 0 ? (double)rec.basePercent : d == 4 ? (double)rec.latAccel : value(&best, d));
+    }
+    printf("\nto the car: picotool load -o 0x%08x %s\n", RP2350_XIP_BASE + (unsigned)PARAMS_FLASH_OFFSET, outPath);
+    printf("in the simulator: line_sim -p %s\n", outPath);
+    return 0;
+}
@@ -0,0 +1,157 @@
+// Checks the wheel speed estimate and speed loops (wheel.c) on the
+// simulated encoders. The estimate against the true speed from a crawl
+// to full speed, next to plain counts per 10 ms window, and how fast it
+// sees a stop. Then the PI holding speed on a full and a flat battery,
+// next to the same commands open loop, and after a stop.
+//
+// usage: wheel_check
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "pico/stdlib.h"
+#include "encoder.h"
+#include "wheel.h"
+#include "sim_encoder.h"
+
+#define WRAP 255
+#define TICK_US 2000 // the steering tick calls the loops this often
+
+// rms error of the estimate in % of the true speed, over 3 s at a steady speed
+static void estimate_error(float cps, float *ours, float *window){
+    wheelSpeed_t ws;
+    int32_t counts[5];
+    double sumOurs = 0, sumWindow = 0;
+    int n = 0, t;
+    sim_encoder_reset();
+    simEncoder.fixedSpeed = 1;
+    simEncoder.wheel[0].cps = cps;
+    wheelSpeedReset(&ws);
+    for(t=0;t<1750;t++){
+        int32_t c = encoderCount(0);
+        float est = wheelSpeedUpdate(&ws, c, time_us_64());
+        memmove(counts, counts + 1, sizeof(int32_t) * 4);
+        counts[4] = c;
+        if (t >= 250){
+            float win = (float)(counts[4] - counts[0]) * 1e6f / (4 * TICK_US);
+            sumOurs += (est - cps) * (est - cps);
+            sumWindow += (win - cps) * (win - cps);
+            n++;
+        }
+        sleep_us(TICK_US);
+    }
+    *ours = (float)(100 * sqrt(sumOurs / n) / cps);
+    *window = (float)(100 * sqrt(sumWindow / n) / cps);
+}
+
+static int check_estimate(){
+    static const float speeds[] = {15, 60, 250, 1000, 5000};
+    int i, bad = 0;
+    printf("speed cps  estimate rms %%  8 ms window rms %%\n");
+    for(i=0;i<(int)(sizeof(speeds) / sizeof(speeds[0]));i++){
+        float ours, window;
+        estimate_error(speeds[i], &ours, &window);
+        // slowly the window sees 0 or 1 edges, fast they're both exact
+        int ok = ours < 12 && (window < 5 || ours < window / 3);
+        printf("%9.0f  %14.1f  %17.1f  %s\n", speeds[i], ours, window, ok ? "ok" : "WRONG");
+        bad += !ok;
+    }
+    return bad;
+}
+
+// the wheel stops dead, how long until the estimate says so
+static int check_stop(){
+    wheelSpeed_t ws;
+    int t, bad = 0;
+    sim_encoder_reset();
+    simEncoder.fixedSpeed = 1;
+    simEncoder.wheel[0].cps = 800;
+    wheelSpeedReset(&ws);
+    for(t=0;t<200;t++){
+        wheelSpeedUpdate(&ws, encoderCount(0), time_us_64());
+        sleep_us(TICK_US);
+    }
+    simEncoder.wheel[0].cps = 0;
+    float last = ws.cps;
+    int below10 = -1, zero = -1;
+    for(t=0;t<200 && zero < 0;t++){
+        float est = wheelSpeedUpdate(&ws, encoderCount(0), time_us_64());
+        if (est > last){
+            bad++; // must only come down
+        }
+        last = est;
+        if (below10 < 0 && est < 80) below10 = t * TICK_US / 1000;
+        if (est == 0) zero = t * TICK_US / 1000;
+        sleep_us(TICK_US);
+    }
+    int ok = !bad && below10 >= 0 && below10 <= 30 && zero >= 0 && zero <= WHEEL_STOP_US / 1000 + 4;
+    printf("stop from 800 cps: under 10%% after %d ms, zero after %d ms, %s\n", below10, zero, ok ? "ok" : "WRONG");
+    return !ok;
+}
+
+// drive both wheels at one command for 2 s, mean speed over the last 0.5 s
+static float run(int cmd, float battery, bool closed){
+    sim_encoder_reset();
+    simEncoder.battery = battery;
+    wheelGains_t g;
+    wheelDefaultGains(&g);
+    wheelInit(&g, WRAP, sim_encoder_output);
+    wheelSetClosedLoop(closed);
+    double sum = 0;
+    int t, n = 0;
+    for(t=0;t<1000;t++){
+        wheelDrive(cmd, cmd);
+        sleep_us(TICK_US);
+        if (t >= 750){
+            sum += simEncoder.wheel[ENCODER_LEFT].cps;
+            n++;
+        }
+    }
+    return (float)(sum / n);
+}
+
+static int check_loops(){
+    static const int cmds[] = {140, 30};
+    static const float batteries[] = {1.0f, 0.75f};
+    int i, j, bad = 0;
+    printf("command  battery  target cps  open loop  closed loop\n");
+    for(i=0;i<2;i++){
+        for(j=0;j<2;j++){
+            float target = (float)cmds[i] / WRAP * WHEEL_MAX_CPS;
+            float open = run(cmds[i], batteries[j], false);
+            float closed = run(cmds[i], batteries[j], true);
+            int ok = fabsf(closed - target) < target * 0.03f;
+            printf("%7d  %7.2f  %10.0f  %8.0f  %11.0f  %s\n", cmds[i], batteries[j], target, open, closed, ok ? "ok" : "WRONG");
+            bad += !ok;
+        }
+    }
+    return bad;
+}
+
+// stop and go again, the loop must start over with its gains
+static int check_restart(){
+    sim_encoder_reset();
+    wheelGains_t g;
+    wheelDefaultGains(&g);
+    wheelInit(&g, WRAP, sim_encoder_output);
+    int t;
+    for(t=0;t<1000;t++){
+        wheelDrive(t < 250 || t >= 500 ? 140 : 0, 140);
+        sleep_us(TICK_US);
+    }
+    float target = 140.0f / WRAP * WHEEL_MAX_CPS;
+    float left = simEncoder.wheel[ENCODER_LEFT].cps;
+    int ok = fabsf(left - target) < target * 0.03f;
+    printf("stopped and started again: %.0f cps for %.0f, %s\n", left, target, ok ? "ok" : "WRONG");
+    return !ok;
+}
+
+int main(){
+    int bad = check_estimate();
+    bad += check_stop();
+    bad += check_loops();
+    bad += check_restart();
+    printf("%s\n", bad ? "wheel check FAILED" : "wheel check passed");
+    return bad ? 1 : 0;
+}
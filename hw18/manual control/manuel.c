@@ -1,7 +1,8 @@
 #include "pico/stdlib.h"
-#include "hardware/pwm.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include "motion.h"
+#include "motor.h"
 
 // === Your Motor Pin Setup ===
 #define A_PHASE 16     // Motor A (Left) Direction
@@ -10,41 +11,82 @@
 #define B_ENABLE 19    // Motor B (Right) Speed
 
 #define WRAP 255
-#define CLK_DIV 1.0f
+#define PWM_FREQ 20000 // Hz, out of hearing
 
 int duty_a = 0; // Range: -100 to +100
 int duty_b = 0; // Range: -100 to +100
 
-// Add a reverse flag for correcting direction per motor
-void set_motor(int duty_percent, uint enbl, uint phase, bool invert_dir) {
-    if (duty_percent > 100) duty_percent = 100;
-    if (duty_percent < -100) duty_percent = -100;
+// both motors in percent, also the motion executor's output
+void drive(int left, int right) {
+    if (left > 100) left = 100;
+    if (left < -100) left = -100;
+    if (right > 100) right = 100;
+    if (right < -100) right = -100;
+    motorSet(left * WRAP / 100, right * WRAP / 100);
+}
 
-    bool forward = duty_percent >= 0;
-    gpio_put(phase, invert_dir ? !forward : forward ? 0 : 1); // Adjust per motor
-    gpio_set_function(enbl, GPIO_FUNC_PWM);
-    uint slice = pwm_gpio_to_slice_num(enbl);
-    pwm_set_wrap(slice, WRAP);
-    pwm_set_clkdiv(slice, CLK_DIV);
-    pwm_set_chan_level(slice, pwm_gpio_to_channel(enbl), abs(duty_percent * WRAP / 100));
-    pwm_set_enabled(slice, true);
+// the rest of a command line, up to Enter or a second without a key
+int read_line(char *line, int size) {
+    int n = 0;
+    while (n < size - 1) {
+        int c = getchar_timeout_us(1000000);
+        if (c == PICO_ERROR_TIMEOUT || c == '\r' || c == '\n') {
+            break;
+        }
+        line[n++] = (char)c;
+    }
+    line[n] = 0;
+    return n;
 }
 
 int main() {
     stdio_init_all();
 
-    gpio_init(A_PHASE); gpio_set_dir(A_PHASE, GPIO_OUT);
-    gpio_init(B_PHASE); gpio_set_dir(B_PHASE, GPIO_OUT);
+    // the PWM is set up once here, not on every speed change
+    motorConfig_t motors;
+    motorDefaultConfig(&motors);
+    motors.pins[MOTOR_LEFT].phase = A_PHASE;
+    motors.pins[MOTOR_LEFT].enable = A_ENABLE;
+    motors.pins[MOTOR_RIGHT].phase = B_PHASE;
+    motors.pins[MOTOR_RIGHT].enable = B_ENABLE;
+    motors.pins[MOTOR_LEFT].freqHz = motors.pins[MOTOR_RIGHT].freqHz = PWM_FREQ;
+    motors.wrap = WRAP;
+    bool motors_ok = motorInit(&motors) == 0;
 
     while (!stdio_usb_connected()) {
         tight_loop_contents();
     }
 
+    // scripted moves run from a timer, the keys stay live while they do
+    motionConfig_t motion;
+    motionDefaultConfig(&motion);
+    motion.maxSpeed = motion.topSpeed * 80 / 100; // the old square path's 80%
+    motion.outputScale = 100;
+    motionInit(&motion);
+    motionStart(drive);
+
+    if (!motors_ok) {
+        printf("Motors: no PWM for %d Hz\n", PWM_FREQ);
+    }
     printf("Manual dual motor control ready.\n");
 
     while (true) {
         int c = getchar_timeout_us(0);
-        if (c != PICO_ERROR_TIMEOUT) {
+        if (c != PICO_ERROR_TIMEOUT && motionBusy()) {
+            // any key stops a script
+            motionAbort();
+            printf("Script aborted.\n");
+        } else if (c == ':') {
+            // a script line, e.g. ":S 500;T 90;A 200 -90", see motionParse()
+            char line[MOTION_LINE_MAX];
+            read_line(line, sizeof(line));
+            int n = motionParse(line);
+            if (n < 0) {
+                printf("Bad or too many moves: %s\n", line);
+            } else {
+                printf("Queued %d moves.\n", n);
+            }
+        } else if (c != PICO_ERROR_TIMEOUT) {
             if (c == 'w') {
                 duty_a = 100;   // Left motor forward
                 duty_b = 100;   // Right motor forward
@@ -61,22 +103,15 @@ int main() {
                 duty_a = -100;
                 duty_b = -100;
             } else if (c == 'q') {
+                // half a metre a side, turning right at the corners
                 printf("Square path movement starting...\n");
-                for (int i = 0; i < 4; i++) {
-                    set_motor(80, A_ENABLE, A_PHASE, false);
-                    set_motor(80, B_ENABLE, B_PHASE, true);
-                    sleep_ms(1000);
-
-                    set_motor(80, A_ENABLE, A_PHASE, false);
-                    set_motor(-80, B_ENABLE, B_PHASE, true);
-                    sleep_ms(1000);
-                }
                 duty_a = 0;
                 duty_b = 0;
+                motionParse("S 500;T -90;S 500;T -90;S 500;T -90;S 500;T -90");
+                continue;
             }
 
-            set_motor(duty_a, A_ENABLE, A_PHASE, false); // Left motor: normal
-            set_motor(duty_b, B_ENABLE, B_PHASE, true);  // Right motor: inverted
+            drive(duty_a, duty_b);
         }
 
         sleep_ms(20);
@@ -0,0 +1,374 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "pico/stdlib.h"
+#include "motion.h"
+
+#define MOTION_PI 3.14159265f
+
+static motionConfig_t motionCfg;
+
+// the queue: the main loop adds at the head, the tick takes from the tail
+static motionSegment_t motionRing[MOTION_QUEUE];
+static volatile uint32_t motionHead = 0, motionTail = 0;
+static volatile bool motionAbortReq = false;
+static volatile uint32_t motionAbortHead = 0; // the abort drops up to here
+// limits from motionParse(), the tick takes them when nothing runs
+static volatile bool motionLimitReq = false;
+static volatile float motionLimitSpeed, motionLimitAccel;
+
+// the tick's state
+static volatile bool motionRunning = false, motionBraking = false;
+static motionProfile_t motionProf;
+static float motionLeftRatio, motionRightRatio; // wheel speed per profile speed
+static uint64_t motionStartUs;
+static float motionBrakeLeft, motionBrakeRight, motionBrakeS; // speeds when aborted
+
+static repeating_timer_t motionTimer;
+static bool motionTimerOn = false;
+static motionOutput_t motionOut = NULL;
+
+void motionProfileMake(motionProfile_t *p, float distance, float maxSpeed, float maxAccel, int shape){
+    // a half cosine ramp covers the same distance as a straight one in the
+    // same time, its peak acceleration is pi/2 higher so it takes longer
+    float k = shape == MOTION_SCURVE ? MOTION_PI / 2 : 1;
+    memset(p, 0, sizeof(*p));
+    p->distance = fabsf(distance);
+    p->shape = shape;
+    if (p->distance <= 0 || maxSpeed <= 0 || maxAccel <= 0){
+        return;
+    }
+    p->peak = maxSpeed;
+    p->rampS = k * maxSpeed / maxAccel;
+    if (p->peak * p->rampS >= p->distance){
+        // too short to get up to speed, ramp up and straight back down
+        p->peak = sqrtf(p->distance * maxAccel / k);
+        p->rampS = k * p->peak / maxAccel;
+    } else {
+        p->cruiseS = (p->distance - p->peak * p->rampS) / p->peak;
+    }
+}
+
+float motionProfileTime(const motionProfile_t *p){
+    return 2 * p->rampS + p->cruiseS;
+}
+
+// speed and distance u of the way up a ramp, 0 to 1
+static float motionRampSpeed(const motionProfile_t *p, float u){
+    if (p->shape == MOTION_SCURVE){
+        return p->peak * (1 - cosf(MOTION_PI * u)) / 2;
+    }
+    return p->peak * u;
+}
+
+static float motionRampDistance(const motionProfile_t *p, float u){
+    if (p->shape == MOTION_SCURVE){
+        return p->peak * p->rampS * (u - sinf(MOTION_PI * u) / MOTION_PI) / 2;
+    }
+    return p->peak * p->rampS * u * u / 2;
+}
+
+float motionProfileSpeed(const motionProfile_t *p, float t){
+    float total = motionProfileTime(p);
+    if (t <= 0 || t >= total || p->rampS <= 0){
+        return 0;
+    }
+    if (t < p->rampS){
+        return motionRampSpeed(p, t / p->rampS);
+    }
+    if (t < p->rampS + p->cruiseS){
+        return p->peak;
+    }
+    return motionRampSpeed(p, (total - t) / p->rampS);
+}
+
+float motionProfileDistance(const motionProfile_t *p, float t){
+    float total = motionProfileTime(p);
+    if (t <= 0 || p->rampS <= 0){
+        return 0;
+    }
+    if (t >= total){
+        return p->distance;
+    }
+    if (t < p->rampS){
+        return motionRampDistance(p, t / p->rampS);
+    }
+    if (t < p->rampS + p->cruiseS){
+        return motionRampDistance(p, 1) + p->peak * (t - p->rampS);
+    }
+    return p->distance - motionRampDistance(p, (total - t) / p->rampS);
+}
+
+void motionDefaultConfig(motionConfig_t *cfg){
+    cfg->topSpeed = 600;
+    cfg->track = 120;
+    cfg->maxSpeed = 300;
+    cfg->maxAccel = 600;
+    cfg->shape = MOTION_SCURVE;
+    cfg->outputScale = 255;
+}
+
+void motionInit(const motionConfig_t *cfg){
+    motionCfg = *cfg;
+    motionHead = motionTail = 0;
+    motionRunning = motionBraking = false;
+    motionAbortReq = false;
+    motionLimitReq = false;
+}
+
+// add a segment behind the others, -1 if the queue is full
+int motionQueue(const motionSegment_t *seg){
+    uint32_t next = (motionHead + 1) % MOTION_QUEUE;
+    if (next == motionTail){
+        return -1;
+    }
+    motionRing[motionHead] = *seg;
+    __sync_synchronize(); // the segment is in before the tick can see it
+    motionHead = next;
+    return 0;
+}
+
+// stop what's running as fast as the acceleration limit allows and drop
+// what's queued so far, the next tick does it. Segments queued after this
+// run once the car has stopped.
+void motionAbort(){
+    motionAbortHead = motionHead;
+    __sync_synchronize(); // the tick sees where to drop to with the request
+    motionAbortReq = true;
+}
+
+bool motionBusy(){
+    return motionRunning || motionBraking || motionHead != motionTail || motionAbortReq || motionLimitReq;
+}
+
+int motionPending(){
+    return (int)((motionHead + MOTION_QUEUE - motionTail) % MOTION_QUEUE);
+}
+
+// the profile and how each wheel follows it
+static void motionBegin(const motionSegment_t *seg){
+    float half = motionCfg.track / 2;
+    float lead = 0;
+    motionLeftRatio = motionRightRatio = 1;
+    if (seg->kind == MOTION_STRAIGHT){
+        lead = fabsf(seg->distance);
+        if (seg->distance < 0){
+            motionLeftRatio = motionRightRatio = -1;
+        }
+    } else if (seg->kind == MOTION_TURN){
+        lead = fabsf(seg->angle) * MOTION_PI / 180 * half;
+        motionLeftRatio = seg->angle > 0 ? -1 : 1;
+        motionRightRatio = -motionLeftRatio;
+    } else if (seg->kind == MOTION_ARC && seg->radius > 0){
+        // the outer wheel leads, the inner one goes slower or even backwards
+        lead = fabsf(seg->angle) * MOTION_PI / 180 * (seg->radius + half);
+        float inner = (seg->radius - half) / (seg->radius + half);
+        if (seg->angle > 0){
+            motionLeftRatio = inner;
+        } else {
+            motionRightRatio = inner;
+        }
+    }
+    motionProfileMake(&motionProf, lead, motionCfg.maxSpeed, motionCfg.maxAccel, seg->shape);
+}
+
+static int motionScale(float speed){
+    return (int)lroundf(speed / motionCfg.topSpeed * motionCfg.outputScale);
+}
+
+// one step: the wheel outputs for now. Returns false when there's nothing
+// to run and the outputs are left alone, the tick a script ends on still
+// returns true with both at 0.
+bool motionTick(uint64_t nowUs, int *left, int *right){
+    if (motionAbortReq){
+        motionTail = motionAbortHead;
+        if (motionRunning){
+            float t = (float)(nowUs - motionStartUs) * 1e-6f;
+            float v = motionProfileSpeed(&motionProf, t);
+            motionBrakeLeft = v * motionLeftRatio;
+            motionBrakeRight = v * motionRightRatio;
+            motionBrakeS = v / motionCfg.maxAccel;
+            motionStartUs = nowUs;
+            motionRunning = false;
+            motionBraking = true;
+        }
+        motionAbortReq = false;
+    }
+    // the brake keeps the limits it started with, new ones are for what follows
+    if (motionLimitReq && !motionRunning){
+        motionCfg.maxSpeed = motionLimitSpeed;
+        motionCfg.maxAccel = motionLimitAccel;
+        __sync_synchronize();
+        motionLimitReq = false;
+    }
+    if (motionBraking){
+        float u = motionBrakeS > 0 ? (float)(nowUs - motionStartUs) * 1e-6f / motionBrakeS : 1;
+        if (u >= 1){
+            motionBraking = false;
+            *left = *right = 0;
+            return true;
+        }
+        *left = motionScale(motionBrakeLeft * (1 - u));
+        *right = motionScale(motionBrakeRight * (1 - u));
+        return true;
+    }
+
+    bool ended = false;
+    if (motionRunning){
+        float t = (float)(nowUs - motionStartUs) * 1e-6f;
+        float total = motionProfileTime(&motionProf);
+        if (t >= total){
+            motionRunning = false;
+            ended = true;
+            // the next one starts where this one should have ended, not
+            // on this tick, so timing errors don't add up along a path
+            motionStartUs += (uint64_t)(total * 1e6f);
+        }
+    } else {
+        motionStartUs = nowUs;
+    }
+    if (!motionRunning){
+        if (motionTail == motionHead){
+            if (!ended){
+                return false;
+            }
+            *left = *right = 0;
+            return true;
+        }
+        __sync_synchronize();
+        motionBegin(&motionRing[motionTail]);
+        motionTail = (motionTail + 1) % MOTION_QUEUE;
+        motionRunning = true;
+    }
+    float v = motionProfileSpeed(&motionProf, (float)(nowUs - motionStartUs) * 1e-6f);
+    *left = motionScale(v * motionLeftRatio);
+    *right = motionScale(v * motionRightRatio);
+    return true;
+}
+
+static bool motionCallback(repeating_timer_t *rt){
+    (void)rt;
+    int left, right;
+    if (motionTick(time_us_64(), &left, &right) && motionOut){
+        motionOut(left, right);
+    }
+    return motionTimerOn;
+}
+
+// run the executor on a timer of its own, for a program with no control
+// loop to call motionTick() from
+bool motionStart(motionOutput_t output){
+    motionOut = output;
+    motionTimerOn = add_repeating_timer_us(-1000000 / MOTION_RATE_HZ, motionCallback, NULL, &motionTimer);
+    return motionTimerOn;
+}
+
+void motionStop(){
+    if (motionTimerOn){
+        cancel_repeating_timer(&motionTimer);
+        motionTimerOn = false;
+    }
+}
+
+// queue segments from a line of text, several separated by ';':
+//   S mm        straight, - backwards
+//   T deg       turn on the spot, + anticlockwise
+//   A mm deg    arc of that radius, + anticlockwise
+//   X           abort what was running before the line
+//   P T|S       trapezoid or S-curve for what follows
+//   V mm/s mm/s^2  speed and acceleration limits, before any move and
+//               only while nothing runs or after X
+// The whole line is checked first, a bad command or more moves than the
+// queue has room for and nothing of it happens.
+// returns the segments queued, -1 if a command was bad or didn't fit
+int motionParse(const char *line){
+    char buf[MOTION_LINE_MAX];
+    strncpy(buf, line, sizeof(buf) - 1);
+    buf[sizeof(buf) - 1] = 0;
+    motionSegment_t segs[MOTION_QUEUE];
+    int n = 0, shape = motionCfg.shape, abort = 0, limits = 0;
+    float maxSpeed = 0, maxAccel = 0;
+    char *save = NULL;
+    char *cmd = strtok_r(buf, ";", &save);
+    for(;cmd;cmd=strtok_r(NULL, ";", &save)){
+        while (isspace((unsigned char)*cmd)){
+            cmd++;
+        }
+        char op = (char)toupper((unsigned char)*cmd);
+        char *p = cmd + (*cmd ? 1 : 0);
+        char *end;
+        float a = strtof(p, &end);
+        int haveA = end != p;
+        p = end;
+        float b = strtof(p, &end);
+        int haveB = end != p;
+        if (op == 'X'){
+            abort = 1;
+            continue;
+        } else if (op == 'P'){
+            while (isspace((unsigned char)*p)){
+                p++;
+            }
+            if (toupper((unsigned char)*p) == 'T'){
+                shape = MOTION_TRAPEZOID;
+            } else if (toupper((unsigned char)*p) == 'S'){
+                shape = MOTION_SCURVE;
+            } else {
+                return -1;
+            }
+            continue;
+        } else if (op == 'V' && haveA && haveB && a > 0 && b > 0 && n == 0 && (abort || !motionBusy())){
+            // nothing queued before runs with them, the tick takes them once it's idle
+            limits = 1;
+            maxSpeed = a;
+            maxAccel = b;
+            continue;
+        } else if (op == 0){
+            continue;
+        }
+        if (n == MOTION_QUEUE){
+            return -1;
+        }
+        motionSegment_t *seg = &segs[n];
+        memset(seg, 0, sizeof(*seg));
+        seg->shape = (uint8_t)shape;
+        if (op == 'S' && haveA){
+            seg->kind = MOTION_STRAIGHT;
+            seg->distance = a;
+        } else if (op == 'T' && haveA){
+            seg->kind = MOTION_TURN;
+            seg->angle = a;
+        } else if (op == 'A' && haveA && haveB && a > 0){
+            seg->kind = MOTION_ARC;
+            seg->radius = a;
+            seg->angle = b;
+        } else {
+            return -1;
+        }
+        n++;
+    }
+    // one slot of the ring always stays empty
+    if (n > MOTION_QUEUE - 1 - motionPending()){
+        return -1;
+    }
+
+    // all of it is good, now it happens
+    if (abort){
+        motionAbort();
+    }
+    motionCfg.shape = shape;
+    if (limits){
+        motionLimitSpeed = maxSpeed;
+        motionLimitAccel = maxAccel;
+        __sync_synchronize();
+        motionLimitReq = true;
+    }
+    int i;
+    for(i=0;i<n;i++){
+        if (motionQueue(&segs[i]) != 0){
+            return -1;
+        }
+    }
+    return n;
+}
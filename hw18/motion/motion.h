@@ -0,0 +1,79 @@
+#ifndef MOTION_h
+#define MOTION_h
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Scripted manoeuvres: straights, turns on the spot and arcs, each run as
+// a velocity profile from a timer so the caller never waits on them.
+// Segments are queued from the main loop and the tick takes them in
+// order, so a whole path is queued at once and the USB keeps working.
+// motionAbort() brings a running script to a stop within the braking
+// distance and drops what was queued before it.
+//
+// The profile is on the distance the fastest wheel covers: trapezoidal,
+// or an S-curve whose speed ramps are half a cosine, which takes the
+// same distance with no step in acceleration. Distances are nominal, from
+// the configured top speed, until the wheel loops make them true.
+
+#define MOTION_QUEUE 16 // segments, one less can be waiting
+#define MOTION_RATE_HZ 200 // when run on its own timer
+#define MOTION_LINE_MAX 48 // longest command line for motionParse()
+
+// segment kinds
+#define MOTION_STRAIGHT 0 // distance mm, - backwards
+#define MOTION_TURN 1 // angle degrees on the spot, + anticlockwise
+#define MOTION_ARC 2 // radius mm and angle degrees, + anticlockwise forwards
+
+// profile shapes
+#define MOTION_TRAPEZOID 0
+#define MOTION_SCURVE 1
+
+typedef struct motionConfig {
+    float topSpeed; // mm/s a wheel does at full output
+    float track; // mm between the wheels
+    float maxSpeed; // mm/s a profile may reach, per wheel
+    float maxAccel; // mm/s^2 per wheel, the S-curve's peak
+    int shape; // MOTION_TRAPEZOID or MOTION_SCURVE
+    int outputScale; // full output, e.g. WRAP or 100 for percent
+} motionConfig_t;
+
+typedef struct motionSegment {
+    uint8_t kind;
+    uint8_t shape;
+    float distance; // MOTION_STRAIGHT
+    float radius; // MOTION_ARC
+    float angle; // MOTION_TURN and MOTION_ARC
+} motionSegment_t;
+
+// a speed profile over one distance, all positive
+typedef struct motionProfile {
+    float distance;
+    float peak; // top speed reached
+    float rampS; // time to reach it, and to stop from it
+    float cruiseS;
+    int shape;
+} motionProfile_t;
+
+typedef void (*motionOutput_t)(int left, int right);
+
+// profiles on their own
+void motionProfileMake(motionProfile_t *p, float distance, float maxSpeed, float maxAccel, int shape);
+float motionProfileTime(const motionProfile_t *p);
+float motionProfileSpeed(const motionProfile_t *p, float t);
+float motionProfileDistance(const motionProfile_t *p, float t);
+
+void motionDefaultConfig(motionConfig_t *cfg);
+void motionInit(const motionConfig_t *cfg);
+int motionQueue(const motionSegment_t *seg);
+int motionParse(const char *line);
+void motionAbort();
+bool motionBusy();
+int motionPending();
+
+// the executor: called from a caller's own timer, or on one of its own
+bool motionTick(uint64_t nowUs, int *left, int *right);
+bool motionStart(motionOutput_t output);
+void motionStop();
+
+#endif
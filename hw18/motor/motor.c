@@ -0,0 +1,271 @@
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/pwm.h"
+#include "hardware/irq.h"
+#include "hardware/clocks.h"
+#include "motor.h"
+
+static motorConfig_t motorCfg;
+static uint motorSlice[MOTORS][2], motorChan[MOTORS][2]; // phase/IN1 and enable/IN2 pins
+static uint32_t motorPeriod[MOTORS], motorFreq[MOTORS];
+static uint32_t motorPhaseMask = 0, motorSliceMask = 0, motorWrapMask = 0;
+static uint16_t motorLevel[NUM_PWM_SLICES][2]; // what each of our slices has been given
+static bool motorIrqAdded = false;
+
+// signed duty in counts << 8, where each motor is and where it's going
+static volatile int32_t motorNow[MOTORS], motorTarget[MOTORS];
+static int32_t motorStep[MOTORS]; // a period at most, counts << 8
+static volatile int motorLast[MOTORS];
+
+// the hw18 car, 16/17 left and 18/19 right on a DRV8835 in phase/enable
+// mode, at 20kHz: out of hearing and well inside what the bridge switches
+void motorDefaultConfig(motorConfig_t *cfg){
+    int i;
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->pins[MOTOR_LEFT].phase = 16;
+    cfg->pins[MOTOR_LEFT].enable = 17;
+    cfg->pins[MOTOR_RIGHT].phase = 18;
+    cfg->pins[MOTOR_RIGHT].enable = 19;
+    for(i=0;i<MOTORS;i++){
+        cfg->pins[i].freqHz = 20000;
+        cfg->pins[i].mode = MOTOR_PHASE_ENABLE;
+        cfg->pins[i].decay = MOTOR_BRAKE;
+    }
+    cfg->wrap = 255;
+    cfg->slewPerS = 10; // stopped to full in 100 ms
+}
+
+// divider and top for a frequency, the divider is 8.4 fixed point.
+// 0 if it can't be done.
+static uint32_t motorDivider(uint32_t sys, const motorPins_t *p, uint32_t *top){
+    uint64_t clocks16 = (uint64_t)sys * 16 / p->freqHz; // clocks a period, << 4
+    uint64_t div16;
+    if (p->top == 0){
+        // the smallest divider that fits the period in 16 bits
+        div16 = (clocks16 + (MOTOR_TOP_MAX + 1) - 1) / (MOTOR_TOP_MAX + 1);
+        if (div16 < 16) div16 = 16;
+        *top = (uint32_t)((clocks16 + div16 / 2) / div16) - 1;
+    } else {
+        div16 = (clocks16 + (p->top + 1) / 2) / (p->top + 1);
+        if (div16 < 16) div16 = 16;
+        *top = p->top;
+    }
+    if (div16 > 0xFFF || *top > MOTOR_TOP_MAX || *top < 1){
+        return 0;
+    }
+    return (uint32_t)div16;
+}
+
+// the levels for one motor's signed duty in counts
+static void motorLevels(int i, int32_t duty, uint32_t *phase){
+    const motorPins_t *p = &motorCfg.pins[i];
+    bool reverse = (duty < 0) != p->invert;
+    // a level of the whole period is high throughout, one short of it at the top resolution
+    uint16_t full = (uint16_t)(motorPeriod[i] > MOTOR_TOP_MAX ? MOTOR_TOP_MAX : motorPeriod[i]);
+    int32_t m = duty < 0 ? -duty : duty;
+    uint16_t mag = (uint16_t)(m > full ? full : m);
+    uint16_t *in1 = &motorLevel[motorSlice[i][0]][motorChan[i][0]];
+    uint16_t *in2 = &motorLevel[motorSlice[i][1]][motorChan[i][1]];
+    if (p->mode == MOTOR_PHASE_ENABLE){
+        if (reverse){
+            *phase |= 1u << p->phase;
+        }
+        *in2 = mag;
+    } else if (p->decay == MOTOR_COAST){
+        // driving one side, both low in the off time
+        *in1 = reverse ? 0 : mag;
+        *in2 = reverse ? mag : 0;
+    } else {
+        // holding one side high, both high in the off time
+        *in1 = reverse ? (uint16_t)(full - mag) : full;
+        *in2 = reverse ? full : (uint16_t)(full - mag);
+    }
+}
+
+// write the motors in the mask as they are now, direction pins first
+static void motorWrite(uint32_t motors){
+    uint32_t phase = 0, phaseMask = 0, slices = 0;
+    int i;
+    uint s;
+    for(i=0;i<MOTORS;i++){
+        if (!(motors & (1u << i))){
+            continue;
+        }
+        motorLevels(i, motorNow[i] / 256, &phase);
+        if (motorCfg.pins[i].mode == MOTOR_PHASE_ENABLE){
+            phaseMask |= 1u << motorCfg.pins[i].phase;
+        } else {
+            slices |= 1u << motorSlice[i][0];
+        }
+        slices |= 1u << motorSlice[i][1];
+    }
+    if (phaseMask){
+        gpio_put_masked(phaseMask, phase);
+    }
+    for(s=0;s<NUM_PWM_SLICES;s++){
+        if (slices & (1u << s)){
+            pwm_set_both_levels(s, motorLevel[s][0], motorLevel[s][1]);
+        }
+    }
+}
+
+// a period on for every motor whose slice wrapped: a step towards its
+// target, and off once nothing is moving
+static void motorWrapIrq(){
+    uint32_t status = pwm_get_irq_status_mask() & motorWrapMask;
+    uint32_t motors = 0, ramping = 0;
+    int i;
+    uint s;
+    for(s=0;s<NUM_PWM_SLICES;s++){
+        if (status & (1u << s)){
+            pwm_clear_irq(s);
+        }
+    }
+    for(i=0;i<MOTORS;i++){
+        uint32_t slice = 1u << motorSlice[i][1];
+        int32_t now = motorNow[i], target = motorTarget[i];
+        if ((status & slice) && now != target){
+            if (target > now + motorStep[i]){
+                now += motorStep[i];
+            } else if (target < now - motorStep[i]){
+                now -= motorStep[i];
+            } else {
+                now = target;
+            }
+            motorNow[i] = now;
+            motors |= 1u << i;
+        }
+        if (now != target){
+            ramping |= slice;
+        }
+    }
+    if (motors){
+        motorWrite(motors);
+    }
+    if (motorWrapMask & ~ramping){
+        pwm_set_irq_mask_enabled(motorWrapMask & ~ramping, false);
+    }
+}
+
+// once at start, both motors stopped. -1 if a frequency can't be made
+// or the wiring can't do the decay asked for.
+int motorInit(const motorConfig_t *cfg){
+    uint32_t sys = clock_get_hz(clk_sys);
+    uint32_t div16[MOTORS], top[MOTORS];
+    int i, k;
+    for(i=0;i<MOTORS;i++){
+        const motorPins_t *p = &cfg->pins[i];
+        if (p->freqHz == 0 || (p->mode == MOTOR_PHASE_ENABLE && p->decay != MOTOR_BRAKE)){
+            return -1;
+        }
+        div16[i] = motorDivider(sys, p, &top[i]);
+        if (div16[i] == 0){
+            return -1;
+        }
+    }
+    motorCfg = *cfg;
+    if (motorWrapMask){
+        pwm_set_irq_mask_enabled(motorWrapMask, false);
+    }
+    motorPhaseMask = motorSliceMask = motorWrapMask = 0;
+    memset(motorLevel, 0, sizeof(motorLevel));
+    for(i=0;i<MOTORS;i++){
+        const motorPins_t *p = &cfg->pins[i];
+        uint pins[2] = {p->phase, p->enable};
+        if (p->mode == MOTOR_PHASE_ENABLE){
+            gpio_init(p->phase);
+            gpio_set_dir(p->phase, GPIO_OUT);
+            gpio_put(p->phase, p->invert);
+            motorPhaseMask |= 1u << p->phase;
+        }
+        for(k=0;k<2;k++){
+            motorSlice[i][k] = pwm_gpio_to_slice_num(pins[k]);
+            motorChan[i][k] = pwm_gpio_to_channel(pins[k]);
+        }
+        motorPeriod[i] = top[i] + 1;
+        motorFreq[i] = (uint32_t)((uint64_t)sys * 16 / ((uint64_t)div16[i] * motorPeriod[i]));
+        float step = cfg->slewPerS * motorPeriod[i] * 256 / motorFreq[i];
+        motorStep[i] = cfg->slewPerS > 0 && step < 1 ? 1 : (int32_t)step;
+        motorNow[i] = motorTarget[i] = 0;
+        motorLast[i] = 0;
+        motorWrapMask |= 1u << motorSlice[i][1];
+        for(k=p->mode == MOTOR_PHASE_ENABLE ? 1 : 0;k<2;k++){
+            uint s = motorSlice[i][k];
+            if (!(motorSliceMask & (1u << s))){ // a slice shared runs at its first motor's PWM
+                motorSliceMask |= 1u << s;
+                pwm_set_enabled(s, false);
+                pwm_set_wrap(s, (uint16_t)top[i]);
+                pwm_set_clkdiv(s, div16[i] / 16.0f);
+                pwm_set_counter(s, 0);
+                pwm_clear_irq(s);
+            }
+        }
+    }
+    motorWrite((1u << MOTORS) - 1); // stopped, both high for in/in braking
+    for(i=0;i<MOTORS;i++){
+        gpio_set_function(cfg->pins[i].enable, GPIO_FUNC_PWM);
+        if (cfg->pins[i].mode == MOTOR_IN_IN){
+            gpio_set_function(cfg->pins[i].phase, GPIO_FUNC_PWM);
+        }
+    }
+    if (!motorIrqAdded){
+        irq_set_exclusive_handler(PWM_IRQ_WRAP, motorWrapIrq);
+        motorIrqAdded = true;
+    }
+    irq_set_enabled(PWM_IRQ_WRAP, true);
+    // one write so they count in step, any other slice (the camera's
+    // clock) is left running
+    hw_set_bits(&pwm_hw->en, motorSliceMask);
+    return 0;
+}
+
+// signed speeds, -wrap to wrap, + forwards. From the steering tick or
+// the main loop, whichever drives.
+void motorSet(int left, int right){
+    int speed[MOTORS] = {left, right};
+    int i;
+    for(i=0;i<MOTORS;i++){
+        int s = speed[i];
+        if (s > motorCfg.wrap) s = motorCfg.wrap;
+        if (s < -motorCfg.wrap) s = -motorCfg.wrap;
+        motorLast[i] = s;
+        motorTarget[i] = (int32_t)((int64_t)s * motorPeriod[i] * 256 / motorCfg.wrap);
+    }
+    if (motorCfg.slewPerS > 0){
+        // the wrap interrupt takes it from here
+        pwm_set_irq_mask_enabled(motorWrapMask, true);
+        return;
+    }
+    for(i=0;i<MOTORS;i++){
+        motorNow[i] = motorTarget[i];
+    }
+    // the slices count in step, don't let the wrap fall between the writes
+    uint s = motorSlice[MOTOR_LEFT][1];
+    while ((uint32_t)pwm_get_counter(s) + MOTOR_GUARD > motorPeriod[MOTOR_LEFT] - 1){
+        tight_loop_contents();
+    }
+    motorWrite((1u << MOTORS) - 1);
+}
+
+// what was last asked for, after clamping
+void motorGet(int *left, int *right){
+    *left = motorLast[MOTOR_LEFT];
+    *right = motorLast[MOTOR_RIGHT];
+}
+
+// the frequency and resolution a motor really got
+void motorPwm(int motor, uint32_t *freqHz, uint16_t *top){
+    *freqHz = motorFreq[motor];
+    *top = (uint16_t)(motorPeriod[motor] - 1);
+}
+
+// still on the way to a target
+bool motorRamping(){
+    int i;
+    for(i=0;i<MOTORS;i++){
+        if (motorNow[i] != motorTarget[i]){
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,67 @@
+#ifndef MOTOR_h
+#define MOTOR_h
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "hardware/gpio.h"
+
+// The two drive motors. motorInit() sets the PWM up once, each motor at
+// its own frequency and resolution, and starts the slices on the same
+// write so their periods line up where the frequencies match.
+//
+// Without a slew limit motorSet() changes both motors at once: one write
+// for the direction pins and one compare register per slice. The compare
+// registers only take a new value at the end of a period, so written
+// back to back both motors change on the same edge; a write is held off
+// if the period is just about to end.
+//
+// With one, motorSet() only sets the targets and the PWM wrap interrupt
+// moves each motor towards its target a step a period, through zero on a
+// reversal, so a step command can't pull a current spike out of the
+// battery or spin the wheels. The interrupt is only on while a motor is
+// still ramping.
+//
+// A phase/enable driver (hw18's DRV8835 wiring) brakes in the PWM's off
+// time by itself. Wired in/in, both inputs PWM, the decay is ours to
+// pick: coast lets the current die out through the diodes (fast decay),
+// brake shorts the motor through the low side (slow decay), which holds
+// the speed closer to the duty and stops harder.
+
+#define MOTORS 2
+#define MOTOR_LEFT 0
+#define MOTOR_RIGHT 1
+#define MOTOR_GUARD 8 // counts before the wrap too close to start an update
+#define MOTOR_TOP_MAX 65535
+
+// wiring
+#define MOTOR_PHASE_ENABLE 0 // phase is the direction pin, enable the PWM
+#define MOTOR_IN_IN 1 // phase is IN1, enable IN2, both PWM
+
+// decay, MOTOR_IN_IN only
+#define MOTOR_BRAKE 0
+#define MOTOR_COAST 1
+
+typedef struct motorPins {
+    uint phase; // direction, low forwards, or IN1
+    uint enable; // PWM, or IN2
+    bool invert; // forwards the other way, for a motor mounted the other way
+    uint32_t freqHz; // PWM frequency
+    uint16_t top; // PWM resolution, counts a period less one, 0 the finest the frequency allows
+    uint8_t mode; // MOTOR_PHASE_ENABLE or MOTOR_IN_IN
+    uint8_t decay; // MOTOR_BRAKE or MOTOR_COAST
+} motorPins_t;
+
+typedef struct motorConfig {
+    motorPins_t pins[MOTORS];
+    int wrap; // full speed in motorSet()'s units
+    float slewPerS; // full speed changes a second at most, 0 no limit
+} motorConfig_t;
+
+void motorDefaultConfig(motorConfig_t *cfg);
+int motorInit(const motorConfig_t *cfg);
+void motorSet(int left, int right);
+void motorGet(int *left, int *right);
+void motorPwm(int motor, uint32_t *freqHz, uint16_t *top);
+bool motorRamping();
+
+#endif